@@ -23,6 +23,8 @@
 #ifndef CBLQ_TO_BITMAP_CONVERT_HPP_
 #define CBLQ_TO_BITMAP_CONVERT_HPP_
 
+#include <algorithm>
+#include <thread>
 #include <boost/smart_ptr.hpp>
 
 #include "pique/region/cblq/cblq.hpp"
@@ -56,4 +58,36 @@ private:
 	void inplace_convert(boost::shared_ptr< const CBLQRegionEncoding<ndim> > in_right, boost::shared_ptr< BitmapRegionEncoding > out_combine_left) const;
 };
 
+/*
+ * Multithreaded conversion. The top levels are walked on one thread, down to the first level with enough words to split
+ * into spans (among levels whose words each cover whole bitmap blocks); each span's subtrees then cover a disjoint range
+ * of bitmap blocks, and are converted concurrently. Below the block size, subtrees are assembled into whole 64-bit blocks
+ * in registers before being combined into the bitmap (leaf words of the dense suffix are deposited with PDEP when
+ * compiled with BMI2 enabled, e.g., -mbmi2).
+ */
+template<int ndim>
+class CBLQToBitmapParallelConverter : public RegionEncodingConverter< CBLQRegionEncoding<ndim>, BitmapRegionEncoding > {
+public:
+	static constexpr uint64_t DEFAULT_MIN_WORDS_PER_SPAN = 1ULL << 10;
+	static constexpr int SPANS_PER_THREAD = 4; // Spans are handed out to threads dynamically, to balance uneven spans
+
+	// nthreads == 0 means one thread per hardware thread
+	CBLQToBitmapParallelConverter(int nthreads = 0, uint64_t min_words_per_span = DEFAULT_MIN_WORDS_PER_SPAN) :
+		nthreads(nthreads > 0 ? nthreads : std::max(1, (int)std::thread::hardware_concurrency())),
+		min_words_per_span(min_words_per_span)
+	{}
+	virtual ~CBLQToBitmapParallelConverter() {}
+
+	virtual boost::shared_ptr< BitmapRegionEncoding > convert(boost::shared_ptr< const CBLQRegionEncoding<ndim> > in) const;
+	virtual void inplace_convert(boost::shared_ptr< const CBLQRegionEncoding<ndim> > in_right, boost::shared_ptr< BitmapRegionEncoding > out_combine_left, NArySetOperation combine_op) const;
+
+private:
+	template<NArySetOperation combineop>
+	void inplace_convert(boost::shared_ptr< const CBLQRegionEncoding<ndim> > in_right, boost::shared_ptr< BitmapRegionEncoding > out_combine_left) const;
+
+private:
+	const int nthreads;
+	const uint64_t min_words_per_span; // A level is split once it has at least this many words per span
+};
+
 #endif /* CBLQ_TO_BITMAP_CONVERT_HPP_ */
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * to-cblq-convert.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#ifndef TO_CBLQ_CONVERT_HPP_
+#define TO_CBLQ_CONVERT_HPP_
+
+#include <vector>
+#include <boost/smart_ptr.hpp>
+
+#include "pique/region/cblq/cblq.hpp"
+#include "pique/region/cblq/cblq-encode.hpp"
+#include "pique/region/bitmap/bitmap.hpp"
+#include "pique/region/ii/ii.hpp"
+#include "pique/convert/region-convert.hpp"
+
+/*
+ * Builds a CBLQ bottom-up from its leaf words (the 2^ndim-element groups of the padded domain), given in order.
+ * Each completed word is either carried up as a pure code or emitted with a 2-code carried up, as in
+ * CBLQRegionEncoder, but a whole leaf word (or a run of uniform leaf words) is handled at a time, rather than
+ * a run of bits. The result is identical to that of CBLQRegionEncoder for the same elements.
+ */
+template<int ndim>
+class CBLQBottomUpBuilder {
+public:
+	typedef typename CBLQRegionEncoding<ndim>::cblq_word_t cblq_word_t;
+	typedef typename CBLQRegionEncoding<ndim>::cblq_semiword_t cblq_semiword_t; // One bit per element of a leaf word
+
+	static constexpr int ELEMENTS_PER_LEAF_WORD = CBLQRegionEncoding<ndim>::CODES_PER_WORD;
+
+public:
+	CBLQBottomUpBuilder(CBLQRegionEncoderConfig conf, uint64_t nelem);
+
+	uint64_t get_num_leaf_words() const { return num_leaf_words; }
+
+	void push_leaf_word(cblq_semiword_t elem_bits); // Bit i is set iff element i of the leaf word is present
+	void push_uniform_leaf_words(uint64_t count, bool filled);
+
+	// Pads any remaining leaf words as empty
+	boost::shared_ptr< CBLQRegionEncoding<ndim> > to_region_encoding();
+
+private:
+	void push_code(int level, cblq_word_t code);
+	void push_uniform_codes(int level, uint64_t count, bool filled);
+	void push_word(int level, cblq_word_t word);
+
+private:
+	const CBLQRegionEncoderConfig conf;
+	const uint64_t nelem;
+	const int nlevels; // Level 0 is the leaf level (as in CBLQRegionEncoder)
+	const uint64_t num_leaf_words;
+	uint64_t leaf_words_pushed;
+
+	std::vector< std::vector< cblq_word_t > > level_words;
+	CBLQSemiwords<ndim> dense_suffix_semiwords;
+
+	std::vector< cblq_word_t > cur_words;
+	std::vector< int > cur_word_lens;
+};
+
+// Converts an uncompressed bitmap to a CBLQ, testing each 2^ndim-bit group of the bitmap as a leaf word,
+// and skipping whole 0- or 1-blocks of the bitmap as runs of uniform leaf words
+template<int ndim>
+class BitmapToCBLQConverter : public RegionEncodingOutOfPlaceConverter< BitmapRegionEncoding, CBLQRegionEncoding<ndim> > {
+public:
+	BitmapToCBLQConverter(CBLQRegionEncoderConfig conf = CBLQRegionEncoderConfig(false));
+	virtual ~BitmapToCBLQConverter() {}
+
+	virtual boost::shared_ptr< CBLQRegionEncoding<ndim> > convert(boost::shared_ptr< const BitmapRegionEncoding > in) const;
+
+private:
+	const CBLQRegionEncoderConfig conf;
+};
+
+// Converts a (sorted) II RID list to a CBLQ, gathering the RIDs falling in each leaf word into one group,
+// and skipping the gaps between RIDs as runs of empty leaf words
+template<int ndim>
+class IIToCBLQConverter : public RegionEncodingOutOfPlaceConverter< IIRegionEncoding, CBLQRegionEncoding<ndim> > {
+public:
+	IIToCBLQConverter(CBLQRegionEncoderConfig conf = CBLQRegionEncoderConfig(false));
+	virtual ~IIToCBLQConverter() {}
+
+	virtual boost::shared_ptr< CBLQRegionEncoding<ndim> > convert(boost::shared_ptr< const IIRegionEncoding > in) const;
+
+private:
+	const CBLQRegionEncoderConfig conf;
+};
+
+#endif /* TO_CBLQ_CONVERT_HPP_ */
@@ -23,6 +23,7 @@
 #ifndef REGION_CONVERT_HPP_
 #define REGION_CONVERT_HPP_
 
+#include <memory>
 #include <boost/smart_ptr.hpp>
 
 #include "pique/region/region-encoding.hpp"
@@ -105,9 +106,9 @@ template<typename InRegionEncodingT, typename OutRegionEncodingT>
 class RegionEncodingOutOfPlaceConverter : public RegionEncodingConverter<InRegionEncodingT, OutRegionEncodingT> {
 public:
 	RegionEncodingOutOfPlaceConverter(std::unique_ptr< SetOperations< OutRegionEncodingT > > setops) :
-		setops(setops)
+		setops(std::move(setops))
 	{
-		assert(setops->can_handle_region_encoding(OutRegionEncodingT::TYPE)); // Just double-checking
+		assert(this->setops->can_handle_region_encoding(OutRegionEncodingT::TYPE)); // Just double-checking
 	}
 	virtual ~RegionEncodingOutOfPlaceConverter() {}
 
@@ -182,7 +183,7 @@ public:
 
 	virtual ~PreferenceListRegionEncodingConverter() {}
 
-	virtual boost::shared_ptr< RegionEncoding > convert(boost::shared_ptr< RegionEncoding > in, RegionEncoding::Type outtype) const {
+	virtual boost::shared_ptr< RegionEncoding > convert(boost::shared_ptr< const RegionEncoding > in, RegionEncoding::Type outtype) const {
 		return this->convert_base(in, outtype);
 	}
 	virtual boost::shared_ptr< RegionEncoding > inplace_convert(boost::shared_ptr< const RegionEncoding > in_right, boost::shared_ptr< RegionEncoding > out_combine_left, NArySetOperation combine_op) const {
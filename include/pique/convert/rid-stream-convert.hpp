@@ -0,0 +1,54 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * rid-stream-convert.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#ifndef RID_STREAM_CONVERT_HPP_
+#define RID_STREAM_CONVERT_HPP_
+
+#include <boost/smart_ptr.hpp>
+
+#include "pique/region/region-encoding.hpp"
+#include "pique/convert/region-convert.hpp"
+
+/*
+ * Converts between any two concrete region representations by streaming the RIDs of the input region
+ * (coalesced into runs) into an encoder for the output representation. Slower than a dedicated converter,
+ * but applicable to every pair of representations.
+ *
+ * In-place conversion (combining the converted region into an existing one) requires set operations
+ * for the output representation; without them, inplace_convert returns nullptr.
+ */
+class RIDStreamRegionEncodingConverter : public AbstractRegionEncodingConverter {
+public:
+	RIDStreamRegionEncodingConverter(boost::shared_ptr< const AbstractSetOperations > combine_setops = nullptr) :
+		combine_setops(combine_setops)
+	{}
+	virtual ~RIDStreamRegionEncodingConverter() {}
+
+	virtual bool can_convert_region_encoding(RegionEncoding::Type intype, RegionEncoding::Type outtype) const;
+
+	virtual boost::shared_ptr< RegionEncoding > convert(boost::shared_ptr< const RegionEncoding > in, RegionEncoding::Type outtype) const;
+	virtual boost::shared_ptr< RegionEncoding > inplace_convert(boost::shared_ptr< const RegionEncoding > in_right, boost::shared_ptr< RegionEncoding > out_combine_left, NArySetOperation combine_op) const;
+
+private:
+	const boost::shared_ptr< const AbstractSetOperations > combine_setops;
+};
+
+#endif /* RID_STREAM_CONVERT_HPP_ */
@@ -52,6 +52,10 @@ public:
 	const std::vector< uint64_t > & get_subvolume_offsets() const { return subvolume_offsets; }
 	const std::vector< uint64_t > & get_subvolume_dims() const { return subvolume_dims; }
 
+	// Computes the sorted, disjoint, maximal linearized ranges covering this subset, under the given linearization of the domain grid
+	// (for Z_ORDER, the grid is padded to a power-of-two cube, as in IndexBuilder::build_index_zo)
+	std::vector< std::pair< dataset_offset_t, dataset_length_t > > compute_linearized_ranges(Grid::Linearization lin = Grid::Linearization::ROW_MAJOR_ORDER) const;
+
 private:
 	const Type type;
 	const Grid domain_grid;
@@ -28,5 +28,6 @@
 #include "pique/encoding/interval/interval-encoding.hpp"
 #include "pique/encoding/binarycomp/binarycomp-encoding.hpp"
 #include "pique/encoding/hier/hier-encoding.hpp"
+#include "pique/encoding/multires/multires-encoding.hpp"
 
 #endif /* SRC_ENCODING_ALL_INDEX_ENCODINGS_HPP_ */
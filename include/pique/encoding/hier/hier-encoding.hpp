@@ -33,7 +33,7 @@ public:
 
 private:
 	virtual std::vector< bin_id_vector_t > get_encoded_region_definitions_impl(bin_count_t nbins) const;
-	virtual region_vector_t get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations &setops) const;
+	virtual region_vector_t get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations &setops, int nthreads) const;
 
 	virtual RMath get_region_math_impl(bin_count_t nbins, bin_id_t lb, bin_id_t ub, bool prefer_complement) const; // [lb, ub)
 
@@ -35,11 +35,12 @@ class RangeIndexEncoding;
 class IntervalIndexEncoding;
 class BinaryComponentIndexEncoding;
 class HierarchicalIndexEncoding;
+class MultiResolutionIndexEncoding;
 
 typedef typename
 	MakeValueToTypeDispatch< EncType >
-	::WithValues< EncType::EQUALITY, EncType::RANGE, EncType::INTERVAL, EncType::BINARY_COMPONENT, EncType::HIERARCHICAL >
-	::WithTypes< EqualityIndexEncoding, RangeIndexEncoding, IntervalIndexEncoding, BinaryComponentIndexEncoding, HierarchicalIndexEncoding >
+	::WithValues< EncType::EQUALITY, EncType::RANGE, EncType::INTERVAL, EncType::BINARY_COMPONENT, EncType::HIERARCHICAL, EncType::MULTI_RESOLUTION >
+	::WithTypes< EqualityIndexEncoding, RangeIndexEncoding, IntervalIndexEncoding, BinaryComponentIndexEncoding, HierarchicalIndexEncoding, MultiResolutionIndexEncoding >
 	::type EncTypeDispatch;
 
 #endif /* SRC_ENCODING_IMPL_INDEX_ENCODING_DISPATCH_HPP_ */
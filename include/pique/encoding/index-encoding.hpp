@@ -27,6 +27,9 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <thread>
+#include <functional>
 #include <boost/smart_ptr.hpp>
 
 #include "pique/indexing/binned-index-types.hpp"
@@ -45,17 +48,21 @@ public:
 	using bin_id_vector_t = std::vector< bin_id_t >;
 	using region_vector_t = std::vector< boost::shared_ptr< RegionEncoding > >;
 
-	enum struct Type : char { EQUALITY, RANGE, INTERVAL, HIERARCHICAL, BINARY_COMPONENT };
+	using region_cost_fn_t = std::function< uint64_t(region_id_t) >;
+
+	enum struct Type : char { EQUALITY, RANGE, INTERVAL, HIERARCHICAL, BINARY_COMPONENT, MULTI_RESOLUTION };
 
 public:
 	// This works only for those index encodings that take no parameters
 	static boost::shared_ptr< IndexEncoding > get_instance(Type type);
 	static boost::shared_ptr< IndexEncoding > get_equality_encoding_instance() { return get_instance(Type::EQUALITY); }
 
+	// nthreads is as for get_encoded_regions
 	static boost::shared_ptr< BinnedIndex > get_encoded_index(
 			boost::shared_ptr< const IndexEncoding > index_enc,
 			boost::shared_ptr< const BinnedIndex > in_index,
-			const AbstractSetOperations &setops);
+			const AbstractSetOperations &setops,
+			int nthreads = 1);
 
 protected:
 	IndexEncoding(Type type) : type(type) {}
@@ -90,9 +97,12 @@ public:
 	 * This may be more efficient than calling get_encoded_region_definitions and following
 	 * its returned instructions, as this function can reuse computations across multiple
 	 * encoded region in some cases.
+	 *
+	 * The set operations are performed on up to nthreads threads (nthreads == 0 means one
+	 * per hardware thread), so setops must support concurrent operations on distinct regions.
 	 */
-	region_vector_t get_encoded_regions(region_vector_t bins, const AbstractSetOperations &setops) const {
-		return this->get_encoded_regions_impl(bins, setops);
+	region_vector_t get_encoded_regions(region_vector_t bins, const AbstractSetOperations &setops, int nthreads = 1) const {
+		return this->get_encoded_regions_impl(bins, setops, nthreads > 0 ? nthreads : std::max(1, (int)std::thread::hardware_concurrency()));
 	}
 
 	// Query side
@@ -100,12 +110,20 @@ public:
 		return this->get_region_math_impl(nbins, lb, ub, prefer_complement);
 	}
 
+	// As above, but encodings with a choice of regions may use region_cost (e.g., the size of each region in bytes) to choose the cheapest
+	RMath get_region_math(bin_count_t nbins, bin_id_t lb, bin_id_t ub, bool prefer_complement, const region_cost_fn_t &region_cost) const { // [lb, ub)
+		return this->get_region_math_with_costs_impl(nbins, lb, ub, prefer_complement, region_cost);
+	}
+
 private:
 	// Delegates
 	virtual std::vector< bin_id_vector_t > get_encoded_region_definitions_impl(bin_count_t nbins) const = 0;
-	virtual region_vector_t get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations &setops) const; // Default: use get_encoded_region_definitions_impl and simple unions
+	virtual region_vector_t get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations &setops, int nthreads) const; // Default: use get_encoded_region_definitions_impl and simple unions (concurrently)
 
 	virtual RMath get_region_math_impl(bin_count_t nbins, bin_id_t lb, bin_id_t ub, bool prefer_complement) const = 0; // [lb, ub)
+	virtual RMath get_region_math_with_costs_impl(bin_count_t nbins, bin_id_t lb, bin_id_t ub, bool prefer_complement, const region_cost_fn_t &region_cost) const { // Default: ignore costs
+		return this->get_region_math_impl(nbins, lb, ub, prefer_complement);
+	}
 
 	virtual void load_from_stream_impl(std::istream &in) {} // Default: no extra information to deserialize
 	virtual void save_to_stream_impl(std::ostream &out)  {} // Default: no extra information to deserialize
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * multires-encoding.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#ifndef MULTIRES_ENCODING_HPP_
+#define MULTIRES_ENCODING_HPP_
+
+#include <cassert>
+#include <boost/serialization/access.hpp>
+
+#include "pique/encoding/index-encoding.hpp"
+
+/*
+ * A two-level encoding storing coarse "super-bin" regions alongside the fine bins. Regions
+ * [0, nbins) are the fine bins (as with equality encoding), and each following region is the
+ * union of super_bin_width consecutive fine bins (the last possibly fewer). No super-bins are
+ * stored if there are no more than super_bin_width bins.
+ *
+ * A bin range is covered by full super-bins in its interior, and at each partially covered
+ * super-bin either by the fine bins inside the range, or by the super-bin minus the fine bins
+ * outside the range, whichever is cheaper under the given region costs.
+ */
+class MultiResolutionIndexEncoding : public IndexEncoding {
+public:
+	static constexpr bin_count_t DEFAULT_SUPER_BIN_WIDTH = 16;
+
+	MultiResolutionIndexEncoding(bin_count_t super_bin_width = DEFAULT_SUPER_BIN_WIDTH) :
+		IndexEncoding(Type::MULTI_RESOLUTION), super_bin_width(super_bin_width)
+	{
+		assert(super_bin_width >= 2);
+	}
+
+	bin_count_t get_super_bin_width() const { return super_bin_width; }
+	region_count_t get_num_super_bins(bin_count_t nbins) const;
+
+	virtual bool operator==(const IndexEncoding &other) const;
+
+private:
+	virtual std::vector< bin_id_vector_t > get_encoded_region_definitions_impl(bin_count_t nbins) const;
+	virtual region_vector_t get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations &setops, int nthreads) const;
+
+	virtual RMath get_region_math_impl(bin_count_t nbins, bin_id_t lb, bin_id_t ub, bool prefer_complement) const; // [lb, ub)
+	virtual RMath get_region_math_with_costs_impl(bin_count_t nbins, bin_id_t lb, bin_id_t ub, bool prefer_complement, const region_cost_fn_t &region_cost) const; // [lb, ub)
+
+private:
+	bin_count_t super_bin_width;
+
+	friend class boost::serialization::access;
+    template<typename Archive> void serialize(Archive &ar, const unsigned int version) {
+    	ar & super_bin_width;
+    }
+};
+
+#endif /* MULTIRES_ENCODING_HPP_ */
@@ -30,6 +30,7 @@
 #include <boost/smart_ptr.hpp>
 #include <boost/optional.hpp>
 
+#include "pique/data/grid.hpp"
 #include "pique/indexing/binned-index-types.hpp"
 #include "pique/indexing/quantization.hpp"
 #include "pique/indexing/binning-spec.hpp"
@@ -51,13 +52,15 @@ public:
     		boost::shared_ptr< const IndexEncoding > index_enc,
     		RegionEncoding::Type index_rep_type,
     		boost::shared_ptr< const AbstractBinningSpecification > bins,
-    		std::vector< boost::shared_ptr< RegionEncoding > > regions) :
+    		std::vector< boost::shared_ptr< RegionEncoding > > regions,
+    		boost::optional< Grid > grid = boost::none) :
         indexed_datatype(indexed_datatype),
         domain_size(domain_size),
         index_enc(index_enc),
         index_rep_type(index_rep_type),
         bins(bins),
-        regions(std::move(regions))
+        regions(std::move(regions)),
+        grid(std::move(grid))
 	{}
     ~BinnedIndex() {}
 
@@ -75,6 +78,9 @@ public:
     uint64_t get_domain_size() const { return domain_size; }
     boost::shared_ptr< const IndexEncoding > get_encoding() const { return index_enc; }
     RegionEncoding::Type get_representation_type() const { return index_rep_type; }
+    // The grid of the indexed elements, and how RIDs linearize it, if recorded (it is by IndexBuilder::build_index_zo, whose RIDs
+    // are Z-order IDs rather than row-major offsets); otherwise, RIDs are row-major offsets into the dataset
+    const boost::optional< Grid > & get_grid() const { return grid; }
 
     // Bins access
     boost::shared_ptr< const AbstractBinningSpecification > get_binning_specification() const { return bins; }
@@ -128,7 +134,20 @@ public:
     			new_index_enc,
     			this->get_representation_type(),
     			this->get_binning_specification(),
-    			std::move(new_regions));
+    			std::move(new_regions),
+    			this->get_grid());
+    }
+
+    // As above, but keeping this index's encoding and replacing its representation type and regions
+    boost::shared_ptr< BinnedIndex > derive_new_index(RegionEncoding::Type new_index_rep_type, std::vector< boost::shared_ptr< RegionEncoding > > new_regions) const {
+    	return boost::make_shared< BinnedIndex >(
+    			this->get_indexed_datatype(),
+    			this->get_domain_size(),
+    			this->get_encoding(),
+    			new_index_rep_type,
+    			this->get_binning_specification(),
+    			std::move(new_regions),
+    			this->get_grid());
     }
 
 private:
@@ -141,6 +160,19 @@ private:
 
     const std::vector< boost::shared_ptr< RegionEncoding > > regions;
 
+    const boost::optional< Grid > grid;
+
     template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT> friend class IndexBuilder;
     friend class IndexAccumulator;
 };
+
+// Receives an index's regions one at a time, in region order, as they are finished (e.g., by an IndexBuilder), so that
+// they need not all be held in memory at once. Methods return false on failure
+class BinnedIndexRegionSink {
+public:
+	virtual ~BinnedIndexRegionSink() {}
+
+	// Called once, before any regions, with the index's metadata (as an index with no regions) and its region count
+	virtual bool begin_regions(const BinnedIndex &index_meta, BinnedIndexTypes::region_count_t nregions) = 0;
+	virtual bool write_region(boost::shared_ptr< RegionEncoding > region) = 0;
+};
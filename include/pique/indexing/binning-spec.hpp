@@ -30,7 +30,10 @@
 #define BINNING_SPEC_HPP_
 
 #include <cstdint>
+#include <vector>
 
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/type_traits.hpp>
 #include <boost/static_assert.hpp>
 #include <boost/none.hpp>
@@ -76,6 +79,11 @@ public:
     virtual bin_id_t lower_bound_bin(UniversalValue value, bin_id_t start_from = 0) const = 0;
     virtual bin_id_t upper_bound_bin(UniversalValue value, bin_id_t start_from = 0) const = 0;
 
+    // Returns a populated binning specification of the same type and parameters, but containing only the
+    // bins needed to decide whether a bin range computed against this specification (as by lower/upper_bound_bin)
+    // is empty or covers all bins: the lowest two bins and the highest bin. Used as a compact partition zone map.
+    virtual boost::shared_ptr< AbstractBinningSpecification > make_zone_map() const = 0;
+
     BinningUniversalDatatypeID get_binning_universal_datatype() const {return  UniversalValue::convert_datatype_to_universal_datatype(this->get_binning_datatype()); };
 
     std::vector< UniversalValue > get_all_bin_keys() const {
@@ -150,6 +158,16 @@ public:
     const QuantizationType & get_quantization() const { return quant; }
     const QuantizedKeyCompareType & get_quantized_key_compare() const { return qcompare; }
 
+protected:
+    // The bin keys to populate a zone map with (see make_zone_map())
+    std::vector< QKeyType > get_zone_map_qkeys() const {
+    	assert(is_populated());
+    	const bin_count_t nbins = get_num_bins();
+    	if (nbins <= 3)
+    		return bin_qkeys;
+    	return std::vector< QKeyType >{ bin_qkeys[0], bin_qkeys[1], bin_qkeys[nbins - 1] };
+    }
+
 private:
 
     bin_id_t bound_bin(UniversalValue user_value, bool inclusive_bound, bin_id_t start_from = 0) const {
@@ -220,6 +238,12 @@ public:
 	virtual Datatypes::IndexableDatatypeID get_binning_datatype() const { return ValueDatatypeID; }
 	virtual BinningSpecificationType get_binning_spec_type() const { return SpecTypeID; }
 
+	virtual boost::shared_ptr< AbstractBinningSpecification > make_zone_map() const {
+		boost::shared_ptr< SigbitsBinningSpecification > zone_map = boost::make_shared< SigbitsBinningSpecification >(sigbits);
+		zone_map->populate(this->get_zone_map_qkeys());
+		return zone_map;
+	}
+
 	int get_sigbits() const { return sigbits; }
 private:
 	friend class boost::serialization::access;
@@ -287,6 +311,12 @@ public:
 	virtual Datatypes::IndexableDatatypeID get_binning_datatype() const { return ValueDatatypeID; }
 	virtual BinningSpecificationType get_binning_spec_type() const { return SpecTypeID; }
 
+	virtual boost::shared_ptr< AbstractBinningSpecification > make_zone_map() const {
+		boost::shared_ptr< PrecisionBinningSpecification > zone_map = boost::make_shared< PrecisionBinningSpecification >(digits);
+		zone_map->populate(this->get_zone_map_qkeys());
+		return zone_map;
+	}
+
 	int get_digits() const { return digits; }
 private:
 	friend class boost::serialization::access;
@@ -363,6 +393,14 @@ public:
 	virtual Datatypes::IndexableDatatypeID get_binning_datatype() const { return ValueDatatypeID; }
 	virtual BinningSpecificationType get_binning_spec_type() const { return SpecTypeID; }
 
+	// Note: quantization here depends on the populated bins, but the zone map bins are chosen
+	// such that quantizing against them preserves the empty/complete bin range decisions
+	virtual boost::shared_ptr< AbstractBinningSpecification > make_zone_map() const {
+		boost::shared_ptr< ExplicitBinsBinningSpecification > zone_map = boost::make_shared< ExplicitBinsBinningSpecification >();
+		zone_map->populate(this->get_zone_map_qkeys());
+		return zone_map;
+	}
+
 	virtual void populate(std::vector< QKeyType > qkeys) {
 		ParentType::populate(std::move(qkeys));
 		this->quant = QuantizationType(this->bin_qkeys, get_negative_infinity());
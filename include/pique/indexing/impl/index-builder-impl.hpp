@@ -25,25 +25,197 @@
 #define _INDEX_BUILD_IMPL_HPP
 
 #include <iostream>
+#include <fstream>
 #include <cassert>
+#include <cstdio>
+#include <algorithm>
+#include <numeric>
+#include <functional>
 #include <vector>
 #include <boost/unordered_map.hpp>
 #include <boost/make_shared.hpp>
 
-//#include "pique/util/zo-iter2.hpp"
+#include "pique/util/zo-iter2.hpp"
 #include "pique/util/datatypes.hpp"
+#include "pique/util/memory-usage.hpp"
 
 #include "pique/data/dataset.hpp"
 #include "pique/indexing/binned-index.hpp"
 #include "pique/region/region-encoding.hpp"
 #include "pique/encoding/index-encoding.hpp"
 
-// Template definitions and specializations
+// Tracks the bin encoders' total state during a build, spilling the largest of them to the scratch file whenever it
+// exceeds the memory budget, and merges the spilled pieces back in when bins are finalized (see IndexBuilderSpillConfig)
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+class IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::Spiller {
+public:
+	Spiller(const IndexBuilder &builder, uint64_t nelem) :
+		builder(builder), nelem(nelem),
+		empty_state_bytes(builder.spill_conf.is_enabled() ? RegionEncoderType(builder.encoder_conf, nelem).get_state_size_in_bytes() : 0),
+		total_state_bytes(0), retained_region_bytes(0), spill_threshold_bytes(builder.spill_conf.memory_budget_bytes)
+	{}
+	~Spiller() {
+		if (scratch.is_open()) {
+			scratch.close();
+			std::remove(builder.spill_conf.scratch_filename.c_str());
+		}
+	}
+
+	// The encoder's state size as tracked by the spiller (always 0 when not spilling, so as to cost nothing)
+	size_t get_state_size(const RegionEncoderType &encoder) const {
+		return builder.spill_conf.is_enabled() ? encoder.get_state_size_in_bytes() : 0;
+	}
+
+	// Should be called whenever a new encoder is added to the build
+	void on_encoder_created() { total_state_bytes += empty_state_bytes; }
+
+	// Should be called after each run is inserted into an encoder (so all encoders are between runs), given its tracked
+	// state size before the insertion. If the encoders' total state is then over budget, spills and restarts them down
+	// to half of it. Returns true if any encoder was restarted (invalidating any pointers to encoders in encoders_by_qkey)
+	bool on_run_inserted(bin_qkey_to_encoder_map_t &encoders_by_qkey, const RegionEncoderType &encoder, size_t prev_state_bytes);
+
+	// Spills and restarts encoders, largest first, until their total state is at most target_bytes, or no encoder
+	// would be smaller once restarted. Returns true if any encoder was restarted
+	bool spill_down_to(bin_qkey_to_encoder_map_t &encoders_by_qkey, uint64_t target_bytes);
+
+	// Finalizes the given bin's encoder, merging any pieces spilled from it ahead of the RIDs it still holds. The
+	// encoder's state is no longer tracked afterward, but if retain_region is set, the finished region is tracked instead
+	boost::shared_ptr< RegionEncoding > finalize_bin(const bin_qkey_t &qkey, RegionEncoderType &encoder, bool retain_region);
+
+private:
+	void spill_piece(const bin_qkey_t &qkey, RegionEncoderType &encoder);
+	void update_peak_state(uint64_t state_bytes) { builder.stats.peak_state_bytes = std::max(builder.stats.peak_state_bytes, state_bytes); }
+
+	const IndexBuilder &builder;
+	const uint64_t nelem;
+	const size_t empty_state_bytes; // The state size of a new encoder (restarting an encoder at most this size cannot help)
+
+	uint64_t total_state_bytes; // Of all encoders
+	uint64_t retained_region_bytes; // Of the finished regions held for the output index
+	uint64_t spill_threshold_bytes;
+
+	std::fstream scratch;
+	boost::unordered_map< bin_qkey_t, std::vector< std::streamoff > > spilled_piece_offsets; // In RID order
+};
 
 template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
-boost::shared_ptr< BinnedIndex >
-IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::build_index(const Dataset &data) {
-	return this->build_index(data, GridSubset(data.get_grid()));
+bool IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::Spiller::on_run_inserted(bin_qkey_to_encoder_map_t &encoders_by_qkey, const RegionEncoderType &encoder, size_t prev_state_bytes) {
+	if (!builder.spill_conf.is_enabled())
+		return false;
+
+	// (an encoder's state may also shrink, e.g. when a CII encoder compresses a chunk)
+	total_state_bytes = total_state_bytes + encoder.get_state_size_in_bytes() - prev_state_bytes;
+
+	bool spilled = false;
+	if (total_state_bytes > spill_threshold_bytes) {
+		const uint64_t budget = builder.spill_conf.memory_budget_bytes;
+		spilled = this->spill_down_to(encoders_by_qkey, budget / 2);
+
+		// If the encoders could not be brought within budget (their state does not shrink when restarted, e.g. for
+		// uncompressed bitmaps), let their state grow somewhat before scanning them again, rather than after every run
+		spill_threshold_bytes = std::max(budget, total_state_bytes + budget / 2);
+	}
+
+	this->update_peak_state(total_state_bytes);
+	return spilled;
+}
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+bool IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::Spiller::spill_down_to(bin_qkey_to_encoder_map_t &encoders_by_qkey, uint64_t target_bytes) {
+	bool spilled = false;
+	TIME_STATS_TIME_BEGIN(builder.stats.spilltime)
+	// Re-measure all encoders (which also keeps the running total exact)
+	total_state_bytes = 0;
+	std::vector< std::pair< size_t, bin_qkey_t > > encoder_sizes;
+	encoder_sizes.reserve(encoders_by_qkey.size());
+	for (auto it = encoders_by_qkey.begin(); it != encoders_by_qkey.end(); ++it) {
+		const size_t encoder_bytes = it->second.get_state_size_in_bytes();
+		total_state_bytes += encoder_bytes;
+		encoder_sizes.push_back(std::make_pair(encoder_bytes, it->first));
+	}
+
+	std::sort(encoder_sizes.begin(), encoder_sizes.end(),
+			[](const std::pair< size_t, bin_qkey_t > &e1, const std::pair< size_t, bin_qkey_t > &e2)->bool { return e1.first > e2.first; });
+
+	for (const std::pair< size_t, bin_qkey_t > &encoder_size : encoder_sizes) {
+		if (total_state_bytes <= target_bytes || encoder_size.first <= empty_state_bytes)
+			break; // (the remaining encoders are no larger)
+
+		auto encoder_it = encoders_by_qkey.find(encoder_size.second);
+		this->spill_piece(encoder_it->first, encoder_it->second);
+
+		encoders_by_qkey.erase(encoder_it);
+		encoders_by_qkey.emplace(std::make_pair(encoder_size.second, RegionEncoderType(builder.encoder_conf, nelem)));
+		total_state_bytes -= encoder_size.first - empty_state_bytes;
+		spilled = true;
+	}
+	TIME_STATS_TIME_END()
+
+	return spilled;
+}
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+void IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::Spiller::spill_piece(const bin_qkey_t &qkey, RegionEncoderType &encoder) {
+	const std::string &scratch_filename = builder.spill_conf.scratch_filename;
+	if (!scratch.is_open()) {
+		scratch.open(scratch_filename, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!scratch.is_open()) {
+			std::cerr << "Error: could not open index build scratch file \"" << scratch_filename << "\"" << std::endl;
+			abort();
+		}
+	}
+
+	// The piece holds all RIDs encoded so far (padded with 0-bits to the full domain)
+	encoder.finalize();
+	boost::shared_ptr< RegionEncodingType > piece = encoder.to_region_encoding();
+
+	scratch.seekp(0, std::ios::end);
+	const std::streamoff offset = scratch.tellp();
+	piece->save_to_stream(scratch);
+	assert(scratch.good());
+
+	spilled_piece_offsets[qkey].push_back(offset);
+	++builder.stats.num_spilled_pieces;
+	builder.stats.spilled_bytes += (uint64_t)(scratch.tellp() - offset);
+}
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< RegionEncoding > IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::Spiller::finalize_bin(const bin_qkey_t &qkey, RegionEncoderType &encoder, bool retain_region) {
+	const size_t encoder_bytes = this->get_state_size(encoder);
+
+	encoder.finalize();
+	boost::shared_ptr< RegionEncoding > region = encoder.to_region_encoding();
+
+	auto pieces_it = spilled_piece_offsets.find(qkey);
+	if (pieces_it != spilled_piece_offsets.end()) {
+		TIME_STATS_TIME_BEGIN(builder.stats.spilltime)
+		// Each piece covers a disjoint range of RIDs following those of the previous piece, and the encoder's own
+		// region follows the last piece, so re-encoding all their RIDs in order yields the bin's full region
+		RegionEncoderType merged_encoder(builder.encoder_conf, nelem);
+		for (std::streamoff offset : pieces_it->second) {
+			boost::shared_ptr< RegionEncodingType > piece = boost::make_shared< RegionEncodingType >();
+			scratch.seekg(offset);
+			piece->load_from_stream(scratch);
+			assert(scratch.good());
+
+			merged_encoder.insert_rids(*piece->make_rid_iterator());
+		}
+		merged_encoder.insert_rids(*region->make_rid_iterator());
+		merged_encoder.finalize();
+
+		region = merged_encoder.to_region_encoding();
+		spilled_piece_offsets.erase(pieces_it);
+		TIME_STATS_TIME_END()
+	}
+
+	if (builder.spill_conf.is_enabled()) {
+		total_state_bytes -= encoder_bytes;
+		this->update_peak_state(total_state_bytes + retained_region_bytes + region->get_size_in_bytes());
+		if (retain_region)
+			retained_region_bytes += region->get_size_in_bytes();
+	}
+
+	return region;
 }
 
 template<typename datatype_t>
@@ -67,45 +239,175 @@ static boost::shared_ptr< BufferedDatasetStream< datatype_t > > open_buffered_da
     return buffered_datastream;
 }
 
+// The state of one index build: the bin encoders, and the position of the next element to index
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+struct IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::BuildState {
+	BuildState(const IndexBuilder &builder, uint64_t nelem) :
+		nelem(nelem), value_pos(0),
+		binning_spec_dup(boost::make_shared< BinningSpecificationType >(*builder.binning_spec)),
+		spiller(builder, nelem)
+	{}
+
+	const uint64_t nelem;
+	uint64_t value_pos;
+	boost::optional< Grid > grid; // Recorded in the output index, if set (see BinnedIndex::get_grid())
+	bin_qkey_to_encoder_map_t encoders_by_qkey;
+	boost::shared_ptr< BinningSpecificationType > binning_spec_dup;
+	Spiller spiller;
+};
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+class IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::Session : public AbstractIndexBuildSession {
+public:
+	Session(const IndexBuilder &builder, uint64_t nelem) : builder(builder), state(this->builder, nelem) {
+		this->builder.reset_stats();
+	}
+
+	virtual void index_block(const Dataset &data, GridSubset block);
+	virtual boost::shared_ptr< BinnedIndex > finish();
+	virtual boost::shared_ptr< BinnedIndex > finish(BinnedIndexRegionSink &sink);
+
+	virtual IndexBuilderStats get_stats() const { return builder.get_stats(); }
+
+private:
+	IndexBuilder builder; // Must precede state, which refers to it
+	BuildState state;
+};
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+class IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::ZOrderSession : public AbstractIndexBuildSession {
+public:
+	ZOrderSession(const IndexBuilder &builder, Grid grid) : builder(builder), grid(std::move(grid)) {
+		this->builder.reset_stats();
+		values.reserve(this->grid.get_npoints());
+	}
+
+	virtual void index_block(const Dataset &data, GridSubset block);
+	virtual boost::shared_ptr< BinnedIndex > finish();
+	virtual boost::shared_ptr< BinnedIndex > finish(BinnedIndexRegionSink &sink);
+
+	virtual IndexBuilderStats get_stats() const { return builder.get_stats(); }
+
+private:
+	IndexBuilder builder;
+	const Grid grid;
+	std::vector< datatype_t > values; // The (row-major) values of the blocks indexed so far
+};
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+void IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::Session::index_block(const Dataset &data, GridSubset block) {
+	TIME_STATS_TIME_BEGIN(builder.stats.totaltime)
+	boost::shared_ptr< BufferedDatasetStream< datatype_t > > buffered_datastream = open_buffered_dataset_stream< datatype_t >(data, std::move(block));
+	assert(state.value_pos + buffered_datastream->get_element_count() <= state.nelem);
+	builder.index_stream(state, *buffered_datastream);
+	TIME_STATS_TIME_END()
+}
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< BinnedIndex > IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::Session::finish() {
+	assert(state.value_pos == state.nelem);
+	TIME_STATS_TIME_BEGIN(builder.stats.totaltime)
+	return builder.finalize_index(state);
+	TIME_STATS_TIME_END()
+}
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< BinnedIndex > IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::Session::finish(BinnedIndexRegionSink &sink) {
+	assert(state.value_pos == state.nelem);
+	TIME_STATS_TIME_BEGIN(builder.stats.totaltime)
+	return builder.finalize_index(state, &sink);
+	TIME_STATS_TIME_END()
+}
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+void IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::ZOrderSession::index_block(const Dataset &data, GridSubset block) {
+	TIME_STATS_TIME_BEGIN(builder.stats.totaltime)
+	builder.load_values(values, data, std::move(block));
+	assert(values.size() <= grid.get_npoints());
+	TIME_STATS_TIME_END()
+}
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< BinnedIndex > IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::ZOrderSession::finish() {
+	TIME_STATS_TIME_BEGIN(builder.stats.totaltime)
+	return builder.index_values_zo(grid, values);
+	TIME_STATS_TIME_END()
+}
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< BinnedIndex > IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::ZOrderSession::finish(BinnedIndexRegionSink &sink) {
+	TIME_STATS_TIME_BEGIN(builder.stats.totaltime)
+	return builder.index_values_zo(grid, values, &sink);
+	TIME_STATS_TIME_END()
+}
+
+// Template definitions and specializations
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< BinnedIndex >
+IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::build_index(const Dataset &data) {
+	return this->build_index(data, GridSubset(data.get_grid()));
+}
+
 template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
 boost::shared_ptr< BinnedIndex >
 IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::build_index(const Dataset &data, GridSubset subset) {
-    using IndexableDatatypeID = Datatypes::IndexableDatatypeID;
-	//static constexpr const IndexableDatatypeID DTID = Datatypes::CTypeToDatatypeID< datatype_t >::value;
+    TIME_STATS_TIME_BEGIN(stats.totaltime) // Time everything
 
-    using bin_id_t = BinnedIndexTypes::bin_id_t;
-    using bin_count_t = BinnedIndexTypes::bin_count_t;
-    using bin_size_t = BinnedIndexTypes::bin_size_t;
-    using region_id_t = BinnedIndexTypes::region_id_t;
-    using region_count_t = BinnedIndexTypes::region_count_t;
+    // Open a dataset stream
+    boost::shared_ptr< BufferedDatasetStream< datatype_t > > buffered_datastream = open_buffered_dataset_stream< datatype_t >(data, std::move(subset));
 
-    using bin_qkey_t = typename BinningSpecificationType::QKeyType;
-    using bin_qkey_to_encoder_map_t = boost::unordered_map< bin_qkey_t, RegionEncoderType >; // Because for a flat index, bin ID == region ID
+    BuildState state(*this, buffered_datastream->get_element_count());
+    this->index_stream(state, *buffered_datastream);
 
-    using TypedDatasetStream = DatasetStream< datatype_t >;
-    using TypedBufferedDatasetStream = BufferedDatasetStream< datatype_t >;
+    return this->finalize_index(state);
+
+    TIME_STATS_TIME_END()
+}
 
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< BinnedIndex >
+IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::build_index(const Dataset &data, GridSubset subset, BinnedIndexRegionSink &sink) {
     TIME_STATS_TIME_BEGIN(stats.totaltime) // Time everything
 
-    // Builder data structures
-    bin_qkey_to_encoder_map_t encoders_by_qkey;
-    boost::shared_ptr< BinningSpecificationType > binning_spec_dup = boost::make_shared< BinningSpecificationType >(*this->binning_spec);
-    const QuantizationType &quant = binning_spec_dup->get_quantization();
-    const QuantizedKeyCompareType &qcompare = binning_spec_dup->get_quantized_key_compare();
+    boost::shared_ptr< BufferedDatasetStream< datatype_t > > buffered_datastream = open_buffered_dataset_stream< datatype_t >(data, std::move(subset));
 
-    // Open a dataset stream
-    boost::shared_ptr< TypedBufferedDatasetStream > buffered_datastream = open_buffered_dataset_stream< datatype_t >(data, std::move(subset));
+    BuildState state(*this, buffered_datastream->get_element_count());
+    this->index_stream(state, *buffered_datastream);
+
+    return this->finalize_index(state, &sink);
+
+    TIME_STATS_TIME_END()
+}
 
-    // Extract constants for ease of use
-    const uint64_t nelem = buffered_datastream->get_element_count();
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< AbstractIndexBuildSession >
+IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::begin_build(uint64_t nelem) const {
+    return boost::make_shared< Session >(*this, nelem);
+}
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< AbstractIndexBuildSession >
+IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::begin_build_zo(Grid grid) const {
+    return boost::make_shared< ZOrderSession >(*this, std::move(grid));
+}
 
-    // Iterate over all runs of bin-equal values in the dataset
-    uint64_t value_pos = 0;
-    while (buffered_datastream->has_next()) {
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+void IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::index_stream(BuildState &state, BufferedDatasetStream< datatype_t > &datastream) {
+    using TypedBufferedDatasetStream = BufferedDatasetStream< datatype_t >;
+
+    const QuantizationType &quant = state.binning_spec_dup->get_quantization();
+    bin_qkey_to_encoder_map_t &encoders_by_qkey = state.encoders_by_qkey;
+    const uint64_t nelem = state.nelem;
+
+    // Iterate over all runs of bin-equal values in the dataset. A run is not merged with one ending the previous
+    // stream, which at most splits one run in two
+    uint64_t value_pos = state.value_pos;
+    while (datastream.has_next()) {
     	using buffer_iterator_t = typename TypedBufferedDatasetStream::buffer_iterator_t;
     	buffer_iterator_t data_it, data_end_it;
 
-    	buffered_datastream->get_buffered_data(data_it, data_end_it);
+    	datastream.get_buffered_data(data_it, data_end_it);
     	++stats.num_read_buffer_blocks;
 
         TIME_STATS_TIME_BEGIN(stats.indexingtime)
@@ -124,8 +426,10 @@ IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::build_index(c
     		auto encoder_for_qkey_it = encoders_by_qkey.find(run_qkey);
 
     		// If this is a new bin, also allocate a new bin builder
-    		if (encoder_for_qkey_it == encoders_by_qkey.end())
+    		if (encoder_for_qkey_it == encoders_by_qkey.end()) {
     			encoder_for_qkey_it = encoders_by_qkey.emplace(std::make_pair(run_qkey, RegionEncoderType(this->encoder_conf, nelem))).first;
+    			state.spiller.on_encoder_created();
+    		}
 
     		// Move it to the first value != run_val (or the end of the array)
     		while (data_it != data_end_it) {
@@ -141,159 +445,222 @@ IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::build_index(c
 
     		// Compute the run length, then append bits to the run's bin's region encoder
     		const uint64_t run_length = value_pos - run_start_pos;
+    		const size_t prev_state_bytes = state.spiller.get_state_size(encoder_for_qkey_it->second);
     		encoder_for_qkey_it->second.insert_bits(run_start_pos, run_length);
+
+    		state.spiller.on_run_inserted(encoders_by_qkey, encoder_for_qkey_it->second, prev_state_bytes);
     	}
         TIME_STATS_TIME_END()
     }
+    state.value_pos = value_pos;
 
-    stats.iostats += buffered_datastream->get_stats();
-    stats.num_bins += encoders_by_qkey.size();
-
-    std::vector< boost::shared_ptr< RegionEncoding > > sorted_regions;
-
-    TIME_STATS_TIME_BEGIN(stats.indexingtime)
-    // Construct a vector of all qkeys seen
-    std::vector< bin_qkey_t > sorted_bin_qkeys;
-    sorted_bin_qkeys.reserve(encoders_by_qkey.size());
-    for (auto it = encoders_by_qkey.begin(); it != encoders_by_qkey.end(); ++it)
-    	sorted_bin_qkeys.push_back(it->first);
+    stats.iostats += datastream.get_stats();
+}
 
-    // Sort qkeys to form the final bin list
-    std::sort(sorted_bin_qkeys.begin(), sorted_bin_qkeys.end(), [&qcompare](const bin_qkey_t &k1, const bin_qkey_t &k2)->bool { return qcompare.compare(k1, k2); });
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< BinnedIndex >
+IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::build_index_zo(const Dataset &data) {
+    return this->build_index_zo(data, GridSubset(data.get_grid()));
+}
 
-    // Load the sorted qkeys into the binning specification as the final bin list
-    binning_spec_dup->populate(sorted_bin_qkeys);
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< BinnedIndex >
+IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::build_index_zo(const Dataset &data, GridSubset subset) {
+    TIME_STATS_TIME_BEGIN(stats.totaltime) // Time everything
 
-    // Collect the region encodings in sorted-bin order
-    for (bin_qkey_t bin_qkey : sorted_bin_qkeys) {
-    	RegionEncoderType &encoder = encoders_by_qkey.find(bin_qkey)->second;
-    	encoder.finalize();
-    	boost::shared_ptr< RegionEncoding > bin_region = encoder.to_region_encoding();
-    	sorted_regions.push_back(bin_region);
+    // Determine the box of elements to index, which must be a box so that it has a Z-order
+    const Grid &data_grid = subset.get_grid();
+    std::vector< uint64_t > box_dims;
+    switch (subset.get_type()) {
+    case GridSubset::Type::WHOLE_DOMAIN:
+        box_dims = data_grid;
+        break;
+    case GridSubset::Type::LINEARIZED_RANGES:
+    {
+        // A single range of whole rows (i.e., whole slices along the first dimension)
+        const uint64_t row_size = std::accumulate(data_grid.begin() + 1, data_grid.end(), (uint64_t)1, std::multiplies< uint64_t >());
+        if (subset.get_ranges().size() != 1 || subset.get_ranges()[0].first % row_size != 0 || subset.get_ranges()[0].second % row_size != 0) {
+            std::cerr << "Error: a Z-order index may only be built over a single range of whole rows of the dataset" << std::endl;
+            abort();
+        }
+        box_dims = data_grid;
+        box_dims[0] = subset.get_ranges()[0].second / row_size;
+        break;
+    }
+    case GridSubset::Type::SUBVOLUME:
+        box_dims = subset.get_subvolume_dims();
+        break;
     }
-    TIME_STATS_TIME_END()
 
-    // Finally, compose the output index to be returned
-    boost::shared_ptr< BinnedIndex > index_out =
-    		boost::make_shared< BinnedIndex >(
-    				typeid(datatype_t),
-    				nelem,
-    				IndexEncoding::get_equality_encoding_instance(),
-    				RegionEncodingType::TYPE,
-    				binning_spec_dup,
-    				sorted_regions);
+    const Grid grid(std::move(box_dims), Grid::Linearization::Z_ORDER);
+
+    // Load the box into memory, so the Z-order traversal may access it randomly
+    std::vector< datatype_t > values;
+    values.reserve(grid.get_npoints());
+    this->load_values(values, data, std::move(subset));
+    assert(values.size() == grid.get_npoints());
 
-    return index_out;
+    return this->index_values_zo(grid, values);
 
     TIME_STATS_TIME_END()
 }
 
-/*
-template<typename datatype_t, typename RegionEncoderT>
-boost::shared_ptr< AbstractBinnedIndex >
-IndexBuilder<datatype_t, RegionEncoderT>::build_index_zo(const Dataset<datatype_t> &data, int sigbits) {
-    typedef typename AbstractBinnedIndex::bin_header_t bin_header_t;
-    typedef BinnedIndexTypes::bin_count_t bin_count_t;
-    typedef BinnedIndexTypes::bin_id_t bin_id_t;
-    typedef BinnedIndexTypes::bin_size_t bin_size_t;
-
-    typedef boost::unordered_map<bin_header_t, bin_id_t> bin_header_to_id_map_t;
-
-    // Extract constants for ease of use
-    const int insigbits = (sizeof(datatype_t) << 3) - sigbits;
-    const int ndim = data.get_grid()->get_ndim();
-    const uint64_t *dims = data.get_grid()->get_grid()->dims;
-    const size_t nelem = data.get_grid()->get_npts();
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+void IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::load_values(std::vector< datatype_t > &values, const Dataset &data, GridSubset subset) {
+    using TypedBufferedDatasetStream = BufferedDatasetStream< datatype_t >;
+    using buffer_iterator_t = typename TypedBufferedDatasetStream::buffer_iterator_t;
+
+    boost::shared_ptr< TypedBufferedDatasetStream > buffered_datastream = open_buffered_dataset_stream< datatype_t >(data, std::move(subset));
+    buffer_iterator_t data_it, data_end_it;
+    while (buffered_datastream->get_buffered_data(data_it, data_end_it)) {
+        values.insert(values.end(), data_it, data_end_it);
+        ++stats.num_read_buffer_blocks;
+    }
+    stats.iostats += buffered_datastream->get_stats();
+}
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< BinnedIndex >
+IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::index_values_zo(const Grid &grid, const std::vector< datatype_t > &values, BinnedIndexRegionSink *sink) {
+    static constexpr bool SMEAR_OUT_OF_BOUNDS = IndexBuilderModeSmearOutOfBounds< RegionEncodingType >::value;
+
+    // Compute the Z-order domain: the smallest cube with power-of-2 sides enclosing the grid
+    const int ndim = grid.size();
+    assert(ndim >= 1 && ndim <= 5 /* supported by zo_loop_iterate */);
+    assert(values.size() == grid.get_npoints());
+
+    const int exp_level = compute_zo_exp_level(ndim, &grid.front());
+    assert(exp_level * ndim < 64);
+    const uint64_t zo_nelem = 1ULL << (exp_level * ndim);
 
     // Builder data structures
+    BuildState state(*this, zo_nelem);
+    state.grid = Grid(std::vector< uint64_t >(grid), Grid::Linearization::Z_ORDER);
+    bin_qkey_to_encoder_map_t &encoders_by_qkey = state.encoders_by_qkey;
+    const QuantizationType &quant = state.binning_spec_dup->get_quantization();
 
-    // The bin header -> bin ID mapping table for use during construction
-    bin_header_to_id_map_t bin_header_to_bin_id;
-    // Bin index CBLQ builders
-    std::vector<RegionEncoderT> bin_encoders;
-    std::vector<bin_header_t> bin_headers;
-
-    // Iterate over all runs of bin-equal values in the dataset
-    const std::vector<datatype_t> &data_arr = *data.get_data();
-
-    bool first_run = true;
-    bin_header_t run_bin_header = (type_convert<datatype_t, bin_header_t>(data_arr[0]) >> insigbits) + 1; // != first bin header, will trigger the first run
-    bin_id_t run_bin;
-    uint64_t run_start_pos;
-    uint64_t last_zid;
-
-    ZOIterLoopBody loop = [&](uint64_t zid, uint64_t rmoid, uint64_t coords[]) {
-        // Retrieve the current value, which will begin a new run
-        const datatype_t cur_val = data_arr[rmoid];
-
-        // Compute the corresponding bin header for this run value
-        const bin_header_t cur_bin_header = type_convert<datatype_t, bin_header_t>(cur_val) >> insigbits;
-
-		// If we changed bins OR skipped elements due to out-of-bounds...
-		if (cur_bin_header != run_bin_header || zid != last_zid + 1) {
-			// Insert the current run as a bit run (unless this is the first
-			if (!first_run) {
-				const bin_size_t run_length_smear = zid - run_start_pos;
-				const bin_size_t run_length_nosmear = last_zid - run_start_pos + 1;
-
-				const bin_size_t run_length = (IndexBuilderModeSmearOutOfBounds< RegionEncodingT >() == true) ? run_length_smear : run_length_nosmear;
-				bin_encoders[run_bin].insert_bits(run_start_pos, run_length);
-			} else {
-				first_run = false;
-			}
-
-			// Start a new run
-			run_bin_header = cur_bin_header;
-        	run_start_pos = zid;
-
-			// Find the bin ID for this bin header, allocating a new bin ID
-			// if this is its first appearance
-			const bin_id_t next_bin_id = bin_encoders.size();
-			std::pair<typename bin_header_to_id_map_t::iterator, bool> bin_id_register =
-					bin_header_to_bin_id.emplace(run_bin_header, next_bin_id);
-
-			// If this is a new bin, also allocate a new bin builder
-	        if (bin_id_register.second) {
-	            bin_encoders.emplace_back(this->encoder_conf, nelem); // emplace = push new region encoder object constructed with an encoder conf and the total elements
-	            bin_headers.push_back(run_bin_header);
-	        }
-
-	        run_bin = bin_id_register.first->second; // emplace_result.iterator->key(bin_id)
+    // The traversal visits the row-major values in Morton tiles (each subcube of the Z-order domain is completed before
+    // the next), so consecutive accesses stay within a few cache lines/pages of each other at every scale
+    TIME_STATS_TIME_BEGIN(stats.indexingtime)
+    // Iterate over all runs of bin-equal values in Z-order, where a run may also be ended by a gap of out-of-bounds
+    // Z-order IDs (when not smearing)
+    bool have_run = false;
+    bin_qkey_t run_qkey{};
+    RegionEncoderType *run_encoder = nullptr;
+    uint64_t run_start_zid = 0, last_zid = 0;
+
+    auto end_run = [&](uint64_t next_zid) {
+        // When smearing, extend the run over any out-of-bounds elements up to the next in-bounds element
+        const uint64_t run_length = (SMEAR_OUT_OF_BOUNDS ? next_zid : last_zid + 1) - run_start_zid;
+        const size_t prev_state_bytes = state.spiller.get_state_size(*run_encoder);
+        run_encoder->insert_bits(run_start_zid, run_length);
+        state.spiller.on_run_inserted(encoders_by_qkey, *run_encoder, prev_state_bytes); // The encoder for the next run is looked up afterward
+    };
+
+    zo_loop_iterate(ndim, &grid.front(), &grid.front(), true, [&](uint64_t zid, uint64_t rmoid, uint64_t coords[]) {
+        const bin_qkey_t qkey = quant.quantize(values[rmoid]);
+
+        if (have_run && qkey == run_qkey && (SMEAR_OUT_OF_BOUNDS || zid == last_zid + 1)) {
+            last_zid = zid; // Continue the current run
+            return;
         }
 
-		last_zid = zid;
-    };
+        if (have_run)
+            end_run(zid);
+
+        // Begin a new run, allocating a new bin encoder if this is a new bin
+        auto encoder_for_qkey_it = encoders_by_qkey.find(qkey);
+        if (encoder_for_qkey_it == encoders_by_qkey.end()) {
+            encoder_for_qkey_it = encoders_by_qkey.emplace(std::make_pair(qkey, RegionEncoderType(this->encoder_conf, zo_nelem))).first;
+            state.spiller.on_encoder_created();
+        }
+
+        have_run = true;
+        run_qkey = qkey;
+        run_encoder = &encoder_for_qkey_it->second;
+        run_start_zid = last_zid = zid;
+    });
+
+    // The last run is always unfinished (and is never smeared past the last in-bounds element)
+    if (have_run)
+        end_run(last_zid + 1);
+    TIME_STATS_TIME_END()
+
+    state.value_pos = zo_nelem;
+    return this->finalize_index(state, sink);
+}
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< BinnedIndex >
+IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::finalize_index(BuildState &state, BinnedIndexRegionSink *sink) {
+    bin_qkey_to_encoder_map_t &encoders_by_qkey = state.encoders_by_qkey;
+    const boost::shared_ptr< BinningSpecificationType > &binning_spec_dup = state.binning_spec_dup;
+    const QuantizedKeyCompareType &qcompare = binning_spec_dup->get_quantized_key_compare();
+
+    stats.num_bins += encoders_by_qkey.size();
+
+    std::vector< boost::shared_ptr< RegionEncoding > > sorted_regions;
 
-    zo_loop_iterate(ndim, dims, dims, true, loop);
+    TIME_STATS_TIME_BEGIN(stats.indexingtime)
+    // Construct a vector of all qkeys seen
+    std::vector< bin_qkey_t > sorted_bin_qkeys;
+    sorted_bin_qkeys.reserve(encoders_by_qkey.size());
+    for (auto it = encoders_by_qkey.begin(); it != encoders_by_qkey.end(); ++it)
+    	sorted_bin_qkeys.push_back(it->first);
 
-    // The last run is always unfinished
-    const bin_size_t last_run_length = last_zid - run_start_pos + 1;
-	bin_encoders[run_bin].insert_bits(run_start_pos, last_run_length);
+    // Sort qkeys to form the final bin list
+    std::sort(sorted_bin_qkeys.begin(), sorted_bin_qkeys.end(), [&qcompare](const bin_qkey_t &k1, const bin_qkey_t &k2)->bool { return qcompare.compare(k1, k2); });
 
-    // The output index to be returned
-    boost::shared_ptr< AbstractBinnedIndex > index_out = boost::make_shared< AbstractBinnedIndex >(sigbits, typeid(datatype_t), AbstractBinnedIndex::BinCompositionType::FLAT);
+    // Load the sorted qkeys into the binning specification as the final bin list
+    binning_spec_dup->populate(sorted_bin_qkeys);
 
-    // All data has been partitioned into index bins. The bins are out of order, and are
-    // also "unfinalized" (need trailing 0's appended).
-    auto bin_encoder_it = bin_encoders.begin();
-    auto bin_header_it = bin_headers.begin();
-    while (bin_encoder_it != bin_encoders.end()) {
-        // Finalize and retrieve the bin index
-    	bin_encoder_it->finalize();
-    	boost::shared_ptr< RegionEncoding > bin_index = bin_encoder_it->to_region_encoding();
+    if (sink) {
+    	// The sink gets the index's metadata up front, then each region as soon as it is finished
+    	if (!sink->begin_regions(*this->make_index(state, std::vector< boost::shared_ptr< RegionEncoding > >()), sorted_bin_qkeys.size())) {
+    		std::cerr << "Error: could not begin writing the index's regions" << std::endl;
+    		abort();
+    	}
 
-    	// Append the bin index to the aggregate output index
-    	index_out->append_bin(*bin_header_it, bin_index);
+    	// When spilling, first bring the encoders down to half the budget, leaving the other half for the bin being finished
+    	if (spill_conf.is_enabled())
+    		state.spiller.spill_down_to(encoders_by_qkey, spill_conf.memory_budget_bytes / 2);
+    }
 
-    	// Increment to the next bin
-    	bin_header_it++;
-    	bin_encoder_it++;
+    // Finish the regions in sorted-bin order, releasing each encoder once its region is finished (so that, when building
+    // out-of-core, the regions being merged in from spilled pieces mostly replace encoder state)
+    for (size_t bin = 0; bin < sorted_bin_qkeys.size(); ++bin) {
+    	const bin_qkey_t &bin_qkey = sorted_bin_qkeys[bin];
+    	auto encoder_it = encoders_by_qkey.find(bin_qkey);
+    	boost::shared_ptr< RegionEncoding > bin_region = state.spiller.finalize_bin(bin_qkey, encoder_it->second, !sink);
+    	encoders_by_qkey.erase(encoder_it);
+
+    	if (!sink) {
+    		sorted_regions.push_back(bin_region);
+    	} else if (!sink->write_region(bin_region)) {
+    		std::cerr << "Error: could not write index region " << bin << std::endl;
+    		abort();
+    	}
     }
+    TIME_STATS_TIME_END()
+
+    stats.peak_rss_bytes = std::max(stats.peak_rss_bytes, get_peak_rss_bytes());
 
-    index_out->sort_bins();
+    // Finally, compose the output index to be returned
+    return this->make_index(state, std::move(sorted_regions));
+}
 
-    return index_out;
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+boost::shared_ptr< BinnedIndex >
+IndexBuilder< datatype_t, RegionEncoderT, BinningSpecificationT >::make_index(const BuildState &state, std::vector< boost::shared_ptr< RegionEncoding > > regions) {
+    return boost::make_shared< BinnedIndex >(
+    		typeid(datatype_t),
+    		state.nelem,
+    		IndexEncoding::get_equality_encoding_instance(),
+    		RegionEncodingType::TYPE,
+    		state.binning_spec_dup,
+    		std::move(regions),
+    		state.grid);
 }
-*/
+
 
 #endif /* _INDEX_BUILD_IMPL_HPP */
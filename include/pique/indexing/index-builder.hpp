@@ -26,9 +26,11 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <string>
 
 #include <boost/smart_ptr.hpp>
 #include <boost/mpl/bool.hpp>
+#include <boost/unordered_map.hpp>
 
 #include "pique/data/dataset.hpp"
 #include "pique/data/grid-subset.hpp"
@@ -53,6 +55,11 @@ struct IndexBuilderStats : public BaseStats< IndexBuilderStats > {
 		combine(this->iostats, other.iostats);
 		combine(this->num_bins, other.num_bins);
 		combine(this->num_read_buffer_blocks, other.num_read_buffer_blocks);
+		combine(this->spilltime, other.spilltime);
+		combine(this->num_spilled_pieces, other.num_spilled_pieces);
+		combine(this->spilled_bytes, other.spilled_bytes);
+		combine(this->peak_state_bytes, other.peak_state_bytes);
+		combine(this->peak_rss_bytes, other.peak_rss_bytes);
 	}
 
 	TimeStats totaltime{};
@@ -60,11 +67,56 @@ struct IndexBuilderStats : public BaseStats< IndexBuilderStats > {
 	IOStats iostats{};
 	uint64_t num_bins{0};
 	uint64_t num_read_buffer_blocks{0};
+
+	// Out-of-core building (see IndexBuilderSpillConfig)
+	TimeStats spilltime{}; // Writing and merging back spilled pieces
+	uint64_t num_spilled_pieces{0};
+	uint64_t spilled_bytes{0};
+	uint64_t peak_state_bytes{0}; // Peak total of bin encoder state and finished regions held at once, as of the end of each run (only tracked when spilling)
+
+	uint64_t peak_rss_bytes{0}; // Peak resident set size of the process as of the end of the build
 };
 
 DEFINE_STATS_SERIALIZE(IndexBuilderStats, stats, \
 	stats.totaltime & stats.indexingtime & \
-	stats.iostats & stats.num_bins & stats.num_read_buffer_blocks);
+	stats.iostats & stats.num_bins & stats.num_read_buffer_blocks & \
+	stats.spilltime & stats.num_spilled_pieces & stats.spilled_bytes & stats.peak_state_bytes & stats.peak_rss_bytes);
+
+// Configures out-of-core index building. Whenever the bin encoders' total state exceeds the memory budget, the
+// largest of them are finalized and spilled to a scratch file (as pieces covering the RIDs encoded so far), and
+// restarted empty; at the end of the build, each bin's spilled pieces are merged back into its final region, one
+// bin at a time. A memory budget of 0 (the default) disables spilling.
+// Note: spilling alone bounds the transient encoder state, not the finished index itself; to bound both, have the
+// finished regions streamed out (see IndexBuilder::build_index with a BinnedIndexRegionSink). Spilling cannot help
+// encoders whose state does not grow with the data encoded (i.e., uncompressed bitmaps)
+struct IndexBuilderSpillConfig {
+	IndexBuilderSpillConfig() {}
+	IndexBuilderSpillConfig(uint64_t memory_budget_bytes, std::string scratch_filename) :
+		memory_budget_bytes(memory_budget_bytes), scratch_filename(std::move(scratch_filename))
+	{}
+
+	bool is_enabled() const { return memory_budget_bytes > 0; }
+
+	uint64_t memory_budget_bytes{0};
+	std::string scratch_filename; // Created (truncated) when the first piece is spilled, and removed at the end of the build
+};
+
+// An index build in progress, fed its dataset a block at a time, so that several variables' indexes may be built in
+// lockstep over the same grid (see MultiVariableIndexBuilder)
+class AbstractIndexBuildSession {
+public:
+	virtual ~AbstractIndexBuildSession() {}
+
+	// Indexes the elements of the given subset of data, which must continue (in row-major order) from the last block
+	virtual void index_block(const Dataset &data, GridSubset block) = 0;
+	// Completes the index, once blocks covering the whole domain have been indexed
+	virtual boost::shared_ptr< BinnedIndex > finish() = 0;
+	// As above, but streams the index's regions to the sink as they are finished, and returns the index without its regions
+	// (see IndexBuilder::build_index)
+	virtual boost::shared_ptr< BinnedIndex > finish(BinnedIndexRegionSink &sink) = 0;
+
+	virtual IndexBuilderStats get_stats() const = 0;
+};
 
 // Declarations
 template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
@@ -77,19 +129,65 @@ public:
 	using QuantizationType = typename BinningSpecificationT::QuantizationType;
 	using QuantizedKeyCompareType = typename BinningSpecificationT::QuantizedKeyCompareType;
 
-	IndexBuilder(RegionEncoderConfigType conf, boost::shared_ptr< BinningSpecificationType > binning_spec) :
-		encoder_conf(std::move(conf)), binning_spec(binning_spec)
+	IndexBuilder(RegionEncoderConfigType conf, boost::shared_ptr< BinningSpecificationType > binning_spec, IndexBuilderSpillConfig spill_conf = IndexBuilderSpillConfig()) :
+		encoder_conf(std::move(conf)), binning_spec(binning_spec), spill_conf(std::move(spill_conf))
 	{}
 
     boost::shared_ptr< BinnedIndex > build_index(const Dataset &data);
     boost::shared_ptr< BinnedIndex > build_index(const Dataset &data, GridSubset subset);
+    // As above, but hands each bin's region to the sink as soon as it is finished, rather than holding them all, and returns
+    // the index's metadata (as an index with no regions). With spilling, this bounds the regions and encoder state held
+    // at once to the memory budget, provided no single bin's region exceeds half of it
+    boost::shared_ptr< BinnedIndex > build_index(const Dataset &data, GridSubset subset, BinnedIndexRegionSink &sink);
+
+    // Builds an index over the dataset's grid in Z-order (Morton order), rather than its stored (row-major) order,
+    // so multi-dimensional encodings (i.e., CBLQ) capture its spatial clustering. The grid is padded to a cube with
+    // power-of-2 sides, so the index domain is 2^(exp_level * ndim) elements, and RIDs are Z-order IDs within it.
+    // Padding elements are empty in all bins, unless IndexBuilderModeSmearOutOfBounds holds for the region encoding,
+    // in which case each gap of padding is assigned to the bin of the element preceding it (yielding fewer, larger
+    // uniform blocks; such padding elements' values are undefined, and should be excluded by the caller)
+    // The index records the grid it was built over (with Z-order linearization; see BinnedIndex::get_grid())
+    boost::shared_ptr< BinnedIndex > build_index_zo(const Dataset &data);
+    // As above, but over only a box within the dataset: the whole domain, a subvolume, or a single range of whole rows (i.e.,
+    // whole slices along the first dimension, such as a row-block partition). RIDs are Z-order IDs within the box
+    boost::shared_ptr< BinnedIndex > build_index_zo(const Dataset &data, GridSubset subset);
+
+    // Begins an incremental (row-major) build of an index over nelem elements. The session has its own copy of this
+    // builder's configuration, and its own statistics
+    boost::shared_ptr< AbstractIndexBuildSession > begin_build(uint64_t nelem) const;
+    // Begins an incremental build of a Z-order index over the whole of the given grid (see build_index_zo). Blocks are
+    // buffered in memory as they are indexed (the Z-order traversal needs random access), and traversed when finished
+    boost::shared_ptr< AbstractIndexBuildSession > begin_build_zo(Grid grid) const;
 
     IndexBuilderStats get_stats() const { return stats; }
     void reset_stats() { stats = IndexBuilderStats(); }
 
+private:
+    using bin_qkey_t = typename BinningSpecificationType::QKeyType;
+    using bin_qkey_to_encoder_map_t = boost::unordered_map< bin_qkey_t, RegionEncoderType >; // Because for a flat index, bin ID == region ID
+
+    class Spiller;
+    struct BuildState;
+    class Session;
+    class ZOrderSession;
+
+    // Indexes all elements of the stream, continuing (in row-major order) from those already indexed
+    void index_stream(BuildState &state, BufferedDatasetStream< datatype_t > &datastream);
+    // Appends all (row-major) values of the subset of data to values
+    void load_values(std::vector< datatype_t > &values, const Dataset &data, GridSubset subset);
+    // Indexes the row-major values of the grid in Z-order (see build_index_zo), handing the regions to the sink, if given
+    // (see finalize_index)
+    boost::shared_ptr< BinnedIndex > index_values_zo(const Grid &grid, const std::vector< datatype_t > &values, BinnedIndexRegionSink *sink = nullptr);
+
+    // Finalizes all bin encoders (merging in any spilled pieces), and composes them (in sorted bin order) into the output
+    // index, or if a sink is given, hands them to it in that order and returns the index without its regions
+    boost::shared_ptr< BinnedIndex > finalize_index(BuildState &state, BinnedIndexRegionSink *sink = nullptr);
+    static boost::shared_ptr< BinnedIndex > make_index(const BuildState &state, std::vector< boost::shared_ptr< RegionEncoding > > regions);
+
 private:
     const RegionEncoderConfigType encoder_conf;
     boost::shared_ptr< BinningSpecificationType > binning_spec;
+    const IndexBuilderSpillConfig spill_conf;
 
     mutable IndexBuilderStats stats;
 };
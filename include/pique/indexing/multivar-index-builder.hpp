@@ -0,0 +1,78 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * multivar-index-builder.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#ifndef MULTIVAR_INDEX_BUILDER_HPP_
+#define MULTIVAR_INDEX_BUILDER_HPP_
+
+#include <cstdint>
+#include <vector>
+#include <boost/smart_ptr.hpp>
+
+#include "pique/data/dataset.hpp"
+#include "pique/data/grid-subset.hpp"
+#include "pique/indexing/binned-index.hpp"
+#include "pique/indexing/index-builder.hpp"
+
+/*
+ * Builds the indexes of several variables sharing a grid in a single pass over the domain: the domain is read in
+ * blocks (slabs of whole rows along the slowest-varying dimension, in row-major order), and each block of every
+ * variable is indexed before moving on to the next block. Each variable's index is built by its own
+ * AbstractIndexBuildSession (see IndexBuilder::begin_build), so variables may differ in datatype, binning and
+ * region representation.
+ *
+ * For file-backed datasets, this keeps all variables' reads moving forward together (e.g., through the same chunks
+ * of an HDF5 file), rather than making one full pass over the file per variable.
+ */
+class MultiVariableIndexBuilder {
+public:
+	static constexpr uint64_t DEFAULT_BLOCK_ELEMENTS = 1ULL<<20;
+
+	// Each block spans at least one row, and otherwise as many rows as fit in block_elements
+	MultiVariableIndexBuilder(uint64_t block_elements = DEFAULT_BLOCK_ELEMENTS);
+
+	// The session must have been begun over the dataset's element count; all datasets must have the same grid
+	void add_variable(boost::shared_ptr< const Dataset > data, boost::shared_ptr< AbstractIndexBuildSession > session);
+
+	// Returns the variables' indexes, in the order they were added
+	std::vector< boost::shared_ptr< BinnedIndex > > build_indexes();
+	// As above, but streams each variable's regions to its sink (in the same order), returning the indexes without their
+	// regions (see AbstractIndexBuildSession::finish)
+	std::vector< boost::shared_ptr< BinnedIndex > > build_indexes(const std::vector< boost::shared_ptr< BinnedIndexRegionSink > > &sinks);
+
+	// Each variable's statistics, in the order they were added
+	std::vector< IndexBuilderStats > get_stats() const;
+
+private:
+	// Indexes every block of the domain in all sessions
+	void index_all_blocks();
+
+	// The block of the domain covering the given rows (along dimension 0), in a subset type supported by data
+	static GridSubset make_block_subset(const Dataset &data, uint64_t first_row, uint64_t nrows);
+
+private:
+	const uint64_t block_elements;
+
+	std::vector< boost::shared_ptr< const Dataset > > datasets;
+	std::vector< boost::shared_ptr< AbstractIndexBuildSession > > sessions;
+};
+
+#endif /* MULTIVAR_INDEX_BUILDER_HPP_ */
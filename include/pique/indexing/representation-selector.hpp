@@ -0,0 +1,61 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * representation-selector.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#ifndef REPRESENTATION_SELECTOR_HPP_
+#define REPRESENTATION_SELECTOR_HPP_
+
+#include <vector>
+#include <boost/smart_ptr.hpp>
+
+#include "pique/region/region-encoding.hpp"
+#include "pique/indexing/binned-index.hpp"
+
+class AbstractRegionEncodingConverter;
+
+/*
+ * Re-encodes each region of an index in whichever of a list of candidate representations gives it the smallest
+ * size, since no single representation suits regions whose densities span many orders of magnitude. If regions end
+ * up in different representations, the resulting index has representation type HETEROGENEOUS (and its regions'
+ * types are recorded individually when written); otherwise it has the one representation chosen for every region.
+ *
+ * Query evaluation on such an index needs a PreferenceListSetOperations covering all candidate representations,
+ * which converts operands to a common representation when needed.
+ */
+class RegionRepresentationSelector {
+public:
+	// Uninverted and compressed inverted indexes, 32-bit WAH, 1D CBLQ, and uncompressed bitmaps
+	static std::vector< RegionEncoding::Type > get_default_candidate_types();
+
+	RegionRepresentationSelector(std::vector< RegionEncoding::Type > candidate_types = get_default_candidate_types()); // Converts regions with a RIDStreamRegionEncodingConverter
+	RegionRepresentationSelector(std::vector< RegionEncoding::Type > candidate_types, boost::shared_ptr< const AbstractRegionEncodingConverter > converter);
+
+	// Regions are re-encoded on up to nthreads threads (nthreads == 0 means one per hardware thread)
+	boost::shared_ptr< BinnedIndex > select_representations(boost::shared_ptr< const BinnedIndex > index, int nthreads = 1) const;
+
+	// Returns the smallest of region's candidate re-encodings (or region itself, if it is already the smallest)
+	boost::shared_ptr< RegionEncoding > select_representation(boost::shared_ptr< RegionEncoding > region) const;
+
+private:
+	const std::vector< RegionEncoding::Type > candidate_types;
+	const boost::shared_ptr< const AbstractRegionEncodingConverter > converter;
+};
+
+#endif /* REPRESENTATION_SELECTOR_HPP_ */
@@ -34,7 +34,7 @@
  * An abstract helper base class, which must be derived to fill in the actual file IO details.
  * The assumptions/guarantees built into this base class are as follows:
  * > The index will be stored in a single, contiguous file or similar backend
- * > It must be possible to open an std::istream or std::ostream into this file at any time (although istreams will only be requested in read mode and ostreams in write mode)
+ * > It must be possible to open an std::istream or std::ostream into this file at any time (although istreams will only be requested in read/append mode and ostreams in write/append mode)
  * > Partition IDs will be dense; that is, for a file with N partitions, the partition IDs will be 0 through N-1
  * > Partitions commited to the central IndexIO (see on_partition_committed) shall be packed sequentially in file
  */
@@ -43,6 +43,10 @@ public:
 	SharedFileFormatIndexIO();
 	virtual ~SharedFileFormatIndexIO() { this->close(); }
 
+	// (De)serializes a partition's footer metadata as it is stored in the footer (e.g., to pass it between processes)
+	static std::string serialize_global_partition_metadata(const GlobalPartitionMetadata &gpmeta);
+	static GlobalPartitionMetadata deserialize_global_partition_metadata(const std::string &buffer);
+
 private:
 	// Return based on internal metadata. Valid in both read and write mode; override to return error if they shouldn't be valid in write mode.
 	virtual GlobalMetadata get_global_metadata_impl();
@@ -51,7 +55,8 @@ private:
 protected:
 	void init_metadata_empty();
 	void read_metadata_from_disk();
-	void write_metadata_to_disk(); // Call to write IndexIO metadata to disk if in write mode (usually called in close_impl())
+	bool read_metadata_for_append(); // Reads existing metadata, then positions the next partition after the existing footer (for append mode); false if the file is malformed
+	void write_metadata_to_disk(); // Call to write IndexIO metadata to disk if in write/append mode (usually called in close_impl())
 
 	// Accepts any committed partition_id_t, or one past the end, which will return the location where the next committed partition will be located
 	uint64_t get_partition_offset_in_file(partition_id_t partition_id);
@@ -115,15 +120,24 @@ private:
 	virtual region_count_t get_num_regions_impl();
 
 	virtual uint64_t compute_regions_size_impl(region_id_t lb, region_id_t ub); // [lb, ub)
+	virtual uint64_t compute_regions_element_count_impl(region_id_t lb, region_id_t ub); // [lb, ub)
 	virtual bool read_regions_impl(const std::set< region_id_t > &regions_to_read, std::map< region_id_t, boost::shared_ptr< RegionEncoding > > &regions);
 
 	virtual void set_partition_metadata_impl(PartitionMetadata metadata);
 	virtual bool write_regions_impl(const std::vector< boost::shared_ptr< RegionEncoding > > &regions);
 
+	// If the partition can be allocated before its size is known, streamed regions are written to disk as they arrive
+	// (after space reserved for the partition header, which is written after the last region); otherwise, they are buffered
+	virtual bool begin_write_regions_impl(region_count_t nregions);
+	virtual bool write_next_region_impl(boost::shared_ptr< RegionEncoding > region);
+
 protected:
 	void init_metadata_empty();
 	void read_metadata_from_disk();
 	void write_partition_to_disk();
+	void finish_streamed_partition();
+
+	IndexIO::GlobalPartitionMetadata make_global_partition_metadata() const;
 
 protected:
 	// Default implementation of open calls init_metadata_empty()/read_metadata_from_disk as appropriate
@@ -154,6 +168,8 @@ private:
 		PartitionMetadata pmeta; // Just store this directly, since we're not doing anything fancy
 
 		std::vector<uint64_t> region_offsets; // Relative to partition, including skip over header. Last offset is partition end offset (i.e., nbins+1 offsets exist)
+		std::vector<uint64_t> region_element_counts; // Number of elements in each region (i.e., its get_element_count()), so counts can be answered without reading regions
+		std::vector<char> region_types; // RegionEncoding::Type of each region; only stored when pmeta.index_rep is HETEROGENEOUS
 
 	    friend class boost::serialization::access;
 	    template<class Archive> void serialize(Archive & ar, const unsigned int version);
@@ -165,6 +181,8 @@ private:
 	boost::optional< uint64_t > partition_offset_in_file; // Always set in read mode, set in write mode after a call to allocate_partition
 
 	std::vector< boost::shared_ptr< RegionEncoding > > regions_to_write; // Buffering from the write_regions function
+	boost::optional< region_count_t > streamed_region_count; // Set if regions are being streamed directly to disk
+	region_id_t next_streamed_region;
 
 	mutable IOStats region_io_stats;
 
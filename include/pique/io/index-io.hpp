@@ -37,7 +37,7 @@
 #include "pique/util/openclose.hpp"
 #include "pique/stats/stats.hpp"
 
-enum struct IndexOpenMode { NOT_OPEN, READ, WRITE, WRITE_APPEND };
+enum struct IndexOpenMode { NOT_OPEN, READ, WRITE, WRITE_APPEND }; // WRITE_APPEND: open an existing index to append partitions to it
 
 class IndexPartitionIO; // fwd decl.
 
@@ -59,6 +59,12 @@ public:
 	// Metadata pertaining to a particular index partition, but which is available without opening that partition
 	struct GlobalPartitionMetadata {
 		domain_t domain;
+
+		// Zone map (optional): the partition's representation type and a binning specification with only its extreme bins
+		// (see AbstractBinningSpecification::make_zone_map()), allowing queries to detect constraints matching none or all
+		// of the partition without opening it
+		boost::optional< RegionEncoding::Type >						index_rep;
+		boost::shared_ptr< const AbstractBinningSpecification >	zone_map;
 	};
 
 public:
@@ -114,7 +120,7 @@ public:
 
 protected:
 	IndexPartitionIO(boost::optional< partition_id_t > partition_id) :
-		openmode(IndexOpenMode::NOT_OPEN), partition_id(partition_id)
+		openmode(IndexOpenMode::NOT_OPEN), partition_id(partition_id), streamed_region_count(0)
 	{}
 
 public:
@@ -127,6 +133,7 @@ public:
 		boost::optional< RegionEncoding::Type	>	index_rep;
 		boost::shared_ptr< const IndexEncoding	>	index_enc;
 		boost::shared_ptr< const ABS			>	binning_spec;
+		boost::optional< Grid					>	grid; // The partition's subvolume and how its RIDs linearize it, if not row-major (see BinnedIndex::get_grid())
 
 		bool is_filled() {
 			return indexed_datatype && domain && index_rep && index_enc && binning_spec;
@@ -137,6 +144,7 @@ public:
 			index_rep = RegionEncoding::Type::UNKNOWN;
 			index_enc = nullptr;
 			binning_spec = nullptr;
+			grid = boost::none;
 		}
 		// Only updates values that are initialized in "other"
 		void update(const PartitionMetadata &other) {
@@ -145,6 +153,7 @@ public:
 			if (other.index_rep)		this->index_rep = other.index_rep;
 			if (other.index_enc)		this->index_enc = other.index_enc;
 			if (other.binning_spec)		this->binning_spec = other.binning_spec;
+			if (other.grid)				this->grid = other.grid;
 		}
 	};
 
@@ -169,6 +178,7 @@ public:
 	// Read API
 	partition_id_t get_partition_id() const { return *partition_id; }
 	uint64_t compute_regions_size(region_id_t lb, region_id_t ub); // [lb, ub)
+	uint64_t compute_regions_element_count(region_id_t lb, region_id_t ub); // [lb, ub), sum of get_element_count() over the regions, without reading them if the index records their counts
 	bool read_regions(const std::set< region_id_t > &regions_to_read, std::map< region_id_t, boost::shared_ptr< RegionEncoding > > &regions);
 
 	// === Write API: may only be called in write mode
@@ -176,6 +186,13 @@ public:
 	void set_domain_global_offset(domain_offset_t global_offset);
 	bool write_regions(const std::vector< boost::shared_ptr< RegionEncoding > > &regions);
 	bool write_index(BinnedIndex &index);
+	void set_index_metadata(const BinnedIndex &index); // Sets the partition metadata describing the index (as write_index() does), but writes no regions
+
+	// Streaming alternative to write_regions(): after the partition metadata is set, declares the number of regions, which
+	// must then be written one at a time, in order. Formats that can write each region out immediately do so, rather than
+	// holding them all until close()
+	bool begin_write_regions(region_count_t nregions);
+	bool write_next_region(boost::shared_ptr< RegionEncoding > region);
 
 protected:
 	// Always call up to these from derived classes
@@ -187,20 +204,43 @@ private:
 	virtual region_count_t get_num_regions_impl() = 0;
 
 	virtual uint64_t compute_regions_size_impl(region_id_t lb, region_id_t ub) = 0; // [lb, ub)
+	virtual uint64_t compute_regions_element_count_impl(region_id_t lb, region_id_t ub) = 0; // [lb, ub)
 	virtual bool read_regions_impl(const std::set< region_id_t > &regions_to_read, std::map< region_id_t, boost::shared_ptr< RegionEncoding > > &regions) = 0;
 
 	virtual void set_partition_metadata_impl(PartitionMetadata metadata) = 0;
 	virtual bool write_regions_impl(const std::vector< boost::shared_ptr< RegionEncoding > > &regions) = 0;
 
 protected:
+	// Default implementations buffer the streamed regions, passing them to write_regions_impl() once all have arrived
+	virtual bool begin_write_regions_impl(region_count_t nregions);
+	virtual bool write_next_region_impl(boost::shared_ptr< RegionEncoding > region);
+
 	void assign_partition_id(partition_id_t partition_id) { this->partition_id = partition_id; }
 
 private:
 	IndexOpenMode openmode;
 	boost::optional< partition_id_t > partition_id;
 
+	region_count_t streamed_region_count; // Buffering for the default streaming write implementation
+	std::vector< boost::shared_ptr< RegionEncoding > > streamed_regions;
+
 	friend class IndexIO;
 };
 
+// Streams an index's regions into a partition (open for writing) as they are finished (see IndexBuilder::build_index)
+class IndexPartitionRegionSink : public BinnedIndexRegionSink {
+public:
+	IndexPartitionRegionSink(boost::shared_ptr< IndexPartitionIO > partio) : partio(partio) {}
+
+	virtual bool begin_regions(const BinnedIndex &index_meta, BinnedIndexTypes::region_count_t nregions) {
+		partio->set_index_metadata(index_meta);
+		return partio->begin_write_regions(nregions);
+	}
+	virtual bool write_region(boost::shared_ptr< RegionEncoding > region) { return partio->write_next_region(region); }
+
+private:
+	boost::shared_ptr< IndexPartitionIO > partio;
+};
+
 #endif /* INDEX_IO_HPP_ */
 
@@ -24,6 +24,11 @@
 #define PARALLEL_INDEX_GENERATOR_IMPL_HPP_
 
 #include <algorithm>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <numeric>
+#include <utility>
 #include "pique/parallel/indexing/parallel-index-generator.hpp"
 
 template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
@@ -40,10 +45,57 @@ ParallelIndexGenerator<datatype_t, RegionEncoderT, BinningSpecificationT>::Paral
 	MPI_Comm_size(comm, &this->size);
 }
 
+// Reads a subset of a dataset fully into memory (as a dataset with the given grid), so it may be indexed without further I/O.
+// Called on a helper thread, so it touches only the dataset (no MPI or shared state), and returns its I/O stats rather than
+// accumulating them
+template<typename datatype_t>
+static auto read_partition_into_memory(const Dataset &data, GridSubset subset, Grid part_grid) -> std::pair< boost::shared_ptr< Dataset >, IOStats > {
+	boost::shared_ptr< DatasetStream< datatype_t > > datastream = boost::dynamic_pointer_cast< DatasetStream< datatype_t > >(data.open_stream(std::move(subset)));
+	assert(datastream);
+
+	const Dataset::dataset_length_t nelem = datastream->get_element_count();
+	std::vector< datatype_t > values;
+	values.reserve(nelem);
+	while (values.size() < nelem && datastream->has_next())
+		datastream->next(nelem - values.size(), values);
+	assert(values.size() == nelem && part_grid.get_npoints() == nelem);
+
+	const IOStats iostats = datastream->get_stats();
+	return std::make_pair(boost::make_shared< InMemoryDataset< datatype_t > >(std::move(values), std::move(part_grid)), iostats);
+}
+
 template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
 void
-ParallelIndexGenerator<datatype_t, RegionEncoderT, BinningSpecificationT>::generate_index(std::string indexio_path, const Dataset& data, Dataset::dataset_length_t subdomain_partition_size, bool dedicated_master, uint64_t subdomain_offset, uint64_t subdomain_size, bool relativize_subdoamin)
+ParallelIndexGenerator<datatype_t, RegionEncoderT, BinningSpecificationT>::index_partition(const Dataset &part_data, GridSubset part_subset, Dataset::dataset_offset_t part_domain_offset, bool zorder)
 {
+	// Build the index partition from the given subset of the dataset
+	boost::shared_ptr< BinnedIndex > part_index = zorder ?
+			this->index_builder.build_index_zo(part_data, std::move(part_subset)) :
+			this->index_builder.build_index(part_data, std::move(part_subset));
+
+	if (this->index_enc) {
+		assert(this->encode_setops);
+		part_index = IndexEncoding::get_encoded_index(this->index_enc, part_index, *this->encode_setops);
+	}
+
+	// Write this partition to parallel_indexio
+	boost::shared_ptr< IndexPartitionIO > partio = this->parallel_indexio.append_partition();
+	partio->set_domain_global_offset(part_domain_offset);
+	partio->write_index(*part_index);
+	partio->close();
+
+	// Update stats
+	stats.num_elements_indexed += part_index->get_domain_size();
+	++stats.num_partitions_indexed;
+	stats.indexio_stats += partio->get_io_stats();
+}
+
+template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
+void
+ParallelIndexGenerator<datatype_t, RegionEncoderT, BinningSpecificationT>::generate_index(std::string indexio_path, const Dataset& data, Dataset::dataset_length_t subdomain_partition_size, bool dedicated_master, uint64_t subdomain_offset, uint64_t subdomain_size, bool relativize_subdoamin, bool dynamic_assignment, bool prefetch_data, bool zorder)
+{
+	using partition_read_result_t = std::pair< boost::shared_ptr< Dataset >, IOStats >;
+
 	// Preliminary computations
 	const Dataset::dataset_length_t full_domain_size = data.get_element_count();
 	subdomain_size = std::min(subdomain_size, full_domain_size);
@@ -54,46 +106,115 @@ ParallelIndexGenerator<datatype_t, RegionEncoderT, BinningSpecificationT>::gener
 	const int num_indexing_ranks = this->size - (dedicated_master ? 1 : 0);
 	const int this_indexing_rank = this->rank - (dedicated_master && this->rank > MASTER_RANK ? 1 : 0); // Rank among indexing ranks (remove the master rank and shift all higher ranks down by 1)
 
+	// In Z-order, each partition must be a slab of whole rows of the grid
+	const Grid grid = data.get_grid();
+	const uint64_t row_size = std::accumulate(grid.begin() + 1, grid.end(), (uint64_t)1, std::multiplies< uint64_t >());
+	if (zorder && (subdomain_offset % row_size != 0 || subdomain_size % row_size != 0 || subdomain_partition_size % row_size != 0)) {
+		std::cerr << "Error: Z-order partitions must consist of whole rows of the grid (multiples of " << row_size << " elements)" << std::endl;
+		abort();
+	}
+
+	// The work queue for dynamic assignment needs MPI-3 one-sided communication
+	if (dynamic_assignment && !MPISharedCounter::is_supported()) {
+		if (this->rank == MASTER_RANK)
+			std::cerr << "Warning: this MPI library lacks MPI-3 one-sided communication, so partitions will be assigned statically" << std::endl;
+		dynamic_assignment = false;
+	}
+
+	// Prefetching an in-memory dataset would only add a copy
+	prefetch_data = prefetch_data && data.get_format() != Dataset::Format::INMEMORY;
+
+	// Computes the subset of "data" covered by a partition
+	auto get_partition_subset = [&](uint64_t partnum) -> GridSubset {
+		const Dataset::dataset_offset_t part_domain_offset = subdomain_offset + partnum * subdomain_partition_size;
+		const Dataset::dataset_offset_t part_domain_end_offset = std::min(part_domain_offset + subdomain_partition_size, subdomain_offset + subdomain_size);
+		const Dataset::dataset_length_t part_domain_size = part_domain_end_offset - part_domain_offset;
+		return GridSubset(grid, part_domain_offset, part_domain_size);
+	};
+	// Computes the grid of a partition once read into memory (its slab of the grid in Z-order, otherwise a 1D grid)
+	auto get_partition_grid = [&](uint64_t partnum) -> Grid {
+		const Dataset::dataset_length_t part_domain_size = get_partition_subset(partnum).get_ranges()[0].second;
+		if (!zorder)
+			return Grid{part_domain_size};
+
+		std::vector< uint64_t > part_dims(grid.begin(), grid.end());
+		part_dims[0] = part_domain_size / row_size;
+		return Grid(std::move(part_dims));
+	};
+	auto get_partition_global_offset = [&](uint64_t partnum) -> Dataset::dataset_offset_t {
+		return subdomain_offset + partnum * subdomain_partition_size - (relativize_subdoamin ? subdomain_offset : 0);
+	};
+
 	TIME_STATS_TIME_BEGIN(stats.total_time)
 
+	// The work queue: the ID of the next partition to be indexed, hosted on the master rank (created collectively, even if unused)
+	MPISharedCounter next_partnum(this->comm, MASTER_RANK);
+
+	// Returns the next partition assigned to this rank, if any remain
+	uint64_t next_static_partnum = this_indexing_rank;
+	auto take_next_partition = [&]() -> boost::optional< uint64_t > {
+		uint64_t partnum;
+		if (dynamic_assignment) {
+			TIME_STATS_TIME_BEGIN(stats.work_queue_time)
+			partnum = next_partnum.fetch_and_add(1);
+			TIME_STATS_TIME_END()
+		} else {
+			partnum = next_static_partnum;
+			next_static_partnum += num_indexing_ranks;
+		}
+		return partnum < num_partitions ? boost::make_optional(partnum) : boost::none;
+	};
+
 	// Open the indexio
 	this->parallel_indexio.open(indexio_path, IndexOpenMode::WRITE);
 
 	if (dedicated_master && this->rank == MASTER_RANK) {
 		// If we are the dedicated master process, close the index immediately.
 		// This will force dedicated MPI message waiting until all other ranks close.
+		TIME_STATS_TIME_BEGIN(stats.idle_time)
 		this->parallel_indexio.close();
-	} else {
+		TIME_STATS_TIME_END()
+	} else if (!prefetch_data) {
 		// In any other case, we are an indexing process, so index stuff
-		for (uint64_t partnum = this_indexing_rank; partnum < num_partitions; partnum += num_indexing_ranks) {
-			// Compute domain bounds
-			const Dataset::dataset_offset_t part_domain_offset = subdomain_offset + partnum * subdomain_partition_size;
-			const Dataset::dataset_offset_t part_domain_end_offset = std::min(part_domain_offset + subdomain_partition_size, subdomain_size);
-			const Dataset::dataset_length_t part_domain_size = part_domain_end_offset - part_domain_offset;
-
-			// Build the index partition from the subset of the dataset computed above
-			const GridSubset subset(data.get_grid(), part_domain_offset, part_domain_size);
-			boost::shared_ptr< BinnedIndex > part_index = this->index_builder.build_index(data, subset);
-
-			if (this->index_enc) {
-				assert(this->encode_setops);
-				part_index = IndexEncoding::get_encoded_index(this->index_enc, part_index, *this->encode_setops);
-			}
-
-			// Write this partition to parallel_indexio
-			boost::shared_ptr< IndexPartitionIO > partio = this->parallel_indexio.append_partition();
-			partio->set_domain_global_offset(part_domain_offset - (relativize_subdoamin ? subdomain_offset : 0));
-			partio->write_index(*part_index);
-			partio->close();
-
-			// Update stats
-			stats.num_elements_indexed += part_domain_size;
-			++stats.num_partitions_indexed;
-			stats.indexio_stats += partio->get_io_stats();
+		while (boost::optional< uint64_t > partnum = take_next_partition())
+			this->index_partition(data, get_partition_subset(*partnum), get_partition_global_offset(*partnum), zorder);
+
+		// Close the indexio to finalize the file (this waits for all other ranks to finish indexing)
+		TIME_STATS_TIME_BEGIN(stats.idle_time)
+		this->parallel_indexio.close();
+		TIME_STATS_TIME_END()
+	} else {
+		// As above, but double-buffered: a helper thread reads the next partition assigned to this rank into memory
+		// while the current one is indexed and written out (all MPI calls remain on this thread)
+		auto start_partition_read = [&](uint64_t partnum) -> std::future< partition_read_result_t > {
+			return std::async(std::launch::async, read_partition_into_memory< datatype_t >, std::cref(data), get_partition_subset(partnum), get_partition_grid(partnum));
+		};
+
+		boost::optional< uint64_t > partnum = take_next_partition();
+		std::future< partition_read_result_t > partition_read;
+		if (partnum)
+			partition_read = start_partition_read(*partnum);
+
+		while (partnum) {
+			// Claim the following partition now, so its read can start as soon as this one's completes
+			const boost::optional< uint64_t > next_partnum = take_next_partition();
+
+			partition_read_result_t part_data;
+			TIME_STATS_TIME_BEGIN(stats.prefetch_wait_time)
+			part_data = partition_read.get();
+			TIME_STATS_TIME_END()
+			stats.dataread_stats += part_data.second;
+
+			if (next_partnum)
+				partition_read = start_partition_read(*next_partnum);
+
+			this->index_partition(*part_data.first, GridSubset(part_data.first->get_grid()), get_partition_global_offset(*partnum), zorder);
+			partnum = next_partnum;
 		}
 
-		// Close the indexio to finalize the file
+		TIME_STATS_TIME_BEGIN(stats.idle_time)
 		this->parallel_indexio.close();
+		TIME_STATS_TIME_END()
 	}
 
 	TIME_STATS_TIME_END()
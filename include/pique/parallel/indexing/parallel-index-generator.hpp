@@ -32,6 +32,7 @@
 #include "pique/encoding/index-encoding.hpp"
 #include "pique/io/index-io.hpp"
 #include "pique/parallel/io/mpi-index-io.hpp"
+#include "pique/parallel/util/mpi-shared-counter.hpp"
 #include "pique/setops/setops.hpp"
 #include "pique/stats/stats.hpp"
 
@@ -42,6 +43,10 @@ struct ParallelIndexingStats {
 	Dataset::dataset_length_t num_elements_indexed{0};
 
 	TimeStats total_time;
+	TimeStats work_queue_time; // Time spent obtaining partition assignments from the work queue
+	TimeStats idle_time; // Time spent after running out of partitions to index, waiting for all ranks to finish and the index to be finalized
+	TimeStats prefetch_wait_time; // Time spent waiting for prefetched partition data (i.e., dataset reads not overlapped with indexing)
+	IOStats dataread_stats; // Dataset reads performed by the prefetching thread (otherwise counted in indexing_stats)
 	IndexBuilderStats indexing_stats;
 	IOStats indexio_stats;
 	MPIIndexIOStats mpistats;
@@ -49,7 +54,9 @@ struct ParallelIndexingStats {
 
 DEFINE_STATS_SERIALIZE(ParallelIndexingStats, stats, \
 	stats.num_partitions_indexed & stats.num_elements_indexed & \
-	stats.total_time & stats.indexing_stats & stats.indexio_stats & stats.mpistats);
+	stats.total_time & stats.work_queue_time & stats.idle_time & \
+	stats.prefetch_wait_time & stats.dataread_stats & \
+	stats.indexing_stats & stats.indexio_stats & stats.mpistats);
 
 template<typename datatype_t, typename RegionEncoderT, typename BinningSpecificationT>
 class ParallelIndexGenerator {
@@ -70,21 +77,33 @@ public:
 	 * data: the dataset to index
 	 * domain_partition_size: the (maximum) number of elements per partition to index (all partitions will be of this size, except possibly the last)
 	 * dedicated_master: if true, one MPI rank will not perform indexing, instead solely directing the allocation of partitions to other ranks for indexing
+	 * dynamic_assignment: if true, partitions are handed out on demand from a shared work queue, so faster ranks index more partitions;
+	 *                     if false, partitions are assigned statically, round-robin among indexing ranks (default true). Dynamic assignment
+	 *                     requires MPI-3 one-sided communication; without it, assignment is static regardless
+	 * prefetch_data: if true, each rank reads its next partition's data on a helper thread while indexing and writing the current one,
+	 *                overlapping dataset I/O with computation (ignored for in-memory datasets) (default true)
 	 * subdomain_offset: the offset of the first element in "data" to index (default 0)
 	 * subdomain_size: the maximum number of elements in "data" to index (default max uint64_t)
 	 * relativize_subdomain: if true, the subdomain specified by subdomain_offset/subdomain_size is treated as the whole domain; that is, element
 	 *                       "subdomain_offset" in "data" is considered RID 0; if false, RIDs correspond to positions in the full "data" dataset (default true)
+	 * zorder: if true, each partition is indexed in Z-order over its slab of the grid (see IndexBuilder::build_index_zo), rather than in row-major
+	 *         order; subdomain_offset, subdomain_size and domain_partition_size must then be multiples of the grid's row size (the product of
+	 *         all but its first dimension), so that every partition is a slab of whole rows (default false)
 	 *
 	 * This function will index elements [subdomain_offset, subdomain_offset + subdomain_size) intersect [0, data.get_element_count()), which will
 	 * correspond to RIDs [subdomain_offset, subdomain_offset + min(subdomain_size, data.get_element_count())) (if relativize_domain is true), or
 	 * RIDs [0, min(subdomain_size, data.get_element_count())) (if relativize_domain is false).
 	 */
     void generate_index(std::string indexio_path, const Dataset &data, Dataset::dataset_length_t domain_partition_size, bool dedicated_master = false,
-    		uint64_t subdomain_offset = 0, uint64_t subdomain_size = std::numeric_limits<uint64_t>::max(), bool relativize_subdoamin = true);
+    		uint64_t subdomain_offset = 0, uint64_t subdomain_size = std::numeric_limits<uint64_t>::max(), bool relativize_subdoamin = true,
+    		bool dynamic_assignment = true, bool prefetch_data = true, bool zorder = false);
 
     ParallelIndexingStats get_stats() const { return stats; }
     void reset_stats() { stats = ParallelIndexingStats(); }
 
+private:
+    void index_partition(const Dataset &part_data, GridSubset part_subset, Dataset::dataset_offset_t part_domain_offset, bool zorder);
+
 private:
     static constexpr int MASTER_RANK = 0;
 private:
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * mpi-shared-counter.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#ifndef MPI_SHARED_COUNTER_HPP_
+#define MPI_SHARED_COUNTER_HPP_
+
+#include "config.h" // include Autoconf config.h to get HAVE_MPI_RMA
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mpi.h>
+
+/*
+ * A 64-bit counter hosted in an MPI window on one rank, which any rank in the communicator may
+ * atomically fetch-and-increment using passive-target RMA (i.e., without the host rank's participation).
+ * Construction and destruction are collective over the communicator.
+ *
+ * Requires MPI-3 one-sided communication (detected by configure as HAVE_MPI_RMA); without it, is_supported()
+ * returns false, and construction and destruction do nothing, but fetch_and_add aborts.
+ */
+class MPISharedCounter {
+public:
+	static constexpr bool is_supported() {
+#ifdef HAVE_MPI_RMA
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	MPISharedCounter(MPI_Comm comm, int hostrank = 0, uint64_t initial_value = 0) :
+		hostrank(hostrank), counter(nullptr), win(MPI_WIN_NULL)
+	{
+#ifdef HAVE_MPI_RMA
+		int rank;
+		MPI_Comm_rank(comm, &rank);
+
+		const MPI_Aint winsize = (rank == hostrank ? sizeof(uint64_t) : 0);
+		MPI_Win_allocate(winsize, sizeof(uint64_t), MPI_INFO_NULL, comm, &this->counter, &this->win);
+
+		if (rank == hostrank) {
+			MPI_Win_lock(MPI_LOCK_EXCLUSIVE, hostrank, 0, this->win);
+			*this->counter = initial_value;
+			MPI_Win_unlock(hostrank, this->win);
+		}
+
+		MPI_Barrier(comm); // Ensure the counter is initialized before any rank increments it
+#endif
+	}
+	~MPISharedCounter() {
+#ifdef HAVE_MPI_RMA
+		MPI_Win_free(&this->win);
+#endif
+	}
+
+	MPISharedCounter(const MPISharedCounter &) = delete;
+	MPISharedCounter & operator=(const MPISharedCounter &) = delete;
+
+	// Atomically adds increment to the counter, returning its value prior to the addition
+	uint64_t fetch_and_add(uint64_t increment = 1) {
+#ifdef HAVE_MPI_RMA
+		uint64_t old_value;
+		MPI_Win_lock(MPI_LOCK_SHARED, this->hostrank, 0, this->win);
+		MPI_Fetch_and_op(&increment, &old_value, MPI_UINT64_T, this->hostrank, 0, MPI_SUM, this->win);
+		MPI_Win_unlock(this->hostrank, this->win);
+		return old_value;
+#else
+		std::cerr << "Error: MPISharedCounter requires MPI-3 one-sided communication, which this MPI library lacks" << std::endl;
+		abort();
+		return 0;
+#endif
+	}
+
+private:
+	const int hostrank;
+	uint64_t *counter;
+	MPI_Win win;
+};
+
+#endif /* MPI_SHARED_COUNTER_HPP_ */
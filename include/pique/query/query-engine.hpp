@@ -39,15 +39,17 @@
 struct QueryEngineOptions {
 	enum struct ComplementMode { AUTO, ALWAYS, NEVER };
 
-	QueryEngineOptions(ComplementMode complement_mode = ComplementMode::AUTO) :
-		complement_mode(complement_mode)
+	QueryEngineOptions(ComplementMode complement_mode = ComplementMode::AUTO, bool rewrite_queries = true) :
+		complement_mode(complement_mode), rewrite_queries(rewrite_queries)
 	{}
 
 	void dump(std::ostream &out = std::cout) const {
 		out << "Complement bin merge mode: " << (complement_mode == ComplementMode::AUTO ? "auto" : complement_mode == ComplementMode::ALWAYS ? "always" : "never") << std::endl;
+		out << "Query rewriting: " << (rewrite_queries ? "on" : "off") << std::endl;
 	}
 
 	ComplementMode complement_mode;
+	bool rewrite_queries; // Apply QueryRewriter before evaluation (see query-rewriter.hpp)
 };
 
 class QueryEngine : public OpenableCloseable< boost::shared_ptr< Database > > {
@@ -62,19 +64,21 @@ public:
 		virtual ~TermEvalStats() {}
 		std::string name;
 		TimeStats total;
-		uint64_t output_region_bytes;
+		uint64_t output_region_bytes{0};
 	};
 	struct ConstraintTermEvalStats : public TermEvalStats {
 		virtual ~ConstraintTermEvalStats() {}
-		bin_id_t lb_bin; // [lb_bin, ub_bin)
-		bin_id_t ub_bin;
+		bin_id_t lb_bin{0}; // [lb_bin, ub_bin) (for a multi-range variable expression, the hull of its bin ranges)
+		bin_id_t ub_bin{0};
 
-		bool forced_complement_binmerge_mode;
-		bool used_complement_binmerge;
-		uint64_t used_bincount;
-		uint64_t used_binbytes;
-		uint64_t other_bincount;
-		uint64_t other_binbytes;
+		bool zone_map_pruned{false}; // Result determined from the partition zone map alone (lb_bin/ub_bin not computed)
+
+		bool forced_complement_binmerge_mode{false};
+		bool used_complement_binmerge{false};
+		uint64_t used_bincount{0};
+		uint64_t used_binbytes{0};
+		uint64_t other_bincount{0};
+		uint64_t other_binbytes{0};
 
 		IOStats binread;
 
@@ -83,14 +87,15 @@ public:
 	};
 	struct MultivarTermEvalStats : public TermEvalStats {
 		virtual ~MultivarTermEvalStats() {}
-		uint64_t arity;
-		uint64_t in_regions_bytes;
+		uint64_t arity{0};
+		uint64_t in_regions_bytes{0};
 	};
 	struct QueryStats {
 		TimeStats total;
 		IOStats iototal;
 		TimeStats decodetotal; // Index decoding for each constraint
 		TimeStats setopstotal; // Combining of constraints into final result
+		uint64_t constraints_skipped = 0; // Constraints left unevaluated due to short-circuiting (e.g., intersection with an empty region)
 		std::vector< boost::shared_ptr< TermEvalStats > > terminfos;
 	};
 	struct QuerySummaryStats : public BaseStats< QuerySummaryStats > {
@@ -114,18 +119,24 @@ public:
 		domain_t partition_domain;
 		QueryStats stats;
 		boost::shared_ptr< RegionEncoding > result;
+
+		// Streams the result's RIDs in batches, offset into the global domain (i.e., by partition_domain.first),
+		// without materializing them all at once; the iterator keeps the result region alive
+		boost::shared_ptr< RIDBatchIterator > make_rid_iterator() const;
 	};
 
-	class QueryCursor {
+	// Cursor over the per-domain results of a query (ResultT == QueryPartitionResult) or a query batch (ResultT == std::vector< QueryPartitionResult >)
+	template<typename ResultT>
+	class BasicQueryCursor {
 	public:
-		QueryCursor(domain_id_t cur_domain, domain_id_t end_domain, domain_id_t domain_step = 1) :
+		BasicQueryCursor(domain_id_t cur_domain, domain_id_t end_domain, domain_id_t domain_step = 1) :
 			cur_domain(cur_domain), end_domain(end_domain), domain_step(domain_step) {}
-		virtual ~QueryCursor() {}
+		virtual ~BasicQueryCursor() {}
 
 		bool has_next() { return cur_domain < end_domain && this->has_next_impl(); }
-		QueryPartitionResult next() {
+		ResultT next() {
 			if (!this->has_next()) abort();
-			QueryPartitionResult result = this->next_impl();
+			ResultT result = this->next_impl();
 			this->cur_domain += domain_step;
 			return result;
 		}
@@ -138,12 +149,15 @@ public:
 
 	private:
 		virtual bool has_next_impl() { return true; }
-		virtual QueryPartitionResult next_impl() = 0;
+		virtual ResultT next_impl() = 0;
 
 	private:
 		domain_id_t cur_domain, end_domain, domain_step;
 	};
 
+	using QueryCursor = BasicQueryCursor< QueryPartitionResult >;
+	using BatchQueryCursor = BasicQueryCursor< std::vector< QueryPartitionResult > >;
+
 public:
 	QueryEngine(QueryEngineOptions options = QueryEngineOptions()) : options(options), database(nullptr) {}
 	virtual ~QueryEngine() { this->close(); }
@@ -151,6 +165,18 @@ public:
 	boost::shared_ptr< RegionEncoding > evaluate(const Query &query, domain_id_t domain_id, QueryStats &qstats);
 	boost::shared_ptr< QueryCursor > evaluate(const Query &query, domain_id_t begin_domain_id = 0, domain_id_t end_domain_id = std::numeric_limits< domain_id_t >::max());
 
+	// Evaluates a batch of queries together; the cursor yields, per domain, one QueryPartitionResult per query (in batch order).
+	// Engines may share work between the queries of a batch (e.g., reading each region once, or evaluating repeated constraints
+	// once), so result regions may be shared between queries, and constraint I/O stats are attributed to only one of them
+	boost::shared_ptr< BatchQueryCursor > evaluate_batch(const std::vector< Query > &queries, domain_id_t begin_domain_id = 0, domain_id_t end_domain_id = std::numeric_limits< domain_id_t >::max());
+
+	// Aggregate queries, answered from index metadata where possible (rather than by materializing result regions)
+	// count: returns the total number of elements matched by the query over the given domains
+	// histogram: returns, for each bucket i, the number of elements of the variable falling in bins whose keys lie
+	//            in [bucket_bounds[i], bucket_bounds[i+1]) (so bucket_bounds must be ascending, and yields bucket_bounds.size() - 1 counts)
+	uint64_t count(const Query &query, domain_id_t begin_domain_id = 0, domain_id_t end_domain_id = std::numeric_limits< domain_id_t >::max());
+	std::vector< uint64_t > histogram(std::string varname, const std::vector< UniversalValue > &bucket_bounds, domain_id_t begin_domain_id = 0, domain_id_t end_domain_id = std::numeric_limits< domain_id_t >::max());
+
 	void reset_timings();
 	QuerySummaryStats get_timings() const;
 
@@ -160,6 +186,12 @@ protected:
 
 private:
 	virtual boost::shared_ptr< QueryCursor > evaluate_impl(const Query &query, domain_id_t begin_domain_id, domain_id_t end_domain_id) = 0;
+	virtual std::vector< uint64_t > histogram_impl(std::string varname, const std::vector< UniversalValue > &bucket_bounds, domain_id_t begin_domain_id, domain_id_t end_domain_id) = 0;
+
+protected:
+	// May be called up to by derived classes as a fallback
+	virtual uint64_t count_impl(const Query &query, domain_id_t begin_domain_id, domain_id_t end_domain_id); // Default: evaluate the query and count the result elements
+	virtual boost::shared_ptr< BatchQueryCursor > evaluate_batch_impl(const std::vector< Query > &queries, domain_id_t begin_domain_id, domain_id_t end_domain_id); // Default: evaluate each query independently, in lockstep
 
 protected:
 	const QueryEngineOptions options;
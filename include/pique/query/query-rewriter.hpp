@@ -0,0 +1,39 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * query-rewriter.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#ifndef QUERY_REWRITER_HPP_
+#define QUERY_REWRITER_HPP_
+
+#include "pique/query/query.hpp"
+
+// Rewrites a Query into an equivalent one that is cheaper to evaluate:
+// - Complements of multi-variable INTERSECTIONs/UNIONs are pushed down to their operands (De Morgan's laws)
+// - Nested INTERSECTION/UNION operators are flattened into single higher-arity operators
+// - Operands of an INTERSECTION/UNION that constrain the same variable are grouped together
+// - Every maximal subexpression involving only a single variable (e.g., "x>1 AND x<5", or "NOT x<5") becomes a
+//   VariableExpressionTerm, which is evaluated as a set of bin ranges (so its set operations, including complement,
+//   cost nothing beyond reading the bins)
+class QueryRewriter {
+public:
+	static Query rewrite(const Query &query);
+};
+
+#endif /* QUERY_REWRITER_HPP_ */
@@ -29,6 +29,7 @@
 #include <boost/smart_ptr.hpp>
 #include <boost/make_shared.hpp>
 
+#include "pique/data/grid.hpp"
 #include "pique/region/region-encoding.hpp"
 #include "pique/setops/setops.hpp"
 #include "pique/io/database.hpp"
@@ -50,6 +51,20 @@ struct ConstraintTerm : public QueryTerm {
 	UniversalValue lower_bound, upper_bound;
 };
 
+// Selects the elements of a variable's grid within the subvolume [subvolume_offsets, subvolume_offsets + subvolume_dims),
+// regardless of their values. The variable supplies the grid (from its dataset metadata) and the partitioning; each index
+// partition records how its RIDs linearize the grid (see BinnedIndex::get_grid())
+struct SpatialConstraintTerm : public QueryTerm {
+	SpatialConstraintTerm(std::string varname, std::vector< uint64_t > subvolume_offsets, std::vector< uint64_t > subvolume_dims) :
+		varname(varname), subvolume_offsets(std::move(subvolume_offsets)), subvolume_dims(std::move(subvolume_dims))
+	{}
+
+	virtual std::string to_string();
+
+	std::string varname;
+	std::vector< uint64_t > subvolume_offsets, subvolume_dims;
+};
+
 struct UnaryOperatorTerm : public QueryTerm {
 	UnaryOperatorTerm(UnarySetOperation op) : op(op) {}
 
@@ -89,4 +104,17 @@ public:
 Query operator&(const Query &left, const Query &right);
 Query operator|(const Query &left, const Query &right);
 
+// A boolean combination of constraints on a single variable (RPN over ConstraintTerms on varname and operator terms),
+// produced by QueryRewriter so the combination can be evaluated directly as a set of bin ranges, rather than by set operations
+struct VariableExpressionTerm : public QueryTerm {
+	VariableExpressionTerm(std::string varname, Query expr) :
+		varname(varname), expr(std::move(expr))
+	{}
+
+	virtual std::string to_string();
+
+	std::string varname;
+	Query expr;
+};
+
 #endif /* QUERY_HPP_ */
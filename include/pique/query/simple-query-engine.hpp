@@ -25,6 +25,8 @@
 
 #include <string>
 #include <set>
+#include <map>
+#include <tuple>
 #include <unordered_map>
 
 #include "pique/encoding/region-math.hpp"
@@ -49,12 +51,19 @@ public:
 
 	void clear_cache() { this->iocache->release_all(); }
 
+	// Returns the query as it will actually be evaluated (i.e., rewritten by QueryRewriter, if enabled in the options)
+	Query prepare_query(const Query &query) const;
+
 protected:
 	virtual bool open_impl(boost::shared_ptr< Database > db);
 	virtual bool close_impl();
 
 private:
 	virtual boost::shared_ptr< QueryCursor > evaluate_impl(const Query &query, domain_id_t begin_domain_id, domain_id_t end_domain_id);
+	virtual boost::shared_ptr< BatchQueryCursor > evaluate_batch_impl(const std::vector< Query > &queries, domain_id_t begin_domain_id, domain_id_t end_domain_id);
+
+	virtual uint64_t count_impl(const Query &query, domain_id_t begin_domain_id, domain_id_t end_domain_id);
+	virtual std::vector< uint64_t > histogram_impl(std::string varname, const std::vector< UniversalValue > &bucket_bounds, domain_id_t begin_domain_id, domain_id_t end_domain_id);
 
 protected:
 	using bin_id_t = BinnedIndexTypes::bin_id_t;
@@ -62,28 +71,50 @@ protected:
 	using region_id_t = BinnedIndexTypes::region_id_t;
 	using RegionMap = std::map< region_id_t, boost::shared_ptr< RegionEncoding > >;
 
-	// Wrapper describing an invocation of evaluate_constraint that can be evaluated at a later time
+	using bin_id_ranges_t = std::vector< bin_id_range_t >; // Sorted, disjoint, non-empty bin ranges
+	using rid_ranges_t = std::vector< std::pair< uint64_t, uint64_t > >; // Sorted, disjoint (first RID, length) ranges
+
+	// The evaluation plan for a univariate constraint at a partition, produced while estimating its cost, so that evaluating
+	// the constraint afterward reuses its open partition (and header), bin ranges and RegionMath rather than recomputing them
+	struct ConstraintPlan {
+		boost::shared_ptr< IndexPartitionIO > partio; // nullptr if there is no plan (e.g., the zone map decided the constraint)
+		bin_id_ranges_t bin_ranges;
+		RegionMath::RegionMath rmath; // Empty if the bin ranges are empty or completely covering
+		ConstraintTermEvalStats terminfo; // Bin range and complement decisions made while planning
+	};
+
+	// Wrapper describing an invocation of evaluate_constraint that can be evaluated at a later time. The term is a
+	// univariate query term: a ConstraintTerm, a VariableExpressionTerm or a SpatialConstraintTerm.
 	struct DeferredConstraintEvaluator {
-		DeferredConstraintEvaluator(const ConstraintTerm &constr, const SimpleQueryEngine &qe) :
-			constr(constr), qe(qe) {}
+		DeferredConstraintEvaluator(const QueryTerm &term, std::string varname, const SimpleQueryEngine &qe) :
+			term(term), varname(std::move(varname)), qe(qe) {}
 
-		boost::shared_ptr< RegionEncoding > operator()(partition_id_t part, ConstraintTermEvalStats &terminfo) const {
-			return qe.evaluate_constraint_at_partition(constr, part, terminfo);
+		boost::shared_ptr< RegionEncoding > operator()(partition_id_t part, ConstraintTermEvalStats &terminfo, const ConstraintPlan *plan = nullptr) const {
+			return qe.evaluate_constraint_at_partition(term, varname, part, terminfo, plan);
 		}
 
-		const ConstraintTerm &constr;
+		const QueryTerm &term;
+		std::string varname;
 		const SimpleQueryEngine &qe;
 	};
 
+	// Identifies identical constraints (variable, lower bound, upper bound), for deduplicating them across the queries of a batch
+	// (other univariate terms, such as variable expressions, are deduplicated per partition by their bin ranges instead)
+	using ConstraintKey = std::tuple< std::string, UniversalValue, UniversalValue >;
+	using ConstraintIDMap = std::map< ConstraintKey, region_id_t >;
+
 	using RegionEncodingPtrCIter = typename std::vector< boost::shared_ptr< RegionEncoding > >::const_iterator;
 	using MutabilityCIter = typename std::vector< int >::const_iterator;
 
 private:
 	// Virtual delegate functions to be implemented by derived classes
 
-	// Perform query plan optimization on (default implementation: do nothing)
+	// Perform query plan optimization on (default implementation: do nothing for constraint RegionMath; for query RegionMath,
+	// order the operands of each intersection by estimated constraint cost, so that cheap, selective constraints are evaluated
+	// first and an empty result can skip the rest). If plans is given, it receives the plan made for each constraint (by
+	// constraint ID) while estimating its cost.
 	virtual void optimize_constraint_region_math(IndexPartitionIO &partio, RegionMath::RegionMath &rmath) const {}
-	virtual void optimize_query_region_math(const std::vector< DeferredConstraintEvaluator > &constraints, const std::vector< partition_id_t > &constraint_partitions, RegionMath::RegionMath &rmath) const {}
+	virtual void optimize_query_region_math(const std::vector< DeferredConstraintEvaluator > &constraints, const std::vector< partition_id_t > &constraint_partitions, RegionMath::RegionMath &rmath, std::vector< ConstraintPlan > *plans = nullptr) const;
 
 	// Estimates the cost of evaluating a given RegionMath, including I/O and setops cost
 	virtual uint64_t compute_constraint_evaluation_cost(IndexPartitionIO &partio, const RegionMath::RegionMath &rmath) const;
@@ -96,26 +127,99 @@ protected:
 
 	// Uses BinningSpecification quantization to convert bound values to bound bins
 	bin_id_range_t compute_bin_range(IndexPartitionIO &partio, const ConstraintTerm &constraint) const;
+	static bin_id_range_t compute_bin_range_for_binning(const AbstractBinningSpecification &binning_spec, const ConstraintTerm &constraint);
+
+	// As above, but for a univariate term (ConstraintTerm or VariableExpressionTerm), whose set operations are applied to the bin ranges
+	bin_id_ranges_t compute_bin_ranges(IndexPartitionIO &partio, const QueryTerm &term) const;
+	static bin_id_ranges_t compute_bin_ranges_for_binning(const AbstractBinningSpecification &binning_spec, const QueryTerm &term);
 
 	// Uses IndexEncoding to produce two alternate evaluation plans, complement
 	// and no-complement, and chooses the one with lesser cost (based on the
 	// cost metric of this->compute_constraint_evaluation_cost()).
 	RegionMath::RegionMath compute_optimal_region_math_for_bin_range(IndexPartitionIO &partio, bin_id_range_t bin_range, ConstraintTermEvalStats &terminfo) const;
 
+	// As above, for each of several bin ranges, taking the union of the results (terminfo bin counts/bytes are summed over the ranges)
+	RegionMath::RegionMath compute_optimal_region_math_for_bin_ranges(IndexPartitionIO &partio, const bin_id_ranges_t &bin_ranges, ConstraintTermEvalStats &terminfo) const;
+
 private:
 	// Implementation helper functions
 
-	// Evaluates a single constraint to RegionEncoding
-	boost::shared_ptr< RegionEncoding > evaluate_constraint_at_partition(const ConstraintTerm &cqt, partition_id_t partition, ConstraintTermEvalStats &terminfo) const;
+	// Checks a constraint against a partition's zone map (from the index footer, so the partition need not be opened).
+	// Returns false/true if the constraint matches none/all of the partition (also outputting the partition's domain
+	// size and representation type, for constructing a uniform result), or boost::none if undetermined or no zone map exists.
+	boost::optional< bool > match_constraint_zone_map(const ConstraintTerm &cqt, partition_id_t partition, uint64_t &domain_size, RegionEncoding::Type &index_rep) const;
+
+	// As above, for a univariate term, combining the zone map matches of its constraints with three-valued logic
+	// (for a spatial constraint, whether its subvolume covers none/all of the partition)
+	boost::optional< bool > match_term_zone_map(const QueryTerm &term, partition_id_t partition, uint64_t &domain_size, RegionEncoding::Type &index_rep) const;
+
+	// Computes the RIDs (relative to the partition) selected by a spatial constraint at a partition, also outputting the
+	// partition's domain size and representation type. The RIDs follow the partition's grid, if its metadata records one
+	// (e.g., a Z-order index over a box of the variable's grid), or else are row-major offsets into the variable's grid.
+	rid_ranges_t compute_spatial_constraint_rid_ranges(const SpatialConstraintTerm &sct, partition_id_t partition, uint64_t &domain_size, RegionEncoding::Type &index_rep) const;
+
+	// Estimates the cost of evaluating a constraint at a partition from index metadata only (zone maps and region sizes, via
+	// compute_constraint_evaluation_cost()), for ordering constraints. Constraints known to produce an empty result cost 0,
+	// and those known to produce a full result cost the maximum. Outputs the plan made for the constraint along the way.
+	uint64_t estimate_constraint_cost(const DeferredConstraintEvaluator &constraint, partition_id_t partition, ConstraintPlan &plan) const;
+
+	// Evaluates a single univariate term (ConstraintTerm, VariableExpressionTerm or SpatialConstraintTerm) on the given variable to RegionEncoding,
+	// following the given plan for it, if any
+	boost::shared_ptr< RegionEncoding > evaluate_constraint_at_partition(const QueryTerm &term, const std::string &varname, partition_id_t partition, ConstraintTermEvalStats &terminfo, const ConstraintPlan *plan = nullptr) const;
+
+	// Evaluates a spatial constraint by building its region directly in the partition's representation, without reading the index
+	boost::shared_ptr< RegionEncoding > evaluate_spatial_constraint_at_partition(const SpatialConstraintTerm &sct, partition_id_t partition, ConstraintTermEvalStats &terminfo) const;
+
+	// Evaluates distinct constraints at their respective partitions, reading the regions needed by all constraints on the same
+	// (variable, partition) index together so that each region is read once. Shared region reads are attributed to the stats
+	// of the first constraint on each index. Univariate terms with identical bin ranges on the same index (e.g., equivalent
+	// rewritten variable expressions) are evaluated once. Outputs one result and one stats object per constraint (shared
+	// between such identical terms).
+	void evaluate_constraints_at_partitions(
+			const std::vector< DeferredConstraintEvaluator > &constraints,
+			const std::vector< partition_id_t > &constraint_partitions,
+			std::vector< boost::shared_ptr< RegionEncoding > > &results,
+			std::vector< boost::shared_ptr< ConstraintTermEvalStats > > &stats) const;
+
+	// Returns an empty/full region if a set of bin ranges is empty/completely covering, or nullptr otherwise
+	boost::shared_ptr< RegionEncoding > make_uniform_result_for_bin_ranges(IndexPartitionIO &partio, const bin_id_ranges_t &bin_ranges) const;
+
+	// Evaluates a set of bin ranges to RegionEncoding (the part of evaluate_constraint_at_partition after bin range computation)
+	boost::shared_ptr< RegionEncoding > evaluate_bin_ranges_at_partition(IndexPartitionIO &partio, const bin_id_ranges_t &bin_ranges, ConstraintTermEvalStats &terminfo) const;
+
+	// Reads the regions of a constraint's RegionMath from a partition, and evaluates it (the part of evaluate_bin_ranges_at_partition after planning)
+	boost::shared_ptr< RegionEncoding > evaluate_region_math_at_partition(IndexPartitionIO &partio, const RegionMath::RegionMath &rmath, ConstraintTermEvalStats &terminfo) const;
+
+	// Counts the elements in a range of bins. For equality-encoded indexes, this uses only the per-region
+	// element counts stored in the partition metadata; otherwise, the bin range is evaluated and counted.
+	uint64_t count_bin_range_at_partition(IndexPartitionIO &partio, bin_id_range_t bin_range) const;
+
+	// Returns the partition IDs for a variable corresponding to the domain IDs [begin_domain_id, end_domain_id)
+	std::vector< partition_id_t > get_partitions_in_domain_range(std::string varname, domain_id_t begin_domain_id, domain_id_t end_domain_id) const;
 
 	// Converts a Query into equivalent RegionMath and DeferredConstraintEvaluators
 	void convert_query_to_region_math(const Query &query, std::vector< DeferredConstraintEvaluator > &constraints, RegionMath::RegionMath &rmath) const;
 
-	// Evaluates region math using a stack and the underlying evaluate_set_op virtual delegate functions
+	// As above, but appends to existing constraints (for converting several queries over a common set of constraints). If constraint_ids
+	// is given, ConstraintTerms identical to previously appended ones are reused rather than appended again.
+	void append_query_to_region_math(const Query &query, std::vector< DeferredConstraintEvaluator > &constraints, RegionMath::RegionMath &rmath, ConstraintIDMap *constraint_ids = nullptr) const;
+
+	// Evaluates region math using a stack and the underlying evaluate_set_op virtual delegate functions. Constraints are evaluated
+	// on demand, and short-circuited: once an intersection operand (or the first operand of a difference) is empty, or a union
+	// operand is full, the remaining operands are not evaluated at all (so their constraints incur no I/O). If plans is given
+	// (from optimize_query_region_math()), each constraint is evaluated following its plan.
 	boost::shared_ptr< RegionEncoding > evaluate_query_region_math(
 			std::vector< DeferredConstraintEvaluator > &constraints,
 			std::vector< partition_id_t > &constraint_partitions,
 			const RegionMath::RegionMath &rmath,
+			QueryStats &qstats,
+			const std::vector< ConstraintPlan > *plans = nullptr) const;
+
+	// As above, but over already-evaluated constraint results (e.g., shared between the queries of a batch), which are not modified
+	boost::shared_ptr< RegionEncoding > evaluate_query_region_math(
+			const std::vector< boost::shared_ptr< RegionEncoding > > &constraint_results,
+			const std::vector< boost::shared_ptr< ConstraintTermEvalStats > > &constraint_stats,
+			const RegionMath::RegionMath &rmath,
 			QueryStats &qstats) const;
 
 	boost::shared_ptr< RegionEncoding > evaluate_constraint_region_math(
@@ -129,6 +233,7 @@ private:
 private:
 	friend class EvaluateVisitor;
 	friend class SimpleQueryCursor;
+	friend class SimpleBatchQueryCursor;
 };
 
 #endif /* SIMPLE_QUERY_ENGINE_HPP_ */
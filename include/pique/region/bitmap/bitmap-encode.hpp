@@ -42,6 +42,7 @@ public:
     virtual ~BitmapRegionEncoder() {}
 
     virtual boost::shared_ptr< BitmapRegionEncoding > to_region_encoding();
+    virtual size_t get_state_size_in_bytes() const { return encoding->get_size_in_bytes(); } // Allocated up front, so spilling cannot reduce it
 
 private:
     virtual void push_bits_impl(uint64_t count, bool bitval);
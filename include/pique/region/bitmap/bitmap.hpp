@@ -71,8 +71,11 @@ public:
     virtual size_t get_size_in_bytes() const { return this->domain_size / std::numeric_limits<uint8_t>::digits; }
     virtual void dump() const;
 
+	virtual RegionUniformity get_region_uniformity() const; // Scans the bitmap, stopping as soon as it is found to be mixed
+
 	virtual uint64_t get_element_count() const;
 	virtual void convert_to_rids(std::vector<uint32_t> &out, bool sorted = false, bool preserve_self = true);
+	virtual boost::shared_ptr< RIDBatchIterator > make_rid_iterator(uint64_t offset = 0) const;
 
 	void to_bitset(boost::dynamic_bitset<block_t> &out);
 	void zero(); // set all bits to 0
@@ -97,6 +100,8 @@ private:
     friend class BitmapSetOperations;
     template<int ndim2> friend class CBLQToBitmapConverter;
     template<int ndim2> friend class CBLQToBitmapDFConverter;
+    template<int ndim2> friend class CBLQToBitmapParallelConverter;
+    template<int ndim2> friend class BitmapToCBLQConverter;
 };
 
 template<> class RegionEncoding::TypeToClass<RegionEncoding::Type::UNCOMPRESSED_BITMAP> { typedef BitmapRegionEncoding REClass; };
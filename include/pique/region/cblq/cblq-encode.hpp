@@ -55,6 +55,7 @@ public:
     virtual ~CBLQRegionEncoder() {}
 
     virtual boost::shared_ptr< CBLQRegionEncoding<ndim> > to_region_encoding();
+    virtual size_t get_state_size_in_bytes() const;
 
 private:
     virtual void push_bits_impl(uint64_t count, bool bitval);
@@ -143,7 +143,48 @@ public:
 	static void traverse_df_levelopt(const CBLQRegionEncoding<ndim> &cblq, LevelProcessBlockFns level_process_block_fns);
 };
 
+// A pull-based counterpart to CBLQTraversalBlocks::traverse_df: yields present blocks one at a time in depth-first
+// (i.e., ascending offset) order, so a traversal can be suspended and resumed (e.g., for streaming RID conversion)
+// Note: the CBLQ must outlive the cursor
+template<int ndim>
+class CBLQBlockCursor {
+public:
+	using block_size_t = CBLQNodeBlockTypes::block_size_t;
+	using block_offset_t = CBLQNodeBlockTypes::block_offset_t;
+
+	CBLQBlockCursor(const CBLQRegionEncoding<ndim> &cblq);
+
+	// Advances to the next present block, returning false if none remain
+	bool next(block_size_t &block_size, block_offset_t &block_offset);
+
+private:
+	using cblq_word_t = typename CBLQRegionEncoding<ndim>::cblq_word_t;
+	using cblq_word_citer_t = typename std::vector< cblq_word_t >::const_iterator;
+	using cblq_semiword_bitblock_t = typename CBLQSemiwords<ndim>::block_t;
+	using cblq_semiword_bitblock_citer_t = typename std::vector< cblq_semiword_bitblock_t >::const_iterator;
+
+	struct Frame {
+		cblq_word_t word; // A CBLQ word, or a semiword at the dense bottom level
+		int next_code;
+		block_offset_t block_offset;
+	};
+
+	void push_frame(block_offset_t block_offset);
+
+private:
+	const int nlevels;
+	const bool has_dense_suffix;
+
+	std::vector< block_size_t > level_block_sizes; // Per level, from the top
+	std::vector< cblq_word_citer_t > level_its; // Next unread word per (non-dense) level, from the top
+	cblq_semiword_bitblock_citer_t dense_bitblock_it;
+	uint64_t dense_semiwords_read;
+
+	std::vector< Frame > stack; // stack[i] is the word being visited at level i (from the top)
+};
+
 #include "pique/region/cblq/impl/cblq-traversal-impl.hpp"
 #include "pique/region/cblq/impl/cblq-traversal-df-impl.hpp"
+#include "pique/region/cblq/impl/cblq-traversal-cursor-impl.hpp"
 
 #endif /* CBLQ_TRAVERSAL_HPP_ */
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * cblq-word-ops.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#ifndef CBLQ_WORD_OPS_HPP_
+#define CBLQ_WORD_OPS_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "pique/region/cblq/cblq.hpp"
+
+/*
+ * Bit-parallel operations on whole CBLQ words. Rather than unpacking a word into its 2-bit codes,
+ * each code is classified with mask arithmetic: a "code mask" has the low bit of a code's bit pair
+ * set iff that code has some property, so all 2^ndim codes of a word are handled at once.
+ *
+ * All operations assume valid input codes (0b00, 0b01 or 0b10).
+ */
+template<int ndim>
+struct CBLQWordOps {
+	using cblq_word_t = typename CBLQWord<ndim>::cblq_word_t;
+
+	static constexpr int CODES_PER_WORD = (1 << ndim);
+	static constexpr uint64_t WORD_BITS = ((uint64_t)1 << (2 * CODES_PER_WORD)) - 1; // 1D words occupy only the low nibble of their byte
+	static constexpr cblq_word_t LOW_BITS = (cblq_word_t)(0x5555555555555555ULL & WORD_BITS);  // The low bit of every code (= ONE_CODES_WORD)
+	static constexpr cblq_word_t HIGH_BITS = (cblq_word_t)(0xAAAAAAAAAAAAAAAAULL & WORD_BITS); // The high bit of every code (= TWO_CODES_WORD)
+
+	// Code masks
+	static inline cblq_word_t one_mask(cblq_word_t word) { return word & LOW_BITS; }
+	static inline cblq_word_t two_mask(cblq_word_t word) { return (word >> 1) & LOW_BITS; }
+	static inline cblq_word_t zero_mask(cblq_word_t word) { return ~(word | (word >> 1)) & LOW_BITS; }
+	static inline cblq_word_t from_masks(cblq_word_t ones, cblq_word_t twos) { return ones | (twos << 1); }
+
+	// 0->1, 1->0, 2->2
+	static inline cblq_word_t complement_word(cblq_word_t word) {
+		return word ^ ((word & HIGH_BITS) >> 1) ^ LOW_BITS;
+	}
+	// 1 U x -> 1, 0 U x -> x, 2 U 2 -> 2
+	static inline cblq_word_t union_word(cblq_word_t left, cblq_word_t right) {
+		const cblq_word_t ones = one_mask(left) | one_mask(right);
+		const cblq_word_t twos = (two_mask(left) | two_mask(right)) & ~ones;
+		return from_masks(ones, twos);
+	}
+	// 0 & x -> 0, 1 & x -> x, 2 & 2 -> 2
+	static inline cblq_word_t intersect_word(cblq_word_t left, cblq_word_t right) {
+		const cblq_word_t zeros = zero_mask(left) | zero_mask(right);
+		const cblq_word_t twos = (two_mask(left) | two_mask(right)) & ~zeros;
+		return from_masks(~(zeros | twos) & LOW_BITS, twos);
+	}
+	// x - 1 -> 0, x - 0 -> x, 0 - x -> 0, 1 - 2 -> 2, 2 - 2 -> 2
+	static inline cblq_word_t difference_word(cblq_word_t left, cblq_word_t right) {
+		return intersect_word(left, complement_word(right));
+	}
+
+	static inline int count_two_codes(cblq_word_t word) {
+		return __builtin_popcountll((unsigned long long)two_mask(word));
+	}
+
+	// Invokes fn(code_pos) for the position of each code selected by the code mask, in increasing order
+	template<typename CodePosFn>
+	static inline void for_each_code_in_mask(cblq_word_t code_mask, CodePosFn fn) {
+		unsigned long long bits = code_mask;
+		while (bits) {
+			fn(__builtin_ctzll(bits) >> 1);
+			bits &= bits - 1;
+		}
+	}
+
+	/*
+	 * Batch operations over runs of consecutive words (e.g., all words of a subtree being copied or
+	 * deleted at one level). Since codes never straddle bytes, these treat the run as a byte array,
+	 * using AVX2 when compiled with it enabled (e.g., -mavx2), and 64-bit scalar chunks otherwise.
+	 * Words narrower than a byte (1D) keep their unused high bits zero.
+	 */
+	static constexpr unsigned char LOW_BITS_BYTE = (unsigned char)(0x55 & WORD_BITS);
+	static constexpr uint64_t LOW_BITS_CHUNK = 0x0101010101010101ULL * LOW_BITS_BYTE;
+
+	// Returns the total number of 2-codes in the run
+	static inline uint64_t count_two_codes_run(const cblq_word_t *words, size_t count) {
+		const unsigned char *bytes = reinterpret_cast< const unsigned char * >(words);
+		size_t nbytes = count * sizeof(cblq_word_t);
+		uint64_t total = 0;
+
+#ifdef __AVX2__
+		// Nibble lookup table popcount over the high bits of each code, accumulated with SAD into 4 64-bit lanes
+		const __m256i nibble_popcounts = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4, 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+		const __m256i low_nibble_mask = _mm256_set1_epi8(0x0F);
+		const __m256i high_bits = _mm256_set1_epi8((char)0xAA);
+		__m256i acc = _mm256_setzero_si256();
+		for (; nbytes >= 32; bytes += 32, nbytes -= 32) {
+			const __m256i v = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast< const __m256i * >(bytes)), high_bits);
+			const __m256i lo = _mm256_shuffle_epi8(nibble_popcounts, _mm256_and_si256(v, low_nibble_mask));
+			const __m256i hi = _mm256_shuffle_epi8(nibble_popcounts, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibble_mask));
+			acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+		}
+		total += (uint64_t)_mm256_extract_epi64(acc, 0) + (uint64_t)_mm256_extract_epi64(acc, 1) +
+				 (uint64_t)_mm256_extract_epi64(acc, 2) + (uint64_t)_mm256_extract_epi64(acc, 3);
+#endif
+
+		for (; nbytes >= 8; bytes += 8, nbytes -= 8) {
+			uint64_t chunk;
+			memcpy(&chunk, bytes, 8);
+			total += __builtin_popcountll(chunk & 0xAAAAAAAAAAAAAAAAULL);
+		}
+		for (; nbytes > 0; ++bytes, --nbytes)
+			total += __builtin_popcount(*bytes & 0xAA);
+		return total;
+	}
+
+	// Writes the complement of each word in the run to out (which may alias in)
+	static inline void complement_run(const cblq_word_t *in, cblq_word_t *out, size_t count) {
+		const unsigned char *in_bytes = reinterpret_cast< const unsigned char * >(in);
+		unsigned char *out_bytes = reinterpret_cast< unsigned char * >(out);
+		size_t nbytes = count * sizeof(cblq_word_t);
+
+#ifdef __AVX2__
+		const __m256i low_bits = _mm256_set1_epi8(LOW_BITS_BYTE);
+		const __m256i high_bits = _mm256_set1_epi8((char)0xAA);
+		for (; nbytes >= 32; in_bytes += 32, out_bytes += 32, nbytes -= 32) {
+			const __m256i v = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(in_bytes));
+			// The 16-bit shift cannot carry a bit across bytes, since only (odd) high code bits are shifted
+			const __m256i twos_low = _mm256_srli_epi16(_mm256_and_si256(v, high_bits), 1);
+			_mm256_storeu_si256(reinterpret_cast< __m256i * >(out_bytes), _mm256_xor_si256(_mm256_xor_si256(v, twos_low), low_bits));
+		}
+#endif
+
+		for (; nbytes >= 8; in_bytes += 8, out_bytes += 8, nbytes -= 8) {
+			uint64_t chunk;
+			memcpy(&chunk, in_bytes, 8);
+			chunk ^= ((chunk & 0xAAAAAAAAAAAAAAAAULL) >> 1) ^ LOW_BITS_CHUNK;
+			memcpy(out_bytes, &chunk, 8);
+		}
+		for (; nbytes > 0; ++in_bytes, ++out_bytes, --nbytes)
+			*out_bytes = *in_bytes ^ ((*in_bytes & 0xAA) >> 1) ^ LOW_BITS_BYTE;
+	}
+};
+
+#endif /* CBLQ_WORD_OPS_HPP_ */
@@ -110,9 +110,12 @@ public:
     virtual size_t get_size_in_bytes() const;
     virtual void dump() const;
 
+	virtual RegionUniformity get_region_uniformity() const;
+
 	virtual uint64_t get_element_count() const;
 	virtual void convert_to_rids(std::vector< uint32_t > &out, bool sorted = false, bool preserve_self = true);
 	virtual void convert_to_rids(std::vector< uint64_t > &out, uint64_t offset, bool sorted = false, bool preserve_self = true);
+	virtual boost::shared_ptr< RIDBatchIterator > make_rid_iterator(uint64_t offset = 0) const;
 
     int get_ndim() const { return ndim; }
     size_t get_num_words() const {
@@ -165,11 +168,43 @@ private:
     	ar & domain_size;
     	ar & has_dense_suffix;
     	ar & level_lens;
-    	ar & words;
+    	if (ndim == 1)
+    		serialize_packed_words(ar);
+    	else
+    		ar & words;
     	if (has_dense_suffix)
     		ar & *dense_suffix;
     }
 
+    // A 1D CBLQ word uses only the low nibble of its byte, so words are packed 16 to a 64-bit block when serialized
+    // (in memory, they remain one per byte so they can be addressed directly by the set operations)
+    template<typename Archive> void serialize_packed_words(Archive &ar) {
+    	static constexpr int WORDS_PER_BLOCK = 64 / BITS_PER_WORD;
+
+    	uint64_t num_words = words.size();
+    	ar & num_words;
+    	if (num_words == 0) {
+    		words.clear();
+    		return;
+    	}
+
+    	const size_t num_blocks_needed = (num_words - 1) / WORDS_PER_BLOCK + 1;
+    	const size_t num_bytes_needed = (num_words * BITS_PER_WORD - 1) / 8 + 1;
+    	std::vector< uint64_t > blocks(num_blocks_needed, 0);
+    	if (!Archive::is_loading::value)
+    		for (size_t i = 0; i < num_words; ++i)
+    			blocks[i / WORDS_PER_BLOCK] |= (uint64_t)words[i] << ((i % WORDS_PER_BLOCK) * BITS_PER_WORD);
+
+    	ar & boost::serialization::make_binary_object((void*)&blocks.front(), num_bytes_needed);
+
+    	if (Archive::is_loading::value) {
+    		static constexpr uint64_t WORD_MASK = (1ULL << BITS_PER_WORD) - 1;
+    		words.resize(num_words);
+    		for (size_t i = 0; i < num_words; ++i)
+    			words[i] = (cblq_word_t)((blocks[i / WORDS_PER_BLOCK] >> ((i % WORDS_PER_BLOCK) * BITS_PER_WORD)) & WORD_MASK);
+    	}
+    }
+
     // Used by any code inserting new content into this CBLQ.
     // Note: does NOT leave valid region representing the empty region;
     // that requires a non-empty internal state (one CBLQ word: 00...0)
@@ -197,24 +232,28 @@ private:
     template<int ndim2> friend class CBLQSetOperationsNAry2Dense;
     template<int ndim2> friend class CBLQSetOperationsNAry3Dense;
     template<int ndim2> friend class CBLQSetOperationsNAry3Fast;
+    template<int ndim2> friend class CBLQSetOperationsNAry3FastParallel;
     template<int ndim2> friend class CBLQToBitmapConverter;
+    template<int ndim2> friend class CBLQToBitmapParallelConverter;
+    template<int ndim2> friend class CBLQBottomUpBuilder;
     template<int ndim2, typename QueueElemT> friend class CBLQTraversal;
     template<int ndim2> friend class CBLQDepthFirstTraversalAccess;
 };
 
+template<> class RegionEncoding::TypeToClass<RegionEncoding::Type::CBLQ_1D> { typedef CBLQRegionEncoding<1> REClass; };
 template<> class RegionEncoding::TypeToClass<RegionEncoding::Type::CBLQ_2D> { typedef CBLQRegionEncoding<2> REClass; };
 template<> class RegionEncoding::TypeToClass<RegionEncoding::Type::CBLQ_3D> { typedef CBLQRegionEncoding<3> REClass; };
 template<> class RegionEncoding::TypeToClass<RegionEncoding::Type::CBLQ_4D> { typedef CBLQRegionEncoding<4> REClass; };
 
-// Instantiations for 2D-4D
+// Instantiations for 1D-4D
+BOOST_CLASS_IMPLEMENTATION(CBLQRegionEncoding<1>, boost::serialization::object_serializable) // no version information serialized
 BOOST_CLASS_IMPLEMENTATION(CBLQRegionEncoding<2>, boost::serialization::object_serializable) // no version information serialized
 BOOST_CLASS_IMPLEMENTATION(CBLQRegionEncoding<3>, boost::serialization::object_serializable) // no version information serialized
 BOOST_CLASS_IMPLEMENTATION(CBLQRegionEncoding<4>, boost::serialization::object_serializable) // no version information serialized
 
 // Class for handling the dense prefix/suffix structure (since CBLQSemiwords
 // are too small for even a char at ndim == 1 or 2)
-// TODO: Consider generalizing this to a sub-byte word stream, could be useful
-//       for 1D CBLQ as well
+// TODO: Consider generalizing this to a sub-byte word stream
 template<int ndim>
 class CBLQSemiwords {
 public:
@@ -321,6 +360,8 @@ private:
 	template<int ndim2> friend class CBLQSetOperationsNAry3Fast;
 	template<int ndim2, typename QueueElemT> friend class CBLQTraversal;
 	template<int ndim2> friend class CBLQDepthFirstTraversalAccess;
+	template<int ndim2> friend class CBLQBlockCursor;
+	template<int ndim2> friend class CBLQToBitmapParallelConverter;
 };
 
 // LevelStateGenFn(levels, level, level_len)
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * cblq-traversal-cursor-impl.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#ifndef CBLQ_TRAVERSAL_CURSOR_IMPL_HPP_
+#define CBLQ_TRAVERSAL_CURSOR_IMPL_HPP_
+
+#include <vector>
+
+#include "pique/region/cblq/cblq.hpp"
+
+template<int ndim>
+CBLQBlockCursor<ndim>::CBLQBlockCursor(const CBLQRegionEncoding<ndim> &cblq) :
+	nlevels(cblq.get_num_levels()),
+	has_dense_suffix(CBLQDepthFirstTraversalAccess<ndim>::has_dense_suffix(cblq)),
+	level_block_sizes(nlevels), level_its(nlevels),
+	dense_bitblock_it(), dense_semiwords_read(0)
+{
+	for (int level = 0; level < nlevels; ++level) {
+		const int level_from_bottom = nlevels - level - 1;
+		level_block_sizes[level] = (1ULL << (ndim * level_from_bottom));
+
+		cblq_word_citer_t end_it;
+		CBLQDepthFirstTraversalAccess<ndim>::get_level_iter_bounds(cblq, level_from_bottom, level_its[level], end_it);
+	}
+
+	if (has_dense_suffix) {
+		uint64_t num_semiwords;
+		CBLQDepthFirstTraversalAccess<ndim>::get_level_dense_iter_bounds(cblq, num_semiwords, dense_bitblock_it);
+	}
+
+	if (nlevels > 0 && cblq.get_domain_size() > 0)
+		this->push_frame(0);
+}
+
+template<int ndim>
+void CBLQBlockCursor<ndim>::push_frame(block_offset_t block_offset) {
+	static constexpr int SEMIWORDS_PER_BITBLOCK = CBLQSemiwords<ndim>::SEMIWORDS_PER_BLOCK;
+	static constexpr cblq_semiword_bitblock_t SEMIWORD_MASK = (((cblq_semiword_bitblock_t)1 << CBLQRegionEncoding<ndim>::BITS_PER_SEMIWORD) - 1);
+
+	const int level = stack.size();
+
+	cblq_word_t word;
+	if (has_dense_suffix && level == nlevels - 1) {
+		const cblq_semiword_bitblock_t bitblock = *(dense_bitblock_it + dense_semiwords_read / SEMIWORDS_PER_BITBLOCK);
+		const int shift = (dense_semiwords_read % SEMIWORDS_PER_BITBLOCK) * CBLQRegionEncoding<ndim>::BITS_PER_SEMIWORD;
+		word = (bitblock >> shift) & SEMIWORD_MASK;
+		++dense_semiwords_read;
+	} else {
+		word = *level_its[level]++;
+	}
+
+	stack.push_back(Frame { word, 0, block_offset });
+}
+
+template<int ndim>
+bool CBLQBlockCursor<ndim>::next(block_size_t &block_size, block_offset_t &block_offset) {
+	while (!stack.empty()) {
+		Frame &frame = stack.back();
+		if (frame.next_code == CBLQRegionEncoding<ndim>::CODES_PER_WORD) {
+			stack.pop_back();
+			continue;
+		}
+
+		const int level = stack.size() - 1;
+		const int i = frame.next_code++;
+		const block_offset_t child_offset = frame.block_offset + i * level_block_sizes[level];
+
+		if (has_dense_suffix && level == nlevels - 1) {
+			// Dense semiword: one bit per code, 1 == present
+			if ((frame.word >> i) & 0b1) {
+				block_size = level_block_sizes[level];
+				block_offset = child_offset;
+				return true;
+			}
+		} else {
+			const cblq_word_t code = (frame.word >> (i * CBLQRegionEncoding<ndim>::BITS_PER_CODE)) & 0b11;
+			if (code == 0b01) {
+				block_size = level_block_sizes[level];
+				block_offset = child_offset;
+				return true;
+			} else if (code == 0b10) {
+				this->push_frame(child_offset); // Note: invalidates frame
+			}
+		}
+	}
+	return false;
+}
+
+#endif /* CBLQ_TRAVERSAL_CURSOR_IMPL_HPP_ */
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * bp128.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+ * A self-contained SIMD-BP128 codec for sorted RID lists, used by CIIRegionEncoding as an
+ * alternative to the external PForDelta library.
+ *
+ * RIDs are coded in blocks of BLOCK_SIZE. Each block stores the differences between RIDs four
+ * positions apart (so the prefix sum needed to decode is a plain 4-lane vector add), bit-packed
+ * vertically across 4 32-bit lanes at the minimum bit width that fits every difference in the block.
+ * A block is laid out as:
+ *   uint32_t base       (the first RID of the block)
+ *   uint8_t  bit_width  (0..32)
+ *   uint8_t  count - 1  (RIDs actually in the block; short blocks are padded with their last RID)
+ *   uint16_t padding
+ *   bit_width * 16 bytes of packed differences
+ *
+ * Encoded blocks are not aligned within the stream, so unaligned loads/stores are used throughout.
+ * The SSE2 kernels and the portable fallback produce identical encodings.
+ */
+class BP128Codec {
+public:
+	typedef uint32_t rid_t;
+
+	static constexpr size_t BLOCK_SIZE = 128;
+	static constexpr size_t HEADER_SIZE = 8;
+	static constexpr size_t MAX_ENCODED_BLOCK_SIZE = HEADER_SIZE + BLOCK_SIZE * sizeof(rid_t);
+
+	// Appends a block encoding the count (1..BLOCK_SIZE) sorted RIDs at rids to out, returning its encoded size in bytes
+	static size_t encode_block(const rid_t *rids, size_t count, std::vector<char> &out);
+
+	// Decodes the block at in into out, which must have room for BLOCK_SIZE RIDs (even if the block is short).
+	// Sets count to the number of RIDs in the block, and returns the block's encoded size in bytes
+	static size_t decode_block(const char *in, rid_t *out, size_t &count);
+
+	// Header-only inspection of an encoded block
+	static size_t get_block_count(const char *in);
+	static size_t get_block_size(const char *in);
+	static rid_t get_block_base(const char *in);
+};
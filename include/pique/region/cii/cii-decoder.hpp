@@ -40,6 +40,10 @@ public:
 	rid_t top() const;
 	void next();
 
+	// Advances to the first RID that is at least rid (if any). When the CII has a skip table, chunks
+	// that lie entirely before rid are skipped without being decoded
+	void skip_to(rid_t rid);
+
 	void dump_to(std::vector<rid_t> &output);
 
 private:
@@ -47,13 +51,18 @@ private:
 	bool decode_next_chunk_to(std::vector<rid_t> &output);
 private:
 	const bool is_decompressing_cii;
+	const CIICompressionFormat format;
 
 	std::vector<rid_t> cur_chunk;
 	std::vector<rid_t>::const_iterator cur_chunk_it;
 	std::vector<rid_t>::const_iterator cur_chunk_it_end;
 
+	std::vector<char>::const_iterator encoded_chunks_begin;
 	std::vector<char>::const_iterator encoded_chunk_it;
 	std::vector<char>::const_iterator encoded_chunk_it_end;
+
+	const std::vector< CIIRegionEncoding::SkipEntry > *skip_table; // nullptr if the CII has none
+	size_t next_chunk_index; // Index of the next chunk to decode (i.e., in the skip table)
 };
 
 /*
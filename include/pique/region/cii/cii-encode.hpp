@@ -31,9 +31,10 @@
 #include "pique/region/region-encoding.hpp"
 #include "pique/region/cii/cii.hpp"
 
-#include <patchedframeofreference.h>
-
-struct CIIRegionEncoderConfig {};
+struct CIIRegionEncoderConfig {
+	CIIRegionEncoderConfig(CIICompressionFormat format = DEFAULT_CII_COMPRESSION_FORMAT) : format(format) {}
+	CIICompressionFormat format;
+};
 
 class CIIRegionEncoder : public RegionEncoder< CIIRegionEncoding, CIIRegionEncoderConfig > {
 public:
@@ -44,6 +45,7 @@ public:
     virtual ~CIIRegionEncoder() {}
 
     virtual boost::shared_ptr< CIIRegionEncoding > to_region_encoding();
+    virtual size_t get_state_size_in_bytes() const { return encoding->get_size_in_bytes() + cur_chunk.size() * sizeof(rid_t); }
 
 private:
     void compress_chunk();
@@ -29,33 +29,64 @@
 #include <boost/limits.hpp>
 #include <boost/iterator/counting_iterator.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/is_bitwise_serializable.hpp>
 
-// ridcompress library
-#include <patchedframeofreference.h>
+#include "config.h" // include Autoconf config.h to get HAVE_RIDCOMPRESS
 
 #include "pique/region/region-encoding.hpp"
+#include "pique/region/cii/bp128.hpp"
 #include "pique/util/fixed-archive.hpp"
 
-// CIIRegionEncoding, a concrete subclass of RegionEncoding utilizing a compressed (PForDelta) inverted index
+// The chunk codec used by a compressed CII
+enum struct CIICompressionFormat : char {
+	PFOR_DELTA, // PForDelta via the external ridcompress library
+	BP128,      // The built-in SIMD-BP128 codec (see bp128.hpp)
+};
+
+// PForDelta is only available when configured with the ridcompress library; BP128 is always available
+#ifdef HAVE_RIDCOMPRESS
+static constexpr CIICompressionFormat DEFAULT_CII_COMPRESSION_FORMAT = CIICompressionFormat::PFOR_DELTA;
+#else
+static constexpr CIICompressionFormat DEFAULT_CII_COMPRESSION_FORMAT = CIICompressionFormat::BP128;
+#endif
+
+// CIIRegionEncoding, a concrete subclass of RegionEncoding utilizing a compressed (PForDelta or BP128) inverted index
 class CIIRegionEncoding : public RegionEncoding {
 public:
 	static constexpr RegionEncoding::Type TYPE = RegionEncoding::Type::CII;
 	typedef uint32_t rid_t;
 
+	// One entry per compressed chunk: the chunk's last RID, and where the chunk begins in the compressed buffer.
+	// Lets decoders binary-search for the chunk holding a given RID rather than decoding every chunk before it
+	struct SkipEntry {
+		rid_t max_rid;
+		uint32_t byte_offset;
+
+		bool operator==(const SkipEntry &other) const { return max_rid == other.max_rid && byte_offset == other.byte_offset; }
+
+		template<typename Archive> void serialize(Archive &ar, const unsigned int version) {
+			ar & max_rid;
+			ar & byte_offset;
+		}
+	};
+
 public:
 	CIIRegionEncoding() :
 		is_compressed(false),
 		is_inverted(false),
+		format(DEFAULT_CII_COMPRESSION_FORMAT),
 		domain_size(0)
 	{}
 	CIIRegionEncoding(uint64_t domain_size) :
 		is_compressed(false),
 		is_inverted(false),
+		format(DEFAULT_CII_COMPRESSION_FORMAT),
 		domain_size(static_cast<rid_t>(domain_size))
 	{}
 	CIIRegionEncoding(uint64_t nelem, bool filled) :
 		is_compressed(false),
 		is_inverted(filled),
+		format(DEFAULT_CII_COMPRESSION_FORMAT),
 		domain_size(static_cast<rid_t>(nelem))
 	{
 		assert(nelem <= (uint64_t)std::numeric_limits<rid_t>::max());
@@ -71,11 +102,19 @@ public:
     virtual size_t get_size_in_bytes() const;
     virtual void dump() const;
 
+    virtual RegionUniformity get_region_uniformity() const; // Note: only detected for uncompressed CIIs (compressed ones report MIXED)
+
     virtual uint64_t get_domain_size() const { return domain_size; }
 	virtual uint64_t get_element_count() const;
 	virtual void convert_to_rids(std::vector<uint32_t> &out, bool sorted = false, bool preserve_self = true);
+	virtual boost::shared_ptr< RIDBatchIterator > make_rid_iterator(uint64_t offset = 0) const;
 
     bool is_compressed_form() const { return this->is_compressed; }
+    CIICompressionFormat get_compression_format() const { return this->format; }
+    const std::vector< SkipEntry > & get_skip_table() const { return this->skip_table; } // Empty if uncompressed (or loaded from an older PForDelta index)
+
+    // Sets the format used when compressing (re-compressing in the new format if already compressed)
+    void set_compression_format(CIICompressionFormat format);
 
     void compress();
     void decompress();
@@ -88,32 +127,45 @@ public:
 private:
     friend class boost::serialization::access;
     template<typename Archive> void serialize(Archive &ar, const unsigned int version) {
-    	enum : char { COMPRESSED_FLAG = 1, INVERTED_FLAG = 2 };
+    	enum : char { COMPRESSED_FLAG = 1, INVERTED_FLAG = 2, BP128_FLAG = 4, SKIP_TABLE_FLAG = 8 };
 
     	char flags = 0;
     	if (Archive::is_saving::value) {
     		flags |= (this->is_compressed ? COMPRESSED_FLAG : 0);
     		flags |= (this->is_inverted ? INVERTED_FLAG : 0);
+    		flags |= (this->format == CIICompressionFormat::BP128 ? BP128_FLAG : 0);
+    		flags |= (this->is_compressed && !this->skip_table.empty() ? SKIP_TABLE_FLAG : 0);
     	}
     	ar & flags;
     	if (Archive::is_loading::value) {
         	this->is_compressed = (flags & COMPRESSED_FLAG);
         	this->is_inverted = (flags & INVERTED_FLAG);
+        	this->format = (flags & BP128_FLAG) ? CIICompressionFormat::BP128 : CIICompressionFormat::PFOR_DELTA;
     	}
 
     	ar & this->domain_size;
     	if (is_compressed)	ar & this->cii;
     	else				ar & this->ii;
+
+    	if (flags & SKIP_TABLE_FLAG)
+    		ar & this->skip_table;
     }
 
+    size_t get_chunk_size() const { return this->format == CIICompressionFormat::BP128 ? BP128Codec::BLOCK_SIZE : CII_CHUNK_SIZE; }
+
+    // Compresses count (1..get_chunk_size()) RIDs as a new chunk at the end of the compressed buffer, in this CII's format
+    void append_compressed_chunk(const rid_t *rids, size_t count);
+
 private:
     static const size_t CII_CHUNK_SIZE;
 
     bool is_compressed;
     bool is_inverted;
+    CIICompressionFormat format;
     rid_t domain_size;
     std::vector<char> cii;
     std::vector<rid_t> ii;
+    std::vector< SkipEntry > skip_table;
 
     friend class CIIRegionEncoder;
     friend class CIISetOperations;
@@ -125,3 +177,7 @@ private:
 template<> class RegionEncoding::TypeToClass<RegionEncoding::Type::CII> { typedef CIIRegionEncoding REClass; };
 
 BOOST_CLASS_IMPLEMENTATION(CIIRegionEncoding, boost::serialization::object_serializable) // no version information serialized
+// Skip tables are written as a bare element count followed by the raw entries
+BOOST_CLASS_IMPLEMENTATION(CIIRegionEncoding::SkipEntry, boost::serialization::object_serializable)
+BOOST_CLASS_IMPLEMENTATION(std::vector< CIIRegionEncoding::SkipEntry >, boost::serialization::object_serializable)
+BOOST_IS_BITWISE_SERIALIZABLE(CIIRegionEncoding::SkipEntry)
@@ -60,6 +60,10 @@ public:
     virtual size_t get_size_in_bytes() const { return rids.size() * sizeof(rid_t); }
     virtual void dump() const;
 
+    virtual RegionUniformity get_region_uniformity() const {
+    	return rids.empty() ? RegionUniformity::EMPTY : rids.size() == domain_size ? RegionUniformity::FILLED : RegionUniformity::MIXED;
+    }
+
     virtual uint64_t get_domain_size() const { return domain_size; }
 	virtual uint64_t get_element_count() const { return rids.size(); }
 	virtual void convert_to_rids(std::vector<uint32_t> &out, bool sorted = false, bool preserve_self = true) {
@@ -68,6 +72,7 @@ public:
 		else
 			out = std::move(rids);
 	}
+	virtual boost::shared_ptr< RIDBatchIterator > make_rid_iterator(uint64_t offset = 0) const;
 
     size_t get_num_rids() const { return rids.size(); }
 
@@ -89,6 +94,7 @@ private:
     friend class IIRegionEncoder;
     friend class IISetOperations;
     friend class IISetOperationsNAry;
+    template<int ndim2> friend class IIToCBLQConverter;
 };
 
 template<> class RegionEncoding::TypeToClass<RegionEncoding::Type::II> { typedef IIRegionEncoding REClass; };
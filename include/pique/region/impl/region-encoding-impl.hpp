@@ -39,6 +39,28 @@ void RegionEncoder<RE, REC>::insert_bits(uint64_t position, uint64_t count) {
 	this->push_bits(count, true);
 }
 
+template<typename RE, typename REC>
+void RegionEncoder<RE, REC>::insert_rids(RIDBatchIterator &rid_it) {
+	static constexpr size_t RID_BATCH_SIZE = 1<<16;
+
+	std::vector< uint64_t > batch;
+	uint64_t run_start = 0, run_length = 0;
+	while (rid_it.next_batch(batch, RID_BATCH_SIZE)) {
+		for (uint64_t rid : batch) {
+			if (run_length > 0 && rid == run_start + run_length) {
+				++run_length;
+			} else {
+				if (run_length > 0)
+					this->insert_bits(run_start, run_length);
+				run_start = rid;
+				run_length = 1;
+			}
+		}
+	}
+	if (run_length > 0)
+		this->insert_bits(run_start, run_length);
+}
+
 template<typename RE, typename REC>
 void RegionEncoder<RE, REC>::finalize() {
     this->push_bits(this->total_bit_count - this->current_bit_count, false);
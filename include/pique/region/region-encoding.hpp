@@ -23,12 +23,33 @@
 #ifndef REGION_ENCODING_HPP_
 #define REGION_ENCODING_HPP_
 
+#include <cassert>
 #include <iostream>
 #include <typeindex>
 #include <vector>
 #include <boost/smart_ptr.hpp>
 #include <boost/optional.hpp>
 
+// RIDBatchIterator, which streams the RIDs of a RegionEncoding in ascending order, a bounded batch at a time,
+// so that large results need not be materialized as a single RID vector
+// Note: the RegionEncoding that produced the iterator must outlive it
+class RIDBatchIterator {
+public:
+	virtual ~RIDBatchIterator() {}
+
+	// Replaces the contents of out with the next (at most max_rids) RIDs; returns false (leaving out empty) once all RIDs have been produced
+	bool next_batch(std::vector<uint64_t> &out, size_t max_rids) {
+		assert(max_rids > 0);
+		out.clear();
+		this->next_batch_impl(out, max_rids);
+		return !out.empty();
+	}
+
+private:
+	// Appends up to max_rids RIDs to out, appending none only when no RIDs remain
+	virtual void next_batch_impl(std::vector<uint64_t> &out, size_t max_rids) = 0;
+};
+
 // RegionEncoding, which describes a subset of a large set elements
 class RegionEncoding {
 public:
@@ -57,12 +78,23 @@ public:
 		CBLQ_4D = 6,
 		WAH = 7,
 		UNCOMPRESSED_BITMAP = 8,
+		WAH64 = 9,
+		HETEROGENEOUS = 10, // Not a concrete representation: marks an index whose regions each have their own representation
 	};
 
+	// The representation of regions synthesized for a HETEROGENEOUS index (e.g., uniform or RID-range regions during
+	// query evaluation); WAH64 represents both fills and ranges compactly
+	static constexpr Type HETEROGENEOUS_SYNTHESIZED_TYPE = Type::WAH64;
+
 	template<RegionEncoding::Type T> class TypeToClass { /*typedef XXX Class*/ };
 
 	static boost::shared_ptr< RegionEncoding > make_null_region(RegionEncoding::Type type);
 	static boost::shared_ptr< RegionEncoding > make_uniform_region(RegionEncoding::Type type, uint64_t nelem, bool filled);
+	// Builds a region with exactly the RIDs in the given sorted, disjoint ranges, each a (first RID, length) pair
+	// (e.g., as produced by GridSubset::compute_linearized_ranges())
+	static boost::shared_ptr< RegionEncoding > make_region_from_rid_ranges(RegionEncoding::Type type, uint64_t nelem, const std::vector< std::pair< uint64_t, uint64_t > > &rid_ranges);
+	// Builds a region with exactly the RIDs produced by the given iterator (e.g., to convert another region to this representation)
+	static boost::shared_ptr< RegionEncoding > make_region_from_rid_iterator(RegionEncoding::Type type, uint64_t nelem, RIDBatchIterator &rid_it);
 
 	static boost::optional< std::type_index > get_region_representation_class_by_type(RegionEncoding::Type type);
 	static boost::optional< Type > get_region_representation_type_by_name(std::string name);
@@ -83,6 +115,8 @@ public:
 	virtual uint64_t get_element_count() const = 0;
 	virtual void convert_to_rids(std::vector<uint32_t> &out, bool sorted = false, bool preserve_self = true) = 0;
 	virtual void convert_to_rids(std::vector<uint64_t> &out, uint64_t offset, bool sorted = false, bool preserve_self = true);
+	// Returns an iterator streaming this region's RIDs (plus offset) in ascending order; this region must outlive the iterator
+	virtual boost::shared_ptr< RIDBatchIterator > make_rid_iterator(uint64_t offset = 0) const = 0;
 
 	virtual void save_to_stream(std::ostream &out) = 0;
 	virtual void load_from_stream(std::istream &in) = 0;
@@ -122,6 +156,13 @@ public:
      */
     void insert_bits(uint64_t position, uint64_t count);
 
+    /**
+     * Inserts all RIDs produced by the given iterator, as with insert_bits (so all
+     * must lie beyond the end of the last pushed bit). Consecutive RIDs are coalesced
+     * into runs, so run-oriented encoders see as few insertions as possible.
+     */
+    void insert_rids(RIDBatchIterator &rid_it);
+
     /**
      * Pushes enough 0-bits to fill the rest of the index (up to total_elements
      * specified in the constructor).
@@ -130,6 +171,12 @@ public:
 
     virtual boost::shared_ptr< RegionEncodingT > to_region_encoding() = 0;
 
+    /**
+     * Returns the approximate memory held by the partial encoding built so far,
+     * in bytes (used to keep index builds within a memory budget).
+     */
+    virtual size_t get_state_size_in_bytes() const = 0;
+
 protected:
     const RegionEncoderConfigT conf;
 
@@ -42,6 +42,7 @@ public:
     virtual ~WAHRegionEncoder() {}
 
     virtual boost::shared_ptr< WAHRegionEncoding > to_region_encoding();
+    virtual size_t get_state_size_in_bytes() const { return encoding->get_size_in_bytes(); }
 
 private:
     virtual void push_bits_impl(uint64_t count, bool bitval);
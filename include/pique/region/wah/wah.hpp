@@ -60,10 +60,13 @@ public:
     virtual size_t get_size_in_bytes() const { return bits.getSerialSize(); }
     virtual void dump() const;
 
+    virtual RegionUniformity get_region_uniformity() const;
+
     virtual uint64_t get_domain_size() const { return bits.size(); }
 	virtual uint64_t get_element_count() const;
 	virtual void convert_to_rids(std::vector<uint32_t> &out, bool sorted = false, bool preserve_self = true);
 	virtual void convert_to_rids(std::vector<uint64_t> &out, uint64_t offset, bool sorted = false, bool preserve_self = true);
+	virtual boost::shared_ptr< RIDBatchIterator > make_rid_iterator(uint64_t offset = 0) const;
 
 	virtual void save_to_stream(std::ostream &out) { boost::archive::simple_binary_oarchive(out, boost::archive::no_header) << *this; }
 	virtual void load_from_stream(std::istream &in) { boost::archive::simple_binary_iarchive(in, boost::archive::no_header) >> *this; }
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * wah64-encode.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#pragma once
+
+#include <cassert>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "pique/region/region-encoding.hpp"
+#include "pique/region/wah/wah64.hpp"
+
+struct WAH64RegionEncoderConfig {};
+
+class WAH64RegionEncoder : public RegionEncoder< WAH64RegionEncoding, WAH64RegionEncoderConfig > {
+public:
+	typedef WAH64RegionEncoding::word_t word_t;
+
+public:
+	WAH64RegionEncoder(WAH64RegionEncoderConfig conf, size_t total_elements);
+    virtual ~WAH64RegionEncoder() {}
+
+    virtual boost::shared_ptr< WAH64RegionEncoding > to_region_encoding();
+    virtual size_t get_state_size_in_bytes() const { return builder.get_size_in_bytes(); }
+
+private:
+    virtual void push_bits_impl(uint64_t count, bool bitval);
+    virtual void finalize_impl();
+
+    WAH64RegionEncoding::Builder builder;
+    word_t cur_literal; // The partially-pushed group
+    int cur_bits;
+
+    boost::shared_ptr< WAH64RegionEncoding > encoding;
+};
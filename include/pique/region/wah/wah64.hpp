@@ -0,0 +1,239 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * wah64.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#ifndef WAH64_HPP_
+#define WAH64_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <boost/smart_ptr.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "pique/region/region-encoding.hpp"
+
+#include "pique/util/fixed-archive.hpp"
+
+/*
+ * WAH64RegionEncoding, a concrete subclass of RegionEncoding utilizing a native word-aligned hybrid (WAH) bitmap
+ * encoding with 64-bit words (independent of FastBit, and not limited to 2^32 elements).
+ *
+ * The bitmap is divided into 63-bit groups. Each word is either a literal (MSB clear, the low 63 bits being the
+ * bits of one group, least significant bit first) or a fill (MSB set, the next bit giving the fill bit value, and
+ * the low 62 bits giving the number of groups in the fill). The final group may be partial; it is always stored
+ * as a literal with its out-of-domain bits cleared. All-0/all-1 full groups are always stored as fills, and adjacent
+ * fills of the same bit are always merged, so the encoding of a given set is unique.
+ */
+class WAH64RegionEncoding : public RegionEncoding {
+public:
+	static constexpr RegionEncoding::Type TYPE = RegionEncoding::Type::WAH64;
+
+	typedef uint64_t word_t;
+	static constexpr int BITS_PER_GROUP = std::numeric_limits< word_t >::digits - 1;
+	static constexpr word_t FILL_FLAG = (word_t)1 << BITS_PER_GROUP;
+	static constexpr word_t FILL_BIT_FLAG = (word_t)1 << (BITS_PER_GROUP - 1);
+	static constexpr word_t FILL_LENGTH_MASK = FILL_BIT_FLAG - 1;
+	static constexpr word_t LITERAL_MASK = FILL_FLAG - 1;
+
+	static constexpr uint64_t groups_for(uint64_t nelem) { return (nelem + BITS_PER_GROUP - 1) / BITS_PER_GROUP; }
+
+	class GroupIterator;
+	class Builder;
+
+public:
+	WAH64RegionEncoding() : RegionEncoding(0), nset(0), words() {}
+	WAH64RegionEncoding(uint64_t nelem, bool filled);
+	virtual ~WAH64RegionEncoding() {}
+
+	virtual RegionEncoding::Type get_type() const { return RegionEncoding::Type::WAH64; }
+
+	virtual size_t get_size_in_bytes() const { return words.size() * sizeof(word_t); }
+	virtual void dump() const;
+
+	// O(1), as the element count is maintained alongside the words
+	virtual RegionUniformity get_region_uniformity() const {
+		return nset == 0 ? RegionUniformity::EMPTY : nset == this->domain_size ? RegionUniformity::FILLED : RegionUniformity::MIXED;
+	}
+
+	virtual uint64_t get_element_count() const { return nset; }
+	virtual void convert_to_rids(std::vector<uint32_t> &out, bool sorted = false, bool preserve_self = true);
+	virtual void convert_to_rids(std::vector<uint64_t> &out, uint64_t offset, bool sorted = false, bool preserve_self = true);
+	virtual boost::shared_ptr< RIDBatchIterator > make_rid_iterator(uint64_t offset = 0) const;
+
+	uint64_t get_group_count() const { return groups_for(this->domain_size); }
+
+	virtual void save_to_stream(std::ostream &out) { boost::archive::simple_binary_oarchive(out, boost::archive::no_header) << *this; }
+	virtual void load_from_stream(std::istream &in) { boost::archive::simple_binary_iarchive(in, boost::archive::no_header) >> *this; }
+
+	virtual bool operator==(const RegionEncoding &other) const;
+
+private:
+	template<typename rid_t, bool has_offset>
+	void convert_to_rids(std::vector< rid_t > &out, uint64_t offset) const;
+
+    friend class boost::serialization::access;
+    template<typename Archive> void serialize(Archive &ar, const unsigned int version) {
+    	ar & this->domain_size;
+    	ar & this->nset;
+    	ar & this->words;
+    }
+
+private:
+    uint64_t nset; // Number of elements present
+    std::vector< word_t > words;
+
+    friend class WAH64RegionEncoder;
+    friend class WAH64SetOperations;
+    friend class WAH64RIDBatchIterator;
+};
+
+// Iterates over the groups of a WAH64RegionEncoding one run at a time (a run being a whole fill or a single literal),
+// allowing any number of groups to be skipped without visiting them individually
+class WAH64RegionEncoding::GroupIterator {
+public:
+	GroupIterator(const WAH64RegionEncoding &region) :
+		cur(region.words.data()), end(region.words.data() + region.words.size()), remaining(0)
+	{
+		this->load_run();
+	}
+
+	bool has_next() const { return remaining > 0; }
+	bool is_fill() const { return (*cur & FILL_FLAG) != 0; }
+	bool fill_bit() const { return (*cur & FILL_BIT_FLAG) != 0; }
+	uint64_t get_run_length() const { return remaining; } // Groups remaining in the current run
+	word_t get_literal() const { return is_fill() ? (fill_bit() ? LITERAL_MASK : 0) : *cur; } // Bits of the current group
+
+	void next_run() { ++cur; this->load_run(); }
+
+	void skip(uint64_t count) {
+		while (count >= remaining && count > 0) {
+			assert(remaining > 0);
+			count -= remaining;
+			this->next_run();
+		}
+		remaining -= count;
+	}
+
+private:
+	void load_run() { remaining = (cur == end) ? 0 : (*cur & FILL_FLAG) ? (*cur & FILL_LENGTH_MASK) : 1; }
+
+private:
+	const word_t *cur, *end;
+	uint64_t remaining;
+};
+
+// Appends groups in order to produce a canonical WAH64RegionEncoding of a given domain size, optionally reusing
+// the storage of a previously-used word vector
+class WAH64RegionEncoding::Builder {
+public:
+	Builder(uint64_t domain_size, std::vector< word_t > &&buffer = std::vector< word_t >()) :
+		domain_size(domain_size), total_groups(groups_for(domain_size)),
+		tail_mask(domain_size % BITS_PER_GROUP ? ((word_t)1 << (domain_size % BITS_PER_GROUP)) - 1 : LITERAL_MASK),
+		groups_appended(0), nset(0), words(std::move(buffer))
+	{
+		words.clear();
+	}
+
+	uint64_t get_groups_remaining() const { return total_groups - groups_appended; }
+	size_t get_size_in_bytes() const { return words.size() * sizeof(word_t); }
+
+	void append_fill(bool bit, uint64_t count) {
+		assert(groups_appended + count <= total_groups);
+		if (count > 0 && groups_appended + count == total_groups && tail_mask != LITERAL_MASK) {
+			// The partial tail group must be kept as a (masked) literal
+			this->append_fill_words(bit, count - 1);
+			this->append_literal_word(bit ? tail_mask : 0);
+		} else {
+			this->append_fill_words(bit, count);
+		}
+	}
+
+	void append_literal(word_t literal) {
+		assert(groups_appended < total_groups);
+		literal &= LITERAL_MASK;
+		if (groups_appended + 1 == total_groups && tail_mask != LITERAL_MASK)
+			this->append_literal_word(literal & tail_mask);
+		else if (literal == 0 || literal == LITERAL_MASK)
+			this->append_fill_words(literal != 0, 1);
+		else
+			this->append_literal_word(literal);
+	}
+
+	// Consumes count groups from it, appending them (or their complements)
+	void append_groups(GroupIterator &it, uint64_t count, bool complement) {
+		while (count > 0) {
+			const uint64_t n = std::min(count, it.get_run_length());
+			if (it.is_fill())
+				this->append_fill(it.fill_bit() != complement, n);
+			else
+				this->append_literal(complement ? ~it.get_literal() : it.get_literal());
+			it.skip(n);
+			count -= n;
+		}
+	}
+
+	// Moves the result into region; this builder's buffer then holds region's previous words, for recycling
+	void finish_into(WAH64RegionEncoding &region) {
+		assert(groups_appended == total_groups);
+		region.domain_size = domain_size;
+		region.nset = nset;
+		region.words.swap(words);
+	}
+
+	std::vector< word_t > release_buffer() { return std::move(words); }
+
+private:
+	void append_fill_words(bool bit, uint64_t count) {
+		if (count == 0)
+			return;
+		const word_t fill = FILL_FLAG | (bit ? FILL_BIT_FLAG : 0);
+		if (!words.empty() && (words.back() & (FILL_FLAG | FILL_BIT_FLAG)) == fill) {
+			assert((words.back() & FILL_LENGTH_MASK) + count <= FILL_LENGTH_MASK);
+			words.back() += count;
+		} else {
+			words.push_back(fill | count);
+		}
+		groups_appended += count;
+		nset += bit ? count * BITS_PER_GROUP : 0;
+	}
+
+	void append_literal_word(word_t literal) {
+		words.push_back(literal);
+		++groups_appended;
+		nset += __builtin_popcountll(literal);
+	}
+
+private:
+	const uint64_t domain_size;
+	const uint64_t total_groups;
+	const word_t tail_mask; // Valid bits of the last group
+	uint64_t groups_appended;
+	uint64_t nset;
+	std::vector< word_t > words;
+};
+
+template<> class RegionEncoding::TypeToClass<RegionEncoding::Type::WAH64> { typedef WAH64RegionEncoding REClass; };
+
+BOOST_CLASS_IMPLEMENTATION(WAH64RegionEncoding, boost::serialization::object_serializable) // no version information serialized
+
+#endif /* WAH64_HPP_ */
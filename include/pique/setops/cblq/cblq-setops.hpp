@@ -24,6 +24,8 @@
 #define CBLQ_SETOPS_HPP_
 
 #include <cstdlib>
+#include <algorithm>
+#include <thread>
 #include <vector>
 #include <boost/smart_ptr.hpp>
 
@@ -46,7 +48,7 @@ public:
 	static constexpr int NDIM = ndim;
 
 	typedef CBLQSetOperationsConfig SetOperationsConfig;
-	CBLQSetOperations(CBLQSetOperationsConfig conf) : conf(conf), suppress_compact(false) {}
+	CBLQSetOperations(CBLQSetOperationsConfig conf) : conf(conf) {}
 	virtual ~CBLQSetOperations() {}
 
 protected:
@@ -61,7 +63,7 @@ private:
 
 protected:
     const CBLQSetOperationsConfig conf;
-    mutable bool suppress_compact;
+    static thread_local bool suppress_compact; // Per-thread, so that concurrent operations on distinct regions are safe
 
     template<int ndim2> friend class CBLQSetOperationsFast; // Allows delegation upward to this class
 };
@@ -157,7 +159,7 @@ public:
 	CBLQSetOperationsNAry3Fast(CBLQSetOperationsConfig conf) : CBLQSetOperationsFast<ndim>(conf) {}
 	virtual ~CBLQSetOperationsNAry3Fast() {}
 
-private:
+protected:
 	//virtual boost::shared_ptr< CBLQRegionEncoding<ndim> > binary_set_op(boost::shared_ptr< const CBLQRegionEncoding<ndim> > left, boost::shared_ptr< const CBLQRegionEncoding<ndim> > right, NArySetOperation op) const;
 
 	using typename CBLQSetOperations<ndim>::RegionEncodingCPtrCIter;
@@ -165,6 +167,61 @@ private:
 
     template<NArySetOperation op>
     inline boost::shared_ptr< CBLQRegionEncoding<ndim> > nary_set_op_impl(RegionEncodingCPtrCIter cblq_it, RegionEncodingCPtrCIter cblq_end_it) const;
+
+protected:
+    // The words of one operand taking part in (a span of) an n-ary set operation: for each level, the offset of the first
+    // such word among all of the operand's words, and the number of such words (and likewise for dense suffix semiwords)
+    struct OperandSpan {
+    	std::vector< uint64_t > level_word_begins, level_word_counts;
+    	uint64_t dense_begin, dense_count;
+    };
+
+    // Checks that the operands are compatible and gathers them, each with a span covering all of its words (padding any dense
+    // suffixes, so this must be done before operands are shared between threads). Returns whether the output has a dense suffix.
+    static bool prepare_operands(RegionEncodingCPtrCIter cblq_it, RegionEncodingCPtrCIter cblq_end_it, std::vector< const CBLQRegionEncoding<ndim> * > &operands, std::vector< OperandSpan > &spans);
+
+    // Processes the non-dense levels [first_level, end_level) of the given spans of the operands, appending output words and
+    // level lengths. level_inds/level_len give the output positions of the operands' words at first_level, and are updated for
+    // end_level. If output_semiwords is non-null, the dense suffix is then processed as well (requires end_level to be the last
+    // non-dense level). Only reads the operands, so concurrent calls over disjoint spans are safe.
+    template<NArySetOperation op>
+    static void nary_set_op_levels(
+    		const std::vector< const CBLQRegionEncoding<ndim> * > &operands, const std::vector< OperandSpan > &spans,
+    		int first_level, int end_level, bool has_dense_suffix,
+    		std::vector< int64_t > &level_inds, uint64_t &level_len,
+    		std::vector< cblq_word_t > &output_words, std::vector< size_t > &output_level_lens, CBLQSemiwords<ndim> *output_semiwords);
+};
+
+// Level-by-level nary set ops as above, but once a level is large enough, it is split into independent spans (each covering
+// a range of that level's output words, and all of their descendants), which are processed concurrently on nthreads threads.
+// Provides intra-operation parallelism for very large regions.
+template<int ndim>
+class CBLQSetOperationsNAry3FastParallel : public CBLQSetOperationsNAry3Fast<ndim> {
+public:
+	static constexpr uint64_t DEFAULT_MIN_WORDS_PER_SPAN = 1ULL << 12;
+	static constexpr int SPANS_PER_THREAD = 4; // Spans are handed out to threads dynamically, to balance uneven spans
+
+	// nthreads == 0 means one thread per hardware thread
+	CBLQSetOperationsNAry3FastParallel(CBLQSetOperationsConfig conf, int nthreads = 0, uint64_t min_words_per_span = DEFAULT_MIN_WORDS_PER_SPAN) :
+		CBLQSetOperationsNAry3Fast<ndim>(conf),
+		nthreads(nthreads > 0 ? nthreads : std::max(1, (int)std::thread::hardware_concurrency())),
+		min_words_per_span(min_words_per_span)
+	{}
+	virtual ~CBLQSetOperationsNAry3FastParallel() {}
+
+private:
+	using typename CBLQSetOperationsNAry3Fast<ndim>::RegionEncodingCPtrCIter;
+	using typename CBLQSetOperationsNAry3Fast<ndim>::OperandSpan;
+    typedef typename CBLQRegionEncoding<ndim>::cblq_word_t cblq_word_t;
+
+    virtual boost::shared_ptr< CBLQRegionEncoding<ndim> > nary_set_op_impl(RegionEncodingCPtrCIter region_it, RegionEncodingCPtrCIter region_end_it, NArySetOperation op) const;
+
+    template<NArySetOperation op>
+    boost::shared_ptr< CBLQRegionEncoding<ndim> > parallel_nary_set_op_impl(RegionEncodingCPtrCIter cblq_it, RegionEncodingCPtrCIter cblq_end_it) const;
+
+private:
+    const int nthreads;
+    const uint64_t min_words_per_span; // A level is split once it has at least this many output words per span
 };
 
 #endif /* CBLQ_SETOPS_HPP_ */
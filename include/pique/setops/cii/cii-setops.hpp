@@ -60,6 +60,17 @@ protected:
     boost::shared_ptr< CIIRegionEncoding > binary_set_op_mixed(boost::shared_ptr< const CIIRegionEncoding > left, boost::shared_ptr< const CIIRegionEncoding > right, NArySetOperation op) const;
     boost::shared_ptr< CIIRegionEncoding > binary_set_op_uncompressed(boost::shared_ptr< const CIIRegionEncoding > left, boost::shared_ptr< const CIIRegionEncoding > right, NArySetOperation op) const;
 
+    // Intersection or difference of a small operand with a much larger, compressed one, probing the larger operand
+    // through its skip table so only the chunks that can overlap the smaller operand are decoded.
+    // Returns nullptr if the operands/operation are not suited to this
+    boost::shared_ptr< CIIRegionEncoding > binary_set_op_skipping(boost::shared_ptr< const CIIRegionEncoding > left, boost::shared_ptr< const CIIRegionEncoding > right, NArySetOperation op) const;
+
+    // An upper bound on the number of RIDs a CII stores (ignoring inversion), computed without decoding it
+    static uint64_t get_stored_rid_bound(const CIIRegionEncoding &cii);
+
+    // The larger operand must store at least this many times as many RIDs as the smaller for binary_set_op_skipping to apply
+    static constexpr uint64_t SKIPPING_SIZE_RATIO = 16;
+
 protected:
     const CIISetOperationsConfig conf;
 };
@@ -201,10 +201,17 @@ protected: // Helper functions
 
 
 
+class AbstractRegionEncodingConverter;
+
 // Attempts to apply any of a list of AbstractSetOperations to a given set of operands; the first AbstractSetOperations that
-// accepts all operand types is applied.
+// accepts all operand types is applied. If none accepts them all (e.g., for regions of a heterogeneous index), the operands
+// are first converted to a common representation: that of the first (and output) operand for in-place operations, or otherwise
+// that of the largest operand that some AbstractSetOperations in the list accepts, so that the least data is converted.
 class PreferenceListSetOperations : public AbstractSetOperations, public std::vector< boost::shared_ptr< AbstractSetOperations > > {
 public:
+	PreferenceListSetOperations(); // Converts operands with a RIDStreamRegionEncodingConverter
+	PreferenceListSetOperations(boost::shared_ptr< const AbstractRegionEncodingConverter > converter) : converter(converter) {}
+
 	virtual bool can_handle_region_encoding(RegionEncoding::Type type) const;
 
 private: // AbstractSetOperations impl. stub implementations
@@ -220,6 +227,17 @@ private: // AbstractSetOperations impl. stub implementations
 
 	virtual REPtr dynamic_nary_set_op_impl(RegionEncodingCPtrCIter it, RegionEncodingCPtrCIter end_it, NArySetOperation op) const;
 	virtual void dynamic_inplace_nary_set_op_impl(REPtr first_and_out, RegionEncodingCPtrCIter it, RegionEncodingCPtrCIter end_it, NArySetOperation op) const;
+
+private:
+	// Returns the first AbstractSetOperations in the list accepting all of the given operand types, or nullptr if there is none
+	boost::shared_ptr< AbstractSetOperations > get_setops_for_types(const std::vector< RegionEncoding::Type > &types) const;
+	// Returns the representation to which to convert the given operands (for non-in-place operations)
+	RegionEncoding::Type get_common_type(RegionEncodingCPtrCIter it, RegionEncodingCPtrCIter end_it) const;
+	// Returns operand itself if it already has the given representation, or otherwise a converted copy
+	RECPtr convert_operand(RECPtr operand, RegionEncoding::Type type) const;
+
+private:
+	boost::shared_ptr< const AbstractRegionEncodingConverter > converter;
 };
 
 // Chooses between two underlying set operation implementations based on the arity of the requested operation
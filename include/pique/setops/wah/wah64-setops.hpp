@@ -0,0 +1,62 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * wah64-setops.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#pragma once
+
+#include <vector>
+#include <boost/smart_ptr.hpp>
+
+#include "pique/region/region-encoding.hpp"
+#include "pique/region/wah/wah64.hpp"
+#include "pique/setops/setops.hpp"
+
+struct WAH64SetOperationsConfig {};
+
+// Set operations over WAH64RegionEncodings, merging the operands run-by-run (so fills are processed in O(1)
+// regardless of length). N-ary operations merge all operands together in a single pass.
+class WAH64SetOperations : public SetOperations< WAH64RegionEncoding > {
+public:
+	typedef WAH64SetOperationsConfig SetOperationsConfig;
+	typedef WAH64RegionEncoding::word_t word_t;
+
+	WAH64SetOperations(WAH64SetOperationsConfig conf) : conf(conf) {}
+	virtual ~WAH64SetOperations() {}
+
+private:
+    virtual boost::shared_ptr< WAH64RegionEncoding > unary_set_op_impl(boost::shared_ptr< const WAH64RegionEncoding > region, UnarySetOperation op) const;
+    virtual void inplace_unary_set_op_impl(boost::shared_ptr< WAH64RegionEncoding > region_and_out, UnarySetOperation op) const;
+
+    virtual boost::shared_ptr< WAH64RegionEncoding > binary_set_op_impl(boost::shared_ptr< const WAH64RegionEncoding > left, boost::shared_ptr< const WAH64RegionEncoding > right, NArySetOperation op) const;
+    virtual void inplace_binary_set_op_impl(boost::shared_ptr< WAH64RegionEncoding > left_and_out, boost::shared_ptr< const WAH64RegionEncoding > right, NArySetOperation op) const;
+
+    using typename SetOperations< WAH64RegionEncoding >::RegionEncodingCPtrCIter;
+    virtual boost::shared_ptr< WAH64RegionEncoding > nary_set_op_impl(RegionEncodingCPtrCIter it, RegionEncodingCPtrCIter end_it, NArySetOperation op) const;
+    virtual void inplace_nary_set_op_impl(boost::shared_ptr< WAH64RegionEncoding > first_and_out, RegionEncodingCPtrCIter it, RegionEncodingCPtrCIter end_it, NArySetOperation op) const;
+
+    // Combines right into left, building the result in scratch's storage (which then receives left's old storage)
+    void inplace_binary_set_op_recycling(WAH64RegionEncoding &left, const WAH64RegionEncoding &right, NArySetOperation op, std::vector< word_t > &scratch) const;
+
+    // Computes the n-ary set operation over operands into out (which may also be one of the operands)
+    void nary_set_op_single_pass(const std::vector< const WAH64RegionEncoding * > &operands, NArySetOperation op, WAH64RegionEncoding &out) const;
+
+protected:
+    const WAH64SetOperationsConfig conf;
+};
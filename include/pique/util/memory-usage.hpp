@@ -0,0 +1,43 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * memory-usage.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef MEMORY_USAGE_HPP_
+#define MEMORY_USAGE_HPP_
+
+#include <cstdint>
+#include <sys/resource.h>
+
+// Returns the peak resident set size of this process so far, in bytes (or 0 if it cannot be determined)
+inline uint64_t get_peak_rss_bytes() {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+#if defined(__APPLE__)
+	return (uint64_t)usage.ru_maxrss; // Reported in bytes
+#else
+	return (uint64_t)usage.ru_maxrss * 1024; // Reported in kilobytes
+#endif
+}
+
+#endif /* MEMORY_USAGE_HPP_ */
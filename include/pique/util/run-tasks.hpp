@@ -0,0 +1,49 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * run-tasks.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#ifndef RUN_TASKS_HPP_
+#define RUN_TASKS_HPP_
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Runs task_fn(task) for each task in [0, ntasks) on up to nthreads threads (including this one), handing out tasks dynamically
+template<typename TaskFn>
+static inline void run_tasks_concurrently(int nthreads, size_t ntasks, TaskFn task_fn) {
+	std::atomic< size_t > next_task(0);
+	auto worker_fn = [&next_task, ntasks, &task_fn]() {
+		size_t task;
+		while ((task = next_task++) < ntasks)
+			task_fn(task);
+	};
+
+	std::vector< std::thread > helpers;
+	for (size_t i = 1; i < std::min((size_t)nthreads, ntasks); ++i)
+		helpers.emplace_back(worker_fn);
+	worker_fn();
+	for (std::thread &helper : helpers)
+		helper.join();
+}
+
+#endif /* RUN_TASKS_HPP_ */
@@ -17,9 +17,8 @@
 /*
  * zo-iter2.hpp
  *
- * TODO: Switch ZOIterLoopBody from std::function<> to function pointer,
- * templated/lambda functor, or other potentially-statically-optimizable
- * loop body form.
+ * Loop bodies are passed as template functors (e.g., lambdas), so they may be
+ * inlined into the loop; ZOIterLoopBody remains usable as a type-erased body.
  *
  *  Created on: Apr 7, 2014
  *      Author: David A. Boyuka II
@@ -28,6 +27,9 @@
 #ifndef ZO_ITER2_HPP_
 #define ZO_ITER2_HPP_
 
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <boost/mpl/if.hpp>
 #include <boost/mpl/comparison.hpp>
 #include <functional>
@@ -37,7 +39,8 @@ typedef std::function<void(uint64_t,uint64_t,uint64_t[])> ZOIterLoopBody;
 // NOTE: Dimensions are in FORTRAN order! dims[0] is the fastest-varying dimension
 template<int ndim, int bitpos>
 struct ZOIterLoopCore {
-	static inline void iterate_core(uint64_t &zid, uint64_t &rmoid, uint64_t coords[ndim], const uint64_t dims[ndim], const uint64_t strides[ndim], ZOIterLoopBody &loop_body) {
+	template<typename LoopBodyT>
+	static inline void iterate_core(uint64_t &zid, uint64_t &rmoid, uint64_t coords[ndim], const uint64_t dims[ndim], const uint64_t strides[ndim], LoopBodyT &loop_body) {
 		const int dimscale = bitpos / ndim;
 		const int whichdim = bitpos % ndim;
 		const uint64_t zid_mask = 1ULL << (bitpos);
@@ -63,7 +66,8 @@ struct ZOIterLoopCore {
 
 template<int ndim>
 struct ZOIterLoopCore<ndim, 0> {
-	static inline void iterate_core(uint64_t &zid, uint64_t &rmoid, uint64_t coords[ndim], const uint64_t dims[ndim], const uint64_t strides[ndim], ZOIterLoopBody &loop_body) {
+	template<typename LoopBodyT>
+	static inline void iterate_core(uint64_t &zid, uint64_t &rmoid, uint64_t coords[ndim], const uint64_t dims[ndim], const uint64_t strides[ndim], LoopBodyT &loop_body) {
 		const uint64_t zid_mask = 1ULL;
 		const uint64_t coord_mask = 1ULL;
 
@@ -90,7 +94,8 @@ struct ZOIterLoopCore<ndim, 0> {
 
 template<int ndim, int bitpos>
 struct ZOIterLoopCoreOverflow {
-	static inline void iterate_core(uint64_t &zid, uint64_t &rmoid, uint64_t coords[ndim], const uint64_t dims[ndim], const uint64_t strides[ndim], ZOIterLoopBody &loop_body) {
+	template<typename LoopBodyT>
+	static inline void iterate_core(uint64_t &zid, uint64_t &rmoid, uint64_t coords[ndim], const uint64_t dims[ndim], const uint64_t strides[ndim], LoopBodyT &loop_body) {
 		fprintf(stderr, "Error: attempt to execute %d-dimension Z-order loop with %d Z-order bits; 64 is maximum\n", ndim, bitpos+1);
 		abort();
 	}
@@ -103,7 +108,8 @@ class ZOIterLoop : private boost::mpl::if_<
 					ZOIterLoopCoreOverflow<ndim, exp_level * ndim - 1>      // ...inherit from code that will immediately abort
 				   >::type {
 public:
-	inline void iterate(const uint64_t dims[ndim], const uint64_t subdims[ndim], bool cOrder, ZOIterLoopBody loop_body) {
+	template<typename LoopBodyT>
+	inline void iterate(const uint64_t dims[ndim], const uint64_t subdims[ndim], bool cOrder, LoopBodyT loop_body) {
 		uint64_t zid = 0;
 		uint64_t rmoid = 0;
 		uint64_t coords[ndim] = {}; // All 0
@@ -123,15 +129,23 @@ public:
 	}
 };
 
-template<int ndim>
-inline void zo_loop_iterate(const uint64_t dims[], const uint64_t subdims[], bool cOrder, ZOIterLoopBody loop_body) {
+// Computes the smallest integer "exp_level" such that 2^exp_level >= dims[i] for all i (i.e., the number of
+// Z-order bits per dimension needed to address the grid)
+inline int compute_zo_exp_level(int ndim, const uint64_t dims[]) {
 	uint64_t maxdim = 0;
 	for (int i = 0; i < ndim; ++i)
 		if (maxdim < dims[i])
 			maxdim = dims[i];
 
-	int exp_level;
-	for (exp_level = 0; maxdim > 1; ++exp_level, maxdim >>= 1);
+	int exp_level = 0;
+	while (exp_level < 64 && (1ULL << exp_level) < maxdim)
+		++exp_level;
+	return exp_level;
+}
+
+template<int ndim, typename LoopBodyT>
+inline void zo_loop_iterate(const uint64_t dims[], const uint64_t subdims[], bool cOrder, LoopBodyT loop_body) {
+	const int exp_level = compute_zo_exp_level(ndim, dims);
 
 	if (exp_level > 64)
 		abort();
@@ -148,13 +162,15 @@ inline void zo_loop_iterate(const uint64_t dims[], const uint64_t subdims[], boo
 }
 
 
-inline void zo_loop_iterate(int ndim, const uint64_t dims[], const uint64_t subdims[], bool cOrder, ZOIterLoopBody loop_body) {
+template<typename LoopBodyT>
+inline void zo_loop_iterate(int ndim, const uint64_t dims[], const uint64_t subdims[], bool cOrder, LoopBodyT loop_body) {
 	switch (ndim) {
 	case 1: zo_loop_iterate<1>(dims, subdims, cOrder, loop_body); return;
 	case 2: zo_loop_iterate<2>(dims, subdims, cOrder, loop_body); return;
 	case 3: zo_loop_iterate<3>(dims, subdims, cOrder, loop_body); return;
 	case 4: zo_loop_iterate<4>(dims, subdims, cOrder, loop_body); return;
 	case 5: zo_loop_iterate<5>(dims, subdims, cOrder, loop_body); return;
+	default: abort();
 	}
 }
 
@@ -25,8 +25,9 @@ AC_ARG_WITH(
   )]dnl
 )
 
-dnl If the ridcompress lib was specified, verify that it exists and can compile
-if test "x$with_ridcompress" != xno; then
+dnl If the ridcompress lib was specified, verify that it exists and can compile; otherwise, CII
+dnl regions are built with the in-tree BP128 codec only
+if test "x$with_ridcompress" != xno -a "x$with_ridcompress" != x; then
     RIDCOMPRESS_CPPFLAGS="-I$with_ridcompress -I$with_ridcompress/include"
     RIDCOMPRESS_LDFLAGS="-L$with_ridcompress -L$with_ridcompress/lib"
     RIDCOMPRESS_LIBS="-lridcompress"
@@ -50,7 +51,7 @@ if test "x$with_ridcompress" != xno; then
       [ridcompress],
       [encode_rids],
       [AC_DEFINE(
-        [HAVE_LIBRIDCOMPRESS],
+        [HAVE_RIDCOMPRESS],
         [1],
         [Define if you have libridcompress]
       )],
@@ -67,10 +68,10 @@ if test "x$with_ridcompress" != xno; then
     AC_SUBST(RIDCOMPRESS_CPPFLAGS)
     AC_SUBST(RIDCOMPRESS_LDFLAGS)
     AC_SUBST(RIDCOMPRESS_LIBS)
+
+    AC_MSG_RESULT([RID compression library found at $with_ridcompress])
 else
-  AC_MSG_FAILURE(
-    [--with-ridcompress is required]dnl
-  )
+  AC_MSG_RESULT([Not building with RID compression library; CII regions will use BP128 compression only])
 fi
 
 ]) dnl End of DEFUN
@@ -21,12 +21,21 @@
  *      Author: David A. Boyuka II
  */
 
+#include <algorithm>
 #include <functional>
+#include <vector>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
 #include <boost/smart_ptr.hpp>
 #include <boost/make_shared.hpp>
 
 #include "pique/region/cblq/cblq-traversal.hpp"
+#include "pique/region/cblq/cblq-word-ops.hpp"
+#include "pique/util/dilate.hpp"
+#include "pique/util/run-tasks.hpp"
 #include "pique/convert/cblq/cblq-to-bitmap-convert.hpp"
 
 // Assumes:
@@ -390,10 +399,370 @@ inline boost::shared_ptr<BitmapRegionEncoding> CBLQToBitmapDFConverter<ndim>::co
 	return out;
 }
 
-// Explicit template instantiation for 2D-4D CBLQs
+// Parallel method
+
+// Bit expansions of groups of codes whose children are leaf words (of 2^ndim elements each) into the elements they cover
+template<int ndim>
+struct LeafCodeExpansion {
+	static constexpr int ELEMENTS_PER_LEAF = (1 << ndim);
+	static constexpr uint64_t LEAF_ONES = ((uint64_t)1 << ELEMENTS_PER_LEAF) - 1;
+	static constexpr uint64_t LEAF_BASES = ~(uint64_t)0 / LEAF_ONES; // The lowest bit of each leaf's bits within a 64-bit block
+
+	// Spreads bit i of code_mask to the bits of the ith leaf, [i*2^ndim, (i+1)*2^ndim)
+	static inline uint64_t spread(uint64_t code_mask) {
+#ifdef __BMI2__
+		return _pdep_u64(code_mask, LEAF_BASES) * LEAF_ONES; // Leaves' bits are disjoint, so the multiply never carries
+#else
+		uint64_t bits = 0;
+		for (; code_mask; code_mask &= code_mask - 1)
+			bits |= LEAF_ONES << (__builtin_ctzll(code_mask) * ELEMENTS_PER_LEAF);
+		return bits;
+#endif
+	}
+
+	// Deposits consecutive leaf semiwords (packed, lowest first) into the leaves' bits selected by leaf_mask (a spread mask)
+	static inline uint64_t deposit(uint64_t semiwords, uint64_t leaf_mask) {
+#ifdef __BMI2__
+		return _pdep_u64(semiwords, leaf_mask);
+#else
+		uint64_t bits = 0;
+		for (; leaf_mask; leaf_mask &= ~(LEAF_ONES << __builtin_ctzll(leaf_mask)), semiwords >>= ELEMENTS_PER_LEAF)
+			bits |= (semiwords & LEAF_ONES) << __builtin_ctzll(leaf_mask);
+		return bits;
+#endif
+	}
+};
+
+// Combines bits of a CBLQ into a bitmap according to a set operation (with the bitmap on the left). Each thread writes a
+// disjoint range of blocks, so no synchronization is needed.
+template<NArySetOperation combineop>
+class BitmapBlockCombiner {
+public:
+	using block_t = BitmapRegionEncoding::block_t;
+
+	BitmapBlockCombiner(std::vector< block_t > &out_bits) : out_blocks(out_bits.data()), nblocks(out_bits.size()) {}
+
+	// Combines nbits <= 64 bits at offset (which is aligned to nbits)
+	inline void combine_bits(uint64_t offset, block_t bits, int nbits) const {
+		const uint64_t blockpos = offset / BitmapRegionEncoding::BITS_PER_BLOCK;
+		if (blockpos >= this->nblocks)
+			return; // Outside the domain
+
+		const int shift = offset % BitmapRegionEncoding::BITS_PER_BLOCK;
+		const block_t mask = (nbits < BitmapRegionEncoding::BITS_PER_BLOCK ? (((block_t)1 << nbits) - 1) : ~(block_t)0) << shift;
+		combine_block(this->out_blocks[blockpos], bits << shift, mask);
+	}
+
+	// Combines count uniform bits at offset (both multiples of 64)
+	inline void combine_uniform(uint64_t offset, uint64_t count, bool filled) const {
+		if (filled == (combineop == NArySetOperation::INTERSECTION))
+			return; // Intersecting with 1s, or otherwise combining with 0s, is a no-op
+
+		const uint64_t begin_block = offset / BitmapRegionEncoding::BITS_PER_BLOCK;
+		if (begin_block >= this->nblocks)
+			return; // Outside the domain
+		const uint64_t end_block = std::min(this->nblocks, begin_block + count / BitmapRegionEncoding::BITS_PER_BLOCK);
+
+		block_t * const begin = this->out_blocks + begin_block, * const end = this->out_blocks + end_block;
+		if (combineop == NArySetOperation::UNION)
+			std::fill(begin, end, ~(block_t)0);
+		else if (combineop == NArySetOperation::SYMMETRIC_DIFFERENCE)
+			for (block_t *block = begin; block != end; ++block)
+				*block = ~*block;
+		else // Intersecting with 0s, or subtracting 1s
+			std::fill(begin, end, (block_t)0);
+	}
+
+private:
+	static inline void combine_block(block_t &block, block_t bits, block_t mask) {
+		if (combineop == NArySetOperation::UNION)
+			block |= bits;
+		else if (combineop == NArySetOperation::INTERSECTION)
+			block &= bits | ~mask;
+		else if (combineop == NArySetOperation::DIFFERENCE)
+			block &= ~bits;
+		else if (combineop == NArySetOperation::SYMMETRIC_DIFFERENCE)
+			block ^= bits;
+	}
+
+private:
+	block_t * const out_blocks;
+	const uint64_t nblocks;
+};
+
+// The raw CBLQ arrays needed to decode it
+template<int ndim>
+struct CBLQDecodeInput {
+	const typename CBLQRegionEncoding<ndim>::cblq_word_t *words;
+	std::vector< uint64_t > level_begins; // The position in words of the first word of each level
+	int levels;
+	bool has_dense_suffix;
+	const uint64_t *semiword_blocks; // The dense suffix, as a stream of packed semiwords
+	size_t num_semiword_blocks;
+
+	// log2 of the number of elements covered by each word at the given level
+	int word_elements_log2(int level) const { return (this->levels - level) * ndim; }
+};
+
+// Decodes CBLQ subtrees depth-first, with a cursor at each level. Since each level's words are the children of the previous
+// level's 2-codes in order, visiting a level's words in order (as depth-first traversal does) keeps the cursors in sync.
+template<int ndim, NArySetOperation combineop>
+class CBLQSubtreeDecoder {
+public:
+	using cblq_word_t = typename CBLQRegionEncoding<ndim>::cblq_word_t;
+	using block_t = BitmapRegionEncoding::block_t;
+	using WordOps = CBLQWordOps<ndim>;
+
+	static constexpr int CODES_PER_WORD = CBLQRegionEncoding<ndim>::CODES_PER_WORD;
+	static constexpr int BLOCK_BITS_LOG2 = 6;
+	static_assert(BitmapRegionEncoding::BITS_PER_BLOCK == (1 << BLOCK_BITS_LOG2), "bitmap blocks must be 64 bits");
+
+	// cursors holds the position of the next word at each level (in words, or the next semiword of the dense suffix)
+	CBLQSubtreeDecoder(const CBLQDecodeInput<ndim> &in, std::vector< uint64_t > cursors, const BitmapBlockCombiner<combineop> &out) :
+		in(in), cursors(std::move(cursors)), out(out)
+	{}
+
+	// Combines the subtree of the next word at the given level, which covers the elements starting at offset
+	void decode_subtree(int level, uint64_t offset) {
+		const int elements_log2 = this->in.word_elements_log2(level);
+		if (elements_log2 > BLOCK_BITS_LOG2)
+			this->decode_word(level, offset);
+		else
+			this->out.combine_bits(offset, this->assemble_word(level), 1 << elements_log2);
+	}
+
+	// As decode_subtree, but stops at split_level (whose words each cover whole blocks), appending the offsets of the words
+	// there to split_offsets rather than decoding them
+	void decode_top(int level, uint64_t offset, int split_level, std::vector< uint64_t > &split_offsets) {
+		const cblq_word_t word = this->in.words[this->cursors[level]++];
+		const int child_elements_log2 = this->in.word_elements_log2(level + 1);
+		for (int i = 0; i < CODES_PER_WORD; ++i) {
+			const int code = (word >> (i * CBLQRegionEncoding<ndim>::BITS_PER_CODE)) & 0b11;
+			const uint64_t child_offset = offset + ((uint64_t)i << child_elements_log2);
+			if (code != 0b10)
+				this->out.combine_uniform(child_offset, 1ULL << child_elements_log2, code == 0b01);
+			else if (level + 1 == split_level)
+				split_offsets.push_back(child_offset);
+			else
+				this->decode_top(level + 1, child_offset, split_level, split_offsets);
+		}
+	}
+
+private:
+	// Combines the subtree of the next word at the given level, which covers more than a block
+	void decode_word(int level, uint64_t offset) {
+		const cblq_word_t word = this->in.words[this->cursors[level]++];
+		const int child_elements_log2 = this->in.word_elements_log2(level + 1);
+
+		if (child_elements_log2 >= BLOCK_BITS_LOG2) {
+			for (int i = 0; i < CODES_PER_WORD; ++i) {
+				const int code = (word >> (i * CBLQRegionEncoding<ndim>::BITS_PER_CODE)) & 0b11;
+				const uint64_t child_offset = offset + ((uint64_t)i << child_elements_log2);
+				if (code == 0b10)
+					this->decode_subtree(level + 1, child_offset);
+				else
+					this->out.combine_uniform(child_offset, 1ULL << child_elements_log2, code == 0b01);
+			}
+		} else {
+			// Children are smaller than a block, so assemble each block from a group of codes
+			const int codes_per_block = 1 << (BLOCK_BITS_LOG2 - child_elements_log2);
+			for (int i = 0; i < CODES_PER_WORD; i += codes_per_block) {
+				const uint64_t block_offset = offset + ((uint64_t)i << child_elements_log2);
+				this->out.combine_bits(block_offset, this->assemble_codes(level, word >> (i * CBLQRegionEncoding<ndim>::BITS_PER_CODE), codes_per_block), BitmapRegionEncoding::BITS_PER_BLOCK);
+			}
+		}
+	}
+
+	// Returns the bits covered by the next word at the given level, which covers at most a block
+	block_t assemble_word(int level) {
+		if (level == this->in.levels - 1) {
+			if (this->in.has_dense_suffix)
+				return this->next_semiwords(1);
+			else
+				return compact_code_mask(WordOps::one_mask(this->in.words[this->cursors[level]++]));
+		}
+
+		return this->assemble_codes(level, this->in.words[this->cursors[level]++], CODES_PER_WORD);
+	}
+
+	// Returns the bits covered by the first ncodes codes of a word at the given level (which cover at most a block)
+	block_t assemble_codes(int level, cblq_word_t word, int ncodes) {
+		const uint64_t codes_mask = ((uint64_t)1 << ncodes) - 1;
+		const uint64_t ones = compact_code_mask(WordOps::one_mask(word)) & codes_mask;
+		const uint64_t twos = compact_code_mask(WordOps::two_mask(word)) & codes_mask;
+
+		// Leaf children in the dense suffix are contiguous semiwords, so deposit them all at once
+		if (level == this->in.levels - 2 && this->in.has_dense_suffix) {
+			using Expansion = LeafCodeExpansion<ndim>;
+			return Expansion::spread(ones) | Expansion::deposit(this->next_semiwords(__builtin_popcountll(twos)), Expansion::spread(twos));
+		}
+
+		const int child_elements_log2 = this->in.word_elements_log2(level + 1);
+		const block_t child_ones = ((block_t)1 << (1 << child_elements_log2)) - 1;
+
+		block_t bits = 0;
+		for (uint64_t mask = ones; mask; mask &= mask - 1)
+			bits |= child_ones << (__builtin_ctzll(mask) << child_elements_log2);
+		for (uint64_t mask = twos; mask; mask &= mask - 1)
+			bits |= this->assemble_word(level + 1) << (__builtin_ctzll(mask) << child_elements_log2);
+		return bits;
+	}
+
+	// Returns the next count semiwords of the dense suffix, packed (count * 2^ndim <= 64)
+	block_t next_semiwords(int count) {
+		const uint64_t bitpos = this->cursors[this->in.levels - 1] * CBLQRegionEncoding<ndim>::BITS_PER_SEMIWORD;
+		const uint64_t blockpos = bitpos / 64;
+		const int shift = bitpos % 64;
+		this->cursors[this->in.levels - 1] += count;
+
+		uint64_t bits = this->in.semiword_blocks[blockpos] >> shift;
+		if (shift != 0 && blockpos + 1 < this->in.num_semiword_blocks)
+			bits |= this->in.semiword_blocks[blockpos + 1] << (64 - shift);
+
+		const int nbits = count * CBLQRegionEncoding<ndim>::BITS_PER_SEMIWORD;
+		return nbits < 64 ? bits & (((uint64_t)1 << nbits) - 1) : bits;
+	}
+
+	// Packs a code mask (with a bit per code, at the low bit of the code) into one bit per code
+	static inline uint64_t compact_code_mask(cblq_word_t code_mask) {
+		return Dilater< cblq_word_t, 2 >::undilate(code_mask);
+	}
+
+private:
+	const CBLQDecodeInput<ndim> &in;
+	std::vector< uint64_t > cursors;
+	const BitmapBlockCombiner<combineop> &out;
+};
+
+// ASSUMPTION: Within a CBLQ, the region outside of the domain size will either be all black or all white; no mix
+template<int ndim>
+template<NArySetOperation combineop>
+void CBLQToBitmapParallelConverter<ndim>::inplace_convert(boost::shared_ptr<const CBLQRegionEncoding<ndim> > in_right, boost::shared_ptr< BitmapRegionEncoding > out_combine_left) const {
+	using Decoder = CBLQSubtreeDecoder< ndim, combineop >;
+
+	assert(in_right->get_domain_size() == out_combine_left->get_domain_size());
+
+	const int levels = in_right->get_num_levels();
+	if (levels == 0)
+		return;
+
+	CBLQDecodeInput<ndim> in;
+	in.words = in_right->words.data();
+	in.levels = levels;
+	in.has_dense_suffix = in_right->has_dense_suffix;
+	in.semiword_blocks = in_right->dense_suffix->semiwords.data();
+	in.num_semiword_blocks = in_right->dense_suffix->semiwords.size();
+	in.level_begins.resize(levels);
+	uint64_t level_begin = 0;
+	for (int level = 0; level < levels; ++level) {
+		in.level_begins[level] = level_begin;
+		level_begin += in_right->level_lens[level];
+	}
+
+	const BitmapBlockCombiner<combineop> out(out_combine_left->bits);
+
+	std::vector< uint64_t > cursors = in.level_begins;
+	if (in.has_dense_suffix)
+		cursors[levels - 1] = 0; // The leaf level is indexed in the dense suffix
+
+	// Find the first level with enough words to split, among the (non-root) levels whose words cover whole blocks
+	const int non_dense_levels = in.has_dense_suffix ? levels - 1 : levels;
+	const size_t num_spans = (size_t)this->nthreads * SPANS_PER_THREAD;
+	int split_level = 1;
+	while (split_level < non_dense_levels &&
+		   in.word_elements_log2(split_level) >= Decoder::BLOCK_BITS_LOG2 &&
+		   in_right->level_lens[split_level] < num_spans * this->min_words_per_span)
+	{
+		++split_level;
+	}
+
+	if (this->nthreads <= 1 || split_level >= non_dense_levels || in.word_elements_log2(split_level) < Decoder::BLOCK_BITS_LOG2) {
+		Decoder(in, std::move(cursors), out).decode_subtree(0, 0); // Never large enough; convert on this thread
+		return;
+	}
+
+	// Decode the levels above the split level on this thread, collecting the offsets of the split level's words
+	std::vector< uint64_t > split_offsets;
+	split_offsets.reserve(in_right->level_lens[split_level]);
+	Decoder top_decoder(in, cursors, out);
+	top_decoder.decode_top(0, 0, split_level, split_offsets);
+	assert(split_offsets.size() == in_right->level_lens[split_level]);
+
+	// Divide the split level's words evenly among the spans, then find each span's first word at each lower level. As in
+	// CBLQSetOperationsNAry3FastParallel, the children of a level's words [b, e) are the next level's words [P(b), P(e)),
+	// where P(x) is the number of 2-codes among the level's first x words.
+	std::vector< uint64_t > span_split_begins(num_spans + 1);
+	for (size_t span = 0; span <= num_spans; ++span)
+		span_split_begins[span] = split_offsets.size() * span / num_spans;
+
+	std::vector< std::vector< uint64_t > > span_cursors(num_spans + 1, cursors);
+	for (size_t span = 0; span <= num_spans; ++span)
+		span_cursors[span][split_level] = in.level_begins[split_level] + span_split_begins[span];
+
+	std::vector< uint64_t > span_two_codes(num_spans);
+	for (int level = split_level; level + 1 < levels; ++level) {
+		run_tasks_concurrently(this->nthreads, num_spans, [&](size_t span) {
+			const uint64_t begin = span_cursors[span][level], end = span_cursors[span + 1][level];
+			span_two_codes[span] = CBLQWordOps<ndim>::count_two_codes_run(in.words + begin, end - begin);
+		});
+
+		uint64_t next_begin = cursors[level + 1];
+		for (size_t span = 0; span < num_spans; ++span) {
+			span_cursors[span][level + 1] = next_begin;
+			next_begin += span_two_codes[span];
+		}
+		span_cursors[num_spans][level + 1] = next_begin;
+	}
+
+	// Decode all spans concurrently; split level words cover whole blocks, so spans never share an output block
+	run_tasks_concurrently(this->nthreads, num_spans, [&](size_t span) {
+		Decoder span_decoder(in, std::move(span_cursors[span]), out);
+		for (uint64_t word = span_split_begins[span]; word < span_split_begins[span + 1]; ++word)
+			span_decoder.decode_subtree(split_level, split_offsets[word]);
+	});
+}
+
+template<int ndim>
+void CBLQToBitmapParallelConverter<ndim>::inplace_convert(boost::shared_ptr<const CBLQRegionEncoding<ndim> > in_right, boost::shared_ptr< BitmapRegionEncoding > out_combine_left, NArySetOperation combine_op) const {
+	switch (combine_op) {
+	case NArySetOperation::UNION:
+		this->template inplace_convert<NArySetOperation::UNION>(in_right, out_combine_left);
+		break;
+	case NArySetOperation::INTERSECTION:
+		this->template inplace_convert<NArySetOperation::INTERSECTION>(in_right, out_combine_left);
+		break;
+	case NArySetOperation::DIFFERENCE:
+		this->template inplace_convert<NArySetOperation::DIFFERENCE>(in_right, out_combine_left);
+		break;
+	case NArySetOperation::SYMMETRIC_DIFFERENCE:
+		this->template inplace_convert<NArySetOperation::SYMMETRIC_DIFFERENCE>(in_right, out_combine_left);
+		break;
+	}
+}
+
+template<int ndim>
+boost::shared_ptr<BitmapRegionEncoding> CBLQToBitmapParallelConverter<ndim>::convert(boost::shared_ptr< const CBLQRegionEncoding<ndim> > in) const {
+	// Create a new, blank bitmap of sufficient length
+	boost::shared_ptr< BitmapRegionEncoding > out = boost::make_shared< BitmapRegionEncoding >();
+	BitmapRegionEncoding::allocate_nbits(*out, in->get_domain_size());
+
+	// Call the in-place convert algorithm with the union combine op
+	this->inplace_convert(in, out, NArySetOperation::UNION);
+
+	// Return the now-populated bitmap
+	return out;
+}
+
+// Explicit template instantiation for 1D-4D CBLQs
+template class CBLQToBitmapConverter<1>;
 template class CBLQToBitmapConverter<2>;
 template class CBLQToBitmapConverter<3>;
 template class CBLQToBitmapConverter<4>;
+template class CBLQToBitmapDFConverter<1>;
 template class CBLQToBitmapDFConverter<2>;
 template class CBLQToBitmapDFConverter<3>;
 template class CBLQToBitmapDFConverter<4>;
+template class CBLQToBitmapParallelConverter<1>;
+template class CBLQToBitmapParallelConverter<2>;
+template class CBLQToBitmapParallelConverter<3>;
+template class CBLQToBitmapParallelConverter<4>;
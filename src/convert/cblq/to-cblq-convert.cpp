@@ -0,0 +1,279 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * to-cblq-convert.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cassert>
+#include <memory>
+
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include "pique/util/compute-exp-level.hpp"
+#include "pique/util/dilate.hpp"
+#include "pique/setops/cblq/cblq-setops.hpp"
+#include "pique/convert/cblq/to-cblq-convert.hpp"
+
+// CBLQBottomUpBuilder
+
+template<int ndim>
+CBLQBottomUpBuilder<ndim>::CBLQBottomUpBuilder(CBLQRegionEncoderConfig conf, uint64_t nelem) :
+	conf(conf),
+	nelem(nelem),
+	nlevels(compute_exp_level<ndim>(nelem)),
+	// Degenerate (single-element) domains have no levels, as with CBLQRegionEncoder
+	num_leaf_words(nlevels > 0 ? ((uint64_t)1 << ((nlevels - 1) * ndim)) : 0),
+	leaf_words_pushed(0),
+	level_words(nlevels),
+	dense_suffix_semiwords(false),
+	cur_words(nlevels, 0),
+	cur_word_lens(nlevels, 0)
+{}
+
+template<int ndim>
+void CBLQBottomUpBuilder<ndim>::push_code(int level, cblq_word_t code) {
+	cblq_word_t &cur_word = this->cur_words[level];
+	int &cur_word_len = this->cur_word_lens[level];
+
+	cur_word |= code << (cur_word_len * CBLQRegionEncoding<ndim>::BITS_PER_CODE);
+	if (++cur_word_len == CBLQRegionEncoding<ndim>::CODES_PER_WORD) {
+		const cblq_word_t word = cur_word;
+		cur_word = 0;
+		cur_word_len = 0;
+		this->push_word(level, word);
+	}
+}
+
+template<int ndim>
+void CBLQBottomUpBuilder<ndim>::push_uniform_codes(int level, uint64_t count, bool filled) {
+	const cblq_word_t code = filled ? 0b01 : 0b00;
+
+	// Complete the current word first, so the rest of the run is word-aligned
+	while (count > 0 && this->cur_word_lens[level] != 0) {
+		this->push_code(level, code);
+		--count;
+	}
+
+	// Whole words of uniform codes are pure, so carry them up directly (the top word is emitted even if pure, though)
+	if (level < this->nlevels - 1 && count >= CBLQRegionEncoding<ndim>::CODES_PER_WORD) {
+		this->push_uniform_codes(level + 1, count / CBLQRegionEncoding<ndim>::CODES_PER_WORD, filled);
+		count %= CBLQRegionEncoding<ndim>::CODES_PER_WORD;
+	}
+
+	while (count-- > 0)
+		this->push_code(level, code);
+}
+
+template<int ndim>
+void CBLQBottomUpBuilder<ndim>::push_word(int level, cblq_word_t word) {
+	using CBLQOut = CBLQRegionEncoding<ndim>;
+	const bool is_top_level = (level == this->nlevels - 1);
+
+	// A pure word is represented by its parent's code, unless it is the top word
+	if (!is_top_level && (word == CBLQOut::ZERO_CODES_WORD || word == CBLQOut::ONE_CODES_WORD)) {
+		this->push_code(level + 1, word == CBLQOut::ONE_CODES_WORD ? 0b01 : 0b00);
+		return;
+	}
+
+	if (level == 0 && this->conf.encode_dense_suffix)
+		this->dense_suffix_semiwords.push_fullword(word);
+	else
+		this->level_words[level].push_back(word);
+
+	if (!is_top_level)
+		this->push_code(level + 1, 0b10);
+}
+
+template<int ndim>
+void CBLQBottomUpBuilder<ndim>::push_leaf_word(cblq_semiword_t elem_bits) {
+	if (this->nlevels == 0)
+		return;
+	assert(this->leaf_words_pushed < this->num_leaf_words);
+
+	++this->leaf_words_pushed;
+	this->push_word(0, Dilater< cblq_word_t, 2 >::dilate(elem_bits)); // Each set bit becomes a 1-code
+}
+
+template<int ndim>
+void CBLQBottomUpBuilder<ndim>::push_uniform_leaf_words(uint64_t count, bool filled) {
+	if (this->nlevels == 0 || count == 0)
+		return;
+	assert(this->leaf_words_pushed + count <= this->num_leaf_words);
+
+	this->leaf_words_pushed += count;
+	if (this->nlevels == 1)
+		this->push_word(0, filled ? CBLQRegionEncoding<ndim>::ONE_CODES_WORD : CBLQRegionEncoding<ndim>::ZERO_CODES_WORD); // The leaf word is the top word
+	else
+		this->push_uniform_codes(1, count, filled);
+}
+
+template<int ndim>
+boost::shared_ptr< CBLQRegionEncoding<ndim> > CBLQBottomUpBuilder<ndim>::to_region_encoding() {
+	this->push_uniform_leaf_words(this->num_leaf_words - this->leaf_words_pushed, false);
+
+	boost::shared_ptr< CBLQRegionEncoding<ndim> > cblq = boost::make_shared< CBLQRegionEncoding<ndim> >(this->nelem);
+
+	std::vector< cblq_word_t > &output = cblq->words;
+	for (int level = this->nlevels - 1; level >= 0; --level) {
+		const std::vector< cblq_word_t > &words = this->level_words[level];
+		output.insert(output.end(), words.begin(), words.end());
+		cblq->level_lens.push_back(words.size());
+	}
+
+	cblq->has_dense_suffix = this->conf.encode_dense_suffix;
+	if (this->conf.encode_dense_suffix) {
+		cblq->dense_suffix->clear();
+		cblq->dense_suffix->append(this->dense_suffix_semiwords);
+	}
+
+	return cblq;
+}
+
+// Out-of-place converters combine in-place via the (bit-parallel) fast CBLQ set operations
+template<int ndim>
+static std::unique_ptr< SetOperations< CBLQRegionEncoding<ndim> > > make_inplace_combine_setops() {
+	return std::unique_ptr< SetOperations< CBLQRegionEncoding<ndim> > >(new CBLQSetOperationsFast<ndim>(CBLQSetOperationsConfig(true)));
+}
+
+// BitmapToCBLQConverter
+
+template<int ndim>
+BitmapToCBLQConverter<ndim>::BitmapToCBLQConverter(CBLQRegionEncoderConfig conf) :
+	RegionEncodingOutOfPlaceConverter< BitmapRegionEncoding, CBLQRegionEncoding<ndim> >(make_inplace_combine_setops<ndim>()),
+	conf(conf)
+{}
+
+template<int ndim>
+boost::shared_ptr< CBLQRegionEncoding<ndim> > BitmapToCBLQConverter<ndim>::convert(boost::shared_ptr< const BitmapRegionEncoding > in) const {
+	using block_t = BitmapRegionEncoding::block_t;
+	using cblq_semiword_t = typename CBLQBottomUpBuilder<ndim>::cblq_semiword_t;
+
+	static constexpr int BITS_PER_LEAF_WORD = CBLQBottomUpBuilder<ndim>::ELEMENTS_PER_LEAF_WORD;
+	static constexpr int LEAF_WORDS_PER_BLOCK = BitmapRegionEncoding::BITS_PER_BLOCK / BITS_PER_LEAF_WORD;
+	static constexpr block_t LEAF_WORD_MASK = ((block_t)1 << BITS_PER_LEAF_WORD) - 1;
+
+	const uint64_t nelem = in->get_domain_size();
+	const std::vector< block_t > &bits = in->bits;
+
+	CBLQBottomUpBuilder<ndim> builder(this->conf, nelem);
+	if (builder.get_num_leaf_words() == 0)
+		return builder.to_region_encoding();
+
+	const uint64_t full_blocks = nelem / BitmapRegionEncoding::BITS_PER_BLOCK;
+	uint64_t blockpos = 0;
+	while (blockpos < full_blocks) {
+		const block_t block = bits[blockpos];
+		if (block == (block_t)0 || block == ~(block_t)0) {
+			// Gather the run of identical uniform blocks, and push it as a single run of uniform leaf words
+			uint64_t run_end = blockpos + 1;
+			while (run_end < full_blocks && bits[run_end] == block)
+				++run_end;
+
+			builder.push_uniform_leaf_words((run_end - blockpos) * LEAF_WORDS_PER_BLOCK, block != (block_t)0);
+			blockpos = run_end;
+		} else {
+			for (int i = 0; i < LEAF_WORDS_PER_BLOCK; ++i)
+				builder.push_leaf_word((cblq_semiword_t)((block >> (i * BITS_PER_LEAF_WORD)) & LEAF_WORD_MASK));
+			++blockpos;
+		}
+	}
+
+	// Bits past the domain in the last (partial) block are undefined, so mask them out (the rest of the padded domain is empty)
+	const int tail_bits = nelem % BitmapRegionEncoding::BITS_PER_BLOCK;
+	if (tail_bits > 0) {
+		const block_t block = bits[full_blocks] & (((block_t)1 << tail_bits) - 1);
+		const int tail_leaf_words = (tail_bits + BITS_PER_LEAF_WORD - 1) / BITS_PER_LEAF_WORD;
+		for (int i = 0; i < tail_leaf_words; ++i)
+			builder.push_leaf_word((cblq_semiword_t)((block >> (i * BITS_PER_LEAF_WORD)) & LEAF_WORD_MASK));
+	}
+
+	return builder.to_region_encoding();
+}
+
+// IIToCBLQConverter
+
+template<int ndim>
+IIToCBLQConverter<ndim>::IIToCBLQConverter(CBLQRegionEncoderConfig conf) :
+	RegionEncodingOutOfPlaceConverter< IIRegionEncoding, CBLQRegionEncoding<ndim> >(make_inplace_combine_setops<ndim>()),
+	conf(conf)
+{}
+
+template<int ndim>
+boost::shared_ptr< CBLQRegionEncoding<ndim> > IIToCBLQConverter<ndim>::convert(boost::shared_ptr< const IIRegionEncoding > in) const {
+	using rid_t = IIRegionEncoding::rid_t;
+	using cblq_semiword_t = typename CBLQBottomUpBuilder<ndim>::cblq_semiword_t;
+
+	static constexpr rid_t RIDS_PER_LEAF_WORD = CBLQBottomUpBuilder<ndim>::ELEMENTS_PER_LEAF_WORD;
+
+	const std::vector< rid_t > &rids = in->rids;
+
+	CBLQBottomUpBuilder<ndim> builder(this->conf, in->get_domain_size());
+	if (builder.get_num_leaf_words() == 0)
+		return builder.to_region_encoding();
+
+	uint64_t next_leaf_word = 0;
+	auto rid_it = rids.cbegin();
+	const auto rid_end = rids.cend();
+	while (rid_it != rid_end) {
+		const uint64_t leaf_word = *rid_it / RIDS_PER_LEAF_WORD;
+		assert(leaf_word >= next_leaf_word); // RIDs must be sorted
+
+		builder.push_uniform_leaf_words(leaf_word - next_leaf_word, false);
+
+		// Since RIDs are sorted and unique, a leaf word is full iff its first and last RIDs are present; gather
+		// any run of consecutive full leaf words into a single run of uniform leaf words
+		uint64_t full_leaf_words = 0;
+		while (rid_end - rid_it >= RIDS_PER_LEAF_WORD &&
+			   *rid_it == (leaf_word + full_leaf_words) * RIDS_PER_LEAF_WORD &&
+			   *(rid_it + (RIDS_PER_LEAF_WORD - 1)) == *rid_it + (RIDS_PER_LEAF_WORD - 1))
+		{
+			rid_it += RIDS_PER_LEAF_WORD;
+			++full_leaf_words;
+		}
+
+		if (full_leaf_words > 0) {
+			builder.push_uniform_leaf_words(full_leaf_words, true);
+			next_leaf_word = leaf_word + full_leaf_words;
+		} else {
+			cblq_semiword_t elem_bits = 0;
+			for (; rid_it != rid_end && *rid_it / RIDS_PER_LEAF_WORD == leaf_word; ++rid_it)
+				elem_bits |= (cblq_semiword_t)1 << (*rid_it % RIDS_PER_LEAF_WORD);
+
+			builder.push_leaf_word(elem_bits);
+			next_leaf_word = leaf_word + 1;
+		}
+	}
+
+	return builder.to_region_encoding();
+}
+
+// Explicit template instantiation for 1D-4D CBLQs
+template class CBLQBottomUpBuilder<1>;
+template class CBLQBottomUpBuilder<2>;
+template class CBLQBottomUpBuilder<3>;
+template class CBLQBottomUpBuilder<4>;
+template class BitmapToCBLQConverter<1>;
+template class BitmapToCBLQConverter<2>;
+template class BitmapToCBLQConverter<3>;
+template class BitmapToCBLQConverter<4>;
+template class IIToCBLQConverter<1>;
+template class IIToCBLQConverter<2>;
+template class IIToCBLQConverter<3>;
+template class IIToCBLQConverter<4>;
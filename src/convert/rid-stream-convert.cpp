@@ -0,0 +1,50 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * rid-stream-convert.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "pique/convert/rid-stream-convert.hpp"
+
+static bool is_concrete_type(RegionEncoding::Type type) {
+	return type != RegionEncoding::Type::UNKNOWN && type != RegionEncoding::Type::HETEROGENEOUS;
+}
+
+bool RIDStreamRegionEncodingConverter::can_convert_region_encoding(RegionEncoding::Type intype, RegionEncoding::Type outtype) const {
+	return is_concrete_type(intype) && is_concrete_type(outtype);
+}
+
+boost::shared_ptr< RegionEncoding > RIDStreamRegionEncodingConverter::convert(boost::shared_ptr< const RegionEncoding > in, RegionEncoding::Type outtype) const {
+	if (!this->can_convert_region_encoding(in->get_type(), outtype))
+		return nullptr;
+
+	boost::shared_ptr< RIDBatchIterator > rid_it = in->make_rid_iterator();
+	return RegionEncoding::make_region_from_rid_iterator(outtype, in->get_domain_size(), *rid_it);
+}
+
+boost::shared_ptr< RegionEncoding > RIDStreamRegionEncodingConverter::inplace_convert(boost::shared_ptr< const RegionEncoding > in_right, boost::shared_ptr< RegionEncoding > out_combine_left, NArySetOperation combine_op) const {
+	if (!this->combine_setops || !this->combine_setops->can_handle_region_encoding(out_combine_left->get_type()))
+		return nullptr;
+
+	boost::shared_ptr< RegionEncoding > converted = this->convert(in_right, out_combine_left->get_type());
+	if (!converted)
+		return nullptr;
+
+	return this->combine_setops->dynamic_inplace_binary_set_op(out_combine_left, converted, combine_op);
+}
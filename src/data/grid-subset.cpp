@@ -0,0 +1,155 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * grid-subset.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+#include "pique/data/grid.hpp"
+#include "pique/data/grid-subset.hpp"
+#include "pique/util/zo-iter2.hpp"
+
+using linearized_range_t = std::pair< GridSubset::dataset_offset_t, GridSubset::dataset_length_t >;
+using linearized_ranges_t = std::vector< linearized_range_t >;
+
+// Appends a range, merging it into the last range if they are adjacent
+static void append_range(linearized_ranges_t &ranges, uint64_t offset, uint64_t length) {
+	if (!ranges.empty() && ranges.back().first + ranges.back().second == offset)
+		ranges.back().second += length;
+	else
+		ranges.push_back(linearized_range_t(offset, length));
+}
+
+// Row-major order: the box is a set of equally-spaced runs, each spanning the extent of the box in the innermost dimension
+// not completely covered by the box (times the sizes of all faster-varying dimensions, which are completely covered)
+static void compute_row_major_box_ranges(const Grid &grid, const std::vector< uint64_t > &box_lb, const std::vector< uint64_t > &box_ub, linearized_ranges_t &ranges) {
+	const int ndim = grid.size();
+
+	int run_dim = ndim - 1;
+	uint64_t inner_stride = 1; // Product of the grid sizes of all dimensions after run_dim
+	while (run_dim > 0 && box_lb[run_dim] == 0 && box_ub[run_dim] == grid[run_dim]) {
+		inner_stride *= grid[run_dim];
+		--run_dim;
+	}
+	const uint64_t run_length = (box_ub[run_dim] - box_lb[run_dim]) * inner_stride;
+
+	// Odometer over the box coordinates of dimensions [0, run_dim)
+	std::vector< uint64_t > coords(box_lb.begin(), box_lb.begin() + run_dim);
+	while (true) {
+		uint64_t offset = 0;
+		for (int d = 0; d < run_dim; ++d)
+			offset = offset * grid[d] + coords[d];
+		offset = (offset * grid[run_dim] + box_lb[run_dim]) * inner_stride;
+		append_range(ranges, offset, run_length);
+
+		int d = run_dim - 1;
+		while (d >= 0 && ++coords[d] == box_ub[d]) {
+			coords[d] = box_lb[d];
+			--d;
+		}
+		if (d < 0)
+			break;
+	}
+}
+
+// Z-order: descends the implicit 2^ndim-ary tree over the padded cube, emitting each cube wholly inside the box as a single
+// range, and skipping each cube wholly outside it (so the number of cubes visited is proportional to the box surface)
+static void compute_zorder_box_ranges(const std::vector< uint64_t > &box_lb, const std::vector< uint64_t > &box_ub, std::vector< uint64_t > &cube_origin, int level, uint64_t zid_base, linearized_ranges_t &ranges) {
+	const int ndim = box_lb.size();
+	const uint64_t side = 1ULL << level;
+
+	bool inside = true;
+	for (int d = 0; d < ndim; ++d) {
+		if (cube_origin[d] >= box_ub[d] || cube_origin[d] + side <= box_lb[d])
+			return; // Disjoint from the box
+		if (cube_origin[d] < box_lb[d] || cube_origin[d] + side > box_ub[d])
+			inside = false;
+	}
+
+	if (inside) {
+		append_range(ranges, zid_base, 1ULL << (level * ndim));
+		return;
+	}
+
+	// A partially overlapping cube has side > 1. Children are in Z-order, with bit d of the child index selecting
+	// the upper half of dimension (ndim - 1 - d) (i.e., the last, fastest-varying dimension is the lowest bit)
+	const uint64_t half = side >> 1;
+	const uint64_t child_nelem = 1ULL << ((level - 1) * ndim);
+	for (uint64_t child = 0; child < (1ULL << ndim); ++child) {
+		for (int d = 0; d < ndim; ++d)
+			if ((child >> (ndim - 1 - d)) & 1)
+				cube_origin[d] += half;
+
+		compute_zorder_box_ranges(box_lb, box_ub, cube_origin, level - 1, zid_base + child * child_nelem, ranges);
+
+		for (int d = 0; d < ndim; ++d)
+			if ((child >> (ndim - 1 - d)) & 1)
+				cube_origin[d] -= half;
+	}
+}
+
+auto GridSubset::compute_linearized_ranges(Grid::Linearization lin) const -> std::vector< std::pair< dataset_offset_t, dataset_length_t > > {
+	const int ndim = this->domain_grid.size();
+	linearized_ranges_t ranges;
+
+	if (this->type == Type::LINEARIZED_RANGES) {
+		if (lin != Grid::Linearization::ROW_MAJOR_ORDER)
+			abort(); // Linearized ranges are only defined in row-major order
+		for (const linearized_range_t &range : this->ranges)
+			if (range.second > 0)
+				append_range(ranges, range.first, range.second);
+		return ranges;
+	}
+
+	// Whole domain or subvolume: both are boxes [box_lb, box_ub)
+	std::vector< uint64_t > box_lb(ndim, 0), box_ub(this->domain_grid.begin(), this->domain_grid.end());
+	if (this->type == Type::SUBVOLUME) {
+		assert(this->subvolume_offsets.size() == ndim && this->subvolume_dims.size() == ndim);
+		for (int d = 0; d < ndim; ++d) {
+			box_lb[d] = this->subvolume_offsets[d];
+			box_ub[d] = this->subvolume_offsets[d] + this->subvolume_dims[d];
+			assert(box_ub[d] <= this->domain_grid[d]);
+		}
+	}
+
+	for (int d = 0; d < ndim; ++d)
+		if (box_lb[d] >= box_ub[d])
+			return ranges; // Empty box
+
+	switch (lin) {
+	case Grid::Linearization::ROW_MAJOR_ORDER:
+		compute_row_major_box_ranges(this->domain_grid, box_lb, box_ub, ranges);
+		break;
+	case Grid::Linearization::Z_ORDER:
+	{
+		const int exp_level = compute_zo_exp_level(ndim, this->domain_grid.data());
+		assert(exp_level * ndim < 64);
+
+		std::vector< uint64_t > cube_origin(ndim, 0);
+		compute_zorder_box_ranges(box_lb, box_ub, cube_origin, exp_level, 0, ranges);
+		break;
+	}
+	default:
+		abort();
+	}
+	return ranges;
+}
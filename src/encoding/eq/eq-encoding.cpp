@@ -46,6 +46,6 @@ auto EqualityIndexEncoding::get_encoded_region_definitions_impl(bin_count_t nbin
 	return enc_region_defs;
 }
 
-auto EqualityIndexEncoding::get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations& setops) const -> region_vector_t {
+auto EqualityIndexEncoding::get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations& setops, int nthreads) const -> region_vector_t {
 	return bins; // No transformation needed
 }
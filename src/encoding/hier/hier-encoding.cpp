@@ -25,6 +25,7 @@
 #include <boost/iterator/counting_iterator.hpp>
 
 #include "pique/encoding/hier/hier-encoding.hpp"
+#include "pique/util/run-tasks.hpp"
 
 // exclusive upper bound
 using bin_id_t = IndexEncoding::bin_id_t;
@@ -116,12 +117,25 @@ auto HierarchicalIndexEncoding::get_encoded_region_definitions_impl(bin_count_t
 	return enc_region_defs;
 }
 
-auto HierarchicalIndexEncoding::get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations& setops) const -> region_vector_t {
+auto HierarchicalIndexEncoding::get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations& setops, int nthreads) const -> region_vector_t {
 	const region_count_t nregions = bins.size() - 1;
 
-	region_vector_t enc_regions;
+	region_vector_t enc_regions(nregions);
 
-	for (region_id_t i = 0; i < nregions; i ++) {
+	// Each encoded region depends only on encoded regions with fewer trailing 1s in their IDs (see below), so
+	// build the regions in layers by number of trailing 1s, building all regions within a layer concurrently
+	std::vector< std::vector< region_id_t > > layers;
+	for (region_id_t i = 0; i < nregions; i++) {
+		size_t trailing_ones = 0;
+		for (region_id_t id = i; id & 1; id >>= 1)
+			++trailing_ones;
+
+		if (layers.size() <= trailing_ones)
+			layers.resize(trailing_ones + 1);
+		layers[trailing_ones].push_back(i);
+	}
+
+	auto build_enc_region = [&](region_id_t i) {
 		region_vector_t enc_regions_to_merge(1, bins[i]); // Always include the ith bin to merge into this encoded region
 
 		// For every trailing 1 in the binary representation of the current region ID, we need
@@ -135,15 +149,16 @@ auto HierarchicalIndexEncoding::get_encoded_regions_impl(region_vector_t bins, c
 			enc_regions_to_merge.push_back(enc_regions[merge_region_id]); // Get the region from the NEW index (we need merged bins)
 		}
 
-		boost::shared_ptr< RegionEncoding > enc_region =
+		enc_regions[i] =
 			setops.dynamic_nary_set_op(
 				enc_regions_to_merge.begin(),
 				enc_regions_to_merge.end(),
 				NArySetOperation::UNION
 			);
+	};
 
-		enc_regions.push_back(enc_region);
-	}
+	for (const std::vector< region_id_t > &layer : layers)
+		run_tasks_concurrently(nthreads, layer.size(), [&](size_t layer_pos) { build_enc_region(layer[layer_pos]); });
 
 	return enc_regions;
 }
@@ -26,6 +26,7 @@
 
 #include "pique/encoding/index-encoding.hpp"
 #include "pique/util/dynamic-dispatch.hpp"
+#include "pique/util/run-tasks.hpp"
 
 #include "pique/indexing/binned-index.hpp"
 #include "pique/setops/setops.hpp"
@@ -35,13 +36,14 @@
 #include "pique/encoding/interval/interval-encoding.hpp"
 #include "pique/encoding/binarycomp/binarycomp-encoding.hpp"
 #include "pique/encoding/hier/hier-encoding.hpp"
+#include "pique/encoding/multires/multires-encoding.hpp"
 
 using EncType = IndexEncoding::Type;
 
 typedef typename
 	MakeValueToTypeDispatch< EncType >
-	::WithValues< EncType::EQUALITY, EncType::RANGE, EncType::INTERVAL, EncType::BINARY_COMPONENT, EncType::HIERARCHICAL >
-	::WithTypes< EqualityIndexEncoding, RangeIndexEncoding, IntervalIndexEncoding, BinaryComponentIndexEncoding, HierarchicalIndexEncoding >
+	::WithValues< EncType::EQUALITY, EncType::RANGE, EncType::INTERVAL, EncType::BINARY_COMPONENT, EncType::HIERARCHICAL, EncType::MULTI_RESOLUTION >
+	::WithTypes< EqualityIndexEncoding, RangeIndexEncoding, IntervalIndexEncoding, BinaryComponentIndexEncoding, HierarchicalIndexEncoding, MultiResolutionIndexEncoding >
 	::type EncTypeDispatch;
 
 boost::shared_ptr< IndexEncoding > IndexEncoding::get_instance(Type type) {
@@ -54,7 +56,8 @@ boost::shared_ptr< IndexEncoding > IndexEncoding::get_instance(Type type) {
 auto IndexEncoding::get_encoded_index(
 	boost::shared_ptr< const IndexEncoding > index_enc,
 	boost::shared_ptr< const BinnedIndex > in_index,
-	const AbstractSetOperations &setops
+	const AbstractSetOperations &setops,
+	int nthreads
 	) -> boost::shared_ptr< BinnedIndex >
 {
 	// Assume the input index is equality-encoded, so that encoded regions == bin regions
@@ -63,24 +66,22 @@ auto IndexEncoding::get_encoded_index(
 	region_vector_t bin_regions;
 	in_index->get_regions(bin_regions);
 
-	region_vector_t encoded_regions = index_enc->get_encoded_regions(bin_regions, setops);
+	region_vector_t encoded_regions = index_enc->get_encoded_regions(bin_regions, setops, nthreads);
 	return in_index->derive_new_index(index_enc, encoded_regions);
 }
 
-auto IndexEncoding::get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations& setops) const -> region_vector_t {
+auto IndexEncoding::get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations& setops, int nthreads) const -> region_vector_t {
 	const std::vector< bin_id_vector_t > enc_region_defs = this->get_encoded_region_definitions(bins.size());
 
-	region_vector_t enc_regions;
-	for (const bin_id_vector_t &enc_region_def : enc_region_defs) {
+	// Each encoded region is an independent union, so they are all built concurrently
+	region_vector_t enc_regions(enc_region_defs.size());
+	run_tasks_concurrently(nthreads, enc_region_defs.size(), [&](size_t i) {
 		region_vector_t bins_to_merge;
-		for (const bin_id_t bin : enc_region_def)
+		for (const bin_id_t bin : enc_region_defs[i])
 			bins_to_merge.push_back(bins[bin]);
 
-		boost::shared_ptr< RegionEncoding > enc_region =
-			setops.dynamic_nary_set_op(bins_to_merge.begin(), bins_to_merge.end(), NArySetOperation::UNION);
-
-		enc_regions.push_back(enc_region);
-	}
+		enc_regions[i] = setops.dynamic_nary_set_op(bins_to_merge.begin(), bins_to_merge.end(), NArySetOperation::UNION);
+	});
 
 	return enc_regions;
 }
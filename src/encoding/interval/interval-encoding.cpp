@@ -21,9 +21,11 @@
  *      Author: David A. Boyuka II
  */
 
+#include <algorithm>
 #include <boost/iterator/counting_iterator.hpp>
 
 #include "pique/encoding/interval/interval-encoding.hpp"
+#include "pique/util/run-tasks.hpp"
 
 auto IntervalIndexEncoding::get_region_math_impl(bin_count_t nbins, bin_id_t lb, bin_id_t ub, bool prefer_complement) const -> RMath {
 	using regid_t = region_id_t;
@@ -103,25 +105,31 @@ auto IntervalIndexEncoding::get_encoded_region_definitions_impl(bin_count_t nbin
 	return enc_region_defs;
 }
 
-auto IntervalIndexEncoding::get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations& setops) const -> region_vector_t {
-	region_vector_t enc_regions;
+auto IntervalIndexEncoding::get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations& setops, int nthreads) const -> region_vector_t {
 	const region_id_t nregions = (bins.size() + 1) / 2; // = ceil(nbins/2)
 	const region_id_t interval_width = bins.size() / 2; //  = floor(nbins/2); intervals are of the form [x, x + interval_width)
 
-	if (nregions > 0) {
-		boost::shared_ptr< RegionEncoding > first_enc_region =
-			setops.dynamic_nary_set_op(bins.begin(), bins.begin() + interval_width, NArySetOperation::UNION);
-		enc_regions.push_back(first_enc_region);
-	}
+	// Split the regions into one contiguous block per thread. Each block seeds its first region with a full
+	// union over its interval, then slides the interval along the rest of the block as in the sequential case
+	const size_t nblocks = std::max< size_t >(1, std::min< size_t >(nthreads, nregions));
+	auto block_begin = [nregions, nblocks](size_t block) -> region_id_t { return (region_id_t)(block * nregions / nblocks); };
 
-	for (region_id_t i = 1; i < nregions; ++i) {
-		boost::shared_ptr< RegionEncoding > enc_region;
+	region_vector_t enc_regions(nregions);
 
-		// ith encoded region = (i-1)th encoded region - (i-1)th bin + (i-1+w)th bin
-		enc_region = setops.dynamic_binary_set_op(enc_regions[i - 1], bins[i - 1], NArySetOperation::DIFFERENCE);
-		enc_region = setops.dynamic_inplace_binary_set_op(enc_region, bins[i - 1 + interval_width], NArySetOperation::UNION);
-		enc_regions.push_back(enc_region);
-	}
+	run_tasks_concurrently(nthreads, nblocks, [&](size_t block) {
+		const region_id_t first = block_begin(block);
+		if (first < block_begin(block + 1))
+			enc_regions[first] = setops.dynamic_nary_set_op(bins.begin() + first, bins.begin() + first + interval_width, NArySetOperation::UNION);
+
+		for (region_id_t i = first + 1; i < block_begin(block + 1); ++i) {
+			boost::shared_ptr< RegionEncoding > enc_region;
+
+			// ith encoded region = (i-1)th encoded region - (i-1)th bin + (i-1+w)th bin
+			enc_region = setops.dynamic_binary_set_op(enc_regions[i - 1], bins[i - 1], NArySetOperation::DIFFERENCE);
+			enc_region = setops.dynamic_inplace_binary_set_op(enc_region, bins[i - 1 + interval_width], NArySetOperation::UNION);
+			enc_regions[i] = enc_region;
+		}
+	});
 
 	return enc_regions;
 }
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * multires-encoding.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <algorithm>
+#include <boost/iterator/counting_iterator.hpp>
+
+#include "pique/encoding/multires/multires-encoding.hpp"
+#include "pique/util/run-tasks.hpp"
+
+constexpr IndexEncoding::bin_count_t MultiResolutionIndexEncoding::DEFAULT_SUPER_BIN_WIDTH;
+
+auto MultiResolutionIndexEncoding::get_num_super_bins(bin_count_t nbins) const -> region_count_t {
+	return (nbins > this->super_bin_width) ? (nbins + this->super_bin_width - 1) / this->super_bin_width : 0;
+}
+
+bool MultiResolutionIndexEncoding::operator==(const IndexEncoding &other) const {
+	return this->IndexEncoding::operator==(other) &&
+	       this->super_bin_width == static_cast< const MultiResolutionIndexEncoding & >(other).super_bin_width;
+}
+
+auto MultiResolutionIndexEncoding::get_encoded_region_definitions_impl(bin_count_t nbins) const -> std::vector< bin_id_vector_t > {
+	std::vector< bin_id_vector_t > enc_region_defs;
+
+	// Fine bins
+	for (bin_id_t bin = 0; bin < nbins; ++bin)
+		enc_region_defs.push_back(bin_id_vector_t(1, bin));
+
+	// Super-bins
+	for (region_id_t super_bin = 0; super_bin < this->get_num_super_bins(nbins); ++super_bin) {
+		const bin_id_t super_bin_begin = super_bin * this->super_bin_width;
+		const bin_id_t super_bin_end = std::min(super_bin_begin + this->super_bin_width, nbins);
+
+		enc_region_defs.push_back(bin_id_vector_t(
+			boost::counting_iterator< bin_id_t >(super_bin_begin),
+			boost::counting_iterator< bin_id_t >(super_bin_end)));
+	}
+
+	return enc_region_defs;
+}
+
+auto MultiResolutionIndexEncoding::get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations& setops, int nthreads) const -> region_vector_t {
+	const bin_count_t nbins = bins.size();
+	const region_count_t nsuper_bins = this->get_num_super_bins(nbins);
+
+	// The fine bins are kept as-is, and the super-bins are independent unions, built concurrently
+	region_vector_t enc_regions(bins);
+	enc_regions.resize(nbins + nsuper_bins);
+
+	run_tasks_concurrently(nthreads, nsuper_bins, [&](size_t super_bin) {
+		const bin_id_t super_bin_begin = super_bin * this->super_bin_width;
+		const bin_id_t super_bin_end = std::min(super_bin_begin + this->super_bin_width, nbins);
+		enc_regions[nbins + super_bin] = setops.dynamic_nary_set_op(bins.begin() + super_bin_begin, bins.begin() + super_bin_end, NArySetOperation::UNION);
+	});
+
+	return enc_regions;
+}
+
+auto MultiResolutionIndexEncoding::get_region_math_impl(bin_count_t nbins, bin_id_t lb, bin_id_t ub, bool prefer_complement) const -> RMath {
+	// Without region sizes, minimize the number of regions read
+	return this->get_region_math_with_costs_impl(nbins, lb, ub, prefer_complement, [](region_id_t) -> uint64_t { return 1; });
+}
+
+auto MultiResolutionIndexEncoding::get_region_math_with_costs_impl(bin_count_t nbins, bin_id_t lb, bin_id_t ub, bool prefer_complement, const region_cost_fn_t &region_cost) const -> RMath {
+	using regid_t = region_id_t;
+	assert(lb < ub && ub <= nbins);
+
+	const region_count_t nsuper_bins = this->get_num_super_bins(nbins);
+
+	// The bins to cover: those in [lb, ub), or if prefer_complement, those outside it (complementing at the end)
+	std::vector< char > covered(nbins, prefer_complement);
+	std::fill(covered.begin() + lb, covered.begin() + ub, !prefer_complement);
+
+	// The covered bins are the union of the additive regions, minus the union of the subtractive regions. Subtractive
+	// regions are only ever uncovered fine bins, whose super-bin was chosen as an additive region
+	std::vector< regid_t > additive_regions, subtractive_regions;
+	for (regid_t super_bin = 0; super_bin * this->super_bin_width < nbins; ++super_bin) {
+		const bin_id_t super_bin_begin = super_bin * this->super_bin_width;
+		const bin_id_t super_bin_end = std::min(super_bin_begin + this->super_bin_width, nbins);
+
+		// Option 1: the covered fine bins. Option 2: the super-bin, minus the uncovered fine bins
+		const bool has_super_bin = (super_bin < nsuper_bins);
+		uint64_t fine_cost = 0, super_cost = has_super_bin ? region_cost(nbins + super_bin) : 0;
+		bool any_covered = false;
+		for (bin_id_t b = super_bin_begin; b < super_bin_end; ++b) {
+			if (covered[b]) {
+				fine_cost += region_cost((regid_t)b);
+				any_covered = true;
+			} else {
+				super_cost += region_cost((regid_t)b);
+			}
+		}
+
+		if (!any_covered)
+			continue;
+
+		if (has_super_bin && super_cost < fine_cost) {
+			additive_regions.push_back(nbins + super_bin);
+			for (bin_id_t b = super_bin_begin; b < super_bin_end; ++b)
+				if (!covered[b])
+					subtractive_regions.push_back((regid_t)b);
+		} else {
+			for (bin_id_t b = super_bin_begin; b < super_bin_end; ++b)
+				if (covered[b])
+					additive_regions.push_back((regid_t)b);
+		}
+	}
+
+	RMath rmath;
+	for (regid_t ar : additive_regions) rmath.push_region(ar);
+	if (additive_regions.size() > 1)
+		rmath.push_op(NArySetOperation::UNION);
+
+	if (!subtractive_regions.empty()) {
+		for (regid_t sr : subtractive_regions) rmath.push_region(sr);
+		rmath.push_op(NArySetOperation::DIFFERENCE, 1 + subtractive_regions.size());
+	}
+
+	if (prefer_complement)
+		rmath.push_op(UnarySetOperation::COMPLEMENT);
+
+	return rmath;
+}
@@ -21,7 +21,10 @@
  *      Author: David A. Boyuka II
  */
 
+#include <algorithm>
+
 #include "pique/encoding/range/range-encoding.hpp"
+#include "pique/util/run-tasks.hpp"
 
 auto RangeIndexEncoding::get_region_math_impl(bin_count_t nbins, bin_id_t lb, bin_id_t ub, bool prefer_complement) const -> RMath {
 	using regid_t = region_id_t;
@@ -52,19 +55,41 @@ auto RangeIndexEncoding::get_encoded_region_definitions_impl(bin_count_t nbins)
 	return enc_region_defs;
 }
 
-auto RangeIndexEncoding::get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations& setops) const -> region_vector_t {
-    region_vector_t encoded_regions;
-    encoded_regions.reserve(bins.size() - 1);
+auto RangeIndexEncoding::get_encoded_regions_impl(region_vector_t bins, const AbstractSetOperations& setops, int nthreads) const -> region_vector_t {
+    // The encoded regions are the prefix unions of the bins, computed as a blocked parallel scan:
+    //   1. split the regions into one contiguous block per thread, and compute each block's local prefix unions concurrently
+    //   2. scan the (few) block totals sequentially, giving the union of all bins preceding each block
+    //   3. union that into every local prefix union of each block but the first, concurrently
+    // This does about twice the set operations of a sequential scan, so it is used only when there are multiple threads
+    const region_count_t nregions = bins.size() - 1;
+    const size_t nblocks = std::max< size_t >(1, std::min< size_t >(nthreads, nregions / 2));
+    auto block_begin = [nregions, nblocks](size_t block) -> region_id_t { return (region_id_t)(block * nregions / nblocks); };
+
+    region_vector_t encoded_regions(nregions);
 
-    for (bin_id_t i = 0; i < bins.size() - 1; i++) {
-    	boost::shared_ptr< RegionEncoding > encoded_region;
+    run_tasks_concurrently(nthreads, nblocks, [&](size_t block) {
+    	for (region_id_t i = block_begin(block); i < block_begin(block + 1); i++) {
+    		if (i == block_begin(block))
+    			encoded_regions[i] = bins[i];
+    		else
+    			encoded_regions[i] = setops.dynamic_binary_set_op(encoded_regions[i-1], bins[i], NArySetOperation::UNION);
+    	}
+    });
 
-    	if (i == 0)
-    		encoded_region = bins[0];
-    	else
-    		encoded_region = setops.dynamic_binary_set_op(encoded_regions[i-1], bins[i], NArySetOperation::UNION);
+    if (nblocks > 1) {
+    	region_vector_t block_carries(nblocks); // Union of all bins preceding each block
+    	block_carries[1] = encoded_regions[block_begin(1) - 1];
+    	for (size_t block = 2; block < nblocks; block++)
+    		block_carries[block] = setops.dynamic_binary_set_op(block_carries[block - 1], encoded_regions[block_begin(block) - 1], NArySetOperation::UNION);
 
-    	encoded_regions.push_back(encoded_region);
+    	const region_id_t first_carried = block_begin(1);
+    	run_tasks_concurrently(nthreads, nregions - first_carried, [&](size_t task) {
+    		const region_id_t i = first_carried + task;
+    		size_t block = (size_t)i * nblocks / nregions; // A lower bound on the block containing i
+    		while (block + 1 < nblocks && block_begin(block + 1) <= i)
+    			block++;
+    		encoded_regions[i] = setops.dynamic_binary_set_op(block_carries[block], encoded_regions[i], NArySetOperation::UNION);
+    	});
     }
 
     return encoded_regions;
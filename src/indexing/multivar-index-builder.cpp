@@ -0,0 +1,105 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * multivar-index-builder.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cassert>
+#include <algorithm>
+
+#include "pique/indexing/multivar-index-builder.hpp"
+
+constexpr uint64_t MultiVariableIndexBuilder::DEFAULT_BLOCK_ELEMENTS;
+
+MultiVariableIndexBuilder::MultiVariableIndexBuilder(uint64_t block_elements) :
+	block_elements(block_elements)
+{
+	assert(block_elements > 0);
+}
+
+void MultiVariableIndexBuilder::add_variable(boost::shared_ptr< const Dataset > data, boost::shared_ptr< AbstractIndexBuildSession > session) {
+	assert(data && session);
+	assert(datasets.empty() || data->get_grid() == datasets.front()->get_grid());
+
+	datasets.push_back(data);
+	sessions.push_back(session);
+}
+
+GridSubset MultiVariableIndexBuilder::make_block_subset(const Dataset &data, uint64_t first_row, uint64_t nrows) {
+	const Grid grid = data.get_grid();
+	const uint64_t row_size = grid.get_npoints() / grid[0];
+
+	if (data.get_format() == Dataset::Format::HDF5) {
+		// HDF5 datasets may be chunked, which supports subvolumes but not linearized ranges
+		std::vector< uint64_t > offsets(grid.size(), 0), dims(grid.begin(), grid.end());
+		offsets[0] = first_row;
+		dims[0] = nrows;
+		return GridSubset(grid, std::move(offsets), std::move(dims));
+	} else {
+		// Whole rows are contiguous in row-major order
+		return GridSubset(grid, first_row * row_size, nrows * row_size);
+	}
+}
+
+void MultiVariableIndexBuilder::index_all_blocks() {
+	if (datasets.empty())
+		return;
+
+	const Grid grid = datasets.front()->get_grid();
+	assert(!grid.empty());
+
+	const uint64_t nrows = grid[0];
+	const uint64_t row_size = (nrows > 0) ? grid.get_npoints() / nrows : 0;
+	const uint64_t rows_per_block = std::max< uint64_t >(1, (row_size > 0) ? block_elements / row_size : nrows);
+
+	for (uint64_t first_row = 0; first_row < nrows && row_size > 0; first_row += rows_per_block) {
+		const uint64_t block_rows = std::min(rows_per_block, nrows - first_row);
+		for (size_t i = 0; i < datasets.size(); ++i)
+			sessions[i]->index_block(*datasets[i], make_block_subset(*datasets[i], first_row, block_rows));
+	}
+}
+
+std::vector< boost::shared_ptr< BinnedIndex > > MultiVariableIndexBuilder::build_indexes() {
+	index_all_blocks();
+
+	std::vector< boost::shared_ptr< BinnedIndex > > indexes;
+	indexes.reserve(sessions.size());
+	for (boost::shared_ptr< AbstractIndexBuildSession > session : sessions)
+		indexes.push_back(session->finish());
+	return indexes;
+}
+
+std::vector< boost::shared_ptr< BinnedIndex > > MultiVariableIndexBuilder::build_indexes(const std::vector< boost::shared_ptr< BinnedIndexRegionSink > > &sinks) {
+	assert(sinks.size() == sessions.size());
+	index_all_blocks();
+
+	std::vector< boost::shared_ptr< BinnedIndex > > indexes;
+	indexes.reserve(sessions.size());
+	for (size_t i = 0; i < sessions.size(); ++i)
+		indexes.push_back(sessions[i]->finish(*sinks[i]));
+	return indexes;
+}
+
+std::vector< IndexBuilderStats > MultiVariableIndexBuilder::get_stats() const {
+	std::vector< IndexBuilderStats > stats;
+	for (boost::shared_ptr< AbstractIndexBuildSession > session : sessions)
+		stats.push_back(session->get_stats());
+	return stats;
+}
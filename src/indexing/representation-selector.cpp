@@ -0,0 +1,88 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * representation-selector.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <algorithm>
+#include <thread>
+#include <boost/make_shared.hpp>
+
+#include "pique/indexing/representation-selector.hpp"
+#include "pique/convert/rid-stream-convert.hpp"
+#include "pique/util/run-tasks.hpp"
+
+auto RegionRepresentationSelector::get_default_candidate_types() -> std::vector< RegionEncoding::Type > {
+	using Type = RegionEncoding::Type;
+	return { Type::II, Type::CII, Type::WAH, Type::CBLQ_1D, Type::UNCOMPRESSED_BITMAP };
+}
+
+RegionRepresentationSelector::RegionRepresentationSelector(std::vector< RegionEncoding::Type > candidate_types) :
+	RegionRepresentationSelector(std::move(candidate_types), boost::make_shared< RIDStreamRegionEncodingConverter >())
+{}
+
+RegionRepresentationSelector::RegionRepresentationSelector(std::vector< RegionEncoding::Type > candidate_types, boost::shared_ptr< const AbstractRegionEncodingConverter > converter) :
+	candidate_types(std::move(candidate_types)), converter(converter)
+{
+	assert(!this->candidate_types.empty());
+}
+
+boost::shared_ptr< RegionEncoding > RegionRepresentationSelector::select_representation(boost::shared_ptr< RegionEncoding > region) const {
+	if (!region)
+		return nullptr;
+
+	boost::shared_ptr< RegionEncoding > best = nullptr;
+	for (RegionEncoding::Type type : this->candidate_types) {
+		boost::shared_ptr< RegionEncoding > candidate =
+			(region->get_type() == type) ? region : this->converter->convert(region, type);
+
+		if (candidate && (!best || candidate->get_size_in_bytes() < best->get_size_in_bytes()))
+			best = candidate;
+	}
+
+	return best ? best : region;
+}
+
+boost::shared_ptr< BinnedIndex > RegionRepresentationSelector::select_representations(boost::shared_ptr< const BinnedIndex > index, int nthreads) const {
+	std::vector< boost::shared_ptr< RegionEncoding > > regions;
+	index->get_regions(regions);
+
+	if (nthreads <= 0)
+		nthreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	// Each region is re-encoded independently
+	run_tasks_concurrently(nthreads, regions.size(), [&](size_t region_id) {
+		regions[region_id] = this->select_representation(regions[region_id]);
+	});
+
+	// Use a single representation type if all regions agree on one
+	RegionEncoding::Type index_rep_type = RegionEncoding::Type::UNKNOWN;
+	for (const boost::shared_ptr< RegionEncoding > &region : regions) {
+		if (!region)
+			continue;
+		else if (index_rep_type == RegionEncoding::Type::UNKNOWN)
+			index_rep_type = region->get_type();
+		else if (index_rep_type != region->get_type())
+			index_rep_type = RegionEncoding::Type::HETEROGENEOUS;
+	}
+	if (index_rep_type == RegionEncoding::Type::UNKNOWN) // No regions at all
+		index_rep_type = index->get_representation_type();
+
+	return index->derive_new_index(index_rep_type, std::move(regions));
+}
@@ -21,12 +21,16 @@
  *      Author: David A. Boyuka II
  */
 
+#include <iostream>
+#include <sstream>
 #include <vector>
+#include <numeric>
 
 #include <boost/iterator/counting_iterator.hpp>
 #include <boost/iostreams/stream.hpp>
 #include <boost/iostreams/device/array.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 
 // To (de)serialize IndexEncoding pointers
 #include "pique/encoding/index-encoding.hpp"
@@ -41,12 +45,32 @@ template<class Archive> void SharedFileFormatIndexIO::segment_offsets_header_t::
 	ar & this->footer_segment_offset;
 }
 
-// Serialize GlobalPartitionMetadata
+// Serialize GlobalPartitionMetadata (the footer's per-partition records). Version 0 footers (written before zone maps)
+// contain only the domain; its class version is serialized once per footer, so both remain readable
+BOOST_CLASS_VERSION(IndexIO::GlobalPartitionMetadata, 1)
 namespace boost { namespace serialization {
 template<class Archive>
 void serialize(Archive & ar, IndexIO::GlobalPartitionMetadata &gpmeta, const unsigned int version) {
     ar & gpmeta.domain.first;
     ar & gpmeta.domain.second;
+
+    if (version < 1) {
+    	gpmeta.index_rep = boost::none;
+    	gpmeta.zone_map = nullptr;
+    	return;
+    }
+
+    // Zone map, if present
+    bool has_zone_map = (gpmeta.index_rep && gpmeta.zone_map);
+    ar & has_zone_map;
+    if (Archive::is_loading::value) {
+    	gpmeta.index_rep = has_zone_map ? boost::make_optional(RegionEncoding::Type::UNKNOWN) : boost::none;
+    	gpmeta.zone_map = nullptr;
+    }
+    if (has_zone_map) {
+    	ar & reinterpret_cast<char&>(*gpmeta.index_rep);
+    	serialize_binning_type(ar, gpmeta.zone_map);
+    }
 }
 }} // namespace
 
@@ -56,7 +80,8 @@ template<class Archive> void SharedFileFormatIndexIO::footer_t::serialize(Archiv
 	ar & this->partition_metadatas;
 }
 
-// Serialize PartitionMetadata
+// Serialize PartitionMetadata. Version 0 partition headers (written before partition grids) end with the binning
+BOOST_CLASS_VERSION(IndexPartitionIO::PartitionMetadata, 1)
 namespace boost { namespace serialization {
 template<class Archive>
 void serialize(Archive & ar, IndexPartitionIO::PartitionMetadata &pmeta, const unsigned int version) {
@@ -71,13 +96,46 @@ void serialize(Archive & ar, IndexPartitionIO::PartitionMetadata &pmeta, const u
 	serialize_encoding(ar, pmeta.index_enc);
 	ar & reinterpret_cast<char&>(*pmeta.index_rep);
 	serialize_binning_type(ar, pmeta.binning_spec);
+
+	if (version < 1)
+		return;
+
+	// Partition grid, if present
+	bool has_grid = (bool)pmeta.grid;
+	ar & has_grid;
+	if (has_grid) {
+		std::vector< uint64_t > dims;
+		char lin;
+		if (!Archive::is_loading::value) {
+			dims = *pmeta.grid;
+			lin = (char)pmeta.grid->get_linearization();
+		}
+		ar & dims;
+		ar & lin;
+		if (Archive::is_loading::value)
+			pmeta.grid = Grid(std::move(dims), (Grid::Linearization)lin);
+	}
 }
 }} // namespace
 
-BOOST_CLASS_IMPLEMENTATION(SharedFileFormatIndexPartitionIO::partition_header_t, boost::serialization::object_serializable) // no version information serialized
+// Version 0 partition headers (written before region element counts) had no version information of their own, so they
+// began with the version information of their PartitionMetadata, which was always 0. That is read here as the header's
+// own version, so a version 0 header's PartitionMetadata is loaded without reading its version information again.
+BOOST_CLASS_IMPLEMENTATION(SharedFileFormatIndexPartitionIO::partition_header_t, boost::serialization::object_class_info) // yes version information serialized
+BOOST_CLASS_VERSION(SharedFileFormatIndexPartitionIO::partition_header_t, 1)
 template<class Archive> void SharedFileFormatIndexPartitionIO::partition_header_t::serialize(Archive & ar, const unsigned int version) {
+	if (version < 1) {
+		boost::serialization::serialize(ar, this->pmeta, 0);
+		ar & this->region_offsets;
+		this->region_element_counts.clear(); // Counted by reading the regions instead (see compute_regions_element_count_impl)
+		return;
+	}
+
 	ar & this->pmeta;
 	ar & this->region_offsets;
+	ar & this->region_element_counts;
+	if (*this->pmeta.index_rep == RegionEncoding::Type::HETEROGENEOUS)
+		ar & this->region_types;
 }
 
 SharedFileFormatIndexIO::SharedFileFormatIndexIO() :
@@ -107,6 +165,19 @@ auto SharedFileFormatIndexIO::get_global_metadata_impl() -> GlobalMetadata {
 	return gmeta;
 }
 
+std::string SharedFileFormatIndexIO::serialize_global_partition_metadata(const GlobalPartitionMetadata &gpmeta) {
+	std::ostringstream out;
+	boost::archive::simple_binary_oarchive(out, boost::archive::no_header) << gpmeta;
+	return out.str();
+}
+
+auto SharedFileFormatIndexIO::deserialize_global_partition_metadata(const std::string &buffer) -> GlobalPartitionMetadata {
+	std::istringstream in(buffer);
+	GlobalPartitionMetadata gpmeta;
+	boost::archive::simple_binary_iarchive(in, boost::archive::no_header) >> gpmeta;
+	return gpmeta;
+}
+
 auto SharedFileFormatIndexIO::get_partition_metadata_impl(partition_id_t begin_partition, partition_id_t end_partition) -> std::vector< GlobalPartitionMetadata > {
 	std::vector< GlobalPartitionMetadata > gpmetas(
 		this->footer->partition_metadatas.begin() + begin_partition,
@@ -134,14 +205,37 @@ void SharedFileFormatIndexIO::read_metadata_from_disk() {
 	close_input_stream(fin);
 }
 
+bool SharedFileFormatIndexIO::read_metadata_for_append() {
+	read_metadata_from_disk();
+
+	// Files written by this class place the footer immediately after the last partition; anything else is malformed,
+	// and appending to it could overwrite data
+	if (this->footer->partition_offsets.back() != this->segment_offsets_header->footer_segment_offset) {
+		std::cerr << "Error: cannot append to index file, its last partition ends at " << this->footer->partition_offsets.back()
+		          << " but its footer starts at " << this->segment_offsets_header->footer_segment_offset << std::endl;
+		return false;
+	}
+
+	// New partitions are placed after the existing footer rather than over it, so the file remains valid (with its
+	// old contents) until write_metadata_to_disk() redirects the header to the new footer. The old footer is left
+	// behind as dead space, accounted to the end of the last existing partition.
+	const uint64_t old_footer_end = this->segment_offsets_header->footer_segment_offset + this->footer.measure();
+	this->footer->partition_offsets.back() = old_footer_end;
+	return true;
+}
+
 void SharedFileFormatIndexIO::write_metadata_to_disk() {
 	// Update the footer offset (i.e., the end of the partition segment)
 	this->segment_offsets_header->footer_segment_offset =
 		this->footer->partition_offsets.back();
 
+	// Write the footer before the header, so the header's footer offset (a small, fixed-size overwrite
+	// at the start of the file) is the last thing updated, and never refers to an incomplete footer
 	std::ostream &fout = open_output_stream(false);
-	this->segment_offsets_header.write(fout);
 	this->footer.write(fout);
+	fout.flush();
+	this->segment_offsets_header.write(fout);
+	fout.flush();
 	close_output_stream(fout);
 }
 
@@ -166,7 +260,8 @@ SharedFileFormatIndexPartitionIO::SharedFileFormatIndexPartitionIO(SharedFileFor
 		[this](){ return *this->partition_offset_in_file; },
 		[    ](){ return std::ios::beg; }
 	),
-	partition_offset_in_file(partition_offset_in_file)
+	partition_offset_in_file(partition_offset_in_file),
+	next_streamed_region(0)
 {}
 
 bool SharedFileFormatIndexPartitionIO::open_impl(IndexOpenMode openmode) {
@@ -187,12 +282,20 @@ bool SharedFileFormatIndexPartitionIO::close_impl() {
 	if (!this->IndexPartitionIO::close_impl())
 		return false;
 
-	if (openmode == IndexOpenMode::WRITE)
-		write_partition_to_disk();
+	if (openmode == IndexOpenMode::WRITE) {
+		if (!this->streamed_region_count) {
+			write_partition_to_disk();
+		} else if (this->next_streamed_region < *this->streamed_region_count) {
+			std::cerr << "Error: index partition closed after only " << this->next_streamed_region << " of its " << *this->streamed_region_count << " regions were written" << std::endl;
+			abort();
+		}
+	}
 
 	this->partition_header = boost::none;
 	this->partition_offset_in_file = boost::none;
 	this->regions_to_write.clear();
+	this->streamed_region_count = boost::none;
+	this->next_streamed_region = 0;
 
 	return true;
 }
@@ -213,15 +316,32 @@ void SharedFileFormatIndexPartitionIO::read_metadata_from_disk() {
 	this->partition_offset_in_file = this->parent.footer->partition_offsets[this->get_partition_id()];
 }
 
+IndexIO::GlobalPartitionMetadata SharedFileFormatIndexPartitionIO::make_global_partition_metadata() const {
+	IndexIO::GlobalPartitionMetadata gpmeta;
+	gpmeta.domain = *this->partition_header->pmeta.domain;
+	gpmeta.index_rep = *this->partition_header->pmeta.index_rep;
+	gpmeta.zone_map = this->partition_header->pmeta.binning_spec->make_zone_map();
+	return gpmeta;
+}
+
 void SharedFileFormatIndexPartitionIO::write_partition_to_disk() {
 	assert(this->partition_header && this->partition_header->pmeta.is_filled());
 
-	IndexIO::GlobalPartitionMetadata gpmeta;
-	gpmeta.domain = *this->partition_header->pmeta.domain;
+	const IndexIO::GlobalPartitionMetadata gpmeta = this->make_global_partition_metadata();
 
 	// Make placeholders for the region offsets to get an accurate size for the partition header
 	this->partition_header->region_offsets.clear();
 	this->partition_header->region_offsets.resize(regions_to_write.size() + 1, 0); // Placeholders for the purpose of accurate computing of the header size
+	// Element counts are known up front, so fill them in before measuring the header
+	this->partition_header->region_element_counts.clear();
+	for (boost::shared_ptr< RegionEncoding > region : regions_to_write)
+		this->partition_header->region_element_counts.push_back(region->get_element_count());
+	// As are the per-region representation types, for a heterogeneous index
+	this->partition_header->region_types.clear();
+	if (*this->partition_header->pmeta.index_rep == RegionEncoding::Type::HETEROGENEOUS)
+		for (boost::shared_ptr< RegionEncoding > region : regions_to_write)
+			this->partition_header->region_types.push_back((char)region->get_type());
+
 	const uint64_t header_size = this->partition_header.measure();
 
 	// BUGFIX: some ostream implementations are broken, with tellp flushing the buffer
@@ -255,7 +375,7 @@ void SharedFileFormatIndexPartitionIO::write_partition_to_disk() {
 		// Write all of the regions, recording the end offset of each one
 		// (also assert that they are the right representation type)
 		for (boost::shared_ptr< RegionEncoding > region : regions_to_write) {
-			assert(region->get_type() == *this->partition_header->pmeta.index_rep);
+			assert(region->get_type() == *this->partition_header->pmeta.index_rep || *this->partition_header->pmeta.index_rep == RegionEncoding::Type::HETEROGENEOUS);
 			region->save_to_stream(fout);
 		}
 
@@ -287,6 +407,26 @@ uint64_t SharedFileFormatIndexPartitionIO::compute_regions_size_impl(region_id_t
 	return this->partition_header->region_offsets[ub] - this->partition_header->region_offsets[lb];
 }
 
+uint64_t SharedFileFormatIndexPartitionIO::compute_regions_element_count_impl(region_id_t lb, region_id_t ub) {
+	const std::vector< uint64_t > &counts = this->partition_header->region_element_counts;
+	if (!counts.empty())
+		return std::accumulate(counts.begin() + lb, counts.begin() + ub, (uint64_t)0);
+
+	// Partitions written before element counts were recorded must have their regions read to count them
+	const boost::counting_iterator< region_id_t > region_begin(lb), region_end(ub);
+	const std::set< region_id_t > regions_to_read(region_begin, region_end);
+	std::map< region_id_t, boost::shared_ptr< RegionEncoding > > regions;
+	if (!this->read_regions_impl(regions_to_read, regions)) {
+		std::cerr << "Error: failed to read regions [" << lb << ", " << ub << ") to count their elements" << std::endl;
+		abort();
+	}
+
+	uint64_t count = 0;
+	for (const auto &region : regions)
+		count += region.second->get_element_count();
+	return count;
+}
+
 bool SharedFileFormatIndexPartitionIO::read_regions_impl(const std::set<region_id_t>& regions_to_read, std::map<region_id_t, boost::shared_ptr<RegionEncoding> >& regions) {
 	std::vector<char> buffer;
 
@@ -328,7 +468,11 @@ bool SharedFileFormatIndexPartitionIO::read_regions_impl(const std::set<region_i
 			boost::shared_ptr< RegionEncoding > region;
 
 			if (region_length > 0) {
-				region = RegionEncoding::make_null_region(*this->partition_header->pmeta.index_rep);
+				const RegionEncoding::Type region_type =
+					(*this->partition_header->pmeta.index_rep == RegionEncoding::Type::HETEROGENEOUS) ?
+						(RegionEncoding::Type)this->partition_header->region_types[region_id] :
+						*this->partition_header->pmeta.index_rep;
+				region = RegionEncoding::make_null_region(region_type);
 
 				// Deserialize the region from the correct slice of the byte buffer just read from disk
 				buffer_stream.seekg(region_offset_in_buffer, buffer_stream.beg);
@@ -346,6 +490,7 @@ bool SharedFileFormatIndexPartitionIO::read_regions_impl(const std::set<region_i
 }
 
 void SharedFileFormatIndexPartitionIO::set_partition_metadata_impl(PartitionMetadata pmeta) {
+	assert(!this->streamed_region_count); // The header's size on disk was fixed when streaming began
 	this->partition_header->pmeta.update(pmeta); // Only load in fields that are initialized in pmeta
 }
 
@@ -353,3 +498,76 @@ bool SharedFileFormatIndexPartitionIO::write_regions_impl(const std::vector< boo
 	this->regions_to_write = regions; // Hold the regions until close() time
 	return true;
 }
+
+bool SharedFileFormatIndexPartitionIO::begin_write_regions_impl(region_count_t nregions) {
+	if (this->is_partition_size_needed_to_allocate_partition())
+		return this->IndexPartitionIO::begin_write_regions_impl(nregions);
+
+	assert(this->partition_header && this->partition_header->pmeta.is_filled());
+	assert(!this->streamed_region_count && this->regions_to_write.empty());
+
+	// The header's size on disk depends only on the lengths of its vectors, so with placeholders in them, space can be
+	// reserved for it ahead of the regions, and the header filled in and written after the last region
+	const bool heterogeneous = (*this->partition_header->pmeta.index_rep == RegionEncoding::Type::HETEROGENEOUS);
+	this->partition_header->region_offsets.assign(nregions + 1, 0);
+	this->partition_header->region_element_counts.assign(nregions, 0);
+	this->partition_header->region_types.assign(heterogeneous ? nregions : 0, 0);
+	this->partition_header->region_offsets[0] = this->partition_header.measure();
+
+	this->partition_offset_in_file = this->allocate_partition(0, this->make_global_partition_metadata());
+	this->streamed_region_count = nregions;
+	this->next_streamed_region = 0;
+
+	if (nregions == 0)
+		finish_streamed_partition();
+	return true;
+}
+
+bool SharedFileFormatIndexPartitionIO::write_next_region_impl(boost::shared_ptr< RegionEncoding > region) {
+	if (!this->streamed_region_count)
+		return this->IndexPartitionIO::write_next_region_impl(region);
+	if (this->next_streamed_region >= *this->streamed_region_count)
+		return false;
+
+	const RegionEncoding::Type index_rep = *this->partition_header->pmeta.index_rep;
+	assert(region->get_type() == index_rep || index_rep == RegionEncoding::Type::HETEROGENEOUS);
+
+	const region_id_t region_id = this->next_streamed_region++;
+	this->partition_header->region_element_counts[region_id] = region->get_element_count();
+	if (index_rep == RegionEncoding::Type::HETEROGENEOUS)
+		this->partition_header->region_types[region_id] = (char)region->get_type();
+
+	// As in write_partition_to_disk(), measure the region rather than relying on tellp()
+	measuring_stream mstream;
+	region->save_to_stream(mstream);
+	const uint64_t region_offset = this->partition_header->region_offsets[region_id];
+	this->partition_header->region_offsets[region_id + 1] = region_offset + mstream.get_byte_count();
+
+	std::ostream &fout = this->parent.open_output_stream(true);
+	{ // IO timing
+		TimeBlock iotime = this->region_io_stats.open_write_time_block();
+		fout.seekp(*this->partition_offset_in_file + region_offset);
+		region->save_to_stream(fout);
+	}
+	const bool success = fout.good();
+	this->region_io_stats.write_bytes += mstream.get_byte_count();
+	this->parent.close_output_stream(fout);
+
+	if (this->next_streamed_region == *this->streamed_region_count)
+		finish_streamed_partition();
+	return success;
+}
+
+void SharedFileFormatIndexPartitionIO::finish_streamed_partition() {
+	const uint64_t partition_offset_in_file = *this->partition_offset_in_file;
+	const uint64_t partition_size = this->partition_header->region_offsets.back();
+
+	// Write the partition header into the space reserved for it, which will implicitly seek to the beginning of the partition
+	std::ostream &fout = this->parent.open_output_stream(true);
+	this->partition_header.write(fout);
+	fout.flush();
+	this->parent.close_output_stream(fout);
+
+	// Commit the partition
+	this->on_partition_committed(partition_offset_in_file, partition_size, this->make_global_partition_metadata());
+}
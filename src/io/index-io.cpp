@@ -72,10 +72,10 @@ auto IndexIO::get_partition_with_domain_offset(domain_offset_t global_domain_off
 }
 
 boost::shared_ptr< IndexPartitionIO > IndexIO::append_partition() {
-	assert(this->openmode == IndexOpenMode::WRITE);
+	assert(this->openmode == IndexOpenMode::WRITE || this->openmode == IndexOpenMode::WRITE_APPEND);
 
 	boost::shared_ptr< IndexPartitionIO > part = append_partition_impl();
-	part->open(this->openmode);
+	part->open(IndexOpenMode::WRITE); // The partition itself is always newly written, even when appending to an existing index
 	return part;
 }
 
@@ -103,6 +103,17 @@ uint64_t IndexPartitionIO::compute_regions_size(region_id_t lb, region_id_t ub)
 	}
 }
 
+uint64_t IndexPartitionIO::compute_regions_element_count(region_id_t lb, region_id_t ub) {
+	if (lb > ub || ub > this->get_num_regions()) {
+		abort();
+		return 0;
+	} else if (lb == ub) {
+		return 0;
+	} else {
+		return compute_regions_element_count_impl(lb, ub);
+	}
+}
+
 bool IndexPartitionIO::read_regions(const std::set< region_id_t > &regions_to_read, std::map< region_id_t, boost::shared_ptr< RegionEncoding > > &regions) {
 	// Validate all regions to read
 	const region_count_t num_regions = get_num_regions();
@@ -130,6 +141,16 @@ bool IndexPartitionIO::write_regions(const std::vector< boost::shared_ptr< Regio
 bool IndexPartitionIO::write_index(BinnedIndex &index) {
 	assert(this->openmode == IndexOpenMode::WRITE);
 
+	std::vector< boost::shared_ptr< RegionEncoding > > regions;
+	index.get_regions(regions);
+
+	set_index_metadata(index);
+	return write_regions(regions);
+}
+
+void IndexPartitionIO::set_index_metadata(const BinnedIndex &index) {
+	assert(this->openmode == IndexOpenMode::WRITE);
+
 	PartitionMetadata pmeta = get_partition_metadata();
 
 	const std::type_index datatype = index.get_indexed_datatype();
@@ -138,15 +159,42 @@ bool IndexPartitionIO::write_index(BinnedIndex &index) {
 	// Use the existing domain offset if present
 	const uint64_t domain_global_offset = (pmeta.domain ? pmeta.domain->first : (domain_offset_t)0);
 
-	std::vector< boost::shared_ptr< RegionEncoding > > regions;
-	index.get_regions(regions);
-
 	pmeta.indexed_datatype = datatypeid;
 	pmeta.domain = std::make_pair(domain_global_offset, index.get_domain_size());
 	pmeta.index_enc = index.get_encoding();
 	pmeta.index_rep = index.get_representation_type();
 	pmeta.binning_spec = index.get_binning_specification();
+	pmeta.grid = index.get_grid();
 
 	set_partition_metadata(pmeta);
-	return write_regions(regions);
+}
+
+bool IndexPartitionIO::begin_write_regions(region_count_t nregions) {
+	assert(this->openmode == IndexOpenMode::WRITE);
+	return this->begin_write_regions_impl(nregions);
+}
+
+bool IndexPartitionIO::write_next_region(boost::shared_ptr< RegionEncoding > region) {
+	assert(this->openmode == IndexOpenMode::WRITE);
+	return this->write_next_region_impl(region);
+}
+
+bool IndexPartitionIO::begin_write_regions_impl(region_count_t nregions) {
+	this->streamed_region_count = nregions;
+	this->streamed_regions.clear();
+	this->streamed_regions.reserve(nregions);
+	return nregions > 0 || this->write_regions_impl(this->streamed_regions);
+}
+
+bool IndexPartitionIO::write_next_region_impl(boost::shared_ptr< RegionEncoding > region) {
+	if (this->streamed_regions.size() >= this->streamed_region_count)
+		return false;
+
+	this->streamed_regions.push_back(region);
+	if (this->streamed_regions.size() < this->streamed_region_count)
+		return true;
+
+	const bool success = this->write_regions_impl(this->streamed_regions);
+	this->streamed_regions.clear();
+	return success;
 }
@@ -47,6 +47,8 @@ bool POSIXIndexIO::open_impl(std::string path, IndexOpenMode openmode) {
 			std::ios::binary |
 			(openmode == IndexOpenMode::READ ?
 				std::ios::in :
+			 openmode == IndexOpenMode::WRITE_APPEND ?
+				std::ios::in | std::ios::out : // Preserve existing contents (no truncation)
 				std::ios::out);
 
 	this->index_file.open(path.c_str(), file_openmode);
@@ -57,6 +59,12 @@ bool POSIXIndexIO::open_impl(std::string path, IndexOpenMode openmode) {
 		this->read_metadata_from_disk(); // Call on base class
 	else if (openmode == IndexOpenMode::WRITE)
 		this->init_metadata_empty();
+	else if (openmode == IndexOpenMode::WRITE_APPEND) {
+		if (!this->read_metadata_for_append()) {
+			this->index_file.close();
+			return false;
+		}
+	}
 	else
 		abort();
 	return true;
@@ -67,7 +75,7 @@ bool POSIXIndexIO::close_impl() {
 	if (!this->SharedFileFormatIndexIO::close_impl())
 		return false;
 
-	if (openmode == IndexOpenMode::WRITE)
+	if (openmode == IndexOpenMode::WRITE || openmode == IndexOpenMode::WRITE_APPEND)
 		this->write_metadata_to_disk(); // Call on the base class to write metadata to disk
 
 	this->index_file.close();
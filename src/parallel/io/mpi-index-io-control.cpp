@@ -21,6 +21,11 @@
  *      Author: David A. Boyuka II
  */
 
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
 #include "pique/parallel/io/impl/mpi-index-io-control.hpp"
 
 boost::shared_ptr< MPIIndexIOWriteControl > MPIIndexIOWriteControl::create_write_control(MPIIndexIO &indexio, MPI_Comm comm, int masterrank) {
@@ -41,10 +46,15 @@ void MPIIndexIOWriteMasterControl::process_message(MPI_Status status) {
 	switch (status.MPI_TAG) {
 	case OBTAIN_PARTITION_SPACE_TAG:
 	{
-		uint64_t msg[3];
-		MPI_Recv(msg, 3, MPI_UNSIGNED_LONG_LONG, source, tag, this->comm, MPI_STATUS_IGNORE);
-		const uint64_t partition_size = msg[0];
-		const IndexIO::GlobalPartitionMetadata pmeta { { msg[1], msg[2] } };
+		// The partition size, followed by the serialized partition metadata (see allocate_and_commit_partition())
+		int msg_size;
+		MPI_Get_count(&status, MPI_BYTE, &msg_size);
+		std::vector< char > msg(msg_size);
+		MPI_Recv(&msg.front(), msg_size, MPI_BYTE, source, tag, this->comm, MPI_STATUS_IGNORE);
+
+		uint64_t partition_size;
+		memcpy(&partition_size, &msg.front(), sizeof(uint64_t));
+		const IndexIO::GlobalPartitionMetadata pmeta = MPIIndexIO::deserialize_global_partition_metadata(std::string(msg.begin() + sizeof(uint64_t), msg.end()));
 
 		uint64_t return_offset = this->allocate_and_commit_partition(partition_size, pmeta); // call the master-local version
 		MPI_Send(&return_offset, 1, MPI_UNSIGNED_LONG_LONG, source, tag, this->comm);
@@ -107,8 +117,12 @@ bool MPIIndexIOWriteMasterControl::close_impl() {
 // obtain_partition_space()
 uint64_t MPIIndexIOWriteControl::allocate_and_commit_partition(uint64_t partition_size, IndexIO::GlobalPartitionMetadata gpmeta) {
 	TIME_STATS_TIME_BEGIN(stats.mpitime)
-	uint64_t msg[3] = { partition_size, gpmeta.domain.first, gpmeta.domain.second };
-	MPI_Send(msg, 3, MPI_UNSIGNED_LONG_LONG, this->masterrank, OBTAIN_PARTITION_SPACE_TAG, this->comm);
+	// Send the full partition metadata (including any zone map), so the master's footer matches a serially written one
+	const std::string gpmeta_buffer = MPIIndexIO::serialize_global_partition_metadata(gpmeta);
+	std::vector< char > msg(sizeof(uint64_t) + gpmeta_buffer.size());
+	memcpy(&msg.front(), &partition_size, sizeof(uint64_t));
+	std::copy(gpmeta_buffer.begin(), gpmeta_buffer.end(), msg.begin() + sizeof(uint64_t));
+	MPI_Send(&msg.front(), (int)msg.size(), MPI_BYTE, this->masterrank, OBTAIN_PARTITION_SPACE_TAG, this->comm);
 
 	uint64_t offset;
 	MPI_Recv(&offset, 1, MPI_UNSIGNED_LONG_LONG, this->masterrank, OBTAIN_PARTITION_SPACE_TAG, this->comm, MPI_STATUS_IGNORE);
@@ -28,6 +28,7 @@
 #include <set>
 
 #include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/iterator/counting_iterator.hpp>
 
 #include "pique/query/query-engine.hpp"
@@ -35,6 +36,53 @@
 #include "pique/util/dynamic-dispatch.hpp"
 #include "pique/util/timing.hpp"
 
+// Wraps a region's RID iterator, holding a reference to the region so it outlives the iterator
+class OwningRIDBatchIterator : public RIDBatchIterator {
+public:
+	OwningRIDBatchIterator(boost::shared_ptr< const RegionEncoding > region, uint64_t offset) :
+		region(region), it(region->make_rid_iterator(offset))
+	{}
+
+private:
+	virtual void next_batch_impl(std::vector<uint64_t> &out, size_t max_rids) {
+		it->next_batch(out, max_rids); // out is empty on entry (cleared by next_batch), so delegating wholesale is safe
+	}
+
+private:
+	const boost::shared_ptr< const RegionEncoding > region;
+	const boost::shared_ptr< RIDBatchIterator > it;
+};
+
+// Default batch cursor: advances independent per-query cursors in lockstep
+class IndependentBatchQueryCursor : public QueryEngine::BatchQueryCursor {
+public:
+	IndependentBatchQueryCursor(std::vector< boost::shared_ptr< QueryEngine::QueryCursor > > cursors, QueryEngine::domain_id_t cur_domain, QueryEngine::domain_id_t end_domain) :
+		QueryEngine::BatchQueryCursor(cur_domain, end_domain), cursors(std::move(cursors))
+	{}
+
+private:
+	virtual bool has_next_impl() {
+		for (boost::shared_ptr< QueryEngine::QueryCursor > &cursor : this->cursors)
+			if (!cursor->has_next())
+				return false;
+		return true;
+	}
+
+	virtual std::vector< QueryEngine::QueryPartitionResult > next_impl() {
+		std::vector< QueryEngine::QueryPartitionResult > results;
+		for (boost::shared_ptr< QueryEngine::QueryCursor > &cursor : this->cursors)
+			results.push_back(cursor->next());
+		return results;
+	}
+
+private:
+	std::vector< boost::shared_ptr< QueryEngine::QueryCursor > > cursors;
+};
+
+boost::shared_ptr< RIDBatchIterator > QueryEngine::QueryPartitionResult::make_rid_iterator() const {
+	return boost::make_shared< OwningRIDBatchIterator >(this->result, this->partition_domain.first);
+}
+
 void QueryEngine::QuerySummaryStats::operator+=(const QueryStats& qstats) {
 	using TermEvalStats = QueryEngine::TermEvalStats;
 	using ConstraintStats = QueryEngine::ConstraintTermEvalStats;
@@ -72,6 +120,37 @@ auto QueryEngine::evaluate(const Query& query, domain_id_t begin_domain_id, doma
 	return this->evaluate_impl(query, begin_domain_id, end_domain_id);
 }
 
+auto QueryEngine::evaluate_batch(const std::vector< Query > &queries, domain_id_t begin_domain_id, domain_id_t end_domain_id) -> boost::shared_ptr< BatchQueryCursor > {
+	return this->evaluate_batch_impl(queries, begin_domain_id, end_domain_id);
+}
+
+uint64_t QueryEngine::count(const Query& query, domain_id_t begin_domain_id, domain_id_t end_domain_id) {
+	return this->count_impl(query, begin_domain_id, end_domain_id);
+}
+
+std::vector< uint64_t > QueryEngine::histogram(std::string varname, const std::vector< UniversalValue > &bucket_bounds, domain_id_t begin_domain_id, domain_id_t end_domain_id) {
+	assert(bucket_bounds.size() >= 1);
+	return this->histogram_impl(std::move(varname), bucket_bounds, begin_domain_id, end_domain_id);
+}
+
+uint64_t QueryEngine::count_impl(const Query& query, domain_id_t begin_domain_id, domain_id_t end_domain_id) {
+	uint64_t count = 0;
+
+	boost::shared_ptr< QueryCursor > cursor = this->evaluate(query, begin_domain_id, end_domain_id);
+	while (cursor->has_next())
+		count += cursor->next().result->get_element_count();
+
+	return count;
+}
+
+auto QueryEngine::evaluate_batch_impl(const std::vector< Query > &queries, domain_id_t begin_domain_id, domain_id_t end_domain_id) -> boost::shared_ptr< BatchQueryCursor > {
+	std::vector< boost::shared_ptr< QueryCursor > > cursors;
+	for (const Query &query : queries)
+		cursors.push_back(this->evaluate(query, begin_domain_id, end_domain_id));
+
+	return boost::make_shared< IndependentBatchQueryCursor >(std::move(cursors), begin_domain_id, end_domain_id);
+}
+
 bool QueryEngine::open_impl(boost::shared_ptr<Database> db) {
 	this->database = db;
 	return true;
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * query-rewriter.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cassert>
+#include <vector>
+#include <map>
+#include <typeinfo>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/optional.hpp>
+
+#include "pique/query/query.hpp"
+#include "pique/query/query-rewriter.hpp"
+
+// Expression tree form of a (RPN) Query
+struct QueryTreeNode {
+	boost::shared_ptr< QueryTerm > term; // A leaf term (constraint, spatial constraint or variable expression), or the operator applied to children
+	std::vector< QueryTreeNode > children;
+	boost::optional< std::string > varname; // Set iff every constraint in this subtree is on this same variable
+
+	bool is_leaf() const { return children.empty(); }
+	bool is_complement() const { return typeid(*term) == typeid(UnaryOperatorTerm); }
+	bool is_nary_op(NArySetOperation op) const {
+		const NAryOperatorTerm *noqt = dynamic_cast< const NAryOperatorTerm * >(term.get());
+		return noqt && noqt->op == op;
+	}
+};
+
+static boost::optional< std::string > compute_common_varname(const std::vector< QueryTreeNode > &children) {
+	for (const QueryTreeNode &child : children)
+		if (!child.varname || *child.varname != *children.front().varname)
+			return boost::none;
+	return children.front().varname;
+}
+
+static QueryTreeNode make_op_node(boost::shared_ptr< QueryTerm > op_term, std::vector< QueryTreeNode > children) {
+	QueryTreeNode node;
+	node.term = op_term;
+	node.children = std::move(children);
+	node.varname = compute_common_varname(node.children);
+	return node;
+}
+
+static QueryTreeNode make_nary_op_node(NArySetOperation op, std::vector< QueryTreeNode > children) {
+	const int arity = children.size();
+	return make_op_node(boost::make_shared< NAryOperatorTerm >(op, arity), std::move(children));
+}
+
+static QueryTreeNode make_complement_node(QueryTreeNode child) {
+	std::vector< QueryTreeNode > children;
+	children.push_back(std::move(child));
+	return make_op_node(boost::make_shared< UnaryOperatorTerm >(UnarySetOperation::COMPLEMENT), std::move(children));
+}
+
+static QueryTreeNode parse_query_tree(const Query &query) {
+	std::vector< QueryTreeNode > stack;
+
+	for (const boost::shared_ptr< QueryTerm > &term : query) {
+		const std::type_info &ti = typeid(*term);
+
+		if (ti == typeid(ConstraintTerm) || ti == typeid(VariableExpressionTerm)) {
+			QueryTreeNode leaf;
+			leaf.term = term;
+			leaf.varname = (ti == typeid(ConstraintTerm) ?
+					dynamic_cast< const ConstraintTerm & >(*term).varname :
+					dynamic_cast< const VariableExpressionTerm & >(*term).varname);
+			stack.push_back(std::move(leaf));
+		} else if (ti == typeid(SpatialConstraintTerm)) {
+			// Spatial constraints have no bin ranges to merge, so leave varname unset to keep them out of variable expressions
+			QueryTreeNode leaf;
+			leaf.term = term;
+			stack.push_back(std::move(leaf));
+		} else {
+			const int arity = (ti == typeid(UnaryOperatorTerm) ? 1 : dynamic_cast< const NAryOperatorTerm & >(*term).arity);
+			assert(stack.size() >= (size_t)arity);
+
+			std::vector< QueryTreeNode > children(
+					std::make_move_iterator(stack.end() - arity),
+					std::make_move_iterator(stack.end()));
+			stack.erase(stack.end() - arity, stack.end());
+			stack.push_back(make_op_node(term, std::move(children)));
+		}
+	}
+
+	assert(stack.size() == 1);
+	return std::move(stack.back());
+}
+
+// Top-down: pushes complements of multi-variable subexpressions through INTERSECTION/UNION by De Morgan's laws (cancelling
+// double complements), so that complements reach single-variable subexpressions, where they become complemented bin ranges
+static void push_down_complements(QueryTreeNode &node) {
+	while (node.is_complement() && !node.varname) {
+		QueryTreeNode child = std::move(node.children[0]);
+
+		if (child.is_complement()) {
+			QueryTreeNode grandchild = std::move(child.children[0]);
+			node = std::move(grandchild);
+		} else if (child.is_nary_op(NArySetOperation::INTERSECTION) || child.is_nary_op(NArySetOperation::UNION)) {
+			const NArySetOperation dual_op = child.is_nary_op(NArySetOperation::INTERSECTION) ? NArySetOperation::UNION : NArySetOperation::INTERSECTION;
+			std::vector< QueryTreeNode > complemented_children;
+			for (QueryTreeNode &grandchild : child.children)
+				complemented_children.push_back(make_complement_node(std::move(grandchild)));
+			node = make_nary_op_node(dual_op, std::move(complemented_children));
+		} else {
+			node.children[0] = std::move(child);
+			break;
+		}
+	}
+
+	for (QueryTreeNode &child : node.children)
+		push_down_complements(child);
+}
+
+// Bottom-up: flattens nested INTERSECTIONs/UNIONs, and groups same-variable operands of each INTERSECTION/UNION
+static void flatten_and_group(QueryTreeNode &node) {
+	for (QueryTreeNode &child : node.children)
+		flatten_and_group(child);
+
+	for (NArySetOperation op : { NArySetOperation::INTERSECTION, NArySetOperation::UNION }) {
+		if (!node.is_nary_op(op))
+			continue;
+
+		// Flatten: splice in the operands of same-operator children
+		std::vector< QueryTreeNode > flat_children;
+		for (QueryTreeNode &child : node.children) {
+			if (child.is_nary_op(op))
+				std::move(child.children.begin(), child.children.end(), std::back_inserter(flat_children));
+			else
+				flat_children.push_back(std::move(child));
+		}
+
+		// Group: gather operands on the same variable into one sub-operator (at the position of the first such operand)
+		std::vector< std::vector< QueryTreeNode > > groups;
+		std::map< std::string, size_t > group_by_varname;
+		for (QueryTreeNode &child : flat_children) {
+			if (child.varname) {
+				auto inserted = group_by_varname.insert(std::make_pair(*child.varname, groups.size()));
+				if (!inserted.second) {
+					groups[inserted.first->second].push_back(std::move(child));
+					continue;
+				}
+			}
+			groups.push_back(std::vector< QueryTreeNode >());
+			groups.back().push_back(std::move(child));
+		}
+
+		if (groups.size() == 1) {
+			node = make_nary_op_node(op, std::move(groups[0]));
+		} else {
+			std::vector< QueryTreeNode > new_children;
+			for (std::vector< QueryTreeNode > &group : groups) {
+				if (group.size() == 1)
+					new_children.push_back(std::move(group[0]));
+				else
+					new_children.push_back(make_nary_op_node(op, std::move(group)));
+			}
+			node = make_nary_op_node(op, std::move(new_children));
+		}
+	}
+}
+
+// Appends the RPN form of a subtree to out, inlining any nested variable expressions
+static void emit_plain(const QueryTreeNode &node, Query &out) {
+	if (node.is_leaf() && typeid(*node.term) == typeid(VariableExpressionTerm)) {
+		const Query &expr = dynamic_cast< const VariableExpressionTerm & >(*node.term).expr;
+		out.insert(out.end(), expr.begin(), expr.end());
+		return;
+	}
+
+	for (const QueryTreeNode &child : node.children)
+		emit_plain(child, out);
+	out.push_back(node.term);
+}
+
+// Appends the RPN form of a subtree to out, replacing maximal single-variable subexpressions by VariableExpressionTerms
+static void emit_rewritten(const QueryTreeNode &node, Query &out) {
+	if (node.varname && !node.is_leaf()) {
+		Query expr;
+		emit_plain(node, expr);
+		out.push_back(boost::make_shared< VariableExpressionTerm >(*node.varname, std::move(expr)));
+		return;
+	}
+
+	for (const QueryTreeNode &child : node.children)
+		emit_rewritten(child, out);
+	out.push_back(node.term);
+}
+
+Query QueryRewriter::rewrite(const Query &query) {
+	if (query.empty())
+		return query;
+
+	QueryTreeNode root = parse_query_tree(query);
+	push_down_complements(root);
+	flatten_and_group(root);
+
+	Query out;
+	emit_rewritten(root, out);
+	return out;
+}
@@ -21,6 +21,7 @@
  *      Author: drew
  */
 
+#include <string>
 #include <vector>
 #include <boost/smart_ptr.hpp>
 #include <boost/make_shared.hpp>
@@ -29,6 +30,13 @@
 #include "pique/setops/setops.hpp"
 #include "pique/query/query.hpp"
 
+std::string SpatialConstraintTerm::to_string() {
+	std::string str = varname + " in ";
+	for (size_t d = 0; d < subvolume_offsets.size(); ++d)
+		str += (d ? "x" : "") + std::string("[") + std::to_string(subvolume_offsets[d]) + "," + std::to_string(subvolume_offsets[d] + subvolume_dims[d]) + ")";
+	return str;
+}
+
 Query operator&(const Query &left, const Query &right) {
 	Query &&r = Query();
 	r.insert(r.begin(), left.begin(), left.end());
@@ -44,3 +52,10 @@ Query operator|(const Query &left, const Query &right) {
 	r.push_back(boost::make_shared< NAryOperatorTerm >(NArySetOperation::UNION));
 	return r;
 }
+
+std::string VariableExpressionTerm::to_string() {
+	std::string str = "{";
+	for (auto it = expr.cbegin(); it != expr.cend(); ++it)
+		str += (it == expr.cbegin() ? "" : " ") + (*it)->to_string();
+	return str + "}";
+}
@@ -22,9 +22,15 @@
  */
 
 #include <cassert>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
 
+#include "pique/data/grid-subset.hpp"
 #include "pique/encoding/index-encoding.hpp"
 #include "pique/io/index-io.hpp"
+#include "pique/query/query-rewriter.hpp"
 #include "pique/query/simple-query-engine.hpp"
 #include "pique/stats/stats.hpp"
 #include "pique/util/timing.hpp"
@@ -43,14 +49,26 @@ struct EvaluateVisitor {
 		stack_mut.push_back(false);
 	}
 	void operator()(const RegionMath::UnaryOperatorTerm &op) {
-		stack.back() = qe.evaluate_set_op(stack.back(), stack_mut.back(), op.op);
-		stack_mut.back() = true;
+		boost::shared_ptr< RegionEncoding > result = qe.evaluate_set_op(stack.back(), stack_mut.back(), op.op);
+		if (result != stack.back()) {
+			stack.back() = result;
+			stack_mut.back() = true;
+		}
 	}
 	void operator()(const RegionMath::NAryOperatorTerm &op) {
 		auto first_operand = stack.end() - op.arity;
 		auto first_operand_mut = stack_mut.end() - op.arity;
-		*first_operand = qe.evaluate_set_op(first_operand, stack.end(), first_operand_mut, stack_mut.end(), op.op);
-		*first_operand_mut = true;
+		boost::shared_ptr< RegionEncoding > result = qe.evaluate_set_op(first_operand, stack.end(), first_operand_mut, stack_mut.end(), op.op);
+
+		// A set operation may pass an operand through as its result (e.g., a unary union); that operand keeps its
+		// mutability, since a region read for a constraint may appear more than once in its RegionMath
+		int result_mut = true;
+		for (int i = 0; i < op.arity; ++i)
+			if (first_operand[i] == result)
+				result_mut = first_operand_mut[i];
+
+		*first_operand = result;
+		*first_operand_mut = result_mut;
 		stack.erase(first_operand + 1, stack.end());
 		stack_mut.erase(first_operand_mut + 1, stack_mut.end());
 	}
@@ -62,6 +80,209 @@ struct EvaluateVisitor {
 	std::vector< int > stack_mut;
 };
 
+// RegionMath evaluator for multi-variable query RegionMath, recording stats for each term
+// (derived classes decide how constraint results are obtained)
+struct EvaluateQueryVisitor : public EvaluateVisitor {
+	using ConstrTermStats = QueryEngine::ConstraintTermEvalStats;
+	using MVTermStats = QueryEngine::MultivarTermEvalStats;
+
+	typedef void result_type;
+	EvaluateQueryVisitor(const SimpleQueryEngine &qe, QueryEngine::QueryStats &qs) : EvaluateVisitor(qe), qs(qs) {}
+	virtual ~EvaluateQueryVisitor() {}
+
+	void operator()(const RegionMath::RegionTerm &op) { this->EvaluateVisitor::operator()(op); }
+	void operator()(const RegionMath::UnaryOperatorTerm &op) {
+		MVTermStats &terminfo = new_multivar_term_stats();
+		terminfo.arity = 1;
+		terminfo.name = std::string("unary:") + (char)('0' + (char)op.op);
+		terminfo.in_regions_bytes = stack.back()->get_size_in_bytes();
+		TIME_STATS_TIME_BEGIN(terminfo.total);
+		this->EvaluateVisitor::operator()(op);
+		TIME_STATS_TIME_END();
+		terminfo.output_region_bytes = stack.back()->get_size_in_bytes();
+		qs.setopstotal += terminfo.total;
+	}
+	void operator()(const RegionMath::NAryOperatorTerm &op) {
+		MVTermStats &terminfo = new_multivar_term_stats();
+		terminfo.arity = op.arity;
+		terminfo.name = std::string("nary:") + (char)('0' + (char)op.op);
+		terminfo.in_regions_bytes = stack.back()->get_size_in_bytes();
+
+		auto first_operand = stack.end() - op.arity, end_operands = stack.end();
+		terminfo.in_regions_bytes = 0;
+		for (auto it = first_operand; it != end_operands; ++it)
+			terminfo.in_regions_bytes += (*it)->get_size_in_bytes();
+
+		TIME_STATS_TIME_BEGIN(terminfo.total);
+		this->EvaluateVisitor::operator()(op);
+		TIME_STATS_TIME_END();
+		terminfo.output_region_bytes = stack.back()->get_size_in_bytes();
+		qs.setopstotal += terminfo.total;
+	}
+
+protected:
+	ConstrTermStats & new_constraint_term_stats() {
+		boost::shared_ptr< ConstrTermStats > stats = boost::make_shared< ConstrTermStats >();
+		qs.terminfos.push_back(stats);
+		return *stats;
+	}
+	MVTermStats & new_multivar_term_stats() {
+		boost::shared_ptr< MVTermStats > stats = boost::make_shared< MVTermStats >();
+		qs.terminfos.push_back(stats);
+		return *stats;
+	}
+
+	QueryEngine::QueryStats &qs;
+};
+
+using bin_id_range_t = std::pair< BinnedIndexTypes::bin_id_t, BinnedIndexTypes::bin_id_t >; // As in SimpleQueryEngine
+using bin_id_ranges_t = std::vector< bin_id_range_t >;
+
+// Evaluates a univariate term (ConstraintTerm, or VariableExpressionTerm over ConstraintTerms) bottom-up over some value domain
+// (e.g., sets of bin ranges), given the value of each constraint and the semantics of each set operation on values
+template<typename ValueT, typename ConstraintFn, typename UnaryOpFn, typename NAryOpFn>
+static ValueT evaluate_univariate_term(const QueryTerm &term, ConstraintFn constraint_value, UnaryOpFn unary_op, NAryOpFn nary_op) {
+	if (typeid(term) == typeid(ConstraintTerm))
+		return constraint_value(dynamic_cast< const ConstraintTerm & >(term));
+
+	const VariableExpressionTerm &vet = dynamic_cast< const VariableExpressionTerm & >(term);
+	std::vector< ValueT > stack;
+	for (const boost::shared_ptr< QueryTerm > &qt : vet.expr) {
+		const std::type_info &ti = typeid(*qt);
+		if (ti == typeid(UnaryOperatorTerm)) {
+			stack.back() = unary_op(dynamic_cast< const UnaryOperatorTerm & >(*qt).op, stack.back());
+		} else if (ti == typeid(NAryOperatorTerm)) {
+			const NAryOperatorTerm &noqt = dynamic_cast< const NAryOperatorTerm & >(*qt);
+			assert(stack.size() >= (size_t)noqt.arity);
+			const std::vector< ValueT > operands(stack.end() - noqt.arity, stack.end());
+			stack.erase(stack.end() - noqt.arity, stack.end());
+			stack.push_back(nary_op(noqt.op, operands));
+		} else {
+			stack.push_back(evaluate_univariate_term< ValueT >(*qt, constraint_value, unary_op, nary_op));
+		}
+	}
+
+	assert(stack.size() == 1);
+	return stack.back();
+}
+
+// Whether an element belongs to the result of a set operation, given whether it belongs to each operand
+static bool apply_nary_set_op_membership(NArySetOperation op, const std::vector< char > &in_operands) {
+	switch (op) {
+	case NArySetOperation::UNION:
+		return std::any_of(in_operands.begin(), in_operands.end(), [](char in)->bool { return in; });
+	case NArySetOperation::INTERSECTION:
+		return std::all_of(in_operands.begin(), in_operands.end(), [](char in)->bool { return in; });
+	case NArySetOperation::DIFFERENCE:
+		return in_operands[0] && std::none_of(in_operands.begin() + 1, in_operands.end(), [](char in)->bool { return in; });
+	case NArySetOperation::SYMMETRIC_DIFFERENCE:
+		return std::count(in_operands.begin(), in_operands.end(), true) % 2 == 1;
+	default: abort(); return false;
+	}
+}
+
+// As above, but with three-valued logic (boost::none = unknown), as used for zone map matching
+static boost::optional< bool > apply_nary_set_op_membership(NArySetOperation op, const std::vector< boost::optional< bool > > &in_operands) {
+	auto is_true = [](const boost::optional< bool > &in)->bool { return in && *in; };
+	auto is_false = [](const boost::optional< bool > &in)->bool { return in && !*in; };
+
+	switch (op) {
+	case NArySetOperation::UNION:
+		if (std::any_of(in_operands.begin(), in_operands.end(), is_true)) return true;
+		if (std::all_of(in_operands.begin(), in_operands.end(), is_false)) return false;
+		return boost::none;
+	case NArySetOperation::INTERSECTION:
+		if (std::any_of(in_operands.begin(), in_operands.end(), is_false)) return false;
+		if (std::all_of(in_operands.begin(), in_operands.end(), is_true)) return true;
+		return boost::none;
+	case NArySetOperation::DIFFERENCE:
+	{
+		const boost::optional< bool > in_rest = apply_nary_set_op_membership(NArySetOperation::UNION, std::vector< boost::optional< bool > >(in_operands.begin() + 1, in_operands.end()));
+		return apply_nary_set_op_membership(NArySetOperation::INTERSECTION, { in_operands[0], in_rest ? boost::optional< bool >(!*in_rest) : boost::none });
+	}
+	case NArySetOperation::SYMMETRIC_DIFFERENCE:
+		if (!std::all_of(in_operands.begin(), in_operands.end(), [](const boost::optional< bool > &in)->bool { return (bool)in; }))
+			return boost::none;
+		return std::count_if(in_operands.begin(), in_operands.end(), is_true) % 2 == 1;
+	default: abort(); return boost::none;
+	}
+}
+
+// Applies a set operation to sets of bin ranges over the bins [0, nbins), by sweeping the elementary intervals between all range endpoints
+template<typename MembershipFn>
+static bin_id_ranges_t combine_bin_ranges(const std::vector< bin_id_ranges_t > &operands, BinnedIndexTypes::bin_id_t nbins, MembershipFn is_member) {
+	using bin_id_t = BinnedIndexTypes::bin_id_t;
+
+	std::vector< bin_id_t > endpoints = { 0, nbins };
+	for (const bin_id_ranges_t &operand : operands)
+		for (const bin_id_range_t &range : operand) {
+			endpoints.push_back(std::min(range.first, nbins));
+			endpoints.push_back(std::min(range.second, nbins));
+		}
+	std::sort(endpoints.begin(), endpoints.end());
+	endpoints.erase(std::unique(endpoints.begin(), endpoints.end()), endpoints.end());
+
+	bin_id_ranges_t out;
+	std::vector< size_t > operand_pos(operands.size(), 0);
+	std::vector< char > in_operands(operands.size());
+	for (size_t i = 0; i + 1 < endpoints.size(); ++i) {
+		const bin_id_t lo = endpoints[i], hi = endpoints[i + 1];
+
+		// Each elementary interval [lo, hi) lies either entirely inside or entirely outside each operand range
+		for (size_t k = 0; k < operands.size(); ++k) {
+			size_t &pos = operand_pos[k];
+			while (pos < operands[k].size() && operands[k][pos].second <= lo)
+				++pos;
+			in_operands[k] = (pos < operands[k].size() && operands[k][pos].first <= lo);
+		}
+
+		if (!is_member(in_operands))
+			continue;
+		else if (!out.empty() && out.back().second == lo)
+			out.back().second = hi;
+		else
+			out.push_back(bin_id_range_t(lo, hi));
+	}
+	return out;
+}
+
+// Operand structure of a (postfix) RegionMath: for each term, the indices of the terms rooting its operands' subtrees
+static std::vector< std::vector< size_t > > compute_region_math_operands(const RegionMath::RegionMath &rmath) {
+	std::vector< std::vector< size_t > > operands(rmath.size());
+	std::vector< size_t > stack;
+	for (size_t i = 0; i < rmath.size(); ++i) {
+		int arity = 0;
+		if (rmath[i].which() == RegionMath::RegionMath::UNARY_OP)
+			arity = 1;
+		else if (rmath[i].which() == RegionMath::RegionMath::NARY_OP)
+			arity = boost::get< RegionMath::NAryOperatorTerm >(rmath[i]).arity;
+
+		assert(stack.size() >= (size_t)arity);
+		operands[i].assign(stack.end() - arity, stack.end());
+		stack.erase(stack.end() - arity, stack.end());
+		stack.push_back(i);
+	}
+	assert(stack.size() == 1);
+	return operands;
+}
+
+// Counts the regions (i.e., constraint references) in the RegionMath subtree rooted at the given term
+static uint64_t count_region_math_regions(const RegionMath::RegionMath &rmath, const std::vector< std::vector< size_t > > &operands, size_t root) {
+	if (rmath[root].which() == RegionMath::RegionMath::REGION)
+		return 1;
+
+	uint64_t count = 0;
+	for (size_t operand : operands[root])
+		count += count_region_math_regions(rmath, operands, operand);
+	return count;
+}
+
+// Records the hull of a set of bin ranges as the bin range of a constraint term
+static void set_terminfo_bin_range(QueryEngine::ConstraintTermEvalStats &terminfo, const bin_id_ranges_t &bin_ranges) {
+	terminfo.lb_bin = (bin_ranges.empty() ? 0 : bin_ranges.front().first);
+	terminfo.ub_bin = (bin_ranges.empty() ? 0 : bin_ranges.back().second);
+}
+
 class SimpleQueryCursor : public QueryEngine::QueryCursor {
 public:
 	using DFE = SimpleQueryEngine::DeferredConstraintEvaluator;
@@ -72,53 +293,54 @@ public:
 	using domain_mapping_t = IndexIOTypes::domain_mapping_t;
 
 	virtual ~SimpleQueryCursor() {}
-	SimpleQueryCursor(
-			SimpleQueryEngine &sqe, std::vector< DFE > constraints, RegionMath::RegionMath multivar_rmath,
-			domain_id_t cur_part, domain_id_t end_part);
+	SimpleQueryCursor(SimpleQueryEngine &sqe, Query query, domain_id_t cur_part, domain_id_t end_part);
 
 	// Move-only, no copying
 	SimpleQueryCursor(const SimpleQueryCursor &) = delete;
 	SimpleQueryCursor(SimpleQueryCursor &&) = default;
 
-private:
-	virtual QueryEngine::QueryPartitionResult next_impl();
+	// Partition mapping helpers (also used by SimpleBatchQueryCursor)
+	static std::vector< std::vector< domain_mapping_t > > compute_partition_mapping(const SimpleQueryEngine &sqe, const std::vector< DFE > &constraints);
+	static void compute_constraint_partitions(const std::vector< std::vector< domain_mapping_t > > &constraint_domain_mapping, domain_id_t domain_id, std::vector< partition_id_t > &constraint_partitions, domain_t &domain);
+	static domain_id_t get_num_domains(const std::vector< std::vector< domain_mapping_t > > &constraint_domain_mapping);
 
 private:
-	std::vector< std::vector< domain_mapping_t > > compute_partition_mapping() const;
-	void compute_constraint_partitions(domain_id_t domain_id, std::vector< partition_id_t > &constraint_partitions, domain_t &domain) const;
+	virtual QueryEngine::QueryPartitionResult next_impl();
 
 private:
 	SimpleQueryEngine &sqe;
+	const Query query; // Retained, since the constraints refer to its terms
 	std::vector< DFE > constraints;
 	RegionMath::RegionMath multivar_rmath;
 
 	std::vector< std::vector< domain_mapping_t > > constraint_domain_mapping; // [constraint_id][sorted_partition_id] -> partition_id
 };
 
-SimpleQueryCursor::SimpleQueryCursor(
-		SimpleQueryEngine &sqe, std::vector< DFE > constraints, RegionMath::RegionMath multivar_rmath,
-		domain_id_t cur_part, domain_id_t end_part) :
-	QueryCursor(cur_part, end_part),
-	sqe(sqe), constraints(std::move(constraints)), multivar_rmath(std::move(multivar_rmath))
+SimpleQueryCursor::SimpleQueryCursor(SimpleQueryEngine &sqe, Query query, domain_id_t cur_part, domain_id_t end_part) :
+	QueryEngine::QueryCursor(cur_part, end_part),
+	sqe(sqe), query(std::move(query))
 {
-	this->constraint_domain_mapping = compute_partition_mapping();
+	// Compute the initial inter-variable query RegionMath
+	this->sqe.convert_query_to_region_math(this->query, this->constraints, this->multivar_rmath);
+
+	this->constraint_domain_mapping = compute_partition_mapping(this->sqe, this->constraints);
 
 	// Restrict the end of this cursor's range to the number of partitions that actually exist
-	this->restrict_end_partition(this->constraint_domain_mapping[0].size());
+	this->restrict_end_partition(get_num_domains(this->constraint_domain_mapping));
 }
 
-auto SimpleQueryCursor::compute_partition_mapping() const -> std::vector< std::vector< domain_mapping_t > > {
+auto SimpleQueryCursor::compute_partition_mapping(const SimpleQueryEngine &sqe, const std::vector< DFE > &constraints) -> std::vector< std::vector< domain_mapping_t > > {
 	using domain_t = IndexIOTypes::domain_t;
 	using domain_mapping_t = IndexIOTypes::domain_mapping_t;
-	if (this->constraints.size() == 0)
+	if (constraints.size() == 0)
 		return std::vector< std::vector< domain_mapping_t > >();
 
-	IndexIOCache &iocache = *this->sqe.iocache;
+	IndexIOCache &iocache = *sqe.iocache;
 	std::vector< partition_count_t > constraint_part_counts;
 	std::vector< std::vector< domain_mapping_t > > constraint_part_domain_mappings;
 
-	for (auto &constraint : this->constraints) {
-		boost::shared_ptr< IndexIO > iio = iocache.open_index_io(constraint.constr.varname);
+	for (auto &constraint : constraints) {
+		boost::shared_ptr< IndexIO > iio = iocache.open_index_io(constraint.varname);
 		constraint_part_counts.push_back(iio->get_num_partitions());
 		constraint_part_domain_mappings.push_back(iio->get_sorted_partition_domain_mappings());
 	}
@@ -149,16 +371,21 @@ auto SimpleQueryCursor::compute_partition_mapping() const -> std::vector< std::v
 	return constraint_part_domain_mappings;
 }
 
-void SimpleQueryCursor::compute_constraint_partitions(domain_id_t domain_id, std::vector< partition_id_t > &constraint_partitions, domain_t &domain) const
+// With no constraints (an empty query or batch), no variable index defines any domains, so there are none to evaluate
+auto SimpleQueryCursor::get_num_domains(const std::vector< std::vector< domain_mapping_t > > &constraint_domain_mapping) -> domain_id_t {
+	return constraint_domain_mapping.empty() ? 0 : constraint_domain_mapping[0].size();
+}
+
+void SimpleQueryCursor::compute_constraint_partitions(const std::vector< std::vector< domain_mapping_t > > &constraint_domain_mapping, domain_id_t domain_id, std::vector< partition_id_t > &constraint_partitions, domain_t &domain)
 {
 	constraint_partitions.clear();
 
 	// Retrieve the domain from the first constraint (all constraints have been verified to have equivalent domain partitioning)
-	domain = this->constraint_domain_mapping[0][domain_id].second;
+	domain = constraint_domain_mapping[0][domain_id].second;
 
 	// Convert each sorted partition ID -> true partition ID mapping table to the true partition ID at the requested sorted_partition
 	std::transform(
-		this->constraint_domain_mapping.begin(), this->constraint_domain_mapping.end(), std::back_inserter(constraint_partitions),
+		constraint_domain_mapping.begin(), constraint_domain_mapping.end(), std::back_inserter(constraint_partitions),
 		[&](const std::vector< domain_mapping_t > &part_mapping) -> partition_id_t {
 			return part_mapping[domain_id].first;
 		}
@@ -175,22 +402,100 @@ QueryEngine::QueryPartitionResult SimpleQueryCursor::next_impl() {
 	// Step 1: Compute partition IDs from the domain ID (also determine the domain bounds)
 	domain_t domain;
 	std::vector< partition_id_t > constraint_partitions; // For each constraint's index, which partition_id_t corresponds to the current domain_id_t
-	this->compute_constraint_partitions(domain_id, constraint_partitions, domain);
+	compute_constraint_partitions(this->constraint_domain_mapping, domain_id, constraint_partitions, domain);
 
-	// Step 2: optimized the RegionMath for this particular partition
+	// Step 2: optimized the RegionMath for this particular partition (planning each constraint along the way)
 	RegionMath::RegionMath optimized_multivar_rmath = this->multivar_rmath;
-	this->sqe.optimize_query_region_math(this->constraints, constraint_partitions, optimized_multivar_rmath);
+	std::vector< SimpleQueryEngine::ConstraintPlan > constraint_plans;
+	this->sqe.optimize_query_region_math(this->constraints, constraint_partitions, optimized_multivar_rmath, &constraint_plans);
 
-	// Step 3: evaluate the query RegionMath
+	// Step 3: evaluate the query RegionMath, following the constraint plans
 	result.partition = domain_id;
 	result.partition_domain = domain;
-	result.result = this->sqe.evaluate_query_region_math(this->constraints, constraint_partitions, optimized_multivar_rmath, result.stats);
+	result.result = this->sqe.evaluate_query_region_math(this->constraints, constraint_partitions, optimized_multivar_rmath, result.stats, &constraint_plans);
 	TIME_STATS_TIME_END()
 
 	return result;
 }
 
 
+// Cursor evaluating a batch of queries together, one domain at a time: each distinct constraint across the batch is evaluated
+// once per domain (with region reads shared per variable index), and the results are then combined per query
+class SimpleBatchQueryCursor : public QueryEngine::BatchQueryCursor {
+public:
+	using DFE = SimpleQueryEngine::DeferredConstraintEvaluator;
+	using ConstrTermStats = QueryEngine::ConstraintTermEvalStats;
+	using partition_id_t = IndexIOTypes::partition_id_t;
+	using domain_t = IndexIOTypes::domain_t;
+	using domain_id_t = IndexIOTypes::domain_id_t;
+	using domain_mapping_t = IndexIOTypes::domain_mapping_t;
+
+	virtual ~SimpleBatchQueryCursor() {}
+	SimpleBatchQueryCursor(SimpleQueryEngine &sqe, std::vector< Query > queries, domain_id_t cur_part, domain_id_t end_part);
+
+	// Move-only, no copying
+	SimpleBatchQueryCursor(const SimpleBatchQueryCursor &) = delete;
+	SimpleBatchQueryCursor(SimpleBatchQueryCursor &&) = default;
+
+private:
+	virtual std::vector< QueryEngine::QueryPartitionResult > next_impl();
+
+private:
+	SimpleQueryEngine &sqe;
+	const std::vector< Query > queries; // Retained, since the constraints refer to their terms
+	std::vector< DFE > constraints; // The distinct constraints of all queries
+	std::vector< RegionMath::RegionMath > query_rmaths; // Per query, over the distinct constraint IDs
+
+	std::vector< std::vector< domain_mapping_t > > constraint_domain_mapping; // [constraint_id][sorted_partition_id] -> partition_id
+};
+
+SimpleBatchQueryCursor::SimpleBatchQueryCursor(SimpleQueryEngine &sqe, std::vector< Query > queries, domain_id_t cur_part, domain_id_t end_part) :
+	QueryEngine::BatchQueryCursor(cur_part, end_part),
+	sqe(sqe), queries(std::move(queries))
+{
+	SimpleQueryEngine::ConstraintIDMap constraint_ids;
+	for (const Query &query : this->queries) {
+		RegionMath::RegionMath rmath;
+		this->sqe.append_query_to_region_math(query, this->constraints, rmath, &constraint_ids);
+		this->query_rmaths.push_back(std::move(rmath));
+	}
+
+	this->constraint_domain_mapping = SimpleQueryCursor::compute_partition_mapping(this->sqe, this->constraints);
+
+	// Restrict the end of this cursor's range to the number of partitions that actually exist
+	this->restrict_end_partition(SimpleQueryCursor::get_num_domains(this->constraint_domain_mapping));
+}
+
+std::vector< QueryEngine::QueryPartitionResult > SimpleBatchQueryCursor::next_impl() {
+	const domain_id_t domain_id = this->get_current_domain_id();
+
+	domain_t domain;
+	std::vector< partition_id_t > constraint_partitions;
+	SimpleQueryCursor::compute_constraint_partitions(this->constraint_domain_mapping, domain_id, constraint_partitions, domain);
+
+	// Evaluate each distinct constraint once for the whole batch
+	std::vector< boost::shared_ptr< RegionEncoding > > constraint_results;
+	std::vector< boost::shared_ptr< ConstrTermStats > > constraint_stats;
+	this->sqe.evaluate_constraints_at_partitions(this->constraints, constraint_partitions, constraint_results, constraint_stats);
+
+	// Then combine the constraint results per query
+	std::vector< QueryEngine::QueryPartitionResult > results(this->queries.size());
+	for (size_t q = 0; q < this->queries.size(); ++q) {
+		QueryEngine::QueryPartitionResult &result = results[q];
+
+		TIME_STATS_TIME_BEGIN(result.stats.total)
+		RegionMath::RegionMath optimized_multivar_rmath = this->query_rmaths[q];
+		this->sqe.optimize_query_region_math(this->constraints, constraint_partitions, optimized_multivar_rmath);
+
+		result.partition = domain_id;
+		result.partition_domain = domain;
+		result.result = this->sqe.evaluate_query_region_math(constraint_results, constraint_stats, optimized_multivar_rmath, result.stats);
+		TIME_STATS_TIME_END()
+	}
+
+	return results;
+}
+
 bool SimpleQueryEngine::open_impl(boost::shared_ptr< Database > db) {
 	if (!this->QueryEngine::open_impl(db)) return false;
 	this->iocache = boost::make_shared< IndexIOCache >(db, IndexOpenMode::READ);
@@ -207,30 +512,110 @@ auto SimpleQueryEngine::evaluate_impl(const Query &query, domain_id_t begin_doma
 {
 	assert(this->is_open());
 
-	RegionMath::RegionMath multivar_rmath;
-	std::vector< DeferredConstraintEvaluator > constraints;
+	// Return a cursor, with query processing deferred until it is advanced
+	return boost::make_shared< SimpleQueryCursor >(*this, this->prepare_query(query), begin_domain_id, end_domain_id);
+}
 
-	// Compute the initial inter-variable query RegionMath
-	this->convert_query_to_region_math(query, constraints, multivar_rmath);
+auto SimpleQueryEngine::evaluate_batch_impl(const std::vector< Query > &queries, domain_id_t begin_domain_id, domain_id_t end_domain_id) -> boost::shared_ptr< BatchQueryCursor >
+{
+	assert(this->is_open());
 
-	// Return a cursor, with query processing deferred until it is advanced
-	return boost::make_shared< SimpleQueryCursor >(*this, std::move(constraints), std::move(multivar_rmath), begin_domain_id, end_domain_id);
+	std::vector< Query > prepared_queries;
+	for (const Query &query : queries)
+		prepared_queries.push_back(this->prepare_query(query));
+
+	return boost::make_shared< SimpleBatchQueryCursor >(*this, std::move(prepared_queries), begin_domain_id, end_domain_id);
+}
+
+uint64_t SimpleQueryEngine::count_impl(const Query &query, domain_id_t begin_domain_id, domain_id_t end_domain_id) {
+	assert(this->is_open());
+
+	// Only univariate queries (a single constraint, or a single-variable expression after rewriting) can be answered
+	// from index metadata, as the count of a disjoint set of bin ranges; anything else needs full evaluation
+	const Query prepared_query = this->prepare_query(query);
+	if (prepared_query.size() != 1)
+		return this->QueryEngine::count_impl(query, begin_domain_id, end_domain_id);
+
+	const QueryTerm &term = *prepared_query.front();
+	std::string varname;
+	if (typeid(term) == typeid(ConstraintTerm))
+		varname = dynamic_cast< const ConstraintTerm & >(term).varname;
+	else if (typeid(term) == typeid(VariableExpressionTerm))
+		varname = dynamic_cast< const VariableExpressionTerm & >(term).varname;
+	else
+		return this->QueryEngine::count_impl(query, begin_domain_id, end_domain_id);
+
+	uint64_t count = 0;
+	for (partition_id_t partition : this->get_partitions_in_domain_range(varname, begin_domain_id, end_domain_id)) {
+		uint64_t domain_size;
+		RegionEncoding::Type index_rep;
+		if (const boost::optional< bool > zone_match = this->match_term_zone_map(term, partition, domain_size, index_rep)) {
+			count += (*zone_match ? domain_size : 0);
+			continue;
+		}
+
+		boost::shared_ptr< IndexPartitionIO > partio = this->iocache->open_index_partition_io(varname, partition);
+		for (const bin_id_range_t &bin_range : this->compute_bin_ranges(*partio, term))
+			count += this->count_bin_range_at_partition(*partio, bin_range);
+	}
+	return count;
+}
+
+std::vector< uint64_t > SimpleQueryEngine::histogram_impl(std::string varname, const std::vector< UniversalValue > &bucket_bounds, domain_id_t begin_domain_id, domain_id_t end_domain_id) {
+	assert(this->is_open());
+
+	std::vector< uint64_t > counts(bucket_bounds.size() - 1, 0);
+	for (partition_id_t partition : this->get_partitions_in_domain_range(varname, begin_domain_id, end_domain_id)) {
+		boost::shared_ptr< IndexPartitionIO > partio = this->iocache->open_index_partition_io(varname, partition);
+		boost::shared_ptr< const AbstractBinningSpecification > binning_spec = partio->get_partition_metadata().binning_spec;
+
+		// Each partition may have a different set of bins, so map the bucket bounds to bins separately for each
+		bin_id_t bucket_lb = binning_spec->lower_bound_bin(bucket_bounds[0]);
+		for (size_t i = 0; i < counts.size(); ++i) {
+			const bin_id_t bucket_ub = binning_spec->lower_bound_bin(bucket_bounds[i + 1], bucket_lb);
+			counts[i] += this->count_bin_range_at_partition(*partio, bin_id_range_t(bucket_lb, bucket_ub));
+			bucket_lb = bucket_ub;
+		}
+	}
+	return counts;
+}
+
+Query SimpleQueryEngine::prepare_query(const Query &query) const {
+	return this->options.rewrite_queries ? QueryRewriter::rewrite(query) : query;
 }
 
 void SimpleQueryEngine::convert_query_to_region_math(const Query& query, std::vector< DeferredConstraintEvaluator > &constraints, RegionMath::RegionMath &rmath) const {
 	constraints.clear();
 	rmath.clear();
+	this->append_query_to_region_math(query, constraints, rmath);
+}
 
+void SimpleQueryEngine::append_query_to_region_math(const Query& query, std::vector< DeferredConstraintEvaluator > &constraints, RegionMath::RegionMath &rmath, ConstraintIDMap *constraint_ids) const {
 	for (auto term_it = query.cbegin(); term_it != query.cend(); term_it++) {
 		const QueryTerm &qt = **term_it;
 		const std::type_info &ti = typeid(qt);
 
 		if (ti == typeid(ConstraintTerm)) {
 			const ConstraintTerm &cqt = dynamic_cast<const ConstraintTerm&>(qt);
-			const region_id_t region_id = constraints.size(); // Get the next available region ID
+			region_id_t region_id = constraints.size(); // Get the next available region ID
 
-			constraints.push_back(DeferredConstraintEvaluator(cqt, *this));
+			// Reuse an identical constraint, if one exists and deduplication was requested
+			if (constraint_ids) {
+				auto inserted = constraint_ids->insert(std::make_pair(ConstraintKey(cqt.varname, cqt.lower_bound, cqt.upper_bound), region_id));
+				region_id = inserted.first->second;
+			}
+
+			if (region_id == constraints.size())
+				constraints.push_back(DeferredConstraintEvaluator(cqt, cqt.varname, *this));
 			rmath.push_region(region_id);
+		} else if (ti == typeid(VariableExpressionTerm)) {
+			const VariableExpressionTerm &vet = dynamic_cast<const VariableExpressionTerm&>(qt);
+			rmath.push_region(constraints.size());
+			constraints.push_back(DeferredConstraintEvaluator(vet, vet.varname, *this));
+		} else if (ti == typeid(SpatialConstraintTerm)) {
+			const SpatialConstraintTerm &sct = dynamic_cast<const SpatialConstraintTerm&>(qt);
+			rmath.push_region(constraints.size());
+			constraints.push_back(DeferredConstraintEvaluator(sct, sct.varname, *this));
 		} else if (ti == typeid(UnaryOperatorTerm)) {
 			const UnaryOperatorTerm &uoqt = dynamic_cast<const UnaryOperatorTerm&>(qt);
 			rmath.push_op(uoqt.op);
@@ -245,124 +630,525 @@ boost::shared_ptr< RegionEncoding > SimpleQueryEngine::evaluate_query_region_mat
 		std::vector< DeferredConstraintEvaluator > &constraints,
 		std::vector< partition_id_t > &constraint_partitions,
 		const RegionMath::RegionMath &rmath,
-		QueryStats &qstats) const
+		QueryStats &qstats,
+		const std::vector< ConstraintPlan > *plans) const
 {
-	class EvaluateQueryVisitor : public EvaluateVisitor {
-	private:
-		using ConstrTermStats = QueryEngine::ConstraintTermEvalStats;
-		using MVTermStats = QueryEngine::MultivarTermEvalStats;
-
+	class DeferredEvaluateQueryVisitor : public EvaluateQueryVisitor {
 	public:
-		typedef void result_type;
-		EvaluateQueryVisitor(
+		DeferredEvaluateQueryVisitor(
 				const SimpleQueryEngine &qe, const std::vector< DeferredConstraintEvaluator > &constraints,
-				std::vector< partition_id_t > &constraint_partitions, QueryEngine::QueryStats &qs) :
-			EvaluateVisitor(qe), constraints(constraints), constraint_partitions(constraint_partitions), qs(qs)
+				std::vector< partition_id_t > &constraint_partitions, const RegionMath::RegionMath &rmath, QueryEngine::QueryStats &qs,
+				const std::vector< ConstraintPlan > *plans) :
+			EvaluateQueryVisitor(qe, qs), constraints(constraints), constraint_partitions(constraint_partitions),
+			rmath(rmath), operands(compute_region_math_operands(rmath)), plans(plans)
 		{}
 
-		void operator()(const RegionMath::RegionTerm &op) { this->EvaluateVisitor::operator()(op); }
-		void operator()(const RegionMath::UnaryOperatorTerm &op) {
-			MVTermStats &terminfo = new_multivar_term_stats();
-			terminfo.arity = 1;
-			terminfo.name = std::string("unary:") + (char)('0' + (char)op.op);
-			terminfo.in_regions_bytes = stack.back()->get_size_in_bytes();
-			TIME_STATS_TIME_BEGIN(terminfo.total);
-			this->EvaluateVisitor::operator()(op);
-			TIME_STATS_TIME_END();
-			terminfo.output_region_bytes = stack.back()->get_size_in_bytes();
-			qs.setopstotal += terminfo.total;
-		}
-		void operator()(const RegionMath::NAryOperatorTerm &op) {
-			MVTermStats &terminfo = new_multivar_term_stats();
-			terminfo.arity = op.arity;
-			terminfo.name = std::string("nary:") + (char)('0' + (char)op.op);
-			terminfo.in_regions_bytes = stack.back()->get_size_in_bytes();
-
-			auto first_operand = stack.end() - op.arity, end_operands = stack.end();
-			terminfo.in_regions_bytes = 0;
-			for (auto it = first_operand; it != end_operands; ++it)
-				terminfo.in_regions_bytes += (*it)->get_size_in_bytes();
-
-			TIME_STATS_TIME_BEGIN(terminfo.total);
-			this->EvaluateVisitor::operator()(op);
-			TIME_STATS_TIME_END();
-			terminfo.output_region_bytes = stack.back()->get_size_in_bytes();
-			qs.setopstotal += terminfo.total;
-		}
-
 		virtual boost::shared_ptr< RegionEncoding > obtain_region(region_id_t constraint_id) {
 			ConstrTermStats &terminfo = new_constraint_term_stats();
 			const partition_id_t constraint_part = constraint_partitions[constraint_id];
-			boost::shared_ptr< RegionEncoding > result = constraints[constraint_id](constraint_part, terminfo); // Evaluate the constraint on-the-fly
+			const ConstraintPlan *plan = (plans && constraint_id < plans->size()) ? &(*plans)[constraint_id] : nullptr;
+			boost::shared_ptr< RegionEncoding > result = constraints[constraint_id](constraint_part, terminfo, plan); // Evaluate the constraint on-the-fly
 			qs.iototal += terminfo.binread;
 			qs.decodetotal += terminfo.binmerge;
 			return result;
 		}
 
+		void evaluate() { this->evaluate_subtree(rmath.size() - 1); }
+
 	private:
-		ConstrTermStats & new_constraint_term_stats() {
-			boost::shared_ptr< ConstrTermStats > stats = boost::make_shared< ConstrTermStats >();
-			qs.terminfos.push_back(stats);
-			return *stats;
+		// Whether an operator's result is already determined to be its k-th operand (given that operand's uniformity)
+		static bool is_short_circuited(const RegionMath::TermVariant &term, size_t k, const RegionEncoding &operand) {
+			using RU = RegionEncoding::RegionUniformity;
+			if (term.which() != RegionMath::RegionMath::NARY_OP)
+				return false;
+
+			switch (boost::get< RegionMath::NAryOperatorTerm >(term).op) {
+			case NArySetOperation::INTERSECTION: return operand.get_region_uniformity() == RU::EMPTY;
+			case NArySetOperation::UNION:        return operand.get_region_uniformity() == RU::FILLED;
+			case NArySetOperation::DIFFERENCE:   return k == 0 && operand.get_region_uniformity() == RU::EMPTY;
+			default:                             return false;
+			}
 		}
-		MVTermStats & new_multivar_term_stats() {
-			boost::shared_ptr< MVTermStats > stats = boost::make_shared< MVTermStats >();
-			qs.terminfos.push_back(stats);
-			return *stats;
+
+		void evaluate_subtree(size_t term_id) {
+			const RegionMath::TermVariant &term = rmath[term_id];
+			const std::vector< size_t > &term_operands = operands[term_id];
+
+			for (size_t k = 0; k < term_operands.size(); ++k) {
+				this->evaluate_subtree(term_operands[k]);
+
+				if (k + 1 < term_operands.size() && is_short_circuited(term, k, *stack.back())) {
+					// The result is this operand itself: replace the evaluated operands with it, and skip the rest
+					stack[stack.size() - (k + 1)] = stack.back();
+					stack_mut[stack_mut.size() - (k + 1)] = stack_mut.back();
+					stack.resize(stack.size() - k);
+					stack_mut.resize(stack_mut.size() - k);
+
+					for (size_t j = k + 1; j < term_operands.size(); ++j)
+						qs.constraints_skipped += count_region_math_regions(rmath, operands, term_operands[j]);
+					return;
+				}
+			}
+
+			boost::apply_visitor(*this, term);
 		}
 
 	private:
 		const std::vector< DeferredConstraintEvaluator > &constraints;
 		const std::vector< partition_id_t > &constraint_partitions;
-		QueryEngine::QueryStats &qs;
+		const RegionMath::RegionMath &rmath;
+		const std::vector< std::vector< size_t > > operands;
+		const std::vector< ConstraintPlan > *plans;
 	};
 
-	boost::shared_ptr< RegionEncoding > result;
-
 	// Evaluate (and time) the query as captured in the supplied RegionMath/RegionMap
-	EvaluateQueryVisitor visitor(*this, constraints, constraint_partitions, qstats);
+	DeferredEvaluateQueryVisitor visitor(*this, constraints, constraint_partitions, rmath, qstats, plans);
+	visitor.evaluate();
+
+	assert(visitor.stack.size() == 1);
+	return visitor.stack.back();
+}
+
+boost::shared_ptr< RegionEncoding > SimpleQueryEngine::evaluate_query_region_math(
+		const std::vector< boost::shared_ptr< RegionEncoding > > &constraint_results,
+		const std::vector< boost::shared_ptr< ConstraintTermEvalStats > > &constraint_stats,
+		const RegionMath::RegionMath &rmath,
+		QueryStats &qstats) const
+{
+	class PrecomputedEvaluateQueryVisitor : public EvaluateQueryVisitor {
+	public:
+		PrecomputedEvaluateQueryVisitor(
+				const SimpleQueryEngine &qe,
+				const std::vector< boost::shared_ptr< RegionEncoding > > &constraint_results,
+				const std::vector< boost::shared_ptr< ConstrTermStats > > &constraint_stats,
+				QueryEngine::QueryStats &qs) :
+			EvaluateQueryVisitor(qe, qs), constraint_results(constraint_results), constraint_stats(constraint_stats)
+		{}
+
+		virtual boost::shared_ptr< RegionEncoding > obtain_region(region_id_t constraint_id) {
+			const ConstrTermStats &terminfo = *constraint_stats[constraint_id];
+			qs.terminfos.push_back(constraint_stats[constraint_id]);
+			qs.iototal += terminfo.binread;
+			qs.decodetotal += terminfo.binmerge;
+			return constraint_results[constraint_id]; // Note: pushed as immutable by EvaluateVisitor, so it is never modified
+		}
+
+	private:
+		const std::vector< boost::shared_ptr< RegionEncoding > > &constraint_results;
+		const std::vector< boost::shared_ptr< ConstrTermStats > > &constraint_stats;
+	};
+
+	PrecomputedEvaluateQueryVisitor visitor(*this, constraint_results, constraint_stats, qstats);
 	for (const RegionMath::TermVariant &term : rmath)
 		boost::apply_visitor(visitor, term);
 
 	assert(visitor.stack.size() == 1);
-	result = visitor.stack.back();
+	return visitor.stack.back();
+}
 
-	return result;
+boost::optional< bool > SimpleQueryEngine::match_constraint_zone_map(const ConstraintTerm &cqt, partition_id_t partition, uint64_t &domain_size, RegionEncoding::Type &index_rep) const {
+	const IndexIO::GlobalPartitionMetadata gpmeta = this->iocache->open_index_io(cqt.varname)->get_partition_metadata(partition);
+	if (!gpmeta.zone_map || !gpmeta.index_rep)
+		return boost::none;
+
+	domain_size = gpmeta.domain.second;
+	index_rep = *gpmeta.index_rep;
+
+	// The zone map retains exactly those bins that determine whether compute_bin_range() would
+	// produce an empty or completely covering bin range against the full binning specification
+	const bin_id_range_t zone_bin_range = compute_bin_range_for_binning(*gpmeta.zone_map, cqt);
+	if (zone_bin_range.second == 0)
+		return false;
+	else if (zone_bin_range.first == 0 && zone_bin_range.second == gpmeta.zone_map->get_num_bins())
+		return true;
+	else
+		return boost::none;
 }
 
-boost::shared_ptr< RegionEncoding > SimpleQueryEngine::evaluate_constraint_at_partition(const ConstraintTerm &cqt, partition_id_t partition, ConstraintTermEvalStats &terminfo) const {
+boost::optional< bool > SimpleQueryEngine::match_term_zone_map(const QueryTerm &term, partition_id_t partition, uint64_t &domain_size, RegionEncoding::Type &index_rep) const {
+	if (typeid(term) == typeid(SpatialConstraintTerm)) {
+		const rid_ranges_t rid_ranges = this->compute_spatial_constraint_rid_ranges(dynamic_cast< const SpatialConstraintTerm & >(term), partition, domain_size, index_rep);
+		if (rid_ranges.empty())
+			return false;
+		else if (rid_ranges.size() == 1 && rid_ranges.front().second == domain_size)
+			return true;
+		else
+			return boost::none;
+	}
+
+	// Any determined result implies some constraint was determined, which also output domain_size and index_rep
+	return evaluate_univariate_term< boost::optional< bool > >(
+		term,
+		[&](const ConstraintTerm &cqt) -> boost::optional< bool > {
+			return this->match_constraint_zone_map(cqt, partition, domain_size, index_rep);
+		},
+		[](UnarySetOperation op, const boost::optional< bool > &in_operand) -> boost::optional< bool > {
+			assert(op == UnarySetOperation::COMPLEMENT);
+			return in_operand ? boost::optional< bool >(!*in_operand) : boost::none;
+		},
+		[](NArySetOperation op, const std::vector< boost::optional< bool > > &in_operands) -> boost::optional< bool > {
+			return apply_nary_set_op_membership(op, in_operands);
+		});
+}
+
+uint64_t SimpleQueryEngine::estimate_constraint_cost(const DeferredConstraintEvaluator &constraint, partition_id_t partition, ConstraintPlan &plan) const {
+	plan = ConstraintPlan();
+
+	uint64_t domain_size;
+	RegionEncoding::Type index_rep;
+	if (const boost::optional< bool > zone_match = this->match_term_zone_map(constraint.term, partition, domain_size, index_rep))
+		return *zone_match ? std::numeric_limits< uint64_t >::max() : 0;
+
+	// Spatial constraints read nothing, and cost only as much as building their regions
+	if (typeid(constraint.term) == typeid(SpatialConstraintTerm))
+		return this->compute_spatial_constraint_rid_ranges(dynamic_cast< const SpatialConstraintTerm & >(constraint.term), partition, domain_size, index_rep).size() * sizeof(uint64_t);
+
+	plan.partio = this->iocache->open_index_partition_io(constraint.varname, partition);
+	plan.bin_ranges = this->compute_bin_ranges(*plan.partio, constraint.term);
+	set_terminfo_bin_range(plan.terminfo, plan.bin_ranges);
+	if (plan.bin_ranges.empty())
+		return 0;
+	else if (plan.bin_ranges.size() == 1 && plan.bin_ranges.front().first == 0 && plan.bin_ranges.front().second == plan.partio->get_num_bins())
+		return std::numeric_limits< uint64_t >::max();
+
+	plan.rmath = this->compute_optimal_region_math_for_bin_ranges(*plan.partio, plan.bin_ranges, plan.terminfo);
+	return this->compute_constraint_evaluation_cost(*plan.partio, plan.rmath);
+}
+
+auto SimpleQueryEngine::compute_spatial_constraint_rid_ranges(const SpatialConstraintTerm &sct, partition_id_t partition, uint64_t &domain_size, RegionEncoding::Type &index_rep) const -> rid_ranges_t {
+	boost::shared_ptr< IndexPartitionIO > partio = this->iocache->open_index_partition_io(sct.varname, partition);
+	const IndexPartitionIO::PartitionMetadata pmeta = partio->get_partition_metadata();
+	const uint64_t domain_offset = pmeta.domain->first;
+	domain_size = pmeta.domain->second;
+	index_rep = *pmeta.index_rep;
+
+	const Grid grid = this->database->get_variable(sct.varname)->get_grid();
+	const int ndim = grid.size();
+	assert(ndim == (int)sct.subvolume_offsets.size() && ndim == (int)sct.subvolume_dims.size());
+
+	rid_ranges_t rid_ranges;
+	if (pmeta.grid) {
+		// The partition indexes a box of the grid, whose origin is at its (row-major) domain offset, in its own linearization:
+		// clip the subvolume to the box, and linearize it within the box
+		const Grid &part_grid = *pmeta.grid;
+		assert((int)part_grid.size() == ndim);
+
+		std::vector< uint64_t > local_offsets(ndim), local_dims(ndim);
+		uint64_t offset_rem = domain_offset;
+		for (int d = ndim - 1; d >= 0; --d) {
+			const uint64_t origin = offset_rem % grid[d];
+			offset_rem /= grid[d];
+
+			const uint64_t begin = std::max(sct.subvolume_offsets[d], origin);
+			const uint64_t end = std::min(sct.subvolume_offsets[d] + sct.subvolume_dims[d], origin + part_grid[d]);
+			if (begin >= end)
+				return rid_ranges; // No overlap with the partition
+
+			local_offsets[d] = begin - origin;
+			local_dims[d] = end - begin;
+		}
+
+		rid_ranges = GridSubset(part_grid, std::move(local_offsets), std::move(local_dims)).compute_linearized_ranges(part_grid.get_linearization());
+	} else {
+		// Only linearize the subvolume's rows (along the first dimension) that the partition's domain spans, rather than the
+		// whole subvolume for every partition
+		const uint64_t row_size = std::accumulate(grid.begin() + 1, grid.end(), (uint64_t)1, std::multiplies< uint64_t >());
+		const uint64_t begin_row = std::max(sct.subvolume_offsets[0], domain_offset / row_size);
+		const uint64_t end_row = std::min(sct.subvolume_offsets[0] + sct.subvolume_dims[0], (domain_offset + domain_size - 1) / row_size + 1);
+		if (domain_size == 0 || begin_row >= end_row)
+			return rid_ranges; // No overlap with the partition
+
+		std::vector< uint64_t > row_offsets = sct.subvolume_offsets, row_dims = sct.subvolume_dims;
+		row_offsets[0] = begin_row;
+		row_dims[0] = end_row - begin_row;
+
+		// Then clip the global (row-major) ranges of those rows to the partition's domain
+		for (const rid_ranges_t::value_type &range : GridSubset(grid, std::move(row_offsets), std::move(row_dims)).compute_linearized_ranges(Grid::Linearization::ROW_MAJOR_ORDER)) {
+			const uint64_t begin = std::max(range.first, domain_offset);
+			const uint64_t end = std::min(range.first + range.second, domain_offset + domain_size);
+			if (begin < end)
+				rid_ranges.push_back(std::make_pair(begin - domain_offset, end - begin));
+		}
+	}
+	return rid_ranges;
+}
+
+boost::shared_ptr< RegionEncoding > SimpleQueryEngine::evaluate_spatial_constraint_at_partition(const SpatialConstraintTerm &sct, partition_id_t partition, ConstraintTermEvalStats &terminfo) const {
+	TIME_STATS_TIME_BEGIN(terminfo.total)
+	terminfo.name = sct.varname;
+
+	uint64_t domain_size;
+	RegionEncoding::Type index_rep;
+	const rid_ranges_t rid_ranges = this->compute_spatial_constraint_rid_ranges(sct, partition, domain_size, index_rep);
+
+	if (rid_ranges.empty() || (rid_ranges.size() == 1 && rid_ranges.front().second == domain_size))
+		return RegionEncoding::make_uniform_region(index_rep, domain_size, !rid_ranges.empty());
+
+	TIME_STATS_TIME_BEGIN(terminfo.binmerge)
+	return RegionEncoding::make_region_from_rid_ranges(index_rep, domain_size, rid_ranges);
+	TIME_STATS_TIME_END()
+	TIME_STATS_TIME_END()
+}
+
+boost::shared_ptr< RegionEncoding > SimpleQueryEngine::evaluate_constraint_at_partition(const QueryTerm &term, const std::string &varname, partition_id_t partition, ConstraintTermEvalStats &terminfo, const ConstraintPlan *plan) const {
+	if (typeid(term) == typeid(SpatialConstraintTerm))
+		return this->evaluate_spatial_constraint_at_partition(dynamic_cast< const SpatialConstraintTerm & >(term), partition, terminfo);
+
+	// With a plan, the zone map is already known not to decide the constraint, and its partition, bin ranges and RegionMath are at hand
+	if (plan && plan->partio) {
+		terminfo = plan->terminfo;
+		TIME_STATS_TIME_BEGIN(terminfo.total)
+		terminfo.name = varname;
+		if (boost::shared_ptr< RegionEncoding > uniform_result = this->make_uniform_result_for_bin_ranges(*plan->partio, plan->bin_ranges))
+			return uniform_result;
+		return this->evaluate_region_math_at_partition(*plan->partio, plan->rmath, terminfo);
+		TIME_STATS_TIME_END()
+	}
+
 	TIME_STATS_TIME_BEGIN(terminfo.total)
-	terminfo.name = cqt.varname;
+	terminfo.name = varname;
+
+	// If the partition zone map decides the constraint, produce a uniform result without opening the partition
+	uint64_t domain_size;
+	RegionEncoding::Type index_rep;
+	if (const boost::optional< bool > zone_match = this->match_term_zone_map(term, partition, domain_size, index_rep)) {
+		terminfo.zone_map_pruned = true;
+		return RegionEncoding::make_uniform_region(index_rep, domain_size, *zone_match);
+	}
 
-	boost::shared_ptr< IndexPartitionIO > partio = this->iocache->open_index_partition_io(cqt.varname, partition);
+	boost::shared_ptr< IndexPartitionIO > partio = this->iocache->open_index_partition_io(varname, partition);
 	assert(partio);
 
-	const bin_id_range_t bin_range = this->compute_bin_range(*partio, cqt);
-	terminfo.lb_bin = bin_range.first;
-	terminfo.ub_bin = bin_range.second;
+	const bin_id_ranges_t bin_ranges = this->compute_bin_ranges(*partio, term);
+	set_terminfo_bin_range(terminfo, bin_ranges);
 
-	IndexPartitionIO::PartitionMetadata pmeta = partio->get_partition_metadata();
+	return this->evaluate_bin_ranges_at_partition(*partio, bin_ranges, terminfo);
+	TIME_STATS_TIME_END()
+}
 
-	// If the bin range is empty or completely covering, return an empty/full region immediately
-	if (bin_range.first >= bin_range.second)
-		return RegionEncoding::make_uniform_region(*pmeta.index_rep, pmeta.domain->second, false);
-	else if (bin_range.first == 0 && bin_range.second == partio->get_num_bins())
-		return RegionEncoding::make_uniform_region(*pmeta.index_rep, pmeta.domain->second, true);
+void SimpleQueryEngine::evaluate_constraints_at_partitions(
+		const std::vector< DeferredConstraintEvaluator > &constraints,
+		const std::vector< partition_id_t > &constraint_partitions,
+		std::vector< boost::shared_ptr< RegionEncoding > > &results,
+		std::vector< boost::shared_ptr< ConstraintTermEvalStats > > &stats) const
+{
+	using index_key_t = std::pair< std::string, partition_id_t >;
+	using bin_ranges_key_t = std::pair< index_key_t, bin_id_ranges_t >;
+	struct PendingConstraint {
+		size_t constraint_id;
+		RegionMath::RegionMath rmath;
+	};
+
+	results.assign(constraints.size(), nullptr);
+	stats.clear();
+
+	// Univariate terms with the same normalized bin ranges on the same index have the same result, even if they differ
+	// syntactically (e.g., rewritten variable expressions), so only the first is evaluated, and the rest share its result and stats
+	std::map< bin_ranges_key_t, size_t > constraint_by_bin_ranges;
+	std::vector< std::pair< size_t, size_t > > duplicate_constraints; // (constraint ID, ID of the identical constraint evaluated instead)
+
+	// Step 1: resolve each constraint without reading regions if possible (via zone map or uniform bin range),
+	// otherwise plan its RegionMath and group it with other constraints on the same index
+	std::map< index_key_t, std::vector< PendingConstraint > > pending_by_index;
+	for (size_t i = 0; i < constraints.size(); ++i) {
+		const QueryTerm &term = constraints[i].term;
+		const std::string &varname = constraints[i].varname;
+		const partition_id_t partition = constraint_partitions[i];
+
+		stats.push_back(boost::make_shared< ConstraintTermEvalStats >());
+		ConstraintTermEvalStats &terminfo = *stats.back();
+
+		if (typeid(term) == typeid(SpatialConstraintTerm)) {
+			results[i] = this->evaluate_spatial_constraint_at_partition(dynamic_cast< const SpatialConstraintTerm & >(term), partition, terminfo);
+			continue;
+		}
+
+		TIME_STATS_TIME_BEGIN(terminfo.total)
+		terminfo.name = varname;
+
+		uint64_t domain_size;
+		RegionEncoding::Type index_rep;
+		if (const boost::optional< bool > zone_match = this->match_term_zone_map(term, partition, domain_size, index_rep)) {
+			terminfo.zone_map_pruned = true;
+			results[i] = RegionEncoding::make_uniform_region(index_rep, domain_size, *zone_match);
+			continue;
+		}
+
+		boost::shared_ptr< IndexPartitionIO > partio = this->iocache->open_index_partition_io(varname, partition);
+		assert(partio);
+
+		const bin_id_ranges_t bin_ranges = this->compute_bin_ranges(*partio, term);
+		set_terminfo_bin_range(terminfo, bin_ranges);
+
+		auto inserted = constraint_by_bin_ranges.insert(std::make_pair(bin_ranges_key_t(index_key_t(varname, partition), bin_ranges), i));
+		if (!inserted.second) {
+			duplicate_constraints.push_back(std::make_pair(i, inserted.first->second));
+			continue;
+		}
+
+		if ((results[i] = this->make_uniform_result_for_bin_ranges(*partio, bin_ranges)))
+			continue;
+
+		pending_by_index[index_key_t(varname, partition)].push_back(
+				PendingConstraint { i, this->compute_optimal_region_math_for_bin_ranges(*partio, bin_ranges, terminfo) });
+		TIME_STATS_TIME_END()
+	}
+
+	// Step 2: per index, read the union of all regions needed by its constraints once, then evaluate each constraint from them
+	for (auto &index_entry : pending_by_index) {
+		std::vector< PendingConstraint > &pending = index_entry.second;
+		boost::shared_ptr< IndexPartitionIO > partio = this->iocache->open_index_partition_io(index_entry.first.first, index_entry.first.second);
+
+		std::set< region_id_t > regions_to_read;
+		for (const PendingConstraint &pc : pending) {
+			const std::set< region_id_t > pc_regions = pc.rmath.get_all_regions();
+			regions_to_read.insert(pc_regions.begin(), pc_regions.end());
+		}
+
+		ConstraintTermEvalStats &first_terminfo = *stats[pending.front().constraint_id];
+		RegionMap regions;
+		{
+			TIME_STATS_TIME_BEGIN(first_terminfo.total)
+			partio->reset_io_stats();
+			assert(partio->read_regions(regions_to_read, regions));
+			first_terminfo.binread = partio->get_io_stats();
+			TIME_STATS_TIME_END()
+		}
+
+		for (const PendingConstraint &pc : pending) {
+			ConstraintTermEvalStats &terminfo = *stats[pc.constraint_id];
+			TIME_STATS_TIME_BEGIN(terminfo.total)
+			results[pc.constraint_id] = this->evaluate_constraint_region_math(regions, pc.rmath, terminfo);
+			TIME_STATS_TIME_END()
+		}
+	}
+
+	for (const std::pair< size_t, size_t > &duplicate : duplicate_constraints) {
+		results[duplicate.first] = results[duplicate.second];
+		stats[duplicate.first] = stats[duplicate.second];
+	}
+}
+
+boost::shared_ptr< RegionEncoding > SimpleQueryEngine::make_uniform_result_for_bin_ranges(IndexPartitionIO &partio, const bin_id_ranges_t &bin_ranges) const {
+	// Bin ranges are disjoint and non-empty, so completely covering means exactly one range over all bins
+	const bool is_empty = bin_ranges.empty();
+	const bool is_full = (bin_ranges.size() == 1 && bin_ranges.front().first == 0 && bin_ranges.front().second == partio.get_num_bins());
+	if (is_empty || is_full) {
+		const IndexPartitionIO::PartitionMetadata pmeta = partio.get_partition_metadata();
+		return RegionEncoding::make_uniform_region(*pmeta.index_rep, pmeta.domain->second, is_full);
+	} else {
+		return nullptr;
+	}
+}
+
+boost::shared_ptr< RegionEncoding > SimpleQueryEngine::evaluate_bin_ranges_at_partition(IndexPartitionIO &partio, const bin_id_ranges_t &bin_ranges, ConstraintTermEvalStats &terminfo) const {
+	// If the bin ranges are empty or completely covering, return an empty/full region immediately
+	if (boost::shared_ptr< RegionEncoding > uniform_result = this->make_uniform_result_for_bin_ranges(partio, bin_ranges))
+		return uniform_result;
 
 	// Invoke the index decoder to determine the best region math to solve this query
-	RegionMath::RegionMath rmath = this->compute_optimal_region_math_for_bin_range(*partio, bin_range, terminfo);
+	const RegionMath::RegionMath rmath = this->compute_optimal_region_math_for_bin_ranges(partio, bin_ranges, terminfo);
+	return this->evaluate_region_math_at_partition(partio, rmath, terminfo);
+}
 
+boost::shared_ptr< RegionEncoding > SimpleQueryEngine::evaluate_region_math_at_partition(IndexPartitionIO &partio, const RegionMath::RegionMath &rmath, ConstraintTermEvalStats &terminfo) const {
 	// Read the regions specified
 	const std::set< region_id_t > regions_to_read = rmath.get_all_regions();
 	std::map< region_id_t, boost::shared_ptr< RegionEncoding > > regions;
 
-	partio->reset_io_stats();
-	assert(partio->read_regions(regions_to_read, regions));
-	terminfo.binread = partio->get_io_stats();
+	partio.reset_io_stats();
+	assert(partio.read_regions(regions_to_read, regions));
+	terminfo.binread = partio.get_io_stats();
 
 	// Evaluate the specified region math on the regions just read
 	return this->evaluate_constraint_region_math(regions, rmath, terminfo);
-	TIME_STATS_TIME_END()
+}
+
+uint64_t SimpleQueryEngine::count_bin_range_at_partition(IndexPartitionIO &partio, bin_id_range_t bin_range) const {
+	IndexPartitionIO::PartitionMetadata pmeta = partio.get_partition_metadata();
+
+	// Empty and completely covering bin ranges need no regions at all
+	if (bin_range.first >= bin_range.second)
+		return 0;
+	else if (bin_range.first == 0 && bin_range.second == partio.get_num_bins())
+		return pmeta.domain->second;
+
+	// With equality encoding, regions are exactly the bins (as are the leading regions with multi-resolution encoding),
+	// so the per-region element counts give the answer directly
+	if (pmeta.index_enc->get_type() == IndexEncoding::Type::EQUALITY || pmeta.index_enc->get_type() == IndexEncoding::Type::MULTI_RESOLUTION)
+		return partio.compute_regions_element_count((region_id_t)bin_range.first, (region_id_t)bin_range.second);
+
+	// Otherwise, evaluate the bin range and count the result
+	ConstraintTermEvalStats terminfo;
+	return this->evaluate_bin_ranges_at_partition(partio, bin_id_ranges_t(1, bin_range), terminfo)->get_element_count();
+}
+
+auto SimpleQueryEngine::get_partitions_in_domain_range(std::string varname, domain_id_t begin_domain_id, domain_id_t end_domain_id) const -> std::vector< partition_id_t > {
+	boost::shared_ptr< IndexIO > iio = this->iocache->open_index_io(varname);
+	const std::vector< IndexIOTypes::domain_mapping_t > domain_mappings = iio->get_sorted_partition_domain_mappings();
+
+	std::vector< partition_id_t > partitions;
+	for (domain_id_t domain_id = begin_domain_id; domain_id < end_domain_id && domain_id < domain_mappings.size(); ++domain_id)
+		partitions.push_back(domain_mappings[domain_id].first);
+	return partitions;
+}
+
+// Default query plan optimization: reorders the operands of each intersection by ascending estimated cost (so that a cheap
+// operand, particularly one known to be empty, may short-circuit the rest), and of each union by descending estimated cost
+// (so that an operand known to be full comes first). An intersection costs as much as its cheapest operand (which may
+// short-circuit it), and other operators as much as their most expensive operand.
+void SimpleQueryEngine::optimize_query_region_math(const std::vector< DeferredConstraintEvaluator > &constraints, const std::vector< partition_id_t > &constraint_partitions, RegionMath::RegionMath &rmath, std::vector< ConstraintPlan > *plans) const {
+	if (plans) {
+		plans->clear();
+		plans->resize(constraints.size());
+	}
+	if (constraints.size() < 2)
+		return; // Nothing to reorder
+
+	static constexpr uint64_t MAX_COST = std::numeric_limits< uint64_t >::max();
+	const std::vector< std::vector< size_t > > operands = compute_region_math_operands(rmath);
+
+	// Operands precede their operators, so subtree costs can be computed in a single forward pass
+	std::vector< uint64_t > costs(rmath.size(), 0);
+	for (size_t i = 0; i < rmath.size(); ++i) {
+		if (rmath[i].which() == RegionMath::RegionMath::REGION) {
+			const region_id_t constraint_id = boost::get< RegionMath::RegionTerm >(rmath[i]).rid;
+			ConstraintPlan plan;
+			costs[i] = this->estimate_constraint_cost(constraints[constraint_id], constraint_partitions[constraint_id], plan);
+			if (plans)
+				(*plans)[constraint_id] = std::move(plan);
+		} else if (rmath[i].which() == RegionMath::RegionMath::UNARY_OP) {
+			const uint64_t operand_cost = costs[operands[i][0]];
+			costs[i] = (operand_cost == 0) ? MAX_COST : (operand_cost == MAX_COST) ? 0 : operand_cost; // Complement swaps known empty/full
+		} else if (boost::get< RegionMath::NAryOperatorTerm >(rmath[i]).op == NArySetOperation::INTERSECTION) {
+			costs[i] = MAX_COST;
+			for (size_t operand : operands[i])
+				costs[i] = std::min(costs[i], costs[operand]);
+		} else {
+			for (size_t operand : operands[i])
+				costs[i] = std::max(costs[i], costs[operand]);
+		}
+	}
+
+	std::function< void(size_t, RegionMath::RegionMath &) > emit_subtree = [&](size_t term_id, RegionMath::RegionMath &out) {
+		std::vector< size_t > term_operands = operands[term_id];
+		if (rmath[term_id].which() == RegionMath::RegionMath::NARY_OP) {
+			const NArySetOperation op = boost::get< RegionMath::NAryOperatorTerm >(rmath[term_id]).op;
+			auto by_cost = [&](size_t a, size_t b)->bool { return costs[a] < costs[b]; };
+			if (op == NArySetOperation::INTERSECTION)
+				std::stable_sort(term_operands.begin(), term_operands.end(), by_cost);
+			else if (op == NArySetOperation::UNION)
+				std::stable_sort(term_operands.rbegin(), term_operands.rend(), by_cost);
+		}
+
+		for (size_t operand : term_operands)
+			emit_subtree(operand, out);
+		out.push_back(rmath[term_id]);
+	};
+
+	RegionMath::RegionMath reordered_rmath;
+	emit_subtree(rmath.size() - 1, reordered_rmath);
+	rmath = std::move(reordered_rmath);
 }
 
 // Visitors for traversing a RegionMath, computing its result using virtual
@@ -403,18 +1189,43 @@ boost::shared_ptr< RegionEncoding > SimpleQueryEngine::evaluate_constraint_regio
 
 // Computes the range of bins touched by a given univariate constraint
 auto SimpleQueryEngine::compute_bin_range(IndexPartitionIO& partio, const ConstraintTerm& constraint) const -> bin_id_range_t {
-	bin_id_range_t bin_range;
+	return compute_bin_range_for_binning(*partio.get_partition_metadata().binning_spec, constraint);
+}
 
-	boost::shared_ptr< const AbstractBinningSpecification > binning_spec = partio.get_partition_metadata().binning_spec;
+auto SimpleQueryEngine::compute_bin_range_for_binning(const AbstractBinningSpecification &binning_spec, const ConstraintTerm& constraint) -> bin_id_range_t {
+	bin_id_range_t bin_range;
 
-	bin_range.first = binning_spec->upper_bound_bin(constraint.lower_bound);
+	bin_range.first = binning_spec.upper_bound_bin(constraint.lower_bound);
 	if (bin_range.first > 0) --bin_range.first; // We received the first bin after the given value. We need to rewind one bin, which will either be an equal bin or the first lesser bin
 
-	bin_range.second = binning_spec->upper_bound_bin(constraint.upper_bound, bin_range.first); // We receive the first bin that is greater than the given value, which is the first bin we don't need, so use that bin as the upper bound
+	bin_range.second = binning_spec.upper_bound_bin(constraint.upper_bound, bin_range.first); // We receive the first bin that is greater than the given value, which is the first bin we don't need, so use that bin as the upper bound
 
 	return bin_range;
 }
 
+auto SimpleQueryEngine::compute_bin_ranges(IndexPartitionIO& partio, const QueryTerm &term) const -> bin_id_ranges_t {
+	return compute_bin_ranges_for_binning(*partio.get_partition_metadata().binning_spec, term);
+}
+
+auto SimpleQueryEngine::compute_bin_ranges_for_binning(const AbstractBinningSpecification &binning_spec, const QueryTerm &term) -> bin_id_ranges_t {
+	const bin_id_t nbins = binning_spec.get_num_bins();
+
+	// Set operations on constraints become set operations on their bin ranges, since bins partition the domain
+	return evaluate_univariate_term< bin_id_ranges_t >(
+		term,
+		[&](const ConstraintTerm &cqt) -> bin_id_ranges_t {
+			const bin_id_range_t bin_range = compute_bin_range_for_binning(binning_spec, cqt);
+			return (bin_range.first < bin_range.second) ? bin_id_ranges_t(1, bin_range) : bin_id_ranges_t();
+		},
+		[&](UnarySetOperation op, const bin_id_ranges_t &operand) -> bin_id_ranges_t {
+			assert(op == UnarySetOperation::COMPLEMENT);
+			return combine_bin_ranges(std::vector< bin_id_ranges_t >(1, operand), nbins, [](const std::vector< char > &in_operands)->bool { return !in_operands[0]; });
+		},
+		[&](NArySetOperation op, const std::vector< bin_id_ranges_t > &operands) -> bin_id_ranges_t {
+			return combine_bin_ranges(operands, nbins, [op](const std::vector< char > &in_operands)->bool { return apply_nary_set_op_membership(op, in_operands); });
+		});
+}
+
 // Default implementation of cost computation: sum of region sizes plus a fixed cost per seek (calibrated with each other using arbitrary multiplier constants)
 uint64_t SimpleQueryEngine::compute_constraint_evaluation_cost(IndexPartitionIO &partio, const RegionMath::RegionMath &rmath) const {
 	// Static, arbitrary cost calibration
@@ -460,9 +1271,9 @@ RegionMath::RegionMath SimpleQueryEngine::compute_optimal_region_math_for_bin_ra
 
 	const IndexPartitionIO::PartitionMetadata pmeta = partio.get_partition_metadata();
 
-	// Get an IndexEncoding object to direct the decoding process
-	IndexEncoding::Type enc_type = pmeta.index_enc->get_type();
-	boost::shared_ptr< IndexEncoding > enc = IndexEncoding::get_instance(enc_type);
+	// Use the partition's own IndexEncoding object (which may carry parameters) to direct the decoding process
+	boost::shared_ptr< const IndexEncoding > enc = pmeta.index_enc;
+	auto region_size = [&partio](region_id_t region) -> uint64_t { return partio.compute_regions_size(region, region + 1); };
 
 	// Define a lambda function to help us compute the RegionMath,
 	// and its associated cost, with and without complement preferred
@@ -472,7 +1283,7 @@ RegionMath::RegionMath SimpleQueryEngine::compute_optimal_region_math_for_bin_ra
 	};
 	auto compute_region_math = [&](bool prefer_compl) -> MeasuredRegionMath {
 		MeasuredRegionMath mrmath;
-		mrmath.rmath = enc->get_region_math(pmeta.binning_spec->get_num_bins(), bin_range.first, bin_range.second, prefer_compl);
+		mrmath.rmath = enc->get_region_math(pmeta.binning_spec->get_num_bins(), bin_range.first, bin_range.second, prefer_compl, region_size);
 		mrmath.regioncount = mrmath.rmath.get_all_regions().size();
 		mrmath.cost = this->compute_constraint_evaluation_cost(partio, mrmath.rmath);
 		return mrmath;
@@ -496,7 +1307,7 @@ RegionMath::RegionMath SimpleQueryEngine::compute_optimal_region_math_for_bin_ra
 		terminfo.used_binbytes = complement.cost;
 		terminfo.used_bincount = complement.regioncount;
 		terminfo.other_binbytes = normal.cost;
-		terminfo.other_binbytes = normal.regioncount;
+		terminfo.other_bincount = normal.regioncount;
 	} else {
 		terminfo.used_binbytes = normal.cost;
 		terminfo.used_bincount = normal.regioncount;
@@ -507,3 +1318,30 @@ RegionMath::RegionMath SimpleQueryEngine::compute_optimal_region_math_for_bin_ra
 	// Return the RegionMath
 	return (use_complement) ? complement.rmath : normal.rmath;
 }
+
+// Plans each bin range separately (each with its own complement decision), then unions the results
+RegionMath::RegionMath SimpleQueryEngine::compute_optimal_region_math_for_bin_ranges(IndexPartitionIO &partio, const bin_id_ranges_t &bin_ranges, ConstraintTermEvalStats &terminfo) const {
+	assert(!bin_ranges.empty());
+	if (bin_ranges.size() == 1)
+		return this->compute_optimal_region_math_for_bin_range(partio, bin_ranges.front(), terminfo);
+
+	RegionMath::RegionMath rmath;
+	terminfo.used_complement_binmerge = false;
+	terminfo.used_bincount = terminfo.used_binbytes = terminfo.other_bincount = terminfo.other_binbytes = 0;
+	for (const bin_id_range_t &bin_range : bin_ranges) {
+		ConstraintTermEvalStats range_terminfo;
+		const RegionMath::RegionMath range_rmath = this->compute_optimal_region_math_for_bin_range(partio, bin_range, range_terminfo);
+		for (const RegionMath::TermVariant &term : range_rmath)
+			rmath.push_back(term);
+
+		terminfo.forced_complement_binmerge_mode = range_terminfo.forced_complement_binmerge_mode;
+		terminfo.used_complement_binmerge |= range_terminfo.used_complement_binmerge;
+		terminfo.used_bincount += range_terminfo.used_bincount;
+		terminfo.used_binbytes += range_terminfo.used_binbytes;
+		terminfo.other_bincount += range_terminfo.other_bincount;
+		terminfo.other_binbytes += range_terminfo.other_binbytes;
+	}
+	rmath.push_op(NArySetOperation::UNION, bin_ranges.size());
+
+	return rmath;
+}
@@ -30,6 +30,53 @@
 
 #include "pique/region/bitmap/bitmap.hpp"
 
+// Streams RIDs by scanning bitmap words, skipping empty words wholesale
+class BitmapRIDBatchIterator : public RIDBatchIterator {
+public:
+	using block_t = BitmapRegionEncoding::block_t;
+	static constexpr int BITS_PER_BLOCK = BitmapRegionEncoding::BITS_PER_BLOCK;
+
+	BitmapRIDBatchIterator(const std::vector< block_t > &bits, uint64_t domain_size, uint64_t offset) :
+		bits(bits), domain_size(domain_size), offset(offset),
+		next_block_idx(0), cur_block(0), cur_bitpos(0)
+	{}
+
+private:
+	virtual void next_batch_impl(std::vector<uint64_t> &out, size_t max_rids) {
+		while (max_rids > 0) {
+			// Advance to the next block with any remaining set bits
+			while (cur_block == 0) {
+				if (next_block_idx >= bits.size())
+					return;
+
+				cur_bitpos = next_block_idx * BITS_PER_BLOCK;
+				cur_block = bits[next_block_idx++];
+
+				// Mask off any bits beyond the end of the domain in the last block
+				if (cur_bitpos + BITS_PER_BLOCK > domain_size)
+					cur_block &= (domain_size > cur_bitpos) ? (((block_t)1 << (domain_size - cur_bitpos)) - 1) : 0;
+			}
+
+			// Emit set bits until the block is exhausted (stopping after its highest set bit) or the batch is full
+			for (; cur_block != 0 && max_rids > 0; cur_block >>= 1, ++cur_bitpos) {
+				if (cur_block & 1) {
+					out.push_back(cur_bitpos + offset);
+					--max_rids;
+				}
+			}
+		}
+	}
+
+private:
+	const std::vector< block_t > &bits;
+	const uint64_t domain_size;
+	const uint64_t offset;
+
+	size_t next_block_idx;
+	block_t cur_block; // Remaining (unemitted) bits of the current block, shifted so bit 0 is at cur_bitpos
+	uint64_t cur_bitpos;
+};
+
 constexpr RegionEncoding::Type BitmapRegionEncoding::TYPE;
 
 static inline int popcount_fbsd2(const uint32_t *buf, int n) {
@@ -120,6 +167,25 @@ void BitmapRegionEncoding::dump() const {
 	std::cout << std::endl;
 }
 
+auto BitmapRegionEncoding::get_region_uniformity() const -> RegionUniformity {
+	const uint64_t full_word_count = this->domain_size / BitmapRegionEncoding::BITS_PER_BLOCK;
+	const int remaining_bits = this->domain_size - full_word_count * BitmapRegionEncoding::BITS_PER_BLOCK;
+
+	bool any_set = false, any_unset = false;
+	for (uint64_t i = 0; i < full_word_count && !(any_set && any_unset); ++i) {
+		any_set |= (this->bits[i] != 0);
+		any_unset |= (this->bits[i] != ~(block_t)0);
+	}
+
+	if (remaining_bits) {
+		const block_t mask = (1ULL << remaining_bits) - 1;
+		any_set |= ((this->bits[full_word_count] & mask) != 0);
+		any_unset |= ((this->bits[full_word_count] & mask) != mask);
+	}
+
+	return (any_set && any_unset) ? RegionUniformity::MIXED : any_set ? RegionUniformity::FILLED : RegionUniformity::EMPTY;
+}
+
 uint64_t BitmapRegionEncoding::get_element_count() const {
 	const uint64_t full_word_count = this->domain_size / BitmapRegionEncoding::BITS_PER_BLOCK;
 	const int remaining_bits = this->domain_size - full_word_count * BitmapRegionEncoding::BITS_PER_BLOCK;
@@ -154,6 +220,10 @@ void BitmapRegionEncoding::convert_to_rids(std::vector<uint32_t>& out, bool sort
 	}
 }
 
+boost::shared_ptr< RIDBatchIterator > BitmapRegionEncoding::make_rid_iterator(uint64_t offset) const {
+	return boost::make_shared< BitmapRIDBatchIterator >(this->bits, this->domain_size, offset);
+}
+
 void BitmapRegionEncoding::to_bitset(boost::dynamic_bitset<block_t> &out) {
 	out.clear();
 	out.append(bits.begin(), bits.end());
@@ -54,6 +54,9 @@ inline void CBLQRegionEncoder<ndim>::push_bits_impl(uint64_t count, bool bitval)
     const cblq_word_t mixed_code = 0b10;
     const cblq_word_t set_code = bitval ? 0b01 : 0b00;
     const cblq_word_t set_mask = bitval ? CBLQOut::ONE_CODES_WORD : CBLQOut::ZERO_CODES_WORD;
+    // Mask for the codes of a word; shifted fill codes overflowing the word are truncated by the word type itself
+    // for 2D+, but a 1D word only occupies the low nibble of its byte, so they must be trimmed explicitly
+    const cblq_word_t word_mask = CBLQOut::ONE_CODES_WORD | CBLQOut::TWO_CODES_WORD;
 
     dbprintf("\nPushing %llu %d-bits...\n", count, bitval ? 1 : 0);
 
@@ -77,12 +80,12 @@ inline void CBLQRegionEncoder<ndim>::push_bits_impl(uint64_t count, bool bitval)
             // which results in an undefined shift operation
             if (cur_word_len < CBLQOut::CODES_PER_WORD) {
             	// Append all set codes to the end of the word (will be trimmed later, if needed)
-            	cur_word |= set_mask << (cur_word_len * CBLQOut::BITS_PER_CODE); // Fill the remainder of the word with the set bit value
+            	cur_word |= (set_mask << (cur_word_len * CBLQOut::BITS_PER_CODE)) & word_mask; // Fill the remainder of the word with the set bit value
             }
         } else {
         	// BUGFIX: part of the above fix
         	// Append all set codes to the end of the word (will be trimmed later, if needed)
-        	cur_word |= set_mask << (cur_word_len * CBLQOut::BITS_PER_CODE); // Fill the remainder of the word with the set bit value
+        	cur_word |= (set_mask << (cur_word_len * CBLQOut::BITS_PER_CODE)) & word_mask; // Fill the remainder of the word with the set bit value
         }
 
         cur_word_len += count;
@@ -178,7 +181,16 @@ inline boost::shared_ptr< CBLQRegionEncoding<ndim> > CBLQRegionEncoder<ndim>::to
     return cblq;
 }
 
-// Explicit instantiation for 2D-4D CBLQ region encoders
+template<int ndim>
+size_t CBLQRegionEncoder<ndim>::get_state_size_in_bytes() const {
+	size_t total_bytes = (dense_suffix_semiwords.get_num_semiwords() * CBLQRegionEncoding<ndim>::BITS_PER_SEMIWORD + 7) >> 3;
+	for (const std::vector<cblq_word_t> &layer : this->layer_words)
+		total_bytes += layer.size() * sizeof(cblq_word_t);
+	return total_bytes;
+}
+
+// Explicit instantiation for 1D-4D CBLQ region encoders
+template class CBLQRegionEncoder<1>;
 template class CBLQRegionEncoder<2>;
 template class CBLQRegionEncoder<3>;
 template class CBLQRegionEncoder<4>;
@@ -23,6 +23,9 @@
 
 #include <cstdint>
 #include <vector>
+#include <algorithm>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/iterator/counting_iterator.hpp>
 
 #include "pique/region/cblq/cblq.hpp"
@@ -59,6 +62,58 @@ void CBLQRegionEncoding<ndim>::convert_to_rids_sorted(std::vector<rid_t> &out, u
 }
 
 
+// Streams RIDs by expanding the blocks produced by a CBLQBlockCursor, splitting blocks across batches as needed
+template<int ndim>
+class CBLQRIDBatchIterator : public RIDBatchIterator {
+public:
+	using block_size_t = typename CBLQBlockCursor<ndim>::block_size_t;
+	using block_offset_t = typename CBLQBlockCursor<ndim>::block_offset_t;
+
+	CBLQRIDBatchIterator(const CBLQRegionEncoding<ndim> &cblq, uint64_t offset) :
+		cursor(cblq), domain_size(cblq.get_domain_size()), offset(offset),
+		cur_rid(0), cur_block_end(0)
+	{}
+
+private:
+	virtual void next_batch_impl(std::vector<uint64_t> &out, size_t max_rids) {
+		while (max_rids > 0) {
+			if (cur_rid == cur_block_end) {
+				block_size_t block_size;
+				block_offset_t block_offset;
+				if (!cursor.next(block_size, block_offset))
+					return;
+
+				// Clip blocks to the domain (blocks are visited in ascending order, so all later blocks lie beyond it too)
+				cur_rid = std::min(block_offset, domain_size);
+				cur_block_end = std::min(block_offset + block_size, domain_size);
+				continue;
+			}
+
+			const uint64_t nrids = std::min< uint64_t >(cur_block_end - cur_rid, max_rids);
+			out.insert(
+					out.end(),
+					boost::counting_iterator< uint64_t >(cur_rid + offset),
+					boost::counting_iterator< uint64_t >(cur_rid + nrids + offset)
+			);
+
+			cur_rid += nrids;
+			max_rids -= nrids;
+		}
+	}
+
+private:
+	CBLQBlockCursor<ndim> cursor;
+	const uint64_t domain_size;
+	const uint64_t offset;
+
+	uint64_t cur_rid, cur_block_end; // [cur_rid, cur_block_end) remains of the current block
+};
+
+template<int ndim>
+boost::shared_ptr< RIDBatchIterator > CBLQRegionEncoding<ndim>::make_rid_iterator(uint64_t offset) const {
+	return boost::make_shared< CBLQRIDBatchIterator<ndim> >(*this, offset);
+}
+
 template<int ndim>
 void CBLQRegionEncoding<ndim>::convert_to_rids(std::vector<uint32_t> &out, bool sorted, bool preserve_self) {
 	return this->convert_to_rids_sorted< uint32_t, false >(out, 0, preserve_self);
@@ -70,8 +125,9 @@ void CBLQRegionEncoding<ndim>::convert_to_rids(std::vector<uint64_t> &out, uint6
 }
 
 
-// Explicit instantiation of 2D-4D CBLQ region encodings
+// Explicit instantiation of 1D-4D CBLQ region encodings
 // (this is also done in cblq.cpp, but multiple instantiations are OK; this forces the functions declared in this file to be instantiated)
+template class CBLQRegionEncoding<1>;
 template class CBLQRegionEncoding<2>;
 template class CBLQRegionEncoding<3>;
 template class CBLQRegionEncoding<4>;
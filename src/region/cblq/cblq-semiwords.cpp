@@ -106,9 +106,11 @@ void
 CBLQSemiwords<ndim>::append(CBLQSemiwords &other) {
 	assert(encoding_two_codes == other.encoding_two_codes);
 
+	// Trim to exact length, so the last block (if any) is the one holding the final semiwords, even if this array was padded
+	semiwords.resize((num_semiwords + SEMIWORDS_PER_BLOCK - 1) / SEMIWORDS_PER_BLOCK);
+
 	const int semiword_shift = num_semiwords % SEMIWORDS_PER_BLOCK;
 	if (semiword_shift == 0) {
-		semiwords.resize(num_semiwords / SEMIWORDS_PER_BLOCK); // trim to exact length
 		semiwords.insert(semiwords.end(), other.semiwords.begin(), other.semiwords.end()); // append new words
 	} else {
 		// Back of semiwords: LLLLLLL???
@@ -217,7 +219,8 @@ CBLQSemiwords<ndim>::operator==(const CBLQSemiwords<ndim> &other) {
 	return true;
 }
 
-// Explicit instantiation of CBLQSemiwords for 2D-4D
+// Explicit instantiation of CBLQSemiwords for 1D-4D
+template class CBLQSemiwords<1>;
 template class CBLQSemiwords<2>;
 template class CBLQSemiwords<3>;
 template class CBLQSemiwords<4>;
@@ -67,6 +67,9 @@ template<>
 const typename CBLQRegionEncoding<1>::cblq_semiword_t
 CBLQRegionEncoding<1>::FULL_SEMIWORD = 0b11;
 
+template<> void CBLQRegionEncoding<1>::print_cblq_word(uint8_t word) {
+    printf("%d%d", (word >> 0) & 0b11, (word >> 2) & 0b11);
+}
 template<> void CBLQRegionEncoding<2>::print_cblq_word(uint8_t word) {
     printf("%d%d%d%d", (word >> 0) & 0b11, (word >> 2) & 0b11, (word >> 4) & 0b11, (word >> 6) & 0b11);
 }
@@ -83,6 +86,9 @@ template<> void CBLQRegionEncoding<4>::print_cblq_word(uint32_t word) {
     	   (word >> 24) & 0b11, (word >> 26) & 0b11, (word >> 28) & 0b11, (word >> 30) & 0b11);
 }
 
+template<> void CBLQRegionEncoding<1>::print_cblq_semiword(uint8_t semiword) {
+    printf("%d%d", (semiword >> 0) & 0b1, (semiword >> 1) & 0b1);
+}
 template<> void CBLQRegionEncoding<2>::print_cblq_semiword(uint8_t semiword) {
     printf("%d%d%d%d",
     	   (semiword >> 0) & 0b1, (semiword >> 1) & 0b1 , (semiword >> 2) & 0b1 , (semiword >> 3) & 0b1);
@@ -461,6 +467,14 @@ bool
 CBLQRegionEncoding<ndim>:: is_the_filled_region() const { return this->is_single_word_cblq(CBLQRegionEncoding<ndim>::ONE_CODES_WORD); }
 
 
+template<int ndim>
+auto
+CBLQRegionEncoding<ndim>::get_region_uniformity() const -> RegionUniformity {
+	if (this->level_lens.empty())
+		return RegionUniformity::MIXED; // Null region
+	return this->is_the_empty_region() ? RegionUniformity::EMPTY : this->is_the_filled_region() ? RegionUniformity::FILLED : RegionUniformity::MIXED;
+}
+
 template<int ndim>
 bool
 CBLQRegionEncoding<ndim>::operator==(const RegionEncoding &other_base) const {
@@ -481,7 +495,8 @@ CBLQRegionEncoding<ndim>::operator==(const RegionEncoding &other_base) const {
 	return true;
 }
 
-// Explicit instantiation of 2D-4D CBLQ region encodings
+// Explicit instantiation of 1D-4D CBLQ region encodings
+template class CBLQRegionEncoding<1>;
 template class CBLQRegionEncoding<2>;
 template class CBLQRegionEncoding<3>;
 template class CBLQRegionEncoding<4>;
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * bp128.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cassert>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "pique/region/cii/bp128.hpp"
+
+constexpr size_t BP128Codec::BLOCK_SIZE;
+constexpr size_t BP128Codec::HEADER_SIZE;
+constexpr size_t BP128Codec::MAX_ENCODED_BLOCK_SIZE;
+
+typedef BP128Codec::rid_t rid_t;
+
+// Minimal 4 x 32-bit lane operations, backed by SSE2 where available
+namespace {
+#if defined(__SSE2__)
+typedef __m128i lanes_t;
+
+inline lanes_t lanes_load(const void *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+inline void lanes_store(void *p, lanes_t v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+inline lanes_t lanes_set1(uint32_t x) { return _mm_set1_epi32((int)x); }
+inline lanes_t lanes_zero() { return _mm_setzero_si128(); }
+inline lanes_t lanes_add(lanes_t a, lanes_t b) { return _mm_add_epi32(a, b); }
+inline lanes_t lanes_sub(lanes_t a, lanes_t b) { return _mm_sub_epi32(a, b); }
+inline lanes_t lanes_or(lanes_t a, lanes_t b) { return _mm_or_si128(a, b); }
+inline lanes_t lanes_and(lanes_t a, lanes_t b) { return _mm_and_si128(a, b); }
+inline lanes_t lanes_shl(lanes_t a, int n) { return _mm_slli_epi32(a, n); }
+inline lanes_t lanes_shr(lanes_t a, int n) { return _mm_srli_epi32(a, n); }
+#else
+struct lanes_t { uint32_t v[4]; };
+
+inline lanes_t lanes_load(const void *p) { lanes_t r; memcpy(r.v, p, sizeof(r.v)); return r; }
+inline void lanes_store(void *p, lanes_t v) { memcpy(p, v.v, sizeof(v.v)); }
+inline lanes_t lanes_set1(uint32_t x) { return lanes_t{{ x, x, x, x }}; }
+inline lanes_t lanes_zero() { return lanes_set1(0); }
+#define LANEWISE(name, expr) \
+	inline lanes_t name(lanes_t a, lanes_t b) { lanes_t r; for (int i = 0; i < 4; i++) r.v[i] = (expr); return r; }
+LANEWISE(lanes_add, a.v[i] + b.v[i])
+LANEWISE(lanes_sub, a.v[i] - b.v[i])
+LANEWISE(lanes_or, a.v[i] | b.v[i])
+LANEWISE(lanes_and, a.v[i] & b.v[i])
+#undef LANEWISE
+inline lanes_t lanes_shl(lanes_t a, int n) { for (int i = 0; i < 4; i++) a.v[i] = (n < 32 ? a.v[i] << n : 0); return a; }
+inline lanes_t lanes_shr(lanes_t a, int n) { for (int i = 0; i < 4; i++) a.v[i] = (n < 32 ? a.v[i] >> n : 0); return a; }
+#endif
+
+constexpr int VECTORS_PER_BLOCK = BP128Codec::BLOCK_SIZE / 4;
+
+// Packs the 128 values at in (each < 2^B) into B 16-byte words at out
+template<int B>
+void pack_block(const rid_t *in, char *out) {
+	lanes_t acc = lanes_zero();
+	int shift = 0;
+	for (int k = 0; k < VECTORS_PER_BLOCK; k++) {
+		const lanes_t v = lanes_load(in + 4 * k);
+		acc = lanes_or(acc, lanes_shl(v, shift));
+		if (shift + B >= 32) {
+			lanes_store(out, acc);
+			out += sizeof(lanes_t);
+
+			const int spill = shift + B - 32; // Bits of v that did not fit in this word
+			acc = spill ? lanes_shr(v, B - spill) : lanes_zero();
+			shift = spill;
+		} else {
+			shift += B;
+		}
+	}
+}
+template<> void pack_block<0>(const rid_t *in, char *out) {}
+
+// Unpacks vector K of B-bit differences from the packed words at in, adding it onto the previous vector of RIDs.
+// Unrolled at compile time over K, so that all word offsets and shift counts are constants
+template<int B, int K>
+struct UnpackStep {
+	static inline void run(const char *in, rid_t *out, lanes_t prev, lanes_t mask) {
+		constexpr int WORD = K * B / 32, SHIFT = K * B % 32;
+
+		lanes_t v = lanes_shr(lanes_load(in + WORD * sizeof(lanes_t)), SHIFT);
+		if (SHIFT + B > 32) // This value straddles two words
+			v = lanes_or(v, lanes_shl(lanes_load(in + (WORD + 1) * sizeof(lanes_t)), 32 - SHIFT));
+
+		prev = lanes_add(prev, lanes_and(v, mask));
+		lanes_store(out + 4 * K, prev);
+		UnpackStep< B, K + 1 >::run(in, out, prev, mask);
+	}
+};
+template<int B>
+struct UnpackStep< B, VECTORS_PER_BLOCK > {
+	static inline void run(const char *in, rid_t *out, lanes_t prev, lanes_t mask) {}
+};
+
+// Unpacks B 16-byte words at in, adding each vector of 4 differences onto the previous vector of RIDs (initially prev)
+template<int B>
+void unpack_block(const char *in, rid_t *out, lanes_t prev) {
+	UnpackStep< B, 0 >::run(in, out, prev, lanes_set1(B == 32 ? ~(uint32_t)0 : ((uint32_t)1 << B) - 1));
+}
+template<> void unpack_block<0>(const char *in, rid_t *out, lanes_t prev) {
+	for (int k = 0; k < VECTORS_PER_BLOCK; k++)
+		lanes_store(out + 4 * k, prev);
+}
+
+typedef void (*pack_fn)(const rid_t *, char *);
+typedef void (*unpack_fn)(const char *, rid_t *, lanes_t);
+
+const pack_fn PACKERS[33] = {
+	pack_block<0>,  pack_block<1>,  pack_block<2>,  pack_block<3>,  pack_block<4>,  pack_block<5>,  pack_block<6>,  pack_block<7>,
+	pack_block<8>,  pack_block<9>,  pack_block<10>, pack_block<11>, pack_block<12>, pack_block<13>, pack_block<14>, pack_block<15>,
+	pack_block<16>, pack_block<17>, pack_block<18>, pack_block<19>, pack_block<20>, pack_block<21>, pack_block<22>, pack_block<23>,
+	pack_block<24>, pack_block<25>, pack_block<26>, pack_block<27>, pack_block<28>, pack_block<29>, pack_block<30>, pack_block<31>,
+	pack_block<32>,
+};
+
+const unpack_fn UNPACKERS[33] = {
+	unpack_block<0>,  unpack_block<1>,  unpack_block<2>,  unpack_block<3>,  unpack_block<4>,  unpack_block<5>,  unpack_block<6>,  unpack_block<7>,
+	unpack_block<8>,  unpack_block<9>,  unpack_block<10>, unpack_block<11>, unpack_block<12>, unpack_block<13>, unpack_block<14>, unpack_block<15>,
+	unpack_block<16>, unpack_block<17>, unpack_block<18>, unpack_block<19>, unpack_block<20>, unpack_block<21>, unpack_block<22>, unpack_block<23>,
+	unpack_block<24>, unpack_block<25>, unpack_block<26>, unpack_block<27>, unpack_block<28>, unpack_block<29>, unpack_block<30>, unpack_block<31>,
+	unpack_block<32>,
+};
+
+inline int bit_width(uint32_t x) {
+	int bits = 0;
+	for (; x; x >>= 1)
+		bits++;
+	return bits;
+}
+}
+
+size_t BP128Codec::encode_block(const rid_t *rids, size_t count, std::vector<char> &out) {
+	assert(count >= 1 && count <= BLOCK_SIZE);
+
+	// Pad short blocks by repeating the last RID (giving zero differences)
+	rid_t padded[BLOCK_SIZE];
+	memcpy(padded, rids, count * sizeof(rid_t));
+	for (size_t i = count; i < BLOCK_SIZE; i++)
+		padded[i] = rids[count - 1];
+
+	// Take differences four positions apart, relative to the base for the first vector
+	const rid_t base = padded[0];
+	rid_t deltas[BLOCK_SIZE];
+	lanes_t prev = lanes_set1(base), all_bits = lanes_zero();
+	for (int k = 0; k < VECTORS_PER_BLOCK; k++) {
+		const lanes_t cur = lanes_load(padded + 4 * k);
+		const lanes_t delta = lanes_sub(cur, prev);
+		lanes_store(deltas + 4 * k, delta);
+		all_bits = lanes_or(all_bits, delta);
+		prev = cur;
+	}
+
+	rid_t all_bits_lanes[4];
+	lanes_store(all_bits_lanes, all_bits);
+	const int bits = bit_width(all_bits_lanes[0] | all_bits_lanes[1] | all_bits_lanes[2] | all_bits_lanes[3]);
+
+	const size_t encoded_size = HEADER_SIZE + bits * sizeof(lanes_t);
+	const size_t old_size = out.size();
+	out.resize(old_size + encoded_size);
+
+	char *header = &out[old_size];
+	memcpy(header, &base, sizeof(rid_t));
+	header[4] = (char)bits;
+	header[5] = (char)(count - 1);
+	header[6] = header[7] = 0;
+
+	PACKERS[bits](deltas, header + HEADER_SIZE);
+	return encoded_size;
+}
+
+size_t BP128Codec::decode_block(const char *in, rid_t *out, size_t &count) {
+	const int bits = (uint8_t)in[4];
+	assert(bits <= 32);
+
+	count = get_block_count(in);
+	UNPACKERS[bits](in + HEADER_SIZE, out, lanes_set1(get_block_base(in)));
+	return HEADER_SIZE + bits * sizeof(lanes_t);
+}
+
+size_t BP128Codec::get_block_count(const char *in) {
+	return (size_t)(uint8_t)in[5] + 1;
+}
+
+size_t BP128Codec::get_block_size(const char *in) {
+	return HEADER_SIZE + (size_t)(uint8_t)in[4] * 16;
+}
+
+auto BP128Codec::get_block_base(const char *in) -> rid_t {
+	rid_t base;
+	memcpy(&base, in, sizeof(rid_t));
+	return base;
+}
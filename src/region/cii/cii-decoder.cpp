@@ -22,19 +22,26 @@
  */
 
 #include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
 #include <boost/iterator/counting_iterator.hpp>
 
-#include <patchedframeofreference.h>
-
 #include "pique/region/cii/cii.hpp"
 #include "pique/region/cii/cii-decoder.hpp"
 
+#ifdef HAVE_RIDCOMPRESS
+#include <patchedframeofreference.h>
+#endif
+
 BaseProgressiveCIIDecoder::BaseProgressiveCIIDecoder(const CIIRegionEncoding &cii) :
-	is_decompressing_cii(cii.is_compressed), cur_chunk()
+	is_decompressing_cii(cii.is_compressed), format(cii.format), cur_chunk(),
+	skip_table(cii.skip_table.empty() ? nullptr : &cii.skip_table), next_chunk_index(0)
 {
 	if (is_decompressing_cii) {
 		cur_chunk_it = cur_chunk.cbegin();
 		cur_chunk_it_end = cur_chunk.cend();
+		encoded_chunks_begin = cii.cii.cbegin();
 		encoded_chunk_it = cii.cii.cbegin();
 		encoded_chunk_it_end = cii.cii.cend();
 		decode_next_chunk();
@@ -58,6 +65,43 @@ void BaseProgressiveCIIDecoder::next() {
 		this->decode_next_chunk();
 }
 
+void BaseProgressiveCIIDecoder::skip_to(rid_t rid) {
+	if (!this->has_top() || this->top() >= rid)
+		return;
+
+	// If rid lies beyond the current chunk, find the first chunk that may contain it
+	if (this->is_decompressing_cii && *(cur_chunk_it_end - 1) < rid) {
+		cur_chunk_it = cur_chunk_it_end;
+
+		if (this->skip_table) {
+			typedef CIIRegionEncoding::SkipEntry SkipEntry;
+			const auto chunk_it = std::lower_bound(
+					this->skip_table->cbegin() + this->next_chunk_index, this->skip_table->cend(), rid,
+					[](const SkipEntry &entry, rid_t rid) -> bool { return entry.max_rid < rid; });
+
+			if (chunk_it == this->skip_table->cend()) {
+				// Every remaining RID is less than rid
+				this->encoded_chunk_it = this->encoded_chunk_it_end;
+				this->next_chunk_index = this->skip_table->size();
+				return;
+			}
+
+			this->encoded_chunk_it = this->encoded_chunks_begin + chunk_it->byte_offset;
+			this->next_chunk_index = chunk_it - this->skip_table->cbegin();
+			if (!this->decode_next_chunk())
+				return;
+		} else {
+			// No skip table, so decode chunks until reaching one that ends at or after rid
+			while (this->decode_next_chunk() && *(cur_chunk_it_end - 1) < rid)
+				cur_chunk_it = cur_chunk_it_end;
+			if (!this->has_top())
+				return;
+		}
+	}
+
+	cur_chunk_it = std::lower_bound(cur_chunk_it, cur_chunk_it_end, rid);
+}
+
 void BaseProgressiveCIIDecoder::dump_to(std::vector<rid_t> &output) {
 	// Copy any remaining decoded RIDs to the output buffer
 	output.insert(output.end(), cur_chunk_it, cur_chunk_it_end);
@@ -75,6 +119,21 @@ bool BaseProgressiveCIIDecoder::decode_next_chunk_to(std::vector<rid_t> &output)
 
 	// Prepare room in the vector for the decoded chunk
 	size_t old_elemcount = output.size();
+
+	if (this->format == CIICompressionFormat::BP128) {
+		output.resize(old_elemcount + BP128Codec::BLOCK_SIZE);
+
+		size_t decoded_chunk_elemcount;
+		const size_t encoded_chunk_length = BP128Codec::decode_block(&*encoded_chunk_it, &output[old_elemcount], decoded_chunk_elemcount);
+		assert(encoded_chunk_length <= (size_t)(encoded_chunk_it_end - encoded_chunk_it));
+
+		output.resize(old_elemcount + decoded_chunk_elemcount);
+		encoded_chunk_it += encoded_chunk_length;
+		++next_chunk_index;
+		return true;
+	}
+
+#ifdef HAVE_RIDCOMPRESS
 	output.resize(old_elemcount + CIIRegionEncoding::CII_CHUNK_SIZE);
 
 	// Set up input/output parameters for chunk decoding
@@ -99,8 +158,13 @@ bool BaseProgressiveCIIDecoder::decode_next_chunk_to(std::vector<rid_t> &output)
 	// this chunk in the encoded array
 	output.resize(old_elemcount + decoded_chunk_elemcount);
 	encoded_chunk_it += encoded_chunk_length / sizeof(char);
+	++next_chunk_index;
 
 	return true;
+#else
+	std::cerr << "Error: cannot decode a PForDelta-compressed CII without the ridcompress library (configure --with-ridcompress)" << std::endl;
+	abort();
+#endif
 }
 
 bool BaseProgressiveCIIDecoder::decode_next_chunk() {
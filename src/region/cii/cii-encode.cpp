@@ -32,8 +32,6 @@ extern "C" {
 #include "pique/region/region-encoding.hpp"
 #include "pique/region/cii/cii-encode.hpp"
 
-#include <patchedframeofreference.h>
-
 CIIRegionEncoder::CIIRegionEncoder(CIIRegionEncoderConfig conf, size_t total_elements) :
 	RegionEncoder< CIIRegionEncoding, CIIRegionEncoderConfig >(conf, total_elements),
 	next_rid(0),
@@ -41,6 +39,7 @@ CIIRegionEncoder::CIIRegionEncoder(CIIRegionEncoderConfig conf, size_t total_ele
 	encoding(boost::make_shared< CIIRegionEncoding >(total_elements))
 {
 	encoding->is_compressed = true;
+	encoding->format = conf.format;
 }
 
 boost::shared_ptr< CIIRegionEncoding > CIIRegionEncoder::to_region_encoding() {
@@ -54,7 +53,7 @@ void CIIRegionEncoder::push_bits_impl(uint64_t count, bool bitval) {
 
 		for (rid_t rid = next_rid; rids_remaining; rid++, rids_remaining--) {
 			this->cur_chunk.push_back(rid);
-			if (this->cur_chunk.size() >= CIIRegionEncoding::CII_CHUNK_SIZE)
+			if (this->cur_chunk.size() >= this->encoding->get_chunk_size())
 				this->compress_chunk();
 		}
 	}
@@ -73,23 +72,6 @@ void CIIRegionEncoder::compress_chunk() {
 	if (!cur_chunk.size())
 		return;
 
-	std::vector<char> &cii_buffer = this->encoding->cii;
-
-	const size_t prev_cii_buffer_size = cii_buffer.size();
-	const size_t max_output_chunk_size = pfor::PatchedFrameOfReference::kSufficientBufferCapacity / sizeof(char);
-	cii_buffer.resize(prev_cii_buffer_size + max_output_chunk_size); // Resize with some new chars to hold the output chunk
-
-	char *output_chunk = &(*cii_buffer.end()) - max_output_chunk_size;
-	const rid_t *input_rids = &(*this->cur_chunk.begin());
-	uint32_t output_chunk_size;
-
-	const bool success = pfor::PatchedFrameOfReference::encode(
-			input_rids, CIIRegionEncoding::CII_CHUNK_SIZE, this->cur_chunk.size(),
-			(void*)output_chunk, max_output_chunk_size, output_chunk_size);
-	assert(success);
-
-	//printf("Compressed %lu RIDs into a new PFD chunk of size %lu\n", this->cur_chunk.size(), output_chunk_size);
-
-	cii_buffer.resize(prev_cii_buffer_size + output_chunk_size);
+	this->encoding->append_compressed_chunk(&this->cur_chunk.front(), this->cur_chunk.size());
 	cur_chunk.clear();
 }
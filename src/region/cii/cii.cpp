@@ -22,20 +22,50 @@
  */
 
 #include <cmath>
+#include <algorithm>
+#include <cstdlib>
 
 #include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
 
 #include "pique/region/cii/cii.hpp"
 #include "pique/region/cii/cii-decoder.hpp"
 
+#ifdef HAVE_RIDCOMPRESS
+// ridcompress library
+#include <patchedframeofreference.h>
+#endif
+
+// Streams RIDs out of a ProgressiveCIIDecoder, so only one chunk is decompressed at a time
+class CIIRIDBatchIterator : public RIDBatchIterator {
+public:
+	CIIRIDBatchIterator(const CIIRegionEncoding &cii, uint64_t offset) :
+		decoder(cii), offset(offset)
+	{}
+
+private:
+	virtual void next_batch_impl(std::vector<uint64_t> &out, size_t max_rids) {
+		for (; decoder.has_top() && max_rids > 0; decoder.next(), --max_rids)
+			out.push_back(decoder.top() + offset);
+	}
+
+private:
+	ProgressiveCIIDecoder decoder;
+	const uint64_t offset;
+};
+
 constexpr RegionEncoding::Type CIIRegionEncoding::TYPE;
-const size_t CIIRegionEncoding::CII_CHUNK_SIZE = pfor::PatchedFrameOfReference::kBatchSize;
+const size_t CIIRegionEncoding::CII_CHUNK_SIZE = 128; // RIDs per PForDelta chunk
+
+#ifdef HAVE_RIDCOMPRESS
+static_assert(pfor::PatchedFrameOfReference::kBatchSize == 128, "CII_CHUNK_SIZE must match the ridcompress PForDelta batch size");
+#endif
 
 size_t CIIRegionEncoding::get_size_in_bytes() const {
 	return 	1 +                             // inverted
-			is_compressed ?
-				cii.size() * sizeof(char) : // cii, OR
-				ii.size() * sizeof(rid_t);  // ii
+			(is_compressed ?
+				cii.size() * sizeof(char) + skip_table.size() * sizeof(SkipEntry) : // cii and its skip table (if any), OR
+				ii.size() * sizeof(rid_t));                                         // ii
 }
 
 void CIIRegionEncoding::dump() const {
@@ -57,8 +87,25 @@ void CIIRegionEncoding::dump() const {
 		std::cout << std::endl;
 }
 
+auto CIIRegionEncoding::get_region_uniformity() const -> RegionUniformity {
+	if (is_compressed)
+		return RegionUniformity::MIXED;
+
+	const bool no_exceptions = ii.empty(), all_exceptions = (ii.size() == domain_size);
+	if (no_exceptions || all_exceptions)
+		return (no_exceptions != is_inverted) ? RegionUniformity::EMPTY : RegionUniformity::FILLED;
+	else
+		return RegionUniformity::MIXED;
+}
+
 uint64_t CIIRegionEncoding::get_element_count() const {
-	if (is_compressed) {
+	if (is_compressed && format == CIICompressionFormat::BP128) {
+		// BP128 chunk headers record their RID counts, so there is no need to decode anything
+		uint64_t count = 0;
+		for (const SkipEntry &entry : skip_table)
+			count += BP128Codec::get_block_count(&cii[entry.byte_offset]);
+		return this->is_inverted ? this->get_domain_size() - count : count;
+	} else if (is_compressed) {
 		// TODO: Inefficient, maintain this count throughout CIIRegionEncoding lifetime, as there are times when it is already known
 		// TODO: Another alternative/improvement: just check PFOR-Delta headers, skip chunk contents (requires code for deeper inspection of PFOR-Delta data)
 		ProgressiveCIIDecoder decoder(*this);
@@ -87,45 +134,69 @@ void CIIRegionEncoding::convert_to_rids(std::vector<uint32_t> &out, bool sorted,
 	}
 }
 
-void CIIRegionEncoding::compress() {
-	if (this->is_compressed) {
-		return;
-	} else if (this->ii.empty()) {
-		this->is_compressed = true;
+boost::shared_ptr< RIDBatchIterator > CIIRegionEncoding::make_rid_iterator(uint64_t offset) const {
+	return boost::make_shared< CIIRIDBatchIterator >(*this, offset);
+}
+
+void CIIRegionEncoding::set_compression_format(CIICompressionFormat format) {
+	if (format == this->format)
 		return;
-	}
 
-	const size_t compressed_chunks = (this->ii.size() - 1) - CIIRegionEncoding::CII_CHUNK_SIZE + 1;
-	const size_t max_output_chunk_size = pfor::PatchedFrameOfReference::kSufficientBufferCapacity / sizeof(char);
-	const size_t max_compressed_size = compressed_chunks * max_output_chunk_size;
+	const bool was_compressed = this->is_compressed;
+	this->decompress();
+	this->format = format;
+	if (was_compressed)
+		this->compress();
+}
+
+void CIIRegionEncoding::append_compressed_chunk(const rid_t *rids, size_t count) {
+	assert(count > 0 && count <= this->get_chunk_size());
 
-	std::vector<rid_t> &ii_buffer = this->ii;
 	std::vector<char> &cii_buffer = this->cii;
-	cii_buffer.clear();
-	cii_buffer.resize(max_compressed_size); // Resize with some new chars to hold the output chunk
-
-	// size = bytes, length = element count
-	char *output_chunk = &cii_buffer.front();
-	rid_t *input_rids = &ii_buffer.front();
-	size_t output_size = 0;
-	size_t rids_left = ii_buffer.size();
-	for (size_t chunk = 0; chunk < compressed_chunks; chunk++) {
-		uint32_t input_chunk_length = std::min(rids_left, CIIRegionEncoding::CII_CHUNK_SIZE);
+	const size_t prev_cii_buffer_size = cii_buffer.size();
+	assert(prev_cii_buffer_size <= std::numeric_limits<uint32_t>::max());
+
+	this->skip_table.push_back(SkipEntry { rids[count - 1], static_cast<uint32_t>(prev_cii_buffer_size) });
+
+	if (this->format == CIICompressionFormat::BP128) {
+		BP128Codec::encode_block(rids, count, cii_buffer);
+	} else {
+#ifdef HAVE_RIDCOMPRESS
+		const size_t max_output_chunk_size = pfor::PatchedFrameOfReference::kSufficientBufferCapacity / sizeof(char);
+		cii_buffer.resize(prev_cii_buffer_size + max_output_chunk_size); // Resize with some new chars to hold the output chunk
+
+		char *output_chunk = &cii_buffer[prev_cii_buffer_size];
 		uint32_t output_chunk_size;
 
 		const bool success = pfor::PatchedFrameOfReference::encode(
-				input_rids, CIIRegionEncoding::CII_CHUNK_SIZE, input_chunk_length,
+				rids, CIIRegionEncoding::CII_CHUNK_SIZE, count,
 				(void*)output_chunk, max_output_chunk_size, output_chunk_size);
 		assert(success);
 
-		output_chunk += output_chunk_size;
-		output_size += output_chunk_size;
-		input_rids += input_chunk_length;
-		rids_left -= input_chunk_length;
+		cii_buffer.resize(prev_cii_buffer_size + output_chunk_size);
+#else
+		std::cerr << "Error: PForDelta CII compression requires the ridcompress library (configure --with-ridcompress), use BP128 instead" << std::endl;
+		abort();
+#endif
 	}
+}
+
+void CIIRegionEncoding::compress() {
+	if (this->is_compressed) {
+		return;
+	} else if (this->ii.empty()) {
+		this->is_compressed = true;
+		return;
+	}
+
+	const size_t chunk_size = this->get_chunk_size();
+
+	this->cii.clear();
+	this->skip_table.clear();
+	for (size_t pos = 0; pos < this->ii.size(); pos += chunk_size)
+		this->append_compressed_chunk(&this->ii[pos], std::min(chunk_size, this->ii.size() - pos));
 
-	cii_buffer.resize(output_size);
-	ii_buffer.clear();
+	this->ii.clear();
 	this->is_compressed = true;
 }
 
@@ -138,6 +209,7 @@ void CIIRegionEncoding::decompress() {
 
 	decoder.dump_to(this->ii);
 	this->cii.clear();
+	this->skip_table.clear();
 	this->is_compressed = false;
 }
 
@@ -151,10 +223,12 @@ bool CIIRegionEncoding::operator==(const RegionEncoding &other_base) const {
 	if (this->domain_size != other.domain_size)
 		return false;
 
-	// If both CIIs are inverted or not inverted, and both are compressed or not compressed,
+	// If both CIIs are inverted or not inverted, and both are compressed (in the same format) or not compressed,
 	// we can directly compare their contents directly. Otherwise, we need to use a decoder
 	// to normalize the contents.
-	if (this->is_compressed == other.is_compressed && this->is_inverted == other.is_inverted) {
+	if (this->is_compressed == other.is_compressed && this->is_inverted == other.is_inverted &&
+		(!this->is_compressed || this->format == other.format))
+	{
 		if (this->is_compressed)
 			return this->cii == other.cii;
 		else
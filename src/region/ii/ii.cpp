@@ -28,6 +28,24 @@
 
 using namespace std;
 
+// Streams the (already sorted) RID list directly
+class IIRIDBatchIterator : public RIDBatchIterator {
+public:
+	IIRIDBatchIterator(const vector< IIRegionEncoding::rid_t > &rids, uint64_t offset) :
+		it(rids.cbegin()), end_it(rids.cend()), offset(offset)
+	{}
+
+private:
+	virtual void next_batch_impl(vector<uint64_t> &out, size_t max_rids) {
+		for (; it != end_it && max_rids > 0; ++it, --max_rids)
+			out.push_back(*it + offset);
+	}
+
+private:
+	vector< IIRegionEncoding::rid_t >::const_iterator it, end_it;
+	const uint64_t offset;
+};
+
 constexpr RegionEncoding::Type IIRegionEncoding::TYPE;
 
 void IIRegionEncoding::dump() const {
@@ -44,6 +62,10 @@ void IIRegionEncoding::dump() const {
 		cout << endl;
 }
 
+boost::shared_ptr< RIDBatchIterator > IIRegionEncoding::make_rid_iterator(uint64_t offset) const {
+	return boost::make_shared< IIRIDBatchIterator >(this->rids, offset);
+}
+
 bool IIRegionEncoding::operator==(const RegionEncoding &other_base) const {
 	if (typeid(other_base) != typeid(IIRegionEncoding))
 		return false;
@@ -37,12 +37,24 @@
 #include "pique/region/cii/cii.hpp"
 #include "pique/region/cblq/cblq.hpp"
 #include "pique/region/wah/wah.hpp"
+#include "pique/region/wah/wah64.hpp"
 #include "pique/region/bitmap/bitmap.hpp"
+#include "pique/region/ii/ii-encode.hpp"
+#include "pique/region/cii/cii-encode.hpp"
+#include "pique/region/cblq/cblq-encode.hpp"
+#include "pique/region/wah/wah-encode.hpp"
+#include "pique/region/wah/wah64-encode.hpp"
+#include "pique/region/bitmap/bitmap-encode.hpp"
 
 using RETypeToClassDispatch =
 		typename MakeValueToTypeDispatch<RegionEncoding::Type>
-	::WithValues< RegionEncoding::Type::II, RegionEncoding::Type::CII, RegionEncoding::Type::WAH, RegionEncoding::Type::CBLQ_2D, RegionEncoding::Type::CBLQ_3D, RegionEncoding::Type::CBLQ_4D, RegionEncoding::Type::UNCOMPRESSED_BITMAP >
-	::WithTypes< IIRegionEncoding, CIIRegionEncoding, WAHRegionEncoding, CBLQRegionEncoding<2>, CBLQRegionEncoding<3>, CBLQRegionEncoding<4>, BitmapRegionEncoding >::type;
+	::WithValues< RegionEncoding::Type::II, RegionEncoding::Type::CII, RegionEncoding::Type::WAH, RegionEncoding::Type::CBLQ_1D, RegionEncoding::Type::CBLQ_2D, RegionEncoding::Type::CBLQ_3D, RegionEncoding::Type::CBLQ_4D, RegionEncoding::Type::UNCOMPRESSED_BITMAP, RegionEncoding::Type::WAH64 >
+	::WithTypes< IIRegionEncoding, CIIRegionEncoding, WAHRegionEncoding, CBLQRegionEncoding<1>, CBLQRegionEncoding<2>, CBLQRegionEncoding<3>, CBLQRegionEncoding<4>, BitmapRegionEncoding, WAH64RegionEncoding >::type;
+
+using RETypeToEncoderDispatch =
+		typename MakeValueToTypeDispatch<RegionEncoding::Type>
+	::WithValues< RegionEncoding::Type::II, RegionEncoding::Type::CII, RegionEncoding::Type::WAH, RegionEncoding::Type::CBLQ_1D, RegionEncoding::Type::CBLQ_2D, RegionEncoding::Type::CBLQ_3D, RegionEncoding::Type::CBLQ_4D, RegionEncoding::Type::UNCOMPRESSED_BITMAP, RegionEncoding::Type::WAH64 >
+	::WithTypes< IIRegionEncoder, CIIRegionEncoder, WAHRegionEncoder, CBLQRegionEncoder<1>, CBLQRegionEncoder<2>, CBLQRegionEncoder<3>, CBLQRegionEncoder<4>, BitmapRegionEncoder, WAH64RegionEncoder >::type;
 
 boost::shared_ptr< RegionEncoding > RegionEncoding::make_null_region(RegionEncoding::Type type) {
 	return RETypeToClassDispatch::dispatchMatching< boost::shared_ptr< RegionEncoding > >(
@@ -51,7 +63,12 @@ boost::shared_ptr< RegionEncoding > RegionEncoding::make_null_region(RegionEncod
 			nullptr);
 }
 
+constexpr RegionEncoding::Type RegionEncoding::HETEROGENEOUS_SYNTHESIZED_TYPE;
+
 boost::shared_ptr< RegionEncoding > RegionEncoding::make_uniform_region(RegionEncoding::Type type, uint64_t nelem, bool filled) {
+	if (type == RegionEncoding::Type::HETEROGENEOUS)
+		type = HETEROGENEOUS_SYNTHESIZED_TYPE;
+
 	return RETypeToClassDispatch::dispatchMatching< boost::shared_ptr< RegionEncoding > >(
 			type,
 			boost::make_shared_dispatch< RegionEncoding >(),
@@ -59,6 +76,49 @@ boost::shared_ptr< RegionEncoding > RegionEncoding::make_uniform_region(RegionEn
 			nelem, filled);
 }
 
+template<typename RegionEncoderConfigT> static RegionEncoderConfigT make_default_encoder_config() { return RegionEncoderConfigT(); }
+template<> CBLQRegionEncoderConfig make_default_encoder_config< CBLQRegionEncoderConfig >() { return CBLQRegionEncoderConfig(false); }
+
+struct EncodeRIDRangesDispatch {
+	template<typename RegionEncoderT>
+	boost::shared_ptr< RegionEncoding > operator()(uint64_t nelem, const std::vector< std::pair< uint64_t, uint64_t > > &rid_ranges) {
+		RegionEncoderT encoder(make_default_encoder_config< typename RegionEncoderT::RegionEncoderConfig >(), nelem);
+		for (const std::pair< uint64_t, uint64_t > &range : rid_ranges)
+			encoder.insert_bits(range.first, range.second);
+		encoder.finalize();
+		return encoder.to_region_encoding();
+	}
+};
+
+boost::shared_ptr< RegionEncoding > RegionEncoding::make_region_from_rid_ranges(RegionEncoding::Type type, uint64_t nelem, const std::vector< std::pair< uint64_t, uint64_t > > &rid_ranges) {
+	if (type == RegionEncoding::Type::HETEROGENEOUS)
+		type = HETEROGENEOUS_SYNTHESIZED_TYPE;
+
+	return RETypeToEncoderDispatch::dispatchMatching< boost::shared_ptr< RegionEncoding > >(
+			type,
+			EncodeRIDRangesDispatch(),
+			nullptr,
+			nelem, rid_ranges);
+}
+
+struct EncodeRIDIteratorDispatch {
+	template<typename RegionEncoderT>
+	boost::shared_ptr< RegionEncoding > operator()(uint64_t nelem, RIDBatchIterator &rid_it) {
+		RegionEncoderT encoder(make_default_encoder_config< typename RegionEncoderT::RegionEncoderConfig >(), nelem);
+		encoder.insert_rids(rid_it);
+		encoder.finalize();
+		return encoder.to_region_encoding();
+	}
+};
+
+boost::shared_ptr< RegionEncoding > RegionEncoding::make_region_from_rid_iterator(RegionEncoding::Type type, uint64_t nelem, RIDBatchIterator &rid_it) {
+	return RETypeToEncoderDispatch::dispatchMatching< boost::shared_ptr< RegionEncoding > >(
+			type,
+			EncodeRIDIteratorDispatch(),
+			nullptr,
+			nelem, rid_it);
+}
+
 typedef boost::bimaps::bimap<
 			boost::bimaps::unordered_set_of< std::string, std::hash< std::string > >,
 			boost::bimaps::unordered_set_of< RegionEncoding::Type > >
@@ -68,10 +128,13 @@ static const std::vector< typename RepTypeMap::value_type > known_reptypes_initl
 		{"ii", RegionEncoding::Type::II},
 		{"cii", RegionEncoding::Type::CII},
 		{"wah", RegionEncoding::Type::WAH},
+		{"cblq1d", RegionEncoding::Type::CBLQ_1D},
 		{"cblq2d", RegionEncoding::Type::CBLQ_2D},
 		{"cblq3d", RegionEncoding::Type::CBLQ_3D},
 		{"cblq4d", RegionEncoding::Type::CBLQ_4D},
 		{"bitmap", RegionEncoding::Type::UNCOMPRESSED_BITMAP},
+		{"wah64", RegionEncoding::Type::WAH64},
+		{"heterogeneous", RegionEncoding::Type::HETEROGENEOUS},
 };
 
 static const RepTypeMap known_reptypes(known_reptypes_initlist.begin(), known_reptypes_initlist.end());
@@ -85,10 +148,12 @@ static const std::vector< typename ClassTypeMap::value_type > known_classtypes_i
 		{RegionEncoding::Type::II, typeid(IIRegionEncoding)},
 		{RegionEncoding::Type::CII, typeid(CIIRegionEncoding)},
 		{RegionEncoding::Type::WAH, typeid(WAHRegionEncoding)},
+		{RegionEncoding::Type::CBLQ_1D, typeid(CBLQRegionEncoding<1>)},
 		{RegionEncoding::Type::CBLQ_2D, typeid(CBLQRegionEncoding<2>)},
 		{RegionEncoding::Type::CBLQ_3D, typeid(CBLQRegionEncoding<3>)},
 		{RegionEncoding::Type::CBLQ_4D, typeid(CBLQRegionEncoding<4>)},
 		{RegionEncoding::Type::UNCOMPRESSED_BITMAP, typeid(BitmapRegionEncoding)},
+		{RegionEncoding::Type::WAH64, typeid(WAH64RegionEncoding)},
 };
 
 static const ClassTypeMap known_classtypes(known_classtypes_initlist.begin(), known_classtypes_initlist.end());
@@ -116,13 +181,12 @@ boost::optional< std::string > RegionEncoding::get_region_representation_type_na
 
 void RegionEncoding::convert_to_rids(std::vector<uint64_t>& out, uint64_t offset, bool sorted, bool preserve_self) {
 	std::vector< uint32_t > rids;
-	std::vector< uint64_t > rids64;
 
 	this->convert_to_rids(rids, sorted, preserve_self);
-	rids64.resize(rids.size());
+	out.resize(rids.size());
 
 	auto in_it = rids.cbegin(), in_end_it = rids.cend();
-	auto out_it = rids64.begin();
+	auto out_it = out.begin();
 	while (in_it != in_end_it) {
 		*out_it = *in_it + offset;
 		++in_it; ++out_it;
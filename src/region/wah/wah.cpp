@@ -22,10 +22,53 @@
  */
 
 #include <iostream>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
 #include "pique/region/wah/wah.hpp"
 
+// Streams RIDs from the bitvector's index sets, resuming partway through a set (range or list) between batches
+class WAHRIDBatchIterator : public RIDBatchIterator {
+public:
+	WAHRIDBatchIterator(const ibis::bitvector &bits, uint64_t offset) :
+		is(bits.firstIndexSet()), pos_in_set(0), offset(offset)
+	{}
+
+private:
+	virtual void next_batch_impl(std::vector<uint64_t> &out, size_t max_rids) {
+		while (is.nIndices() > 0 && max_rids > 0) {
+			const ibis::bitvector::word_t *ii = is.indices();
+			if (is.isRange()) {
+				// pos_in_set counts RIDs consumed from the range [ii[0], ii[1])
+				for (; ii[0] + pos_in_set < ii[1] && max_rids > 0; ++pos_in_set, --max_rids)
+					out.push_back(ii[0] + pos_in_set + offset);
+				if (ii[0] + pos_in_set < ii[1])
+					return;
+			} else {
+				for (; pos_in_set < is.nIndices() && max_rids > 0; ++pos_in_set, --max_rids)
+					out.push_back(ii[pos_in_set] + offset);
+				if (pos_in_set < is.nIndices())
+					return;
+			}
+
+			++is;
+			pos_in_set = 0;
+		}
+	}
+
+private:
+	ibis::bitvector::indexSet is;
+	ibis::bitvector::word_t pos_in_set;
+	const uint64_t offset;
+};
+
 constexpr RegionEncoding::Type WAHRegionEncoding::TYPE;
 
+auto WAHRegionEncoding::get_region_uniformity() const -> RegionUniformity {
+	const uint64_t count = this->bits.count(); // Only scans the compressed words
+	return count == 0 ? RegionUniformity::EMPTY : count == this->bits.size() ? RegionUniformity::FILLED : RegionUniformity::MIXED;
+}
+
 uint64_t WAHRegionEncoding::get_element_count() const {
 	return this->bits.count();
 }
@@ -58,6 +101,10 @@ void WAHRegionEncoding::convert_to_rids(std::vector< rid_t > &out, uint64_t offs
 	}
 }
 
+boost::shared_ptr< RIDBatchIterator > WAHRegionEncoding::make_rid_iterator(uint64_t offset) const {
+	return boost::make_shared< WAHRIDBatchIterator >(this->bits, offset);
+}
+
 bool WAHRegionEncoding::operator==(const RegionEncoding& other_base) const {
 	if (typeid(other_base) != typeid(WAHRegionEncoding))
 		return false;
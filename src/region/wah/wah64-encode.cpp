@@ -0,0 +1,76 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * wah64-encode.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include "pique/region/wah/wah64-encode.hpp"
+
+WAH64RegionEncoder::WAH64RegionEncoder(WAH64RegionEncoderConfig conf, size_t total_elements) :
+	RegionEncoder< WAH64RegionEncoding, WAH64RegionEncoderConfig >(conf, total_elements),
+	builder(total_elements),
+	cur_literal(0), cur_bits(0),
+	encoding(boost::make_shared< WAH64RegionEncoding >())
+{}
+
+boost::shared_ptr< WAH64RegionEncoding > WAH64RegionEncoder::to_region_encoding() {
+	return this->encoding;
+}
+
+void WAH64RegionEncoder::push_bits_impl(uint64_t count, bool bitval) {
+	const int BITS_PER_GROUP = WAH64RegionEncoding::BITS_PER_GROUP;
+
+	// First, top off the partial group, if any
+	if (cur_bits > 0) {
+		const int take = (int)std::min< uint64_t >(count, BITS_PER_GROUP - cur_bits);
+		if (bitval)
+			cur_literal |= (((word_t)1 << take) - 1) << cur_bits;
+		cur_bits += take;
+		count -= take;
+
+		if (cur_bits < BITS_PER_GROUP)
+			return;
+
+		builder.append_literal(cur_literal);
+		cur_literal = 0;
+		cur_bits = 0;
+	}
+
+	// Then, append all whole groups as a single fill
+	const uint64_t full_groups = count / BITS_PER_GROUP;
+	builder.append_fill(bitval, full_groups);
+	count -= full_groups * BITS_PER_GROUP;
+
+	// Finally, start a new partial group with any leftover bits
+	cur_literal = bitval ? ((word_t)1 << count) - 1 : 0;
+	cur_bits = (int)count;
+}
+
+void WAH64RegionEncoder::finalize_impl() {
+	if (cur_bits > 0) {
+		builder.append_literal(cur_literal);
+		cur_literal = 0;
+		cur_bits = 0;
+	}
+
+	builder.finish_into(*this->encoding);
+}
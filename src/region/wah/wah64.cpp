@@ -0,0 +1,152 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * wah64.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include "pique/region/wah/wah64.hpp"
+
+// Streams RIDs by walking the WAH words, emitting 1-fills as RID ranges and skipping 0-fills wholesale
+class WAH64RIDBatchIterator : public RIDBatchIterator {
+public:
+	using word_t = WAH64RegionEncoding::word_t;
+	static constexpr int BITS_PER_GROUP = WAH64RegionEncoding::BITS_PER_GROUP;
+
+	WAH64RIDBatchIterator(const WAH64RegionEncoding &region, uint64_t offset) :
+		words(region.words), offset(offset),
+		next_word_idx(0), group_pos(0),
+		cur_literal(0), literal_pos(0), range_pos(0), range_end(0)
+	{}
+
+private:
+	virtual void next_batch_impl(std::vector<uint64_t> &out, size_t max_rids) {
+		while (max_rids > 0) {
+			if (cur_literal != 0) {
+				// Emit set bits of the current literal, lowest first
+				for (; cur_literal != 0 && max_rids > 0; cur_literal &= cur_literal - 1, --max_rids)
+					out.push_back(literal_pos + __builtin_ctzll(cur_literal) + offset);
+			} else if (range_pos < range_end) {
+				// Emit the remainder of the current 1-fill
+				for (; range_pos < range_end && max_rids > 0; ++range_pos, --max_rids)
+					out.push_back(range_pos + offset);
+			} else {
+				if (next_word_idx >= words.size())
+					return;
+
+				const word_t word = words[next_word_idx++];
+				if (word & WAH64RegionEncoding::FILL_FLAG) {
+					const uint64_t fill_bits = (word & WAH64RegionEncoding::FILL_LENGTH_MASK) * BITS_PER_GROUP;
+					if (word & WAH64RegionEncoding::FILL_BIT_FLAG) {
+						range_pos = group_pos;
+						range_end = group_pos + fill_bits;
+					}
+					group_pos += fill_bits;
+				} else {
+					cur_literal = word;
+					literal_pos = group_pos;
+					group_pos += BITS_PER_GROUP;
+				}
+			}
+		}
+	}
+
+private:
+	const std::vector< word_t > &words;
+	const uint64_t offset;
+
+	size_t next_word_idx;
+	uint64_t group_pos; // Position of the first bit of the group following the last-visited word
+
+	word_t cur_literal; // Remaining (unemitted) bits of the current literal
+	uint64_t literal_pos;
+	uint64_t range_pos, range_end; // Remaining (unemitted) RIDs of the current 1-fill
+};
+
+constexpr RegionEncoding::Type WAH64RegionEncoding::TYPE;
+constexpr int WAH64RegionEncoding::BITS_PER_GROUP;
+constexpr WAH64RegionEncoding::word_t WAH64RegionEncoding::FILL_FLAG;
+constexpr WAH64RegionEncoding::word_t WAH64RegionEncoding::FILL_BIT_FLAG;
+constexpr WAH64RegionEncoding::word_t WAH64RegionEncoding::FILL_LENGTH_MASK;
+constexpr WAH64RegionEncoding::word_t WAH64RegionEncoding::LITERAL_MASK;
+
+WAH64RegionEncoding::WAH64RegionEncoding(uint64_t nelem, bool filled) :
+	RegionEncoding(nelem), nset(0), words()
+{
+	Builder builder(nelem);
+	builder.append_fill(filled, groups_for(nelem));
+	builder.finish_into(*this);
+}
+
+void WAH64RegionEncoding::dump() const {
+	std::cout << "Domain size: " << this->domain_size << ", element count: " << this->nset << std::endl;
+	for (word_t word : this->words) {
+		if (word & FILL_FLAG)
+			std::cout << "F" << ((word & FILL_BIT_FLAG) ? 1 : 0) << "x" << (word & FILL_LENGTH_MASK) << " ";
+		else
+			std::cout << "L" << std::hex << std::setw(16) << std::setfill('0') << word << std::dec << " ";
+	}
+	std::cout << std::endl;
+}
+
+void WAH64RegionEncoding::convert_to_rids(std::vector<uint32_t>& out, bool sorted, bool preserve_self) {
+	this->convert_to_rids< uint32_t, false >(out, 0);
+}
+void WAH64RegionEncoding::convert_to_rids(std::vector<uint64_t>& out, uint64_t offset, bool sorted, bool preserve_self) {
+	this->convert_to_rids< uint64_t, true >(out, offset);
+}
+
+template<typename rid_t, bool has_offset>
+void WAH64RegionEncoding::convert_to_rids(std::vector< rid_t > &out, uint64_t offset) const {
+	out.clear();
+	out.reserve(this->nset);
+
+	const uint64_t base = has_offset ? offset : 0;
+	uint64_t group_pos = 0;
+	for (word_t word : this->words) {
+		if (word & FILL_FLAG) {
+			const uint64_t fill_bits = (word & FILL_LENGTH_MASK) * BITS_PER_GROUP;
+			if (word & FILL_BIT_FLAG)
+				for (uint64_t rid = group_pos; rid < group_pos + fill_bits; ++rid)
+					out.push_back(rid + base);
+			group_pos += fill_bits;
+		} else {
+			for (; word != 0; word &= word - 1)
+				out.push_back(group_pos + __builtin_ctzll(word) + base);
+			group_pos += BITS_PER_GROUP;
+		}
+	}
+}
+
+boost::shared_ptr< RIDBatchIterator > WAH64RegionEncoding::make_rid_iterator(uint64_t offset) const {
+	return boost::make_shared< WAH64RIDBatchIterator >(*this, offset);
+}
+
+bool WAH64RegionEncoding::operator==(const RegionEncoding& other_base) const {
+	if (typeid(other_base) != typeid(WAH64RegionEncoding))
+		return false;
+	const WAH64RegionEncoding &other = dynamic_cast<const WAH64RegionEncoding&>(other_base);
+
+	// The encoding is canonical, so equal sets have identical words
+	return this->domain_size == other.domain_size && this->words == other.words;
+}
@@ -21,6 +21,7 @@
  *      Author: David A. Boyuka II
  */
 
+#include <algorithm>
 #include <type_traits>
 #include <vector>
 
@@ -29,91 +30,108 @@
 #include <boost/optional.hpp>
 
 #include "pique/region/cblq/cblq.hpp"
+#include "pique/region/cblq/cblq-word-ops.hpp"
 #include "pique/setops/cblq/cblq-setops.hpp"
 
-// Special values needed for optimization below
-// -2 -> 0 | 2, -1 -> 1 | 2, 0 -> 2 | 2, 1 -> 2 | 1, 2 -> 2 | 0
-// -2 -> COPY_R, -1 -> DELETE_R, 0 -> UNION, 1 -> DELETE_L, 2 -> COPY_L
-enum struct cblq_union_action_t { COPY_R = -2, DELETE_R = -1, UNION = 0, DELETE_L = 1, COPY_L = 2, };
+// Actions queued for each 2-code in either operand. A unary action applies to the whole subtree beneath a 2-code
+// in one operand (where the other operand has a 0- or 1-code); BINARY recurses into the subtrees of both operands
+enum struct cblq_fast_action_t { BINARY, COPY_L, DELETE_L, COPY_R, DELETE_R, COMPLEMENT_R, };
 
 struct cblq_action_block_t {
-	cblq_action_block_t() : action(cblq_union_action_t::UNION), count(0) {}
-	cblq_action_block_t(cblq_union_action_t action, size_t count) :
+	cblq_action_block_t() : action(cblq_fast_action_t::BINARY), count(0) {}
+	cblq_action_block_t(cblq_fast_action_t action, size_t count) :
 		action(action), count(count)
 	{}
-	cblq_union_action_t action;
+	cblq_fast_action_t action;
 	size_t count;
 };
 
-template<int ndim>
-inline static int count_two_codes(typename CBLQRegionEncoding<ndim>::cblq_word_t word) {
-	int count = 0;
-	for (int i = 0; i < CBLQRegionEncoding<ndim>::CODES_PER_WORD; i++) {
-		count += (word & 0b10);
-		word >>= CBLQRegionEncoding<ndim>::BITS_PER_CODE;
+// Enqueues an action, coalescing it into the previous block if both are the same unary action (since the
+// subtrees they cover are adjacent at every lower level, they can be processed as a single run of words)
+inline static void enqueue_action(
+		cblq_fast_action_t action, size_t count,
+		typename std::vector< cblq_action_block_t >::iterator actionqueue_begin,
+		typename std::vector< cblq_action_block_t >::iterator &actionqueue_out_it)
+{
+	if (action != cblq_fast_action_t::BINARY && actionqueue_out_it != actionqueue_begin && (actionqueue_out_it - 1)->action == action) {
+		(actionqueue_out_it - 1)->count += count;
+	} else {
+		*actionqueue_out_it = cblq_action_block_t(action, count);
+		++actionqueue_out_it;
 	}
-	return count >> 1; // Divide by 2, since each 2-code added 2
 }
 
-template<int ndim, cblq_union_action_t inaction>
+template<int ndim, cblq_fast_action_t inaction>
 inline static void apply_unary_action_helper(
 		size_t count,
 		typename std::vector< typename CBLQRegionEncoding<ndim>::cblq_word_t >::const_iterator &in_it,
 		typename std::vector< typename CBLQRegionEncoding<ndim>::cblq_word_t >::iterator &out_it,
+		typename std::vector< cblq_action_block_t >::iterator actionqueue_begin,
 		typename std::vector< cblq_action_block_t >::iterator &actionqueue_out_it)
 {
-	typedef typename CBLQRegionEncoding<ndim>::cblq_word_t cblq_word_t;
-	size_t children = 0;
-	do {
-		const cblq_word_t in_word = *in_it;
-		++in_it;
-		if (inaction == cblq_union_action_t::COPY_L || inaction == cblq_union_action_t::COPY_R) {
-			*out_it = in_word;
-			++out_it;
-		}
-		children += count_two_codes<ndim>(in_word);
-	} while (--count > 0);
-
-	if (children) {
-		*actionqueue_out_it = cblq_action_block_t(inaction, children);
-		++actionqueue_out_it;
+	using word_ops = CBLQWordOps<ndim>;
+
+	// Process the whole run of words at once: copy/complement it (unless deleting), and count its 2-codes (which
+	// are unchanged by complementing), each of which inherits this action at the next level
+	if (inaction == cblq_fast_action_t::COPY_L || inaction == cblq_fast_action_t::COPY_R) {
+		out_it = std::copy(in_it, in_it + count, out_it);
+	} else if (inaction == cblq_fast_action_t::COMPLEMENT_R) {
+		word_ops::complement_run(&*in_it, &*out_it, count);
+		out_it += count;
 	}
+
+	const uint64_t children = word_ops::count_two_codes_run(&*in_it, count);
+	in_it += count;
+
+	if (children)
+		enqueue_action(inaction, children, actionqueue_begin, actionqueue_out_it);
 }
 
-template<int ndim>
-inline static void apply_union_helper(
+template<int ndim, NArySetOperation op>
+inline static void apply_binary_helper(
 		typename std::vector< typename CBLQRegionEncoding<ndim>::cblq_word_t >::const_iterator &left_it,
 		typename std::vector< typename CBLQRegionEncoding<ndim>::cblq_word_t >::const_iterator &right_it,
 		typename std::vector< typename CBLQRegionEncoding<ndim>::cblq_word_t >::iterator &out_it,
+		typename std::vector< cblq_action_block_t >::iterator actionqueue_begin,
 		typename std::vector< cblq_action_block_t >::iterator &actionqueue_out_it)
 {
 	typedef typename CBLQRegionEncoding<ndim>::cblq_word_t cblq_word_t;
+	using word_ops = CBLQWordOps<ndim>;
 
-	cblq_word_t left_word = *left_it;
-	cblq_word_t right_word = *right_it;
+	const cblq_word_t left_word = *left_it;
+	const cblq_word_t right_word = *right_it;
 	++left_it;
 	++right_it;
 
-	cblq_word_t or_word = left_word | right_word; // 0/1 U 0/1 -> 0/1, 0 U 2 -> 2, 2 U 2 -> 2, 1 U 2 -> 3 (fix this)
-	const cblq_word_t out_word = or_word & ~((or_word & CBLQRegionEncoding<ndim>::ONE_CODES_WORD) << 1); // Masks out 2's with a mask created from the 1's
-	*out_it = out_word;
+	switch (op) {
+	case NArySetOperation::UNION:        *out_it = word_ops::union_word(left_word, right_word); break;
+	case NArySetOperation::INTERSECTION: *out_it = word_ops::intersect_word(left_word, right_word); break;
+	case NArySetOperation::DIFFERENCE:   *out_it = word_ops::difference_word(left_word, right_word); break;
+	default: abort();
+	}
 	++out_it;
 
-	// Search for 2-codes in both words in parallel, and queue actions if found
-	for (int codepos = 0; codepos < CBLQRegionEncoding<ndim>::CODES_PER_WORD; codepos++) {
-		if (or_word & 0b10) {
-			// -2 -> 0 | 2, -1 -> 1 | 2, 0 -> 2 | 2, 1 -> 2 | 1, 2 -> 2 | 0
-			// -2 -> COPY_R, -1 -> DELETE_R, 0 -> UNION, 1 -> DELETE_L, 2 -> DELETE_R
-			const cblq_union_action_t codediff_action = (cblq_union_action_t)((int64_t)(left_word & 0b11) - (int64_t)(right_word & 0b11));
-			*actionqueue_out_it = cblq_action_block_t(codediff_action, 1);
-			++actionqueue_out_it;
-		}
-		if (codepos < CBLQRegionEncoding<ndim>::CODES_PER_WORD - 1) {
-			left_word >>= CBLQRegionEncoding<ndim>::BITS_PER_CODE;
-			right_word >>= CBLQRegionEncoding<ndim>::BITS_PER_CODE;
-			or_word >>= CBLQRegionEncoding<ndim>::BITS_PER_CODE;
-		}
-	}
+	// Classify all codes at once. Where only one operand has a 2-code, the other operand's code decides whether that
+	// subtree is kept or dropped: 2 U 0, 2 & 1, 2 - 0 keep the left subtree; 0 U 2, 1 & 2 keep, and 1 - 2 complements, the right one
+	const cblq_word_t left_twos = word_ops::two_mask(left_word);
+	const cblq_word_t right_twos = word_ops::two_mask(right_word);
+	const cblq_word_t binary_mask = left_twos & right_twos;
+	const cblq_word_t keep_left_mask = left_twos & (op == NArySetOperation::INTERSECTION ? word_ops::one_mask(right_word) : word_ops::zero_mask(right_word));
+	const cblq_word_t keep_right_mask = right_twos & (op == NArySetOperation::UNION ? word_ops::zero_mask(left_word) : word_ops::one_mask(left_word));
+	constexpr cblq_fast_action_t KEEP_R_ACTION = (op == NArySetOperation::DIFFERENCE ? cblq_fast_action_t::COMPLEMENT_R : cblq_fast_action_t::COPY_R);
+
+	// Visit only the 2-codes, in order, queuing one action for each
+	word_ops::for_each_code_in_mask(left_twos | right_twos, [&](int code_pos) {
+		const cblq_word_t code_bit = (cblq_word_t)1 << (code_pos * CBLQRegionEncoding<ndim>::BITS_PER_CODE);
+		cblq_fast_action_t action;
+		if (binary_mask & code_bit)
+			action = cblq_fast_action_t::BINARY;
+		else if (left_twos & code_bit)
+			action = (keep_left_mask & code_bit) ? cblq_fast_action_t::COPY_L : cblq_fast_action_t::DELETE_L;
+		else
+			action = (keep_right_mask & code_bit) ? KEEP_R_ACTION : cblq_fast_action_t::DELETE_R;
+		enqueue_action(action, 1, actionqueue_begin, actionqueue_out_it);
+	});
 }
 
 template<typename block_t>
@@ -177,8 +195,26 @@ inline static void skip_bits(
 	} while (scount > 0);
 }
 
-template<int ndim, typename semiword_block_t>
-inline static void binary_union_set_op(
+// Appends one semiword (with no bits set beyond its width) to the output bits. Semiwords are never split across
+// blocks, since the output is always semiword-aligned and semiwords evenly divide blocks
+template<typename block_t>
+inline static void put_semiword(
+		block_t semiword, int semiword_bits,
+		typename std::vector< block_t >::iterator &out_bits, block_t &out_headblock, int &out_shift_remaining)
+{
+	const int BITS_PER_BLOCK = (sizeof(block_t) << 3);
+	out_headblock |= (semiword << (BITS_PER_BLOCK - out_shift_remaining));
+	out_shift_remaining -= semiword_bits;
+	if (out_shift_remaining == 0) {
+		*out_bits = out_headblock;
+		++out_bits;
+		out_shift_remaining = BITS_PER_BLOCK;
+		out_headblock = 0;
+	}
+}
+
+template<int ndim, NArySetOperation op, typename semiword_block_t>
+inline static void binary_set_op(
 		bool has_dense_suffix, int non_dense_levels,
 		typename std::vector< typename CBLQRegionEncoding<ndim>::cblq_word_t >::const_iterator &left_it,
 		typename std::vector< typename CBLQRegionEncoding<ndim>::cblq_word_t >::const_iterator &right_it,
@@ -191,37 +227,40 @@ inline static void binary_union_set_op(
 {
 	typedef typename CBLQRegionEncoding<ndim>::cblq_word_t cblq_word_t;
 	std::vector< cblq_action_block_t > this_actionqueue;
-	std::vector< cblq_action_block_t > next_actionqueue = { cblq_action_block_t(cblq_union_action_t::UNION, 1) };
+	std::vector< cblq_action_block_t > next_actionqueue = { cblq_action_block_t(cblq_fast_action_t::BINARY, 1) };
 
     for (int level = 0; level < non_dense_levels; level++) {
     	this_actionqueue = std::move(next_actionqueue);
     	next_actionqueue.clear();
-    	next_actionqueue.resize(this_actionqueue.size() * CBLQRegionEncoding<ndim>::CODES_PER_WORD + 1); // All cblq_action_block_t's default to is_copy=false and left/right_count = 0
+    	next_actionqueue.resize(this_actionqueue.size() * CBLQRegionEncoding<ndim>::CODES_PER_WORD + 1); // All cblq_action_block_t's default to BINARY with count = 0
+    	const auto next_actionqueue_begin = next_actionqueue.begin();
     	auto next_actionqueue_out_it = next_actionqueue.begin();
 
-    	//const size_t level_len = this_actionqueue.size(); // not needed
     	const typename std::vector<cblq_word_t>::iterator out_it_before_level = out_it;
 
     	for (auto it = this_actionqueue.cbegin(), end_it = this_actionqueue.cend(); it != end_it; ++it) {
     		const cblq_action_block_t &curaction = *it;
-    		const cblq_union_action_t action = curaction.action;
+    		const cblq_fast_action_t action = curaction.action;
     		const size_t count = curaction.count;
 
     		switch (action) {
-    		case cblq_union_action_t::UNION:
-    			apply_union_helper<ndim>(left_it, right_it, out_it, next_actionqueue_out_it);
+    		case cblq_fast_action_t::BINARY:
+    			apply_binary_helper<ndim, op>(left_it, right_it, out_it, next_actionqueue_begin, next_actionqueue_out_it);
     			break;
-    		case cblq_union_action_t::DELETE_L:
-    			apply_unary_action_helper<ndim, cblq_union_action_t::DELETE_L>(count, left_it, out_it, next_actionqueue_out_it);
+    		case cblq_fast_action_t::DELETE_L:
+    			apply_unary_action_helper<ndim, cblq_fast_action_t::DELETE_L>(count, left_it, out_it, next_actionqueue_begin, next_actionqueue_out_it);
     			break;
-    		case cblq_union_action_t::DELETE_R:
-    			apply_unary_action_helper<ndim, cblq_union_action_t::DELETE_R>(count, right_it, out_it, next_actionqueue_out_it);
+    		case cblq_fast_action_t::DELETE_R:
+    			apply_unary_action_helper<ndim, cblq_fast_action_t::DELETE_R>(count, right_it, out_it, next_actionqueue_begin, next_actionqueue_out_it);
     			break;
-    		case cblq_union_action_t::COPY_L:
-    			apply_unary_action_helper<ndim, cblq_union_action_t::COPY_L>(count, left_it, out_it, next_actionqueue_out_it);
+    		case cblq_fast_action_t::COPY_L:
+    			apply_unary_action_helper<ndim, cblq_fast_action_t::COPY_L>(count, left_it, out_it, next_actionqueue_begin, next_actionqueue_out_it);
     			break;
-    		case cblq_union_action_t::COPY_R:
-    			apply_unary_action_helper<ndim, cblq_union_action_t::COPY_R>(count, right_it, out_it, next_actionqueue_out_it);
+    		case cblq_fast_action_t::COPY_R:
+    			apply_unary_action_helper<ndim, cblq_fast_action_t::COPY_R>(count, right_it, out_it, next_actionqueue_begin, next_actionqueue_out_it);
+    			break;
+    		case cblq_fast_action_t::COMPLEMENT_R:
+    			apply_unary_action_helper<ndim, cblq_fast_action_t::COMPLEMENT_R>(count, right_it, out_it, next_actionqueue_begin, next_actionqueue_out_it);
     			break;
     		}
     	}
@@ -235,6 +274,9 @@ inline static void binary_union_set_op(
 
     if (has_dense_suffix) {
     	const int BITS_PER_BLOCK = (sizeof(semiword_block_t) << 3);
+    	const int BITS_PER_SEMIWORD = CBLQRegionEncoding<ndim>::BITS_PER_SEMIWORD;
+    	const semiword_block_t SEMIWORD_MASK = ((semiword_block_t)1 << BITS_PER_SEMIWORD) - 1;
+
     	// Invariants: left/right/out_denseit always points to where the corresponding headblock came from/is going to
     	semiword_block_t left_headblock = *left_denseit;
     	semiword_block_t right_headblock = *right_denseit;
@@ -243,42 +285,60 @@ inline static void binary_union_set_op(
     	int right_shift_remaining = BITS_PER_BLOCK;
     	int out_shift_remaining = BITS_PER_BLOCK;
 
-    	//typename std::remove_reference<decltype(out_denseit)>::type			out_denseit_save;
-    	//typename std::remove_reference<decltype(out_shift_remaining)>::type	out_shift_remaining_save;
-
     	for (auto it = next_actionqueue.cbegin(), end_it = next_actionqueue.cend(); it != end_it; ++it) {
     		const cblq_action_block_t &curaction = *it;
-    		const cblq_union_action_t action = curaction.action;
-    		const size_t count_in_bits = curaction.count * CBLQRegionEncoding<ndim>::BITS_PER_SEMIWORD;
+    		const cblq_fast_action_t action = curaction.action;
+    		const size_t count_in_bits = curaction.count * BITS_PER_SEMIWORD;
 
     		switch (action) {
-    		case cblq_union_action_t::UNION:
+    		case cblq_fast_action_t::BINARY:
+    			if (op != NArySetOperation::UNION) {
+    				// BINARY always has count exactly 1, so combine the two semiwords directly
+    				const semiword_block_t left_semiword = left_headblock & SEMIWORD_MASK;
+    				const semiword_block_t right_semiword = right_headblock & SEMIWORD_MASK;
+    				skip_bits(BITS_PER_SEMIWORD, left_denseit, left_headblock, left_shift_remaining);
+    				skip_bits(BITS_PER_SEMIWORD, right_denseit, right_headblock, right_shift_remaining);
+
+    				const semiword_block_t out_semiword =
+    						(op == NArySetOperation::INTERSECTION) ?
+    								(left_semiword & right_semiword) :
+    								(left_semiword & ~right_semiword);
+    				put_semiword(out_semiword, BITS_PER_SEMIWORD, out_denseit, out_headblock, out_shift_remaining);
+    				break;
+    			}
     			// For union, just copy both left and right, since they OR into the same buffer
     			/* no break */
-    		case cblq_union_action_t::COPY_L:
+    		case cblq_fast_action_t::COPY_L:
     			// copy (OR) the bits from the left buffer into the out buffer
     			copy_bits(count_in_bits, left_denseit, left_headblock, left_shift_remaining, out_denseit, out_headblock, out_shift_remaining);
-    			if (action == cblq_union_action_t::COPY_L)
+    			if (action == cblq_fast_action_t::COPY_L)
     				break;
 
-    			// If we get here, ut was really UNION, so reset the out pointer and fall through to COPY_R
-    			if (out_shift_remaining == BITS_PER_BLOCK) { // We just wrapped around to a new block (since UNION always has count exactly 1)
+    			// If we get here, it was really a union, so reset the out pointer and fall through to COPY_R
+    			if (out_shift_remaining == BITS_PER_BLOCK) { // We just wrapped around to a new block (since BINARY always has count exactly 1)
     				--out_denseit;
     				out_headblock = *out_denseit;
-    				out_shift_remaining = CBLQRegionEncoding<ndim>::BITS_PER_SEMIWORD;
+    				out_shift_remaining = BITS_PER_SEMIWORD;
     			} else {
-    				out_shift_remaining += CBLQRegionEncoding<ndim>::BITS_PER_SEMIWORD;
+    				out_shift_remaining += BITS_PER_SEMIWORD;
     			}
     			/* no break */
-    		case cblq_union_action_t::COPY_R:
+    		case cblq_fast_action_t::COPY_R:
     			// copy (OR) the bits from the right buffer into the out buffer
     			copy_bits(count_in_bits, right_denseit, right_headblock, right_shift_remaining, out_denseit, out_headblock, out_shift_remaining);
     			break;
-    		case cblq_union_action_t::DELETE_L:
+    		case cblq_fast_action_t::COMPLEMENT_R:
+    			for (size_t i = 0; i < curaction.count; ++i) {
+    				const semiword_block_t right_semiword = right_headblock & SEMIWORD_MASK;
+    				skip_bits(BITS_PER_SEMIWORD, right_denseit, right_headblock, right_shift_remaining);
+    				put_semiword((semiword_block_t)(~right_semiword & SEMIWORD_MASK), BITS_PER_SEMIWORD, out_denseit, out_headblock, out_shift_remaining);
+    			}
+    			break;
+    		case cblq_fast_action_t::DELETE_L:
     			// skip the appropriate number of bits in the left buffer
     			skip_bits(count_in_bits, left_denseit, left_headblock, left_shift_remaining);
     			break;
-    		case cblq_union_action_t::DELETE_R:
+    		case cblq_fast_action_t::DELETE_R:
     			// skip the appropriate number of bits in the right buffer
     			skip_bits(count_in_bits, right_denseit, right_headblock, right_shift_remaining);
     			break;
@@ -317,12 +377,7 @@ CBLQSetOperationsFast<ndim>::unary_set_op_impl(boost::shared_ptr< const CBLQRegi
 	switch (op) {
 	case UnarySetOperation::COMPLEMENT:
 	{
-		auto in_it = in_cblq.cbegin();
-		auto out_it = out_cblq.begin();
-		for (; in_it != in_cblq.cend(); ++in_it, ++out_it) {
-			const cblq_word_t word = *in_it;
-			*out_it = word ^ ((word & CBLQRegionEncoding<ndim>::TWO_CODES_WORD) >> 1) ^ CBLQRegionEncoding<ndim>::ONE_CODES_WORD; // 0->1, 1->0, 2->2
-		}
+		CBLQWordOps<ndim>::complement_run(in_cblq.data(), out_cblq.data(), in_cblq.size()); // 0->1, 1->0, 2->2
 
 		if (has_dense_suffix) {
 			for (auto in_it = in_dense.semiwords.begin(), out_it = out_dense.semiwords.begin(); in_it != in_dense.semiwords.end(); ++in_it, ++out_it) {
@@ -342,8 +397,8 @@ CBLQSetOperationsFast<ndim>::unary_set_op_impl(boost::shared_ptr< const CBLQRegi
 template<int ndim>
 boost::shared_ptr< CBLQRegionEncoding<ndim> >
 CBLQSetOperationsFast<ndim>::binary_set_op_impl(boost::shared_ptr< const CBLQRegionEncoding<ndim> > left, boost::shared_ptr< const CBLQRegionEncoding<ndim> > right, NArySetOperation op) const {
-	if (op != NArySetOperation::UNION)
-		return this->template CBLQSetOperations<ndim>::binary_set_op_impl(left, right, op); // Delegate upward if this isn't a union
+	if (op != NArySetOperation::UNION && op != NArySetOperation::INTERSECTION && op != NArySetOperation::DIFFERENCE)
+		return this->template CBLQSetOperations<ndim>::binary_set_op_impl(left, right, op); // Delegate upward for symmetric difference
 
 	assert(left->get_domain_size() == right->get_domain_size());
 	assert(left->get_num_levels() == right->get_num_levels());
@@ -389,7 +444,13 @@ CBLQSetOperationsFast<ndim>::binary_set_op_impl(boost::shared_ptr< const CBLQReg
 
 	switch (op) {
 	case NArySetOperation::UNION:
-		binary_union_set_op< ndim, typename CBLQSemiwords<ndim>::block_t >(has_dense_suffix, non_dense_levels, left_it, right_it, out_it, left_denseit, right_denseit, out_denseit, out_dense_remaining_bits, output->level_lens);
+		binary_set_op< ndim, NArySetOperation::UNION, typename CBLQSemiwords<ndim>::block_t >(has_dense_suffix, non_dense_levels, left_it, right_it, out_it, left_denseit, right_denseit, out_denseit, out_dense_remaining_bits, output->level_lens);
+		break;
+	case NArySetOperation::INTERSECTION:
+		binary_set_op< ndim, NArySetOperation::INTERSECTION, typename CBLQSemiwords<ndim>::block_t >(has_dense_suffix, non_dense_levels, left_it, right_it, out_it, left_denseit, right_denseit, out_denseit, out_dense_remaining_bits, output->level_lens);
+		break;
+	case NArySetOperation::DIFFERENCE:
+		binary_set_op< ndim, NArySetOperation::DIFFERENCE, typename CBLQSemiwords<ndim>::block_t >(has_dense_suffix, non_dense_levels, left_it, right_it, out_it, left_denseit, right_denseit, out_denseit, out_dense_remaining_bits, output->level_lens);
 		break;
 	default:
 		abort();
@@ -411,7 +472,8 @@ CBLQSetOperationsFast<ndim>::binary_set_op_impl(boost::shared_ptr< const CBLQReg
     return output;
 }
 
-// Explicit instantiation of 2D-4D CBLQ set ops
+// Explicit instantiation of 1D-4D CBLQ set ops
+template class CBLQSetOperationsFast<1>;
 template class CBLQSetOperationsFast<2>;
 template class CBLQSetOperationsFast<3>;
 template class CBLQSetOperationsFast<4>;
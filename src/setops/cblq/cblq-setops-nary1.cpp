@@ -169,7 +169,8 @@ CBLQSetOperationsNAry1<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter cblq_it,
 	return output;
 }
 
-// Explicit instantiation of 2D-4D CBLQ N-ary set operations
+// Explicit instantiation of 1D-4D CBLQ N-ary set operations
+template class CBLQSetOperationsNAry1<1>;
 template class CBLQSetOperationsNAry1<2>;
 template class CBLQSetOperationsNAry1<3>;
 template class CBLQSetOperationsNAry1<4>;
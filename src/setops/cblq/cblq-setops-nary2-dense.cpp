@@ -250,7 +250,8 @@ CBLQSetOperationsNAry2Dense<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter cblq
 	return output;
 }
 
-// Explicit instantiation of 2D-4D CBLQ N-ary set operations
+// Explicit instantiation of 1D-4D CBLQ N-ary set operations
+template class CBLQSetOperationsNAry2Dense<1>;
 template class CBLQSetOperationsNAry2Dense<2>;
 template class CBLQSetOperationsNAry2Dense<3>;
 template class CBLQSetOperationsNAry2Dense<4>;
@@ -32,6 +32,7 @@
 #include <boost/iterator/counting_iterator.hpp>
 
 #include "pique/region/cblq/cblq.hpp"
+#include "pique/region/cblq/cblq-word-ops.hpp"
 #include "pique/setops/setops.hpp"
 #include "pique/setops/cblq/cblq-setops.hpp"
 
@@ -300,16 +301,14 @@ CBLQSetOperationsNAry3Dense<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter cblq
 				const size_t outind = *outind_it;
 				const cblq_word_t oper_cblq_word = *cblq_word_it++;
 
-				unpack_cblq_word<ndim>(oper_cblq_word, oper_cblq_codes);
-
 				// If this is a DELETE action, enqueue DELETEs for all children, then skip any further processing
 				if (outind == -1) {
-					for (int code_pos = 0; code_pos < CBLQRegionEncoding<ndim>::CODES_PER_WORD; code_pos++)
-						if (oper_cblq_codes[code_pos] == 0b10)
-							output_outinds.push_back(-1);
+					output_outinds.insert(output_outinds.end(), (size_t)CBLQWordOps<ndim>::count_two_codes(oper_cblq_word), (size_t)-1);
 					continue;
 				}
 
+				unpack_cblq_word<ndim>(oper_cblq_word, oper_cblq_codes);
+
 				cblq_word_t &state_cblq_word = level_cblq_words[outind];
 				nary_action_compact_t *state_action_word = &level_actions[outind * CBLQRegionEncoding<ndim>::CODES_PER_WORD];
 
@@ -453,7 +452,8 @@ CBLQSetOperationsNAry3Dense<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter cblq
 	return output;
 }
 
-// Explicit instantiation of 2D-4D CBLQ N-ary set operations
+// Explicit instantiation of 1D-4D CBLQ N-ary set operations
+template class CBLQSetOperationsNAry3Dense<1>;
 template class CBLQSetOperationsNAry3Dense<2>;
 template class CBLQSetOperationsNAry3Dense<3>;
 template class CBLQSetOperationsNAry3Dense<4>;
@@ -23,7 +23,11 @@
 
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <thread>
 #include <vector>
 
 #include <boost/smart_ptr.hpp>
@@ -32,6 +36,8 @@
 #include <boost/iterator/counting_iterator.hpp>
 
 #include "pique/region/cblq/cblq.hpp"
+#include "pique/region/cblq/cblq-word-ops.hpp"
+#include "pique/util/run-tasks.hpp"
 #include "pique/setops/setops.hpp"
 #include "pique/setops/cblq/cblq-setops.hpp"
 
@@ -71,19 +77,6 @@ void child_ind_helper::ensure_init() {
 	CHILD_IND_TABLE_INIT = true;
 }
 
-template<int ndim>
-inline static int count_two_codes(typename CBLQRegionEncoding<ndim>::cblq_word_t word) {
-	static constexpr int NUM_LOOKUPS = (CBLQRegionEncoding<ndim>::CODES_PER_WORD - 1) / child_ind_helper::CODES_PER_LOOKUP + 1;
-
-	int children = 0;
-	for (int i = 0; i < NUM_LOOKUPS; ++i) {
-		const typename child_ind_helper::lookup_index_t lookup_key = ((word >> (i * child_ind_helper::BITS_PER_LOOKUP)) & child_ind_helper::LOOKUP_MASK);
-		children += child_ind_helper::CHILD_IND_TABLE[lookup_key].nchildren;
-	}
-
-	return children;
-}
-
 template<int ndim>
 inline static void append_child_inds(typename CBLQRegionEncoding<ndim>::cblq_word_t word, uint64_t base_ind, typename std::vector< int64_t >::iterator &out_inds_it) {
 	static constexpr int NUM_LOOKUPS = (CBLQRegionEncoding<ndim>::CODES_PER_WORD - 1) / child_ind_helper::CODES_PER_LOOKUP + 1;
@@ -172,10 +165,11 @@ inline static void level_postprocess(
 				abort();
 			*scan_word_it = word;
 
-			for (int codepos = 0; codepos < CBLQRegionEncoding<ndim>::CODES_PER_WORD; ++codepos, ++cur_ind) {
-				if (word & 0b10 << (codepos * CBLQRegionEncoding<ndim>::BITS_PER_CODE))
-					ind_mapping[cur_ind] = mapped_ind++;
-			}
+			// Assign consecutive mapped inds to the 2-codes only, visiting them directly rather than scanning every code
+			CBLQWordOps<ndim>::for_each_code_in_mask(CBLQWordOps<ndim>::two_mask(word), [&ind_mapping, &mapped_ind, cur_ind](int codepos) {
+				ind_mapping[cur_ind + codepos] = mapped_ind++;
+			});
+			cur_ind += CBLQRegionEncoding<ndim>::CODES_PER_WORD;
 		}
 
 		// Densely remap all outinds produced
@@ -199,66 +193,70 @@ inline static void level_postprocess(
 }
 
 template<int ndim>
-template<NArySetOperation op>
-inline boost::shared_ptr< CBLQRegionEncoding<ndim> >
-CBLQSetOperationsNAry3Fast<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter cblq_it, RegionEncodingCPtrCIter cblq_end_it) const {
+bool CBLQSetOperationsNAry3Fast<ndim>::prepare_operands(RegionEncodingCPtrCIter cblq_it, RegionEncodingCPtrCIter cblq_end_it, std::vector< const CBLQRegionEncoding<ndim> * > &operands, std::vector< OperandSpan > &spans) {
 	const boost::optional< bool > common_has_dense_suffix = CBLQRegionEncoding<ndim>::deduce_common_suffix_density(cblq_it, cblq_end_it);
 	assert(common_has_dense_suffix); // all operands must have compatible suffix density (i.e., each the same/empty)
 
-	const int levels = (*cblq_it)->get_num_levels();
 	const bool has_dense_suffix = *common_has_dense_suffix;
-	const int non_dense_levels = has_dense_suffix ? levels - 1 : levels;
+	const int levels = (*cblq_it)->get_num_levels();
 	const uint64_t domain_size = (*cblq_it)->get_domain_size();
 
-	// Initialize iterators to traverse through the words of each CBLQ operand passed to this function (as well as the implicit "this" CBLQ)
-	size_t num_operands = 0;
-	std::vector< typename std::vector<cblq_word_t>::const_iterator > cblq_word_its;
-	std::vector< typename std::vector<cblq_word_t>::const_iterator > cblq_word_end_its;
-	std::vector< typename std::vector<uint64_t>::const_iterator > cblq_level_len_its;
 	for (auto it = cblq_it; it != cblq_end_it; it++) {
 		const CBLQRegionEncoding<ndim> &cblq = **it; // first * = deref iterator, second * = deref pointer to CBLQ that the iterator was holding
-		// Ensure uniform level count and suffix denseness across all CBLQs
+		// Ensure uniform level count and domain size across all CBLQs
 		assert(cblq.get_num_levels() == levels);
-		//assert(cblq.has_dense_suffix == has_dense_suffix); // now checked above
 		assert(cblq.domain_size == domain_size);
 
-		num_operands++;
-		cblq_word_its.push_back(cblq.words.cbegin());
-		cblq_word_end_its.push_back(cblq.words.cend());
-		cblq_level_len_its.push_back(cblq.level_lens.cbegin());
-	}
+		OperandSpan span;
+		uint64_t level_word_begin = 0;
+		for (size_t level_len : cblq.level_lens) {
+			span.level_word_begins.push_back(level_word_begin);
+			span.level_word_counts.push_back(level_len);
+			level_word_begin += level_len;
+		}
+		span.dense_begin = 0;
+		span.dense_count = cblq.dense_suffix->get_num_semiwords();
 
-	// Allocate a new CBLQ for output
-	boost::shared_ptr< CBLQRegionEncoding<ndim> > output = boost::make_shared< CBLQRegionEncoding<ndim> >(domain_size);
-	output->has_dense_suffix = has_dense_suffix;
-	output->level_lens.resize(levels);
+		if (has_dense_suffix)
+			cblq.dense_suffix->ensure_padded(); // The dense suffix processing may read one block past the end
 
-	std::vector<cblq_word_t> &output_words = output->words;
+		operands.push_back(&cblq);
+		spans.push_back(std::move(span));
+	}
 
-	// Input operand target index array. Produced in the previous step, indicates which output CBLQ word should be modified by each input word
-	// Outind arrays are packed back-to-back, since it is known how many belong to each operand (= operand.level_lens[level])
-	std::vector<int64_t> in_level_inds(num_operands, 0); // Fill with 0 indices for each operand
+	return has_dense_suffix;
+}
 
-	// Output operand target index array. Built up during processing of a level, then dense-compacted and moved to in_level_outinds
+template<int ndim>
+template<NArySetOperation op>
+void CBLQSetOperationsNAry3Fast<ndim>::nary_set_op_levels(
+		const std::vector< const CBLQRegionEncoding<ndim> * > &operands, const std::vector< OperandSpan > &spans,
+		int first_level, int end_level, bool has_dense_suffix,
+		std::vector< int64_t > &level_inds, uint64_t &level_len,
+		std::vector< cblq_word_t > &output_words, std::vector< size_t > &output_level_lens, CBLQSemiwords<ndim> *output_semiwords)
+{
+	const size_t num_operands = operands.size();
+	const int levels = operands.front()->get_num_levels();
+	const int non_dense_levels = has_dense_suffix ? levels - 1 : levels;
+
+	// Output operand target index array. Built up during processing of a level, then dense-compacted and moved to level_inds
+	// Outind arrays are packed back-to-back, since it is known how many belong to each operand (= the span's word count at the level)
 	std::vector<int64_t> out_level_inds;
 	std::vector<uint64_t> out_level_inds_operand_ends(num_operands);
 
-	// Size of level for the next iteration (computed at the end of each iteration for the next iteration)
-	size_t next_level_len = 1;
-
 	// For each CBLQ level
-	for (int level = 0; level < non_dense_levels; level++) {
-		output->level_lens[level] = next_level_len; // The number of words we will output this level is already known: it's the number of non-delete actions that are queued
+	for (int level = first_level; level < end_level; level++) {
+		output_level_lens.push_back(level_len); // The number of words we will output this level is already known: it's the number of non-delete actions that are queued
 
 		// Allocate space in out_level_inds
 		if (level + 1 < levels) {
 			uint64_t expected_out_inds = 0; // The number of inds produced by the next level is
-			if (level + 1 < non_dense_levels) { // Next level is the dense suffix
+			if (level + 1 < non_dense_levels) { // Next level is not the dense suffix
 				for (size_t operand = 0; operand < num_operands; ++operand)
-					expected_out_inds += *(cblq_level_len_its[operand] + 1); // Add the number of words in the next level
+					expected_out_inds += spans[operand].level_word_counts[level + 1]; // Add the number of words in the next level
 			} else {
-				for (auto it = cblq_it; it != cblq_end_it; ++it)
-					expected_out_inds += (*it)->dense_suffix->get_num_semiwords(); // Add the number of semiwords in the next level
+				for (size_t operand = 0; operand < num_operands; ++operand)
+					expected_out_inds += spans[operand].dense_count; // Add the number of semiwords in the next level
 			}
 			out_level_inds.resize(expected_out_inds + CBLQRegionEncoding<ndim>::CODES_PER_WORD /* Extra sentinel to allow intentional overrun */);
 		} else {
@@ -267,21 +265,17 @@ CBLQSetOperationsNAry3Fast<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter cblq_
 
 		// Allocate space in output_words and set up the base iterator
 		const size_t prev_output_words_size = output_words.size();
-		output_words.resize(prev_output_words_size + next_level_len, (op == NArySetOperation::UNION) ? CBLQRegionEncoding<ndim>::ZERO_CODES_WORD : CBLQRegionEncoding<ndim>::ONE_CODES_WORD);
+		output_words.resize(prev_output_words_size + level_len, (op == NArySetOperation::UNION) ? CBLQRegionEncoding<ndim>::ZERO_CODES_WORD : CBLQRegionEncoding<ndim>::ONE_CODES_WORD);
 		const auto level_output_words_it = output_words.begin() + prev_output_words_size;
 
 		// Set up in and out ind iterators
-		auto in_inds_it = in_level_inds.cbegin();
+		auto in_inds_it = level_inds.cbegin();
 		auto out_inds_it = out_level_inds.begin();
 
 		// For each operand, apply all CBLQ words to the proper locations in the output (or skip them if they are to be deleted)
 		for (size_t operand = 0; operand < num_operands; operand++) {
-			auto &cblq_level_len_it = cblq_level_len_its[operand];
-			const uint64_t level_len = *cblq_level_len_it;
-			++cblq_level_len_it;
-
-			auto cblq_word_it = cblq_word_its[operand]; // Get the CBLQ word iterator for this CBLQ
-			auto cblq_word_end_it = cblq_word_it + level_len;
+			auto cblq_word_it = operands[operand]->words.cbegin() + spans[operand].level_word_begins[level];
+			const auto cblq_word_end_it = cblq_word_it + spans[operand].level_word_counts[level];
 
 			// For each action in which this operand participates
 			while (cblq_word_it != cblq_word_end_it) {
@@ -304,11 +298,8 @@ CBLQSetOperationsNAry3Fast<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter cblq_
 					append_child_inds<ndim>(oper_cblq_word, base_ind, out_inds_it); // This will overflow the valid end of out_level_inds, but we allocated enough extra sentinel space earlier so that it won't segfault
 				} else { // DELETE
 					// Skip the specified number of words, counting the number of two codes therein
-					int64_t skip_children = 0;
-					for (int64_t i = 0; i < -ind; ++i) {
-						skip_children += count_two_codes<ndim>(*cblq_word_it);
-						++cblq_word_it;
-					}
+					const int64_t skip_children = CBLQWordOps<ndim>::count_two_codes_run(&*cblq_word_it, -ind);
+					cblq_word_it += -ind;
 					// If there were any skipped two codes, enqueue a delete action covering all of them now
 					if (skip_children) {
 						*out_inds_it = -skip_children;
@@ -317,52 +308,37 @@ CBLQSetOperationsNAry3Fast<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter cblq_
 				}
 			}
 
-			cblq_word_its[operand] = cblq_word_it;
 			out_level_inds_operand_ends[operand] = out_inds_it - out_level_inds.begin();
 		}
 
 		// Post-process the output of the previous step
 		if (level < levels - 1) {
 			out_level_inds.resize(out_level_inds.size() - CBLQRegionEncoding<ndim>::CODES_PER_WORD); // Remove the extra sentinel for overflow so that the vector is tight (level_postprocess relies on an accurate size())
-			level_postprocess<ndim, op>(level_output_words_it, out_level_inds_operand_ends, out_level_inds, next_level_len); // updates out_level_inds and next_level_len
-			in_level_inds = std::move(out_level_inds);
+			level_postprocess<ndim, op>(level_output_words_it, out_level_inds_operand_ends, out_level_inds, level_len); // updates out_level_inds and level_len
+			level_inds = std::move(out_level_inds);
 			out_level_inds.clear();
 		}
 	}
 
-	if (has_dense_suffix) {
-		using semiword_block_t = typename CBLQSemiwords<ndim>::block_t;
+	if (output_semiwords) {
+		assert(has_dense_suffix && end_level == non_dense_levels);
 		const int BITS_PER_BLOCK = std::numeric_limits<semiword_block_t>::digits;
 
-		// Set the (non-dense) leaf level length to 0
-		output->level_lens[levels - 1] = 0;
-
-		// Collect dense suffix information and iterators
-		std::vector< uint64_t > dense_level_lens;
-		std::vector< typename std::vector< semiword_block_t >::const_iterator > in_block_its;
-		for (auto it = cblq_it; it != cblq_end_it; it++) {
-			const CBLQRegionEncoding<ndim> &cblq = **it;
-			dense_level_lens.push_back(cblq.dense_suffix->get_num_semiwords());
-			cblq.dense_suffix->ensure_padded();
-			in_block_its.push_back(cblq.dense_suffix->semiwords.begin());
-		}
-
 		// Set up output
-		CBLQSemiwords<ndim> &output_semiwords = *output->dense_suffix;
-		std::vector< semiword_block_t > &output_blocks = output_semiwords.semiwords;
-
-		output_semiwords.num_semiwords = next_level_len;
+		std::vector< semiword_block_t > &output_blocks = output_semiwords->semiwords;
+		output_semiwords->num_semiwords = level_len;
 		output_blocks.clear();
-		output_blocks.resize(next_level_len / CBLQSemiwords<ndim>::SEMIWORDS_PER_BLOCK + 1, 0);
+		output_blocks.resize(level_len / CBLQSemiwords<ndim>::SEMIWORDS_PER_BLOCK + 1, 0);
 
 		// Process dense suffixes
-		auto in_inds_it = in_level_inds.begin();
+		auto in_inds_it = level_inds.begin();
 		for (size_t operand = 0; operand < num_operands; ++operand) {
-			const uint64_t dense_level_len = dense_level_lens[operand];
-			auto in_block_it = in_block_its[operand];
+			const OperandSpan &span = spans[operand];
+			const uint64_t dense_level_len = span.dense_count;
+			auto in_block_it = operands[operand]->dense_suffix->semiwords.cbegin() + span.dense_begin / CBLQSemiwords<ndim>::SEMIWORDS_PER_BLOCK;
 
 			semiword_block_t cur_block = *in_block_it;
-			uint64_t in_block_shift = 0;
+			uint64_t in_block_shift = span.dense_begin % CBLQSemiwords<ndim>::SEMIWORDS_PER_BLOCK * CBLQRegionEncoding<ndim>::BITS_PER_SEMIWORD;
 			for (uint64_t i = 0; i < dense_level_len;) {
 				const int64_t ind = *in_inds_it;
 				++in_inds_it;
@@ -405,6 +381,31 @@ CBLQSetOperationsNAry3Fast<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter cblq_
 				*it = ~*it;
 		}
 	}
+}
+
+template<int ndim>
+template<NArySetOperation op>
+inline boost::shared_ptr< CBLQRegionEncoding<ndim> >
+CBLQSetOperationsNAry3Fast<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter cblq_it, RegionEncodingCPtrCIter cblq_end_it) const {
+	std::vector< const CBLQRegionEncoding<ndim> * > operands;
+	std::vector< OperandSpan > spans;
+	const bool has_dense_suffix = prepare_operands(cblq_it, cblq_end_it, operands, spans);
+
+	const int levels = operands.front()->get_num_levels();
+	const int non_dense_levels = has_dense_suffix ? levels - 1 : levels;
+
+	// Allocate a new CBLQ for output
+	boost::shared_ptr< CBLQRegionEncoding<ndim> > output = boost::make_shared< CBLQRegionEncoding<ndim> >(operands.front()->get_domain_size());
+	output->has_dense_suffix = has_dense_suffix;
+
+	// Input operand target index array. Produced in the previous step, indicates which output CBLQ word should be modified by each input word
+	std::vector<int64_t> level_inds(operands.size(), 0); // Fill with 0 indices for each operand
+	uint64_t level_len = 1; // Size of the level for each iteration (computed at the end of the previous iteration)
+
+	nary_set_op_levels<op>(operands, spans, 0, non_dense_levels, has_dense_suffix, level_inds, level_len, output->words, output->level_lens, has_dense_suffix ? output->dense_suffix.get() : nullptr);
+
+	if (has_dense_suffix)
+		output->level_lens.push_back(0); // Set the (non-dense) leaf level length to 0
 
 	return output;
 }
@@ -443,7 +444,188 @@ CBLQSetOperationsNAry3Fast<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter cblq_
 //		return this->template CBLQSetOperationsFast<ndim>::binary_set_op(left, right, op);
 //}
 
-// Explicit instantiation of 2D-4D CBLQ N-ary set operations
+template<int ndim>
+template<NArySetOperation op>
+boost::shared_ptr< CBLQRegionEncoding<ndim> >
+CBLQSetOperationsNAry3FastParallel<ndim>::parallel_nary_set_op_impl(RegionEncodingCPtrCIter cblq_it, RegionEncodingCPtrCIter cblq_end_it) const {
+	std::vector< const CBLQRegionEncoding<ndim> * > operands;
+	std::vector< OperandSpan > whole_spans;
+	const bool has_dense_suffix = this->prepare_operands(cblq_it, cblq_end_it, operands, whole_spans);
+
+	const size_t num_operands = operands.size();
+	const int levels = operands.front()->get_num_levels();
+	const int non_dense_levels = has_dense_suffix ? levels - 1 : levels;
+	const size_t num_spans = (size_t)this->nthreads * SPANS_PER_THREAD;
+
+	boost::shared_ptr< CBLQRegionEncoding<ndim> > output = boost::make_shared< CBLQRegionEncoding<ndim> >(operands.front()->get_domain_size());
+	output->has_dense_suffix = has_dense_suffix;
+
+	// Process the top levels on this thread, until reaching a level with enough output words to be worth splitting
+	std::vector< int64_t > level_inds(num_operands, 0);
+	uint64_t level_len = 1;
+	int split_level = 0;
+	while (split_level < non_dense_levels && level_len < num_spans * this->min_words_per_span) {
+		this->template nary_set_op_levels<op>(operands, whole_spans, split_level, split_level + 1, has_dense_suffix, level_inds, level_len, output->words, output->level_lens, nullptr);
+		++split_level;
+	}
+
+	if (split_level == non_dense_levels) { // Never large enough; finish up (with the dense suffix, if any) on this thread
+		if (has_dense_suffix) {
+			this->template nary_set_op_levels<op>(operands, whole_spans, split_level, split_level, has_dense_suffix, level_inds, level_len, output->words, output->level_lens, output->dense_suffix.get());
+			output->level_lens.push_back(0);
+		}
+		return output;
+	}
+
+	// Divide the output words of the split level evenly among the spans, and find the range of each operand's inds (in
+	// level_inds, which are back-to-back by operand) and words belonging to each span. Delete actions go to the span of the
+	// preceding word with an output position (so each span's range of inds and words is contiguous in each operand).
+	std::vector< uint64_t > span_out_begins(num_spans + 1);
+	for (size_t span = 0; span <= num_spans; ++span)
+		span_out_begins[span] = level_len * span / num_spans;
+
+	std::vector< std::vector< size_t > > span_ind_begins(num_operands, std::vector< size_t >(num_spans + 1));
+	std::vector< std::vector< uint64_t > > span_word_begins(num_operands, std::vector< uint64_t >(num_spans + 1));
+	size_t ind_pos = 0;
+	for (size_t operand = 0; operand < num_operands; ++operand) {
+		const uint64_t level_words = whole_spans[operand].level_word_counts[split_level];
+		size_t cur_span = 0;
+		uint64_t word = 0;
+
+		span_ind_begins[operand][0] = ind_pos;
+		span_word_begins[operand][0] = 0;
+		while (word < level_words) {
+			const int64_t ind = level_inds[ind_pos];
+			if (ind >= 0) {
+				while ((uint64_t)ind >= span_out_begins[cur_span + 1]) {
+					++cur_span;
+					span_ind_begins[operand][cur_span] = ind_pos;
+					span_word_begins[operand][cur_span] = word;
+				}
+				++word;
+			} else {
+				word += -ind;
+			}
+			++ind_pos;
+		}
+		for (size_t span = cur_span + 1; span <= num_spans; ++span) {
+			span_ind_begins[operand][span] = ind_pos;
+			span_word_begins[operand][span] = level_words;
+		}
+	}
+
+	std::vector< std::vector< OperandSpan > > span_operands(num_spans, std::vector< OperandSpan >(num_operands));
+	for (size_t span = 0; span < num_spans; ++span) {
+		for (size_t operand = 0; operand < num_operands; ++operand) {
+			OperandSpan &opspan = span_operands[span][operand];
+			opspan.level_word_begins.assign(levels, 0);
+			opspan.level_word_counts.assign(levels, 0);
+			opspan.level_word_begins[split_level] = whole_spans[operand].level_word_begins[split_level] + span_word_begins[operand][span];
+			opspan.level_word_counts[split_level] = span_word_begins[operand][span + 1] - span_word_begins[operand][span];
+			opspan.dense_begin = opspan.dense_count = 0;
+		}
+	}
+
+	// Extend each span down through the lower levels. The children of a level's words [b, e) are the next level's words
+	// [P(b), P(e)), where P(x) is the number of 2-codes among the level's first x words. So, count the 2-codes in each span's
+	// words concurrently, then take prefix sums of those counts across the spans to find each span's words at the next level.
+	for (int level = split_level; level + 1 < levels; ++level) {
+		std::vector< std::vector< uint64_t > > span_two_codes(num_spans, std::vector< uint64_t >(num_operands));
+		run_tasks_concurrently(this->nthreads, num_spans, [&](size_t span) {
+			for (size_t operand = 0; operand < num_operands; ++operand) {
+				const OperandSpan &opspan = span_operands[span][operand];
+				span_two_codes[span][operand] = CBLQWordOps<ndim>::count_two_codes_run(operands[operand]->words.data() + opspan.level_word_begins[level], opspan.level_word_counts[level]);
+			}
+		});
+
+		const bool next_is_dense = (level + 1 == non_dense_levels);
+		for (size_t operand = 0; operand < num_operands; ++operand) {
+			uint64_t next_begin = next_is_dense ? 0 : whole_spans[operand].level_word_begins[level + 1];
+			for (size_t span = 0; span < num_spans; ++span) {
+				OperandSpan &opspan = span_operands[span][operand];
+				if (next_is_dense) {
+					opspan.dense_begin = next_begin;
+					opspan.dense_count = span_two_codes[span][operand];
+				} else {
+					opspan.level_word_begins[level + 1] = next_begin;
+					opspan.level_word_counts[level + 1] = span_two_codes[span][operand];
+				}
+				next_begin += span_two_codes[span][operand];
+			}
+		}
+	}
+
+	// Process all spans concurrently, each into its own output
+	std::vector< std::vector< cblq_word_t > > span_words(num_spans);
+	std::vector< std::vector< size_t > > span_level_lens(num_spans);
+	std::vector< std::unique_ptr< CBLQSemiwords<ndim> > > span_semiwords(num_spans);
+	run_tasks_concurrently(this->nthreads, num_spans, [&](size_t span) {
+		// Gather this span's inds from each operand, with output positions relative to the span
+		std::vector< int64_t > span_inds;
+		for (size_t operand = 0; operand < num_operands; ++operand) {
+			for (size_t i = span_ind_begins[operand][span]; i < span_ind_begins[operand][span + 1]; ++i) {
+				const int64_t ind = level_inds[i];
+				span_inds.push_back(ind >= 0 ? ind - (int64_t)span_out_begins[span] : ind);
+			}
+		}
+
+		uint64_t span_level_len = span_out_begins[span + 1] - span_out_begins[span];
+		if (has_dense_suffix)
+			span_semiwords[span].reset(new CBLQSemiwords<ndim>(false));
+
+		this->template nary_set_op_levels<op>(operands, span_operands[span], split_level, non_dense_levels, has_dense_suffix, span_inds, span_level_len, span_words[span], span_level_lens[span], span_semiwords[span].get());
+	});
+
+	// Concatenate the spans' outputs, level by level
+	std::vector< size_t > span_level_offsets(num_spans, 0);
+	for (int level = split_level; level < non_dense_levels; ++level) {
+		size_t level_total = 0;
+		for (size_t span = 0; span < num_spans; ++span) {
+			const size_t span_level_len = span_level_lens[span][level - split_level];
+			const auto span_level_it = span_words[span].cbegin() + span_level_offsets[span];
+			output->words.insert(output->words.end(), span_level_it, span_level_it + span_level_len);
+			span_level_offsets[span] += span_level_len;
+			level_total += span_level_len;
+		}
+		output->level_lens.push_back(level_total);
+	}
+
+	if (has_dense_suffix) {
+		for (size_t span = 0; span < num_spans; ++span)
+			output->dense_suffix->append(*span_semiwords[span]);
+		output->level_lens.push_back(0); // Set the (non-dense) leaf level length to 0
+	}
+
+	return output;
+}
+
+template<int ndim>
+boost::shared_ptr< CBLQRegionEncoding<ndim> >
+CBLQSetOperationsNAry3FastParallel<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter cblq_it, RegionEncodingCPtrCIter cblq_end_it, NArySetOperation op) const {
+	if (this->nthreads <= 1 || (op != NArySetOperation::UNION && op != NArySetOperation::INTERSECTION))
+		return this->CBLQSetOperationsNAry3Fast<ndim>::nary_set_op_impl(cblq_it, cblq_end_it, op);
+
+	child_ind_helper::ensure_init(); // Before any threads are started
+
+	boost::shared_ptr< CBLQRegionEncoding<ndim> > output;
+	if (op == NArySetOperation::UNION)
+		output = this->parallel_nary_set_op_impl<NArySetOperation::UNION>(cblq_it, cblq_end_it);
+	else
+		output = this->parallel_nary_set_op_impl<NArySetOperation::INTERSECTION>(cblq_it, cblq_end_it);
+
+	// Finally, compact the output CBLQ if requested
+	if (this->conf.compact_after_setop)
+		output->compact();
+
+	return output;
+}
+
+// Explicit instantiation of 1D-4D CBLQ N-ary set operations
+template class CBLQSetOperationsNAry3Fast<1>;
 template class CBLQSetOperationsNAry3Fast<2>;
 template class CBLQSetOperationsNAry3Fast<3>;
 template class CBLQSetOperationsNAry3Fast<4>;
+template class CBLQSetOperationsNAry3FastParallel<1>;
+template class CBLQSetOperationsNAry3FastParallel<2>;
+template class CBLQSetOperationsNAry3FastParallel<3>;
+template class CBLQSetOperationsNAry3FastParallel<4>;
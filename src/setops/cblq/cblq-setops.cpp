@@ -340,7 +340,11 @@ CBLQSetOperations<ndim>::nary_set_op_impl(RegionEncodingCPtrCIter region_it, Reg
 	return output;
 }
 
-// Explicit instantiation of 2D-4D CBLQ set ops
+template<int ndim>
+thread_local bool CBLQSetOperations<ndim>::suppress_compact = false;
+
+// Explicit instantiation of 1D-4D CBLQ set ops
+template class CBLQSetOperations<1>;
 template class CBLQSetOperations<2>;
 template class CBLQSetOperations<3>;
 template class CBLQSetOperations<4>;
@@ -23,6 +23,8 @@
 
 #include <vector>
 #include <queue>
+#include <limits>
+#include <algorithm>
 #include <boost/smart_ptr.hpp>
 #include <boost/make_shared.hpp>
 
@@ -56,10 +58,13 @@ CIISetOperations::unary_set_op_impl(boost::shared_ptr< const CIIRegionEncoding >
 
 boost::shared_ptr< CIIRegionEncoding >
 CIISetOperations::binary_set_op_impl(boost::shared_ptr< const CIIRegionEncoding > left, boost::shared_ptr< const CIIRegionEncoding > right, NArySetOperation op) const {
-	if (left->is_compressed || right->is_compressed)
+	if (left->is_compressed || right->is_compressed) {
+		if (boost::shared_ptr< CIIRegionEncoding > output = this->binary_set_op_skipping(left, right, op))
+			return output;
 		return this->binary_set_op_mixed(left, right, op);
-	else
+	} else {
 		return this->binary_set_op_uncompressed(left, right, op);
+	}
 }
 
 boost::shared_ptr< CIIRegionEncoding >
@@ -215,6 +220,68 @@ CIISetOperations::binary_set_op_uncompressed(boost::shared_ptr< const CIIRegionE
 	return output;
 }
 
+constexpr uint64_t CIISetOperations::SKIPPING_SIZE_RATIO;
+
+uint64_t CIISetOperations::get_stored_rid_bound(const CIIRegionEncoding &cii) {
+	if (!cii.is_compressed)
+		return cii.ii.size();
+	else if (!cii.skip_table.empty() || cii.cii.empty())
+		return cii.skip_table.size() * cii.get_chunk_size();
+	else
+		return std::numeric_limits< uint64_t >::max(); // Compressed without a skip table; unknown without decoding
+}
+
+boost::shared_ptr< CIIRegionEncoding >
+CIISetOperations::binary_set_op_skipping(boost::shared_ptr< const CIIRegionEncoding > left, boost::shared_ptr< const CIIRegionEncoding > right, NArySetOperation op) const {
+	if (op != NArySetOperation::INTERSECTION && op != NArySetOperation::DIFFERENCE)
+		return nullptr;
+
+	assert(left->domain_size == right->domain_size);
+	const rid_t domain_size = left->domain_size;
+
+	bool invert_result;
+	normalize_inverted_operands(left->is_inverted, right->is_inverted, left, right, op, invert_result);
+
+	// Only A & B and A - B, with A the small operand, can avoid visiting all of B
+	if (op == NArySetOperation::INTERSECTION) {
+		if (get_stored_rid_bound(*left) > get_stored_rid_bound(*right))
+			std::swap(left, right);
+	} else if (op != NArySetOperation::DIFFERENCE) {
+		return nullptr;
+	}
+
+	const CIIRegionEncoding &small = *left, &large = *right;
+	if (!large.is_compressed || large.skip_table.empty() ||
+		get_stored_rid_bound(small) > get_stored_rid_bound(large) / SKIPPING_SIZE_RATIO)
+	{
+		return nullptr;
+	}
+
+	boost::shared_ptr< CIIRegionEncoding > output = boost::make_shared< CIIRegionEncoding >();
+	output->domain_size = domain_size;
+	output->is_compressed = false;
+	output->is_inverted = invert_result;
+	std::vector<rid_t> &output_rids = output->ii;
+
+	// Base decoders, as inversion has already been pulled out of the operands
+	BaseProgressiveCIIDecoder small_rids(small);
+	BaseProgressiveCIIDecoder large_rids(large);
+
+	const bool keep_matches = (op == NArySetOperation::INTERSECTION);
+	for (; small_rids.has_top(); small_rids.next()) {
+		const rid_t rid = small_rids.top();
+		large_rids.skip_to(rid);
+
+		const bool matched = large_rids.has_top() && large_rids.top() == rid;
+		if (matched == keep_matches)
+			output_rids.push_back(rid);
+		else if (!large_rids.has_top()) // Nothing more can match an intersection
+			break;
+	}
+
+	return output;
+}
+
 boost::shared_ptr< CIIRegionEncoding >
 CIISetOperations::nary_set_op_impl(RegionEncodingCPtrCIter start_it, RegionEncodingCPtrCIter end_it, NArySetOperation op) const {
 	return this->nary_set_op_smartcompare_impl(start_it, end_it, op);
@@ -23,10 +23,18 @@
 #ifndef SRC_SETOPS_IMPL_PREFLIST_SETOPS_CPP_
 #define SRC_SETOPS_IMPL_PREFLIST_SETOPS_CPP_
 
+#include <algorithm>
+#include <boost/make_shared.hpp>
+
 #include "pique/setops/setops.hpp"
+#include "pique/convert/rid-stream-convert.hpp"
 
 // Attempts to apply any of a list of AbstractSetOperations to a given set of operands; the first AbstractSetOperations that
 // accepts all operand types is applied.
+PreferenceListSetOperations::PreferenceListSetOperations() :
+	converter(boost::make_shared< RIDStreamRegionEncodingConverter >())
+{}
+
 bool PreferenceListSetOperations::can_handle_region_encoding(RegionEncoding::Type type) const {
 	return std::any_of(
 			this->begin(), this->end(),
@@ -35,6 +43,36 @@ bool PreferenceListSetOperations::can_handle_region_encoding(RegionEncoding::Typ
 	});
 }
 
+boost::shared_ptr< AbstractSetOperations > PreferenceListSetOperations::get_setops_for_types(const std::vector< RegionEncoding::Type > &types) const {
+	for (auto setopsit = this->begin(); setopsit != this->end(); setopsit++) {
+		const boost::shared_ptr< AbstractSetOperations > setops = *setopsit;
+		if (std::all_of(types.begin(), types.end(), [&setops](RegionEncoding::Type type) -> bool { return setops->can_handle_region_encoding(type); }))
+			return setops;
+	}
+	return nullptr;
+}
+
+RegionEncoding::Type PreferenceListSetOperations::get_common_type(RegionEncodingCPtrCIter it, RegionEncodingCPtrCIter end_it) const {
+	RECPtr largest = nullptr;
+	for (; it != end_it; it++)
+		if (this->can_handle_region_encoding((*it)->get_type()) && (!largest || (*it)->get_size_in_bytes() > largest->get_size_in_bytes()))
+			largest = *it;
+
+	if (!largest)
+		abort(); // Unsupported region encoding type
+	return largest->get_type();
+}
+
+auto PreferenceListSetOperations::convert_operand(RECPtr operand, RegionEncoding::Type type) const -> RECPtr {
+	if (operand->get_type() == type)
+		return operand;
+
+	const REPtr converted = (this->converter ? this->converter->convert(operand, type) : nullptr);
+	if (!converted)
+		abort(); // Unsupported region encoding conversion
+	return converted;
+}
+
 auto PreferenceListSetOperations::dynamic_unary_set_op_impl(RECPtr region, UnarySetOperation op) const -> REPtr {
 	const RegionEncoding::Type type = region->get_type();
 
@@ -60,67 +98,69 @@ void PreferenceListSetOperations::dynamic_inplace_unary_set_op_impl(REPtr region
 }
 
 auto PreferenceListSetOperations::dynamic_binary_set_op_impl(RECPtr left, RECPtr right, NArySetOperation op) const -> REPtr {
-	const RegionEncoding::Type ltype = left->get_type();
-	const RegionEncoding::Type rtype = right->get_type();
-	for (auto it = this->begin(); it != this->end(); it++)
-		if ((*it)->can_handle_region_encoding(ltype) &&
-				(*it)->can_handle_region_encoding(rtype))
-			return (*it)->dynamic_binary_set_op(left, right, op);
+	if (const boost::shared_ptr< AbstractSetOperations > setops = this->get_setops_for_types({ left->get_type(), right->get_type() }))
+		return setops->dynamic_binary_set_op(left, right, op);
 
-	abort(); // Unsupported region encoding type
-	return nullptr;
+	// Mixed representations: convert to a common one
+	const std::vector< RECPtr > operands = { left, right };
+	const RegionEncoding::Type type = this->get_common_type(operands.begin(), operands.end());
+	return this->get_setops_for_types({ type })->dynamic_binary_set_op(this->convert_operand(left, type), this->convert_operand(right, type), op);
 }
 
 void PreferenceListSetOperations::dynamic_inplace_binary_set_op_impl(REPtr left_and_out, RECPtr right, NArySetOperation op) const {
 	const RegionEncoding::Type ltype = left_and_out->get_type();
-	const RegionEncoding::Type rtype = right->get_type();
-	for (auto it = this->begin(); it != this->end(); it++) {
-		if ((*it)->can_handle_region_encoding(ltype) &&
-				(*it)->can_handle_region_encoding(rtype)) {
-			return;
-		}
+	if (const boost::shared_ptr< AbstractSetOperations > setops = this->get_setops_for_types({ ltype, right->get_type() })) {
+		setops->dynamic_inplace_binary_set_op(left_and_out, right, op);
+		return;
 	}
 
-	abort(); // Unsupported region encoding type
+	// Mixed representations: the output keeps its representation, so convert the other operand to it
+	const boost::shared_ptr< AbstractSetOperations > setops = this->get_setops_for_types({ ltype });
+	if (!setops)
+		abort(); // Unsupported region encoding type
+	setops->dynamic_inplace_binary_set_op(left_and_out, this->convert_operand(right, ltype), op);
 }
 
 auto PreferenceListSetOperations::dynamic_nary_set_op_impl(RegionEncodingCPtrCIter it, RegionEncodingCPtrCIter end_it, NArySetOperation op) const -> REPtr {
-	for (auto setopsit = this->begin(); setopsit != this->end(); setopsit++) {
-		boost::shared_ptr< AbstractSetOperations > setops = *setopsit;
-		bool success = true;
-		for (auto operit = it; operit != end_it; operit++) {
-			if (!setops->can_handle_region_encoding((*operit)->get_type())) {
-				success = false;
-				break;
-			}
-		}
+	std::vector< RegionEncoding::Type > types;
+	for (auto operit = it; operit != end_it; operit++)
+		types.push_back((*operit)->get_type());
 
-		if (success)
-			return setops->dynamic_nary_set_op_impl(it, end_it, op);
-	}
+	if (const boost::shared_ptr< AbstractSetOperations > setops = this->get_setops_for_types(types))
+		return setops->dynamic_nary_set_op_impl(it, end_it, op);
 
-	abort(); // Unsupported region encoding type
-	return nullptr;
+	// Mixed representations: convert to a common one
+	const RegionEncoding::Type type = this->get_common_type(it, end_it);
+	std::vector< RECPtr > operands;
+	for (auto operit = it; operit != end_it; operit++)
+		operands.push_back(this->convert_operand(*operit, type));
+
+	return this->get_setops_for_types({ type })->dynamic_nary_set_op_impl(operands.begin(), operands.end(), op);
 }
 
 void PreferenceListSetOperations::dynamic_inplace_nary_set_op_impl(REPtr first_and_out, RegionEncodingCPtrCIter it, RegionEncodingCPtrCIter end_it, NArySetOperation op) const {
-	for (auto setopsit = this->begin(); setopsit != this->end(); setopsit++) {
-		boost::shared_ptr< AbstractSetOperations > setops = *setopsit;
-		bool success = true;
-		for (auto operit = it; operit != end_it; operit++) {
-			if (!setops->can_handle_region_encoding((*operit)->get_type())) {
-				success = false;
-				break;
-			}
-		}
+	const RegionEncoding::Type first_type = first_and_out->get_type();
 
-		if (success)
-			return;
+	std::vector< RegionEncoding::Type > types(1, first_type);
+	for (auto operit = it; operit != end_it; operit++)
+		types.push_back((*operit)->get_type());
+
+	if (const boost::shared_ptr< AbstractSetOperations > setops = this->get_setops_for_types(types)) {
+		setops->dynamic_inplace_nary_set_op(first_and_out, it, end_it, op);
+		return;
 	}
 
-	abort(); // Unsupported region encoding type
-}
+	// Mixed representations: the output keeps its representation, so convert the other operands to it
+	const boost::shared_ptr< AbstractSetOperations > setops = this->get_setops_for_types({ first_type });
+	if (!setops)
+		abort(); // Unsupported region encoding type
 
+	std::vector< RECPtr > operands;
+	for (auto operit = it; operit != end_it; operit++)
+		operands.push_back(this->convert_operand(*operit, first_type));
+
+	setops->dynamic_inplace_nary_set_op(first_and_out, operands.cbegin(), operands.cend(), op);
+}
 
 
 
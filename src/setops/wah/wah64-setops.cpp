@@ -0,0 +1,352 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * wah64-setops.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <boost/make_shared.hpp>
+#include "pique/setops/wah/wah64-setops.hpp"
+
+using word_t = WAH64RegionEncoding::word_t;
+using GroupIterator = WAH64RegionEncoding::GroupIterator;
+using Builder = WAH64RegionEncoding::Builder;
+using RegionUniformity = RegionEncoding::RegionUniformity;
+
+// What a fill in one operand implies for the output over the fill's groups
+enum struct FillAction { ZEROS, ONES, COPY_OTHER, COMPLEMENT_OTHER };
+
+template<NArySetOperation op>
+static inline FillAction fill_action(bool fill_bit, bool fill_is_left) {
+	switch (op) {
+	case NArySetOperation::UNION:					return fill_bit ? FillAction::ONES : FillAction::COPY_OTHER;
+	case NArySetOperation::INTERSECTION:			return fill_bit ? FillAction::COPY_OTHER : FillAction::ZEROS;
+	case NArySetOperation::SYMMETRIC_DIFFERENCE:	return fill_bit ? FillAction::COMPLEMENT_OTHER : FillAction::COPY_OTHER;
+	case NArySetOperation::DIFFERENCE:
+		if (fill_is_left)
+			return fill_bit ? FillAction::COMPLEMENT_OTHER : FillAction::ZEROS;
+		else
+			return fill_bit ? FillAction::ZEROS : FillAction::COPY_OTHER;
+	default: abort(); return FillAction::ZEROS;
+	}
+}
+
+template<NArySetOperation op>
+static inline word_t combine_literals(word_t left, word_t right) {
+	switch (op) {
+	case NArySetOperation::UNION:					return left | right;
+	case NArySetOperation::INTERSECTION:			return left & right;
+	case NArySetOperation::DIFFERENCE:				return left & ~right;
+	case NArySetOperation::SYMMETRIC_DIFFERENCE:	return left ^ right;
+	default: abort(); return 0;
+	}
+}
+
+// Merges the two operands run-by-run: whenever either side is in a fill, the output over the whole fill is
+// determined by the fill bit alone (a uniform fill, or a copy/complement of the other side's groups)
+template<NArySetOperation op>
+static void merge_binary(const WAH64RegionEncoding &left, const WAH64RegionEncoding &right, Builder &out) {
+	GroupIterator left_it(left), right_it(right);
+	while (left_it.has_next()) {
+		assert(right_it.has_next());
+		if (left_it.is_fill() || right_it.is_fill()) {
+			// Let the longer fill (or the only fill) govern
+			const bool fill_is_left = left_it.is_fill() && (!right_it.is_fill() || left_it.get_run_length() >= right_it.get_run_length());
+			GroupIterator &fill_it = fill_is_left ? left_it : right_it;
+			GroupIterator &other_it = fill_is_left ? right_it : left_it;
+			const uint64_t ngroups = fill_it.get_run_length();
+
+			switch (fill_action<op>(fill_it.fill_bit(), fill_is_left)) {
+			case FillAction::ZEROS:				out.append_fill(false, ngroups); other_it.skip(ngroups); break;
+			case FillAction::ONES:				out.append_fill(true, ngroups); other_it.skip(ngroups); break;
+			case FillAction::COPY_OTHER:		out.append_groups(other_it, ngroups, false); break;
+			case FillAction::COMPLEMENT_OTHER:	out.append_groups(other_it, ngroups, true); break;
+			}
+			fill_it.next_run();
+		} else {
+			out.append_literal(combine_literals<op>(left_it.get_literal(), right_it.get_literal()));
+			left_it.next_run();
+			right_it.next_run();
+		}
+	}
+	assert(!right_it.has_next());
+}
+
+static void merge_binary(const WAH64RegionEncoding &left, const WAH64RegionEncoding &right, NArySetOperation op, Builder &out) {
+	switch (op) {
+	case NArySetOperation::UNION:					merge_binary< NArySetOperation::UNION >(left, right, out); break;
+	case NArySetOperation::INTERSECTION:			merge_binary< NArySetOperation::INTERSECTION >(left, right, out); break;
+	case NArySetOperation::DIFFERENCE:				merge_binary< NArySetOperation::DIFFERENCE >(left, right, out); break;
+	case NArySetOperation::SYMMETRIC_DIFFERENCE:	merge_binary< NArySetOperation::SYMMETRIC_DIFFERENCE >(left, right, out); break;
+	}
+}
+
+/*
+ * Merges any number of operands (for union, intersection or symmetric difference) in a single pass, without
+ * intermediate results. Operand runs are consumed lazily, in order of where they end (tracked by a min-heap):
+ * - if any operand is in a dominating fill (a 1-fill for union, a 0-fill for intersection), the output is that
+ *   fill through the end of the longest such fill, and the runs of the other operands beneath it are skipped
+ *   without being combined;
+ * - otherwise, if any operand is in a literal, the literals are combined into one output group (fills of
+ *   the non-dominating bit are not touched, apart from their effect on the symmetric difference parity);
+ * - otherwise, all operands are in fills, and the output is uniform until the earliest of them ends.
+ */
+template<NArySetOperation op>
+static void merge_nary(const std::vector< const WAH64RegionEncoding * > &operands, Builder &out) {
+	static_assert(op != NArySetOperation::DIFFERENCE, "difference is computed via a union of the subtrahends");
+	typedef std::pair< uint64_t, size_t > RunEnd; // (group at which an operand's current run ends, operand index)
+
+	const size_t noperands = operands.size();
+	const uint64_t total_groups = operands.front()->get_group_count();
+	if (total_groups == 0)
+		return;
+
+	std::vector< GroupIterator > its;
+	std::vector< uint64_t > run_ends(noperands, 0);
+	its.reserve(noperands);
+	for (const WAH64RegionEncoding *operand : operands)
+		its.emplace_back(*operand);
+
+	std::priority_queue< RunEnd, std::vector< RunEnd >, std::greater< RunEnd > > next_run_ends;
+	std::vector< size_t > literal_operands; // Operands whose current run is a literal at pos
+	uint64_t fill_ends[2] = { 0, 0 }; // Furthest end of any 0-/1-fill seen so far
+	size_t fill_counts[2] = { 0, 0 }; // Number of operands in 0-/1-fills at pos
+	uint64_t pos = 0;
+
+	// Advances operand i to its run containing pos, and records what kind of run that is
+	auto land = [&](size_t i) {
+		GroupIterator &it = its[i];
+		while (run_ends[i] <= pos) {
+			it.next_run();
+			run_ends[i] += it.get_run_length();
+		}
+
+		if (it.is_fill()) {
+			const bool bit = it.fill_bit();
+			++fill_counts[bit];
+			fill_ends[bit] = std::max(fill_ends[bit], run_ends[i]);
+		} else {
+			literal_operands.push_back(i);
+		}
+		next_run_ends.push(RunEnd(run_ends[i], i));
+	};
+
+	for (size_t i = 0; i < noperands; ++i) {
+		run_ends[i] = its[i].get_run_length();
+		land(i);
+	}
+
+	while (pos < total_groups) {
+		if (op == NArySetOperation::UNION && fill_ends[1] > pos) {
+			out.append_fill(true, fill_ends[1] - pos);
+			pos = fill_ends[1];
+		} else if (op == NArySetOperation::INTERSECTION && fill_ends[0] > pos) {
+			out.append_fill(false, fill_ends[0] - pos);
+			pos = fill_ends[0];
+		} else if (!literal_operands.empty()) {
+			word_t literal =
+				(op == NArySetOperation::INTERSECTION) ? WAH64RegionEncoding::LITERAL_MASK :
+				(op == NArySetOperation::SYMMETRIC_DIFFERENCE && (fill_counts[1] & 1)) ? WAH64RegionEncoding::LITERAL_MASK :
+				0;
+			for (size_t i : literal_operands)
+				literal = combine_literals<op>(literal, its[i].get_literal());
+
+			out.append_literal(literal);
+			++pos;
+		} else {
+			const bool bit =
+				(op == NArySetOperation::UNION) ? false :
+				(op == NArySetOperation::INTERSECTION) ? true :
+				(fill_counts[1] & 1);
+			const uint64_t next_pos = next_run_ends.top().first;
+
+			out.append_fill(bit, next_pos - pos);
+			pos = next_pos;
+		}
+
+		if (pos >= total_groups)
+			break;
+
+		// Move every operand whose run has ended onto its run containing the new pos
+		literal_operands.clear();
+		while (next_run_ends.top().first <= pos) {
+			const size_t i = next_run_ends.top().second;
+			next_run_ends.pop();
+			if (its[i].is_fill())
+				--fill_counts[its[i].fill_bit()];
+			land(i);
+		}
+	}
+}
+
+boost::shared_ptr< WAH64RegionEncoding > WAH64SetOperations::unary_set_op_impl(boost::shared_ptr< const WAH64RegionEncoding > region, UnarySetOperation op) const {
+	assert(op == UnarySetOperation::COMPLEMENT);
+
+	boost::shared_ptr< WAH64RegionEncoding > output = boost::make_shared< WAH64RegionEncoding >();
+
+	Builder out(region->domain_size);
+	GroupIterator it(*region);
+	out.append_groups(it, region->get_group_count(), true);
+	out.finish_into(*output);
+
+	return output;
+}
+
+void WAH64SetOperations::inplace_unary_set_op_impl(boost::shared_ptr< WAH64RegionEncoding > region_and_out, UnarySetOperation op) const {
+	assert(op == UnarySetOperation::COMPLEMENT);
+
+	// Complementing never changes the word structure, only fill bits and literal contents
+	for (word_t &word : region_and_out->words) {
+		if (word & WAH64RegionEncoding::FILL_FLAG)
+			word ^= WAH64RegionEncoding::FILL_BIT_FLAG;
+		else
+			word ^= WAH64RegionEncoding::LITERAL_MASK;
+	}
+
+	// Re-clear the out-of-domain bits of the partial tail group, if any
+	const int tail_bits = region_and_out->domain_size % WAH64RegionEncoding::BITS_PER_GROUP;
+	if (tail_bits)
+		region_and_out->words.back() &= ((word_t)1 << tail_bits) - 1;
+
+	region_and_out->nset = region_and_out->domain_size - region_and_out->nset;
+}
+
+boost::shared_ptr< WAH64RegionEncoding > WAH64SetOperations::binary_set_op_impl(boost::shared_ptr< const WAH64RegionEncoding > left, boost::shared_ptr< const WAH64RegionEncoding > right, NArySetOperation op) const {
+	assert(left->domain_size == right->domain_size);
+
+	boost::shared_ptr< WAH64RegionEncoding > output = boost::make_shared< WAH64RegionEncoding >();
+
+	Builder out(left->domain_size);
+	merge_binary(*left, *right, op, out);
+	out.finish_into(*output);
+
+	return output;
+}
+
+void WAH64SetOperations::inplace_binary_set_op_impl(boost::shared_ptr< WAH64RegionEncoding > left_and_out, boost::shared_ptr< const WAH64RegionEncoding > right, NArySetOperation op) const {
+	std::vector< word_t > scratch;
+	this->inplace_binary_set_op_recycling(*left_and_out, *right, op, scratch);
+}
+
+void WAH64SetOperations::inplace_binary_set_op_recycling(WAH64RegionEncoding &left, const WAH64RegionEncoding &right, NArySetOperation op, std::vector< word_t > &scratch) const {
+	assert(left.domain_size == right.domain_size);
+
+	// Short-circuit cases where one operand is uniform and the result is either unchanged, uniform, or a copy of right
+	enum struct Shortcut { NONE, UNCHANGED, EMPTY, FILLED, COPY_RIGHT } shortcut = Shortcut::NONE;
+	const RegionUniformity left_uniformity = left.get_region_uniformity(), right_uniformity = right.get_region_uniformity();
+
+	if (right_uniformity == RegionUniformity::EMPTY) {
+		shortcut = (op == NArySetOperation::INTERSECTION) ? Shortcut::EMPTY : Shortcut::UNCHANGED;
+	} else if (right_uniformity == RegionUniformity::FILLED) {
+		switch (op) {
+		case NArySetOperation::UNION:			shortcut = Shortcut::FILLED; break;
+		case NArySetOperation::INTERSECTION:	shortcut = Shortcut::UNCHANGED; break;
+		case NArySetOperation::DIFFERENCE:		shortcut = Shortcut::EMPTY; break;
+		default: break;
+		}
+	} else if (left_uniformity == RegionUniformity::EMPTY) {
+		shortcut = (op == NArySetOperation::UNION || op == NArySetOperation::SYMMETRIC_DIFFERENCE) ? Shortcut::COPY_RIGHT : Shortcut::UNCHANGED;
+	} else if (left_uniformity == RegionUniformity::FILLED) {
+		if (op == NArySetOperation::UNION)
+			shortcut = Shortcut::UNCHANGED;
+		else if (op == NArySetOperation::INTERSECTION)
+			shortcut = Shortcut::COPY_RIGHT;
+	}
+
+	switch (shortcut) {
+	case Shortcut::UNCHANGED:
+		return;
+	case Shortcut::COPY_RIGHT:
+		left.words = right.words;
+		left.nset = right.nset;
+		return;
+	case Shortcut::EMPTY:
+	case Shortcut::FILLED:
+	{
+		Builder out(left.domain_size, std::move(scratch));
+		out.append_fill(shortcut == Shortcut::FILLED, left.get_group_count());
+		out.finish_into(left);
+		scratch = out.release_buffer();
+		return;
+	}
+	case Shortcut::NONE:
+		break;
+	}
+
+	Builder out(left.domain_size, std::move(scratch));
+	merge_binary(left, right, op, out);
+	out.finish_into(left);
+	scratch = out.release_buffer();
+}
+
+// Applies an n-ary set operation over all operands in a single pass
+void WAH64SetOperations::nary_set_op_single_pass(const std::vector< const WAH64RegionEncoding * > &operands, NArySetOperation op, WAH64RegionEncoding &out) const {
+	const uint64_t domain_size = operands.front()->domain_size;
+	for (const WAH64RegionEncoding *operand : operands)
+		assert(operand->domain_size == domain_size);
+
+	if (op == NArySetOperation::DIFFERENCE) {
+		// A - B - C - ... == A - (B | C | ...)
+		WAH64RegionEncoding subtrahend;
+		this->nary_set_op_single_pass(std::vector< const WAH64RegionEncoding * >(operands.begin() + 1, operands.end()), NArySetOperation::UNION, subtrahend);
+
+		Builder builder(domain_size);
+		merge_binary< NArySetOperation::DIFFERENCE >(*operands.front(), subtrahend, builder);
+		builder.finish_into(out);
+		return;
+	}
+
+	Builder builder(domain_size);
+	if (operands.size() == 1) {
+		GroupIterator it(*operands.front());
+		builder.append_groups(it, operands.front()->get_group_count(), false);
+	} else if (operands.size() == 2) {
+		merge_binary(*operands[0], *operands[1], op, builder);
+	} else {
+		switch (op) {
+		case NArySetOperation::UNION:					merge_nary< NArySetOperation::UNION >(operands, builder); break;
+		case NArySetOperation::INTERSECTION:			merge_nary< NArySetOperation::INTERSECTION >(operands, builder); break;
+		case NArySetOperation::SYMMETRIC_DIFFERENCE:	merge_nary< NArySetOperation::SYMMETRIC_DIFFERENCE >(operands, builder); break;
+		default: abort();
+		}
+	}
+	builder.finish_into(out);
+}
+
+boost::shared_ptr< WAH64RegionEncoding > WAH64SetOperations::nary_set_op_impl(RegionEncodingCPtrCIter it, RegionEncodingCPtrCIter end_it, NArySetOperation op) const {
+	std::vector< const WAH64RegionEncoding * > operands;
+	for (; it != end_it; ++it)
+		operands.push_back(it->get());
+
+	boost::shared_ptr< WAH64RegionEncoding > output = boost::make_shared< WAH64RegionEncoding >();
+	this->nary_set_op_single_pass(operands, op, *output);
+	return output;
+}
+
+void WAH64SetOperations::inplace_nary_set_op_impl(boost::shared_ptr< WAH64RegionEncoding > first_and_out, RegionEncodingCPtrCIter it, RegionEncodingCPtrCIter end_it, NArySetOperation op) const {
+	std::vector< const WAH64RegionEncoding * > operands(1, first_and_out.get());
+	for (; it != end_it; ++it)
+		operands.push_back(it->get());
+
+	// Safe, as the result is only moved into first_and_out after all operands have been consumed
+	this->nary_set_op_single_pass(operands, op, *first_and_out);
+}
@@ -27,9 +27,11 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <fstream>
 #include <boost/smart_ptr.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/iterator/counting_iterator.hpp>
+#include <boost/serialization/vector.hpp>
 
 #include "pique/data/grid.hpp"
 #include "pique/data/dataset.hpp"
@@ -38,6 +40,9 @@
 #include "pique/indexing/index-builder.hpp"
 #include "pique/io/index-io.hpp"
 #include "pique/io/posix/posix-index-io.hpp"
+#include "pique/encoding/index-encoding-serialization.hpp"
+#include "pique/util/serializable-chunk.hpp"
+#include "pique/util/datatypes.hpp"
 #include "pique/util/universal-value.hpp"
 
 #include "pique/region/ii/ii.hpp"
@@ -69,6 +74,161 @@ static void test_index_io(typename RegionEncoderT::RegionEncoderConfig conf, con
 #endif
 }
 
+// Write one partition, then reopen the index in append mode to add a second, and check both read back intact
+template<typename RegionEncoderT>
+static void test_index_io_append(typename RegionEncoderT::RegionEncoderConfig conf, const std::vector<int> &domain, std::string indexfile = "test-index-io.idx") {
+	boost::shared_ptr< BinnedIndex > index1 = make_index< RegionEncoderT, int >(conf, domain);
+	boost::shared_ptr< BinnedIndex > index2 = make_index< RegionEncoderT, int >(conf, std::vector<int>(domain.rbegin(), domain.rend()));
+
+	write_index(index1, indexfile, 0);
+
+	{
+		POSIXIndexIO appendio;
+		assert(appendio.open(indexfile, IndexOpenMode::WRITE_APPEND));
+		assert(appendio.get_num_partitions() == 1);
+
+		boost::shared_ptr< IndexPartitionIO > partio = appendio.append_partition();
+		assert(partio != nullptr);
+
+		partio->set_domain_global_offset(domain.size());
+		assert(partio->write_index(*index2));
+		assert(partio->close());
+
+		// Until the append is closed, the file still holds the original index intact
+		verify_index(index1, indexfile, 0, 1);
+
+		assert(appendio.close());
+	}
+
+	verify_index(index1, indexfile, 0, 2);
+	verify_index(index2, indexfile, domain.size(), 2);
+
+#ifdef VERBOSE_TESTS
+	printf("Index IO append test %s passed!\n", typeid(typename RegionEncoderT::RegionEncodingOutT).name());
+#endif
+}
+
+// The shared-file index format as written before partition headers recorded region element counts (and before
+// partition grids and zone maps), reproduced here to check such indexes remain readable
+namespace baseline_format {
+struct segment_offsets_header_t {
+	uint64_t partition_segment_offset, footer_segment_offset;
+	template<class Archive> void serialize(Archive & ar, const unsigned int version) {
+		ar & partition_segment_offset;
+		ar & footer_segment_offset;
+	}
+};
+struct global_partition_metadata_t {
+	IndexIOTypes::domain_t domain;
+	template<class Archive> void serialize(Archive & ar, const unsigned int version) {
+		ar & domain.first;
+		ar & domain.second;
+	}
+};
+struct footer_t {
+	std::vector< uint64_t > partition_offsets;
+	std::vector< global_partition_metadata_t > partition_metadatas;
+	template<class Archive> void serialize(Archive & ar, const unsigned int version) {
+		ar & partition_offsets;
+		ar & partition_metadatas;
+	}
+};
+struct partition_metadata_t {
+	char indexed_datatype;
+	IndexIOTypes::domain_t domain;
+	boost::shared_ptr< const IndexEncoding > index_enc;
+	char index_rep;
+	boost::shared_ptr< const AbstractBinningSpecification > binning_spec;
+	template<class Archive> void serialize(Archive & ar, const unsigned int version) {
+		ar & indexed_datatype;
+		ar & domain.first;
+		ar & domain.second;
+		serialize_encoding(ar, index_enc);
+		ar & index_rep;
+		serialize_binning_type(ar, binning_spec);
+	}
+};
+struct partition_header_t {
+	partition_metadata_t pmeta;
+	std::vector< uint64_t > region_offsets;
+	template<class Archive> void serialize(Archive & ar, const unsigned int version) {
+		ar & pmeta;
+		ar & region_offsets;
+	}
+};
+
+template<typename T>
+static void write(std::ostream &out, const T &obj) {
+	boost::archive::simple_binary_oarchive binary_write(out, boost::archive::no_header);
+	binary_write << obj;
+}
+}
+BOOST_CLASS_IMPLEMENTATION(baseline_format::footer_t, boost::serialization::object_serializable)
+BOOST_CLASS_IMPLEMENTATION(baseline_format::partition_header_t, boost::serialization::object_serializable)
+
+// Writes a single-partition index in the baseline format, then checks it reads back intact, with element counts
+// computed from its regions
+template<typename RegionEncoderT>
+static void test_index_io_baseline(typename RegionEncoderT::RegionEncoderConfig conf, const std::vector<int> &domain, std::string indexfile) {
+	boost::shared_ptr< BinnedIndex > index = make_index< RegionEncoderT, int >(conf, domain);
+	std::vector< boost::shared_ptr< RegionEncoding > > regions;
+	index->get_regions(regions);
+
+	baseline_format::segment_offsets_header_t soh;
+	baseline_format::partition_header_t header;
+	baseline_format::footer_t footer;
+
+	header.pmeta.indexed_datatype = (char)Datatypes::CTypeToDatatypeID< int >::value;
+	header.pmeta.domain = IndexIOTypes::domain_t(0, domain.size());
+	header.pmeta.index_enc = index->get_encoding();
+	header.pmeta.index_rep = (char)index->get_representation_type();
+	header.pmeta.binning_spec = index->get_binning_specification();
+	header.region_offsets.assign(regions.size() + 1, 0);
+
+	const uint64_t soh_size = measure_serializable(soh, boost::archive::no_header);
+	const uint64_t header_size = measure_serializable(header, boost::archive::no_header);
+	measuring_stream mstream;
+	header.region_offsets[0] = header_size;
+	for (size_t i = 0; i < regions.size(); ++i) {
+		regions[i]->save_to_stream(mstream);
+		header.region_offsets[i + 1] = header_size + mstream.get_byte_count();
+	}
+
+	soh.partition_segment_offset = soh_size;
+	soh.footer_segment_offset = soh_size + header.region_offsets.back();
+	footer.partition_offsets = { soh.partition_segment_offset, soh.footer_segment_offset };
+	footer.partition_metadatas.push_back(baseline_format::global_partition_metadata_t{ header.pmeta.domain });
+
+	{
+		std::ofstream out(indexfile, std::ios::out | std::ios::binary | std::ios::trunc);
+		baseline_format::write(out, soh);
+		baseline_format::write(out, header);
+		for (boost::shared_ptr< RegionEncoding > region : regions)
+			region->save_to_stream(out);
+		baseline_format::write(out, footer);
+		assert(out.good());
+	}
+
+	verify_index(index, indexfile, 0, 1);
+
+	POSIXIndexIO indexio;
+	assert(indexio.open(indexfile, IndexOpenMode::READ));
+	const IndexIO::GlobalPartitionMetadata gpmeta = indexio.get_partition_metadata(0);
+	assert(!gpmeta.index_rep && !gpmeta.zone_map);
+
+	boost::shared_ptr< IndexPartitionIO > partio = indexio.get_partition(0);
+	assert(!partio->get_partition_metadata().grid);
+	for (BinnedIndexTypes::region_id_t lb = 0; lb < regions.size(); ++lb) {
+		uint64_t expected_count = 0;
+		for (BinnedIndexTypes::region_id_t ub = lb + 1; ub <= regions.size(); ++ub) {
+			expected_count += regions[ub - 1]->get_element_count();
+			assert(partio->compute_regions_element_count(lb, ub) == expected_count);
+		}
+	}
+	assert(partio->close());
+	assert(indexio.close());
+}
+
 int main(int argc, char **argv) {
 	char *tempdir_cstr = std::getenv("testworkdir");
 	std::string tempdir = (tempdir_cstr ? tempdir_cstr : "test.work.dir");
@@ -89,6 +249,13 @@ int main(int argc, char **argv) {
 	test_index_io< WAHRegionEncoder >(WAHRegionEncoderConfig(), big_domain, tempfile);
 	test_index_io< CBLQRegionEncoder<2> >(CBLQRegionEncoderConfig(false), big_domain, tempfile);
 	test_index_io< CBLQRegionEncoder<2> >(CBLQRegionEncoderConfig(true), big_domain, tempfile);
+
+	test_index_io_append< IIRegionEncoder >(IIRegionEncoderConfig(), SMALL_DOMAIN, tempfile);
+	test_index_io_append< CIIRegionEncoder >(CIIRegionEncoderConfig(), big_domain, tempfile);
+	test_index_io_append< CBLQRegionEncoder<2> >(CBLQRegionEncoderConfig(false), big_domain, tempfile);
+
+	test_index_io_baseline< IIRegionEncoder >(IIRegionEncoderConfig(), SMALL_DOMAIN, tempfile);
+	test_index_io_baseline< CBLQRegionEncoder<2> >(CBLQRegionEncoderConfig(true), big_domain, tempfile);
 }
 
 
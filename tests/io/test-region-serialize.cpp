@@ -38,6 +38,8 @@
 #include "pique/region/cblq/cblq-encode.hpp"
 #include "pique/region/wah/wah.hpp"
 #include "pique/region/wah/wah-encode.hpp"
+#include "pique/region/wah/wah64.hpp"
+#include "pique/region/wah/wah64-encode.hpp"
 
 const uint64_t region_size = 16;
 const uint64_t region1_counts[] = {3, 4, 1, 3, 4, 1, 0, 0};
@@ -90,10 +92,16 @@ static void test_serialization(typename RegionEncoderT::RegionEncoderConfig conf
 
 int main(int argc, char **argv) {
 	test_serialization< IIRegionEncoder >(IIRegionEncoderConfig(), (uint64_t)(8 + 8 * 4));
-	test_serialization< CIIRegionEncoder >(CIIRegionEncoderConfig(), (uint64_t)(37));
+#ifdef HAVE_RIDCOMPRESS
+	test_serialization< CIIRegionEncoder >(CIIRegionEncoderConfig(CIICompressionFormat::PFOR_DELTA), (uint64_t)(37));
+#endif
+	test_serialization< CIIRegionEncoder >(CIIRegionEncoderConfig(CIICompressionFormat::BP128), (uint64_t)(1 + 4 + 8 + (8 + 4 * 16) + 8 + 1 * 8));
+	test_serialization< CBLQRegionEncoder<1> >(CBLQRegionEncoderConfig(false), (uint64_t)(8 + 8 + (11 * 4 + 7) / 8)); // 1D words are packed, 4 bits each
+	test_serialization< CBLQRegionEncoder<1> >(CBLQRegionEncoderConfig(true), (uint64_t)(8 + 8 + (7 * 4 + 7) / 8 + 8 + (4 * 2 + 7) / 8));
 	test_serialization< CBLQRegionEncoder<2> >(CBLQRegionEncoderConfig(false), (uint64_t)(8 + 1 * 5));
 	test_serialization< CBLQRegionEncoder<2> >(CBLQRegionEncoderConfig(true), (uint64_t)(8 + 1 * 1 + 1 * 4 / 2));
 	test_serialization< WAHRegionEncoder >(WAHRegionEncoderConfig(), (uint64_t)(0));
+	test_serialization< WAH64RegionEncoder >(WAH64RegionEncoderConfig(), (uint64_t)(8 + 8 + 8 + 1 * 8));
 }
 
 
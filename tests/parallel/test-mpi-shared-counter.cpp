@@ -0,0 +1,84 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * test-mpi-shared-counter.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include <mpi.h>
+
+#include "pique/parallel/util/mpi-shared-counter.hpp"
+
+// All ranks draw from the counter concurrently (as ranks claim partitions under dynamic assignment), with ranks
+// drawing different amounts; every value below the final total must be drawn by exactly one rank
+static void do_test(MPI_Comm comm, int hostrank, uint64_t initial_value) {
+	int rank, size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+
+	const int ndraws = 100 * (rank + 1);
+	std::vector< uint64_t > drawn;
+	{
+		MPISharedCounter counter(comm, hostrank, initial_value);
+		for (int i = 0; i < ndraws; ++i)
+			drawn.push_back(counter.fetch_and_add(1));
+	}
+	assert(std::is_sorted(drawn.begin(), drawn.end())); // Each rank's own draws only ever increase
+
+	std::vector< int > counts(size), displs(size);
+	MPI_Gather(&ndraws, 1, MPI_INT, &counts.front(), 1, MPI_INT, 0, comm);
+	for (int r = 1; r < size; ++r)
+		displs[r] = displs[r - 1] + counts[r - 1];
+
+	std::vector< uint64_t > all_drawn(rank == 0 ? displs.back() + counts.back() : 0);
+	MPI_Gatherv(&drawn.front(), ndraws, MPI_UINT64_T, rank == 0 ? &all_drawn.front() : nullptr, &counts.front(), &displs.front(), MPI_UINT64_T, 0, comm);
+
+	if (rank == 0) {
+		std::sort(all_drawn.begin(), all_drawn.end());
+		for (uint64_t i = 0; i < all_drawn.size(); ++i) {
+			if (all_drawn[i] != initial_value + i) {
+				std::cerr << "Error: shared counter value " << (initial_value + i) << " was not drawn exactly once (host rank " << hostrank << ")" << std::endl;
+				abort();
+			}
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	MPI_Init(&argc, &argv);
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+	if (MPISharedCounter::is_supported()) {
+		do_test(MPI_COMM_WORLD, 0, 0);
+		do_test(MPI_COMM_WORLD, size - 1, 1000);
+	} else if (rank == 0) {
+		std::cerr << "MPI-3 one-sided communication unavailable, skipping shared counter test" << std::endl;
+	}
+
+	MPI_Finalize();
+	return 0;
+}
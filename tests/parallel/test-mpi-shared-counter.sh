@@ -0,0 +1,3 @@
+#!/bin/bash
+
+$MPIRUN -$MPIRUN_NP $NPROC ./test-mpi-shared-counter
\ No newline at end of file
@@ -27,6 +27,8 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <fstream>
+#include <limits>
 #include <boost/smart_ptr.hpp>
 #include <boost/make_shared.hpp>
 
@@ -59,15 +61,31 @@ make_dataset(const std::vector<int> &domain) {
 	return dataset;
 }
 
+// Writes the domain to a raw file (on the master), so the parallel build reads it from disk (exercising data prefetching)
+static boost::shared_ptr< Dataset > make_raw_dataset(const std::vector<int> &domain, std::string datafile) {
+	int rank;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	if (rank == 0) {
+		std::ofstream fout(datafile, std::ios::out | std::ios::binary | std::ios::trunc);
+		fout.write((const char*)&domain.front(), domain.size() * sizeof(int));
+		fout.close();
+		assert(!fout.fail());
+	}
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	return boost::make_shared< RawDataset >(datafile, Grid{domain.size()}, Datatypes::IndexableDatatypeID::SINT_32);
+}
+
 template<typename RegionEncoderT>
-void do_test(typename RegionEncoderT::RegionEncoderConfig conf, const std::vector< int > &domain, std::string indexfile, Dataset::dataset_length_t partition_domain_size) {
+void do_test(typename RegionEncoderT::RegionEncoderConfig conf, const std::vector< int > &domain, std::string indexfile, Dataset::dataset_length_t partition_domain_size, bool raw_dataset = false, bool dynamic_assignment = true) {
 	using SigbitsBinningSpec = SigbitsBinningSpecification< int >;
 
 	boost::shared_ptr< InMemoryDataset<int> > dataset = make_dataset(domain);
+	boost::shared_ptr< Dataset > pll_dataset = (raw_dataset ? make_raw_dataset(domain, indexfile + ".rawdata") : dataset);
 
 	{
 		ParallelIndexGenerator< int, RegionEncoderT, SigbitsBinningSpec > pll_index_gen(MPI_COMM_WORLD, conf, boost::make_shared< SigbitsBinningSpec >(sizeof(int)*8));
-		pll_index_gen.generate_index(indexfile, *dataset, partition_domain_size);
+		pll_index_gen.generate_index(indexfile, *pll_dataset, partition_domain_size, false, 0, std::numeric_limits<uint64_t>::max(), true, dynamic_assignment);
 	}
 
 	// Now, the master process will perform a serial version of the index build, and will verify all partitions
@@ -107,7 +125,26 @@ void do_test(typename RegionEncoderT::RegionEncoderConfig conf, const std::vecto
 			std::cerrr << "Checking partition " << (partid+1) << " of " << expected_partition_count << "..." << std::endl;
 #endif
 			verify_index< POSIXIndexIO >(part_indexes[partid], indexfile + ".serialcompare", this_part_domain_off, expected_partition_count);
+			verify_index< POSIXIndexIO >(part_indexes[partid], indexfile, this_part_domain_off, expected_partition_count); // Partitions may be in any order, but are found by domain offset
+		}
+
+		// Each partition's footer metadata, including its zone map, must match that of the serial build
+		POSIXIndexIO pll_iio, serial_iio;
+		assert(pll_iio.open(indexfile, IndexOpenMode::READ));
+		assert(serial_iio.open(indexfile + ".serialcompare", IndexOpenMode::READ));
+		const std::vector< IndexIOTypes::domain_mapping_t > pll_mappings = pll_iio.get_sorted_partition_domain_mappings();
+		const std::vector< IndexIOTypes::domain_mapping_t > serial_mappings = serial_iio.get_sorted_partition_domain_mappings();
+		assert(pll_mappings.size() == serial_mappings.size());
+		for (size_t i = 0; i < pll_mappings.size(); ++i) {
+			const IndexIO::GlobalPartitionMetadata pll_gpmeta = pll_iio.get_partition_metadata(pll_mappings[i].first);
+			const IndexIO::GlobalPartitionMetadata serial_gpmeta = serial_iio.get_partition_metadata(serial_mappings[i].first);
+			assert(pll_gpmeta.domain == serial_gpmeta.domain);
+			assert(pll_gpmeta.index_rep && pll_gpmeta.zone_map);
+			assert(*pll_gpmeta.index_rep == *serial_gpmeta.index_rep);
+			assert(pll_gpmeta.zone_map->get_all_bin_keys() == serial_gpmeta.zone_map->get_all_bin_keys());
 		}
+		pll_iio.close();
+		serial_iio.close();
 	}
 }
 
@@ -125,6 +162,8 @@ int main(int argc, char **argv) {
 	std::vector<int> big_domain = make_big_domain(1ULL << 14, 30);
 
 	do_test< IIRegionEncoder >(IIRegionEncoderConfig(), big_domain, tempfile, big_domain.size() / 4 / 4); // divide by 4 for expected MPI size, divide by 4 again for desired partitiosn per rank
+	do_test< IIRegionEncoder >(IIRegionEncoderConfig(), big_domain, tempfile, big_domain.size() / 4 / 4, true);
+	do_test< IIRegionEncoder >(IIRegionEncoderConfig(), big_domain, tempfile, big_domain.size() / 4 / 4, true, false);
 
 	MPI_Finalize();
 }
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * test-query-aggregates.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include "pique/data/grid.hpp"
+#include "pique/data/dataset.hpp"
+#include "pique/region/region-encoding.hpp"
+#include "pique/indexing/binned-index.hpp"
+#include "pique/indexing/index-builder.hpp"
+#include "pique/setops/setops.hpp"
+
+#include "pique/region/bitmap/bitmap.hpp"
+#include "pique/region/bitmap/bitmap-encode.hpp"
+#include "pique/setops/bitmap/bitmap-setops.hpp"
+
+#include "pique/io/index-io.hpp"
+#include "pique/io/posix/posix-index-io.hpp"
+
+#include "pique/query/basic-query-engine.hpp"
+
+#include "make-index.hpp"
+#include "write-and-verify-index.hpp"
+#include "write-dataset-metafile.hpp"
+#include "standard-datasets.hpp"
+
+static boost::shared_ptr< InMemoryDataset<int> >
+make_dataset(const std::vector<int> &domain) {
+	boost::shared_ptr< InMemoryDataset<int> > dataset = boost::make_shared< InMemoryDataset<int> >((std::vector<int>(domain)), Grid{domain.size()});
+
+	return dataset;
+}
+
+static boost::shared_ptr< Database > make_database(std::string indexfile, std::string datametafile) {
+	boost::shared_ptr< Database > db = boost::make_shared< Database >();
+	boost::shared_ptr< DataVariable > var = boost::make_shared< DataVariable >("var", datametafile, indexfile);
+
+	db->add_variable(var);
+	return db;
+}
+
+static uint64_t brute_force_count(const std::vector<int> &domain, int lb, int ub) { // [lb, ub]
+	uint64_t count = 0;
+	for (int v : domain)
+		if (v >= lb && v <= ub)
+			++count;
+	return count;
+}
+
+static Query make_constraint_query(int lb, int ub) {
+	Query q;
+	q.push_back(boost::make_shared< ConstraintTerm >("var", UniversalValue(lb), UniversalValue(ub)));
+	return q;
+}
+
+static void do_test(const std::string testname, const std::vector<int> &domain, int maxval, IndexEncoding::Type enc_type, std::string indexfile, std::string datametafile) {
+	boost::shared_ptr< BitmapSetOperations > setops = boost::make_shared< BitmapSetOperations >(BitmapSetOperationsConfig());
+
+	boost::shared_ptr< InMemoryDataset<int> > dataset = make_dataset(domain);
+	boost::shared_ptr< BinnedIndex > flat_index = make_index< BitmapRegionEncoder, int >(BitmapRegionEncoderConfig(), dataset);
+
+	boost::shared_ptr< BinnedIndex > index;
+	if (enc_type == IndexEncoding::Type::EQUALITY)
+		index = flat_index;
+	else
+		index = IndexEncoding::get_encoded_index(IndexEncoding::get_instance(enc_type), flat_index, *setops);
+
+	write_dataset_metadata_file(*dataset, datametafile);
+	write_and_verify_index(index, indexfile);
+
+	boost::shared_ptr< Database > db = make_database(indexfile, datametafile);
+	BasicQueryEngine qe(setops);
+	qe.open(db);
+
+	// Single-constraint counts
+	for (int lb = 0; lb <= maxval; ++lb) {
+		for (int ub = lb; ub <= maxval; ++ub) {
+			const uint64_t count = qe.count(make_constraint_query(lb, ub));
+			if (count != brute_force_count(domain, lb, ub)) {
+				std::cerr << "Error: test \"" << testname << "\", count for [" << lb << ", " << ub << "] was " << count << ", expected " << brute_force_count(domain, lb, ub) << std::endl;
+				abort();
+			}
+		}
+	}
+
+	// Compound query count (evaluation fallback)
+	const Query compound = make_constraint_query(0, maxval / 2) | make_constraint_query(maxval, maxval);
+	assert(qe.count(compound) == brute_force_count(domain, 0, maxval / 2) + brute_force_count(domain, maxval, maxval));
+
+	// Histogram over half-open buckets [0, 1), [1, maxval), [maxval, maxval + 1)
+	const std::vector< UniversalValue > bucket_bounds = { UniversalValue(0), UniversalValue(1), UniversalValue(maxval), UniversalValue(maxval + 1) };
+	const std::vector< uint64_t > hist = qe.histogram("var", bucket_bounds);
+	assert(hist.size() == 3);
+	assert(hist[0] == brute_force_count(domain, 0, 0));
+	assert(hist[1] == brute_force_count(domain, 1, maxval - 1));
+	assert(hist[2] == brute_force_count(domain, maxval, maxval));
+
+	qe.close();
+}
+
+int main(int argc, char **argv) {
+	using EncType = IndexEncoding::Type;
+
+	char *tempdir_cstr = std::getenv("testworkdir");
+	std::string tempdir = (tempdir_cstr ? tempdir_cstr : "test.work.dir");
+
+	std::string indexfile = tempdir + "/test-query-aggregates.index";
+	std::string datametafile = tempdir + "/test-query-aggregates.meta";
+
+	for (EncType enc_type : { EncType::EQUALITY, EncType::RANGE, EncType::BINARY_COMPONENT }) {
+		do_test("small", SMALL_DOMAIN, 2, enc_type, indexfile, datametafile);
+		do_test("medium", MEDIUM_DOMAIN, 5, enc_type, indexfile, datametafile);
+		do_test("big", BIG_DOMAIN, 9, enc_type, indexfile, datametafile);
+	}
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * test-query-batch.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include "pique/data/grid.hpp"
+#include "pique/data/dataset.hpp"
+#include "pique/region/region-encoding.hpp"
+#include "pique/indexing/binned-index.hpp"
+#include "pique/indexing/index-builder.hpp"
+#include "pique/setops/setops.hpp"
+
+#include "pique/region/bitmap/bitmap.hpp"
+#include "pique/region/bitmap/bitmap-encode.hpp"
+#include "pique/setops/bitmap/bitmap-setops.hpp"
+
+#include "pique/io/index-io.hpp"
+#include "pique/io/posix/posix-index-io.hpp"
+
+#include "pique/query/basic-query-engine.hpp"
+
+#include "make-index.hpp"
+#include "write-and-verify-index.hpp"
+#include "write-dataset-metafile.hpp"
+#include "standard-datasets.hpp"
+
+static Query make_constraint_query(std::string varname, int lb, int ub) {
+	Query q;
+	q.push_back(boost::make_shared< ConstraintTerm >(varname, UniversalValue(lb), UniversalValue(ub)));
+	return q;
+}
+
+static Query make_complement_query(Query q) {
+	q.push_back(boost::make_shared< UnaryOperatorTerm >(UnarySetOperation::COMPLEMENT));
+	return q;
+}
+
+static void do_test(IndexEncoding::Type enc_type, bool rewrite_queries, std::string indexfile, std::string datametafile) {
+	boost::shared_ptr< BitmapSetOperations > setops = boost::make_shared< BitmapSetOperations >(BitmapSetOperationsConfig());
+
+	boost::shared_ptr< InMemoryDataset<int> > dataset = boost::make_shared< InMemoryDataset<int> >(std::vector<int>(BIG_DOMAIN), Grid{BIG_DOMAIN.size()});
+	boost::shared_ptr< BinnedIndex > index = make_index< BitmapRegionEncoder, int >(BitmapRegionEncoderConfig(), dataset);
+	if (enc_type != IndexEncoding::Type::EQUALITY)
+		index = IndexEncoding::get_encoded_index(IndexEncoding::get_instance(enc_type), index, *setops);
+
+	write_dataset_metadata_file(*dataset, datametafile);
+	write_and_verify_index(index, indexfile);
+
+	// Two variables over the same index, so that constraints on both appear in the batch
+	boost::shared_ptr< Database > db = boost::make_shared< Database >();
+	db->add_variable(boost::make_shared< DataVariable >("var", datametafile, indexfile));
+	db->add_variable(boost::make_shared< DataVariable >("var2", datametafile, indexfile));
+
+	BasicQueryEngine qe(setops, QueryEngineOptions(QueryEngineOptions::ComplementMode::AUTO, rewrite_queries));
+	qe.open(db);
+
+	const std::vector< Query > queries = {
+		make_constraint_query("var", 1, 3),
+		make_constraint_query("var", 1, 3) & make_constraint_query("var", 2, 7), // Repeats the first query's constraint
+		make_complement_query(make_constraint_query("var", 2, 7)),
+		make_constraint_query("var2", 0, 9) | make_constraint_query("var", 4, 5),
+		make_constraint_query("var", 1, 3),                                      // Repeats the first query entirely
+		make_constraint_query("var", 2, 7) & make_constraint_query("var", 1, 3), // Repeats the second query, reordered
+		make_complement_query(make_constraint_query("var", 2, 7)),               // Repeats the third query entirely
+	};
+
+	boost::shared_ptr< QueryEngine::BatchQueryCursor > batch_cursor = qe.evaluate_batch(queries);
+	size_t ndomains = 0;
+	while (batch_cursor->has_next()) {
+		const QueryEngine::domain_id_t domain_id = batch_cursor->get_current_domain_id();
+		const std::vector< QueryEngine::QueryPartitionResult > batch_results = batch_cursor->next();
+		assert(batch_results.size() == queries.size());
+
+		// Each batch result must match independent evaluation of the same query
+		for (size_t q = 0; q < queries.size(); ++q) {
+			QueryEngine::QueryStats qstats;
+			boost::shared_ptr< RegionEncoding > expected = qe.evaluate(queries[q], domain_id, qstats);
+			if (*batch_results[q].result != *expected) {
+				std::cerr << "Error: batch query " << q << " result differs from independent evaluation (encoding " << (int)enc_type << ")" << std::endl;
+				abort();
+			}
+			assert(batch_results[q].partition == domain_id);
+		}
+
+		// Identical constraints are evaluated once, so their stats are shared between queries
+		auto shares_terminfo = [&batch_results](size_t q1, size_t t1, size_t q2) -> bool {
+			const auto &terminfos2 = batch_results[q2].stats.terminfos;
+			return std::find(terminfos2.begin(), terminfos2.end(), batch_results[q1].stats.terminfos[t1]) != terminfos2.end();
+		};
+		assert(batch_results[0].stats.terminfos[0] == batch_results[4].stats.terminfos[0]);
+		if (!rewrite_queries) {
+			assert(shares_terminfo(0, 0, 1));
+			assert(shares_terminfo(2, 0, 1));
+			assert(shares_terminfo(2, 0, 6));
+		} else {
+			// Each same-variable query is rewritten into one variable expression, shared with any other having the same bin ranges
+			assert(batch_results[1].stats.terminfos.size() == 1 && batch_results[2].stats.terminfos.size() == 1);
+			assert(batch_results[1].stats.terminfos[0] == batch_results[5].stats.terminfos[0]);
+			assert(batch_results[2].stats.terminfos[0] == batch_results[6].stats.terminfos[0]);
+		}
+
+		++ndomains;
+	}
+	assert(ndomains == 1);
+
+	// An empty batch, or a query without constraints, has no variable index to define its domains, so it yields none
+	assert(!qe.evaluate_batch(std::vector< Query >())->has_next());
+	assert(!qe.evaluate(Query())->has_next());
+	assert(qe.count(Query()) == 0);
+
+	qe.close();
+}
+
+int main(int argc, char **argv) {
+	using EncType = IndexEncoding::Type;
+
+	char *tempdir_cstr = std::getenv("testworkdir");
+	std::string tempdir = (tempdir_cstr ? tempdir_cstr : "test.work.dir");
+
+	std::string indexfile = tempdir + "/test-query-batch.index";
+	std::string datametafile = tempdir + "/test-query-batch.meta";
+
+	for (EncType enc_type : { EncType::EQUALITY, EncType::RANGE, EncType::INTERVAL, EncType::BINARY_COMPONENT })
+		for (bool rewrite_queries : { false, true })
+			do_test(enc_type, rewrite_queries, indexfile, datametafile);
+}
@@ -39,6 +39,15 @@
 #include "pique/region/bitmap/bitmap-encode.hpp"
 #include "pique/setops/bitmap/bitmap-setops.hpp"
 
+#include "pique/region/cblq/cblq.hpp"
+#include "pique/region/cblq/cblq-encode.hpp"
+#include "pique/setops/cblq/cblq-setops.hpp"
+
+#include "pique/setops/ii/ii-setops.hpp"
+#include "pique/setops/cii/cii-setops.hpp"
+#include "pique/setops/wah/wah-setops.hpp"
+#include "pique/setops/wah/wah64-setops.hpp"
+
 #include "pique/io/index-io.hpp"
 #include "pique/io/posix/posix-index-io.hpp"
 
@@ -93,20 +102,39 @@ struct TestCase {
 	const std::pair< int, int > bins_to_test;
 };
 
-template<typename RegionEncoderT, typename SetOperationsT>
-static boost::shared_ptr< Database >
+// The set operations build-index encodes indexes with
+static boost::shared_ptr< AbstractSetOperations > make_build_index_setops() {
+	boost::shared_ptr< PreferenceListSetOperations > setops = boost::make_shared< PreferenceListSetOperations >();
+	setops->push_back(boost::make_shared< IISetOperations >(IISetOperationsConfig()));
+	setops->push_back(boost::make_shared< CIISetOperations >(CIISetOperationsConfig(true)));
+	setops->push_back(boost::make_shared< CBLQSetOperationsFast<1> >(CBLQSetOperationsConfig(true)));
+	setops->push_back(boost::make_shared< CBLQSetOperationsFast<2> >(CBLQSetOperationsConfig(true)));
+	setops->push_back(boost::make_shared< CBLQSetOperationsFast<3> >(CBLQSetOperationsConfig(true)));
+	setops->push_back(boost::make_shared< CBLQSetOperationsFast<4> >(CBLQSetOperationsConfig(true)));
+	setops->push_back(boost::make_shared< WAHSetOperations >(WAHSetOperationsConfig(true)));
+	setops->push_back(boost::make_shared< WAH64SetOperations >(WAH64SetOperationsConfig()));
+	return setops;
+}
+
+// An index to query, and the set operations to encode and query it with
+struct TestIndex {
+	std::string name;
+	boost::shared_ptr< Database > db;
+	boost::shared_ptr< AbstractSetOperations > setops;
+};
+
+template<typename RegionEncoderT>
+static TestIndex
 prepare_test(
 	const TestCase &test,
+	std::string index_name,
 	typename RegionEncoderT::RegionEncoderConfig conf,
 	IndexEncoding::Type enc_type,
-	typename SetOperationsT::SetOperationsConfig setops_conf,
+	boost::shared_ptr< AbstractSetOperations > setops,
 	std::string indexfile,
-	std::string datametafile)
+	std::string datametafile,
+	int nthreads = 1)
 {
-	typedef typename RegionEncoderT::RegionEncodingOutT RegionEncodingT;
-
-	boost::shared_ptr< SetOperationsT > setops = boost::make_shared< SetOperationsT >(setops_conf);
-
 	boost::shared_ptr< InMemoryDataset<int> > dataset = make_dataset(test.domain);
 	boost::shared_ptr< BinnedIndex > flat_index = make_index< RegionEncoderT, int >(conf, dataset);
 
@@ -114,38 +142,30 @@ prepare_test(
 	if (enc_type == IndexEncoding::Type::EQUALITY)
 		index = flat_index;
 	else
-		index = IndexEncoding::get_encoded_index(IndexEncoding::get_instance(enc_type), flat_index, *setops);
+		index = IndexEncoding::get_encoded_index(IndexEncoding::get_instance(enc_type), flat_index, *setops, nthreads);
 
 	write_dataset_metadata_file(*dataset, datametafile);
 	write_and_verify_index(index, indexfile);
 
-	boost::shared_ptr< Database > db = make_database(indexfile, datametafile);
-	return db;
+	return TestIndex{ index_name, make_database(indexfile, datametafile), setops };
 }
 
-static void do_test(
-	const TestCase &test,
-	std::vector< std::string > index_names,
-	std::vector< boost::shared_ptr< Database > > dbs,
-	boost::shared_ptr< AbstractSetOperations > setops)
-{
+static void do_test(const TestCase &test, const std::vector< TestIndex > &indexes) {
 	QueryEngine::QueryStats qinfo;
+	std::vector< uint32_t > oracle_rids, result_rids;
 	for (int lb = test.bins_to_test.first; lb < test.bins_to_test.second; ++lb) {
 		for (int ub = lb + 1; ub < test.bins_to_test.second; ++ub) {
 			const std::pair< int, int > bin_range{lb, ub};
 
-			auto db_it = dbs.begin(), db_end_it = dbs.end();
-			auto index_name_it = index_names.begin();
+			// Indexes may differ in representation, so compare their results' RIDs
+			const TestIndex &oracle = indexes.front();
+			run_query(oracle.db, oracle.setops, bin_range, qinfo)->convert_to_rids(oracle_rids, true, true);
 
-			const std::string oracle_name = *index_name_it++;
-			const boost::shared_ptr< RegionEncoding > oracle_region = run_query(*db_it++, setops, bin_range, qinfo);
+			for (auto index_it = indexes.begin() + 1; index_it != indexes.end(); ++index_it) {
+				run_query(index_it->db, index_it->setops, bin_range, qinfo)->convert_to_rids(result_rids, true, true);
 
-			while (db_it != db_end_it) {
-				const std::string index_name = *index_name_it++;
-				boost::shared_ptr< RegionEncoding > result_region = run_query(*db_it++, setops, bin_range, qinfo);
-
-				if (*result_region != *oracle_region) {
-					std::cerr << "Error: for query [" << lb << ", " << (ub+1) << "), index \"" << index_name << "\" result doesn't match oracle index \"" << oracle_name << "\"" << std::endl;
+				if (result_rids != oracle_rids) {
+					std::cerr << "Error: for query [" << lb << ", " << (ub+1) << "), index \"" << index_it->name << "\" result doesn't match oracle index \"" << oracle.name << "\"" << std::endl;
 					abort();
 				}
 			}
@@ -176,24 +196,41 @@ int main(int argc, char **argv) {
 		{ "interval", EncType::INTERVAL },
 		{ "hier", EncType::HIERARCHICAL },
 		{ "binarycomp", EncType::BINARY_COMPONENT },
+		{ "multires", EncType::MULTI_RESOLUTION },
 	};
 
 	for (const TestCase &test : TEST_CASES) {
-		std::vector< boost::shared_ptr< Database > > dbs;
-		std::vector< std::string > index_filenames;
+		std::vector< TestIndex > indexes;
 		boost::shared_ptr< BitmapSetOperations > setops = boost::make_shared< BitmapSetOperations >(BitmapSetOperationsConfig());
 
 		for (auto enc : encs) {
 			const std::string enc_name = enc.first;
 			const EncType enc_type = enc.second;
-			index_filenames.push_back(indexfile_prefix + enc_name + indexfile_suffix);
-			dbs.push_back(prepare_test< BitmapRegionEncoder, BitmapSetOperations >(test, BitmapRegionEncoderConfig(), enc_type, BitmapSetOperationsConfig(), index_filenames.back(), datametafile));
+			indexes.push_back(prepare_test< BitmapRegionEncoder >(test, enc_name, BitmapRegionEncoderConfig(), enc_type, setops, indexfile_prefix + enc_name + indexfile_suffix, datametafile));
 		}
 
-		do_test(test, index_filenames, dbs, setops);
-	}
-}
-
-
+		// Also build each encoded index concurrently, which must give the same query results
+		for (auto enc : encs) {
+			const std::string enc_name = enc.first + "-parallel";
+			const EncType enc_type = enc.second;
+			indexes.push_back(prepare_test< BitmapRegionEncoder >(test, enc_name, BitmapRegionEncoderConfig(), enc_type, setops, indexfile_prefix + enc_name + indexfile_suffix, datametafile, 3));
+		}
 
+		// Likewise with CBLQ set operations (whose n-ary operations keep per-thread state), both directly and through the
+		// preference list build-index encodes with
+		for (auto enc : encs) {
+			const std::string enc_name = enc.first + "-cblq-parallel";
+			const EncType enc_type = enc.second;
+			indexes.push_back(prepare_test< CBLQRegionEncoder<1> >(test, enc_name, CBLQRegionEncoderConfig(false), enc_type,
+					boost::make_shared< CBLQSetOperations<1> >(CBLQSetOperationsConfig(true)), indexfile_prefix + enc_name + indexfile_suffix, datametafile, 3));
+		}
+		for (auto enc : encs) {
+			const std::string enc_name = enc.first + "-preflist-parallel";
+			const EncType enc_type = enc.second;
+			indexes.push_back(prepare_test< CBLQRegionEncoder<1> >(test, enc_name, CBLQRegionEncoderConfig(false), enc_type,
+					make_build_index_setops(), indexfile_prefix + enc_name + indexfile_suffix, datametafile, 3));
+		}
 
+		do_test(test, indexes);
+	}
+}
@@ -232,7 +232,7 @@ int main(int argc, char **argv) {
 		qes["bitmap"] = make_bitmap_query_engine< CBLQToBitmapConverter<2>, BitmapSetOperations >(BitmapSetOperationsConfig());
 		qes["bitmap-df"] = make_bitmap_query_engine< CBLQToBitmapDFConverter<2>, BitmapSetOperations >(BitmapSetOperationsConfig());
 
-		std::vector< EncType > encs = {  EncType::EQUALITY, EncType::RANGE, EncType::INTERVAL, EncType::HIERARCHICAL, EncType::BINARY_COMPONENT, };
+		std::vector< EncType > encs = {  EncType::EQUALITY, EncType::RANGE, EncType::INTERVAL, EncType::HIERARCHICAL, EncType::BINARY_COMPONENT, EncType::MULTI_RESOLUTION, };
 		for (auto it = encs.begin(); it != encs.end(); ++it) {
 			const EncType enc_type = *it;
 			//do_test< WAHRegionEncoder, WAHSetOperations, WAHSetOperations >(test, WAHRegionEncoderConfig(), enc_type, WAHSetOperationsConfig(), WAHSetOperationsConfig(), indexfile, datametafile);
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * test-query-heterogeneous.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <set>
+#include <vector>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include "pique/data/grid.hpp"
+#include "pique/data/dataset.hpp"
+#include "pique/region/region-encoding.hpp"
+#include "pique/indexing/binned-index.hpp"
+#include "pique/indexing/representation-selector.hpp"
+#include "pique/convert/rid-stream-convert.hpp"
+
+#include "pique/region/bitmap/bitmap.hpp"
+#include "pique/region/bitmap/bitmap-encode.hpp"
+
+#include "pique/setops/setops.hpp"
+#include "pique/setops/ii/ii-setops.hpp"
+#include "pique/setops/cii/cii-setops.hpp"
+#include "pique/setops/cblq/cblq-setops.hpp"
+#include "pique/setops/wah/wah-setops.hpp"
+#include "pique/setops/wah/wah64-setops.hpp"
+#include "pique/setops/bitmap/bitmap-setops.hpp"
+
+#include "pique/io/index-io.hpp"
+#include "pique/io/posix/posix-index-io.hpp"
+
+#include "pique/query/basic-query-engine.hpp"
+
+#include "make-index.hpp"
+#include "write-and-verify-index.hpp"
+#include "write-dataset-metafile.hpp"
+
+using RegionType = RegionEncoding::Type;
+
+// Each partition holds the values [10*p, 10*p + 3], with one dense, one sparse, one clustered and one scattered value,
+// so value ranges drift across partitions (letting zone maps prune them) and bin densities differ widely
+static constexpr int NUM_PARTITIONS = 4;
+static constexpr uint64_t PARTITION_SIZE = 4096;
+
+static int make_value(int partition, uint64_t i) {
+	const int base = partition * 10;
+	if (i % 512 == 0)
+		return base + 1;
+	else if (i >= 1024 && i < 2048)
+		return base + 2;
+	else if (i % 3 == 0)
+		return base + 3;
+	else
+		return base;
+}
+
+static std::vector<int> make_partition_domain(int partition) {
+	std::vector<int> domain;
+	for (uint64_t i = 0; i < PARTITION_SIZE; ++i)
+		domain.push_back(make_value(partition, i));
+	return domain;
+}
+
+// All but the last partition store their regions in the candidate representations round-robin (so every candidate is
+// written, read and queried); the last one uses whichever candidate RegionRepresentationSelector finds smallest
+static boost::shared_ptr< BinnedIndex > make_heterogeneous_index(boost::shared_ptr< const BinnedIndex > flat_index, int partition) {
+	const std::vector< RegionType > candidates = RegionRepresentationSelector::get_default_candidate_types();
+
+	if (partition == NUM_PARTITIONS - 1)
+		return RegionRepresentationSelector(candidates).select_representations(flat_index);
+
+	RIDStreamRegionEncodingConverter converter;
+	std::vector< boost::shared_ptr< RegionEncoding > > regions;
+	flat_index->get_regions(regions);
+	for (size_t i = 0; i < regions.size(); ++i) {
+		regions[i] = converter.convert(regions[i], candidates[(partition + i) % candidates.size()]);
+		assert(regions[i]);
+	}
+
+	return flat_index->derive_new_index(RegionType::HETEROGENEOUS, std::move(regions));
+}
+
+// Writes the heterogeneous index, and the same index in uncompressed bitmaps as an oracle
+static void write_partitioned_indexes(std::string indexfile, std::string oraclefile) {
+	std::vector< boost::shared_ptr< BinnedIndex > > indexes;
+	std::set< RegionType > types_written;
+
+	POSIXIndexIO iio, oracle_iio;
+	assert(iio.open(indexfile, IndexOpenMode::WRITE));
+	assert(oracle_iio.open(oraclefile, IndexOpenMode::WRITE));
+
+	for (int p = 0; p < NUM_PARTITIONS; ++p) {
+		InMemoryDataset<int> dataset(make_partition_domain(p), Grid{PARTITION_SIZE});
+		boost::shared_ptr< BinnedIndex > flat_index = make_index< BitmapRegionEncoder, int >(BitmapRegionEncoderConfig(), dataset);
+
+		boost::shared_ptr< IndexPartitionIO > oracle_partio = oracle_iio.append_partition();
+		oracle_partio->set_domain_global_offset(p * PARTITION_SIZE);
+		assert(oracle_partio->write_index(*flat_index));
+		assert(oracle_partio->close());
+
+		indexes.push_back(make_heterogeneous_index(flat_index, p));
+		assert(indexes.back()->get_representation_type() == RegionType::HETEROGENEOUS);
+
+		std::vector< boost::shared_ptr< RegionEncoding > > regions;
+		indexes.back()->get_regions(regions);
+		for (const boost::shared_ptr< RegionEncoding > &region : regions)
+			types_written.insert(region->get_type());
+
+		boost::shared_ptr< IndexPartitionIO > partio = iio.append_partition();
+		partio->set_domain_global_offset(p * PARTITION_SIZE);
+		assert(partio->write_index(*indexes.back()));
+		assert(partio->close());
+	}
+
+	assert(iio.close());
+	assert(oracle_iio.close());
+
+	for (RegionType type : RegionRepresentationSelector::get_default_candidate_types())
+		assert(types_written.count(type));
+
+	// Each region must read back in its own representation, and every partition must have a zone map
+	for (int p = 0; p < NUM_PARTITIONS; ++p)
+		verify_index(indexes[p], indexfile, p * PARTITION_SIZE, NUM_PARTITIONS);
+
+	assert(iio.open(indexfile, IndexOpenMode::READ));
+	for (const IndexIO::GlobalPartitionMetadata &gpmeta : iio.get_all_partition_metadatas())
+		assert(gpmeta.zone_map && gpmeta.index_rep && *gpmeta.index_rep == RegionType::HETEROGENEOUS);
+	assert(iio.close());
+}
+
+static boost::shared_ptr< PreferenceListSetOperations > make_preflist_setops() {
+	boost::shared_ptr< PreferenceListSetOperations > setops = boost::make_shared< PreferenceListSetOperations >();
+	setops->push_back(boost::make_shared< IISetOperations >(IISetOperationsConfig()));
+	setops->push_back(boost::make_shared< CIISetOperations >(CIISetOperationsConfig(false)));
+	setops->push_back(boost::make_shared< WAHSetOperations >(WAHSetOperationsConfig()));
+	setops->push_back(boost::make_shared< WAH64SetOperations >(WAH64SetOperationsConfig())); // For regions synthesized from zone maps and spatial constraints
+	setops->push_back(boost::make_shared< CBLQSetOperations<1> >(CBLQSetOperationsConfig(true)));
+	setops->push_back(boost::make_shared< BitmapSetOperations >(BitmapSetOperationsConfig()));
+	return setops;
+}
+
+static boost::shared_ptr< Database > make_database(std::string indexfile, std::string datametafile) {
+	boost::shared_ptr< Database > db = boost::make_shared< Database >();
+	db->add_variable(boost::make_shared< DataVariable >("var", datametafile, indexfile));
+	return db;
+}
+
+// The query must select the same elements of each partition from the heterogeneous index as from the oracle index
+static void check_query(BasicQueryEngine &qe, BasicQueryEngine &oracle_qe, const Query &q, bool expect_zone_map_pruning) {
+	bool any_pruned = false;
+	for (int p = 0; p < NUM_PARTITIONS; ++p) {
+		QueryEngine::QueryStats qstats, oracle_qstats;
+		boost::shared_ptr< RegionEncoding > result = qe.evaluate(q, p, qstats);
+		boost::shared_ptr< RegionEncoding > oracle_result = oracle_qe.evaluate(q, p, oracle_qstats);
+
+		for (const boost::shared_ptr< QueryEngine::TermEvalStats > &terminfo : qstats.terminfos)
+			if (const QueryEngine::ConstraintTermEvalStats *cterm = dynamic_cast< const QueryEngine::ConstraintTermEvalStats * >(terminfo.get()))
+				any_pruned |= cterm->zone_map_pruned;
+
+		std::vector< uint32_t > rids, oracle_rids;
+		result->convert_to_rids(rids, true, true);
+		oracle_result->convert_to_rids(oracle_rids, true, true);
+
+		if (rids != oracle_rids) {
+			std::cerr << "Error: query result in partition " << p << " doesn't match the oracle index" << std::endl;
+			abort();
+		}
+	}
+
+	assert(any_pruned == expect_zone_map_pruning);
+}
+
+static Query make_constraint(int lb, int ub) {
+	Query q;
+	q.push_back(boost::make_shared< ConstraintTerm >("var", UniversalValue(lb), UniversalValue(ub)));
+	return q;
+}
+
+static Query make_box(uint64_t offset, uint64_t size) {
+	Query q;
+	q.push_back(boost::make_shared< SpatialConstraintTerm >("var", std::vector< uint64_t >{ offset }, std::vector< uint64_t >{ size }));
+	return q;
+}
+
+int main(int argc, char **argv) {
+	char *tempdir_cstr = std::getenv("testworkdir");
+	std::string tempdir = (tempdir_cstr ? tempdir_cstr : "test.work.dir");
+
+	std::string indexfile = tempdir + "/test-query-heterogeneous.index";
+	std::string oraclefile = tempdir + "/test-query-heterogeneous.oracle.index";
+	std::string datametafile = tempdir + "/test-query-heterogeneous.meta";
+
+	std::vector<int> full_domain;
+	for (int p = 0; p < NUM_PARTITIONS; ++p) {
+		const std::vector<int> part_domain = make_partition_domain(p);
+		full_domain.insert(full_domain.end(), part_domain.begin(), part_domain.end());
+	}
+	write_dataset_metadata_file(InMemoryDataset<int>(std::vector<int>(full_domain), Grid{full_domain.size()}), datametafile);
+
+	write_partitioned_indexes(indexfile, oraclefile);
+
+	BasicQueryEngine qe(make_preflist_setops());
+	BasicQueryEngine oracle_qe(boost::make_shared< BitmapSetOperations >(BitmapSetOperationsConfig()));
+	qe.open(make_database(indexfile, datametafile));
+	oracle_qe.open(make_database(oraclefile, datametafile));
+
+	const Query box = make_box(PARTITION_SIZE / 2, 2 * PARTITION_SIZE);
+
+	// Regions read from the index, in differing representations across partitions
+	check_query(qe, oracle_qe, make_constraint(1, 3), true);
+	check_query(qe, oracle_qe, make_constraint(0, 2) | make_constraint(11, 13), true);
+
+	// Whole partitions pruned by their zone maps, synthesized in HETEROGENEOUS_SYNTHESIZED_TYPE and combined with read regions
+	check_query(qe, oracle_qe, make_constraint(0, 100), true);
+	check_query(qe, oracle_qe, make_constraint(0, 100) & make_constraint(12, 23), true);
+
+	// Spatial constraints, also synthesized, combined with read and zone-map-synthesized regions
+	check_query(qe, oracle_qe, box, false);
+	check_query(qe, oracle_qe, box & make_constraint(11, 14), true);
+	check_query(qe, oracle_qe, box | make_constraint(0, 1), true);
+
+	qe.close();
+	oracle_qe.close();
+}
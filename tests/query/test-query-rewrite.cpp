@@ -0,0 +1,203 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * test-query-rewrite.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <typeinfo>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include "pique/data/grid.hpp"
+#include "pique/data/dataset.hpp"
+#include "pique/region/region-encoding.hpp"
+#include "pique/indexing/binned-index.hpp"
+#include "pique/indexing/index-builder.hpp"
+#include "pique/setops/setops.hpp"
+
+#include "pique/region/bitmap/bitmap.hpp"
+#include "pique/region/bitmap/bitmap-encode.hpp"
+#include "pique/setops/bitmap/bitmap-setops.hpp"
+
+#include "pique/io/index-io.hpp"
+#include "pique/io/posix/posix-index-io.hpp"
+
+#include "pique/query/query-rewriter.hpp"
+#include "pique/query/basic-query-engine.hpp"
+
+#include "make-index.hpp"
+#include "write-and-verify-index.hpp"
+#include "write-dataset-metafile.hpp"
+#include "standard-datasets.hpp"
+
+static Query make_constraint_query(std::string varname, int lb, int ub) {
+	Query q;
+	q.push_back(boost::make_shared< ConstraintTerm >(varname, UniversalValue(lb), UniversalValue(ub)));
+	return q;
+}
+
+static Query make_complement_query(Query q) {
+	q.push_back(boost::make_shared< UnaryOperatorTerm >(UnarySetOperation::COMPLEMENT));
+	return q;
+}
+
+static Query make_difference_query(Query left, const Query &right) {
+	left.insert(left.end(), right.begin(), right.end());
+	left.push_back(boost::make_shared< NAryOperatorTerm >(NArySetOperation::DIFFERENCE, 2));
+	return left;
+}
+
+static Query make_xor_query(Query left, const Query &right) {
+	left.insert(left.end(), right.begin(), right.end());
+	left.push_back(boost::make_shared< NAryOperatorTerm >(NArySetOperation::SYMMETRIC_DIFFERENCE, 2));
+	return left;
+}
+
+template<typename TermT>
+static const TermT & term_as(const Query &q, size_t i) {
+	assert(i < q.size() && typeid(*q[i]) == typeid(TermT));
+	return dynamic_cast< const TermT & >(*q[i]);
+}
+
+static void test_rewrite_structure() {
+	const Query x1 = make_constraint_query("x", 1, 3), x2 = make_constraint_query("x", 2, 7);
+	const Query y = make_constraint_query("y", 0, 4), z = make_constraint_query("z", 5, 9);
+
+	// Single-variable conjunctions and complements become one variable expression
+	{
+		const Query rq = QueryRewriter::rewrite(x1 & x2);
+		assert(rq.size() == 1);
+		assert(term_as< VariableExpressionTerm >(rq, 0).varname == "x");
+		assert(term_as< VariableExpressionTerm >(rq, 0).expr.size() == 3);
+
+		const Query rq2 = QueryRewriter::rewrite(make_complement_query(x1));
+		assert(rq2.size() == 1);
+		assert(term_as< VariableExpressionTerm >(rq2, 0).varname == "x");
+	}
+
+	// Single constraints are left alone
+	{
+		const Query rq = QueryRewriter::rewrite(y);
+		assert(rq.size() == 1);
+		assert(term_as< ConstraintTerm >(rq, 0).varname == "y");
+	}
+
+	// Nested unions are flattened into one higher-arity union
+	{
+		const Query rq = QueryRewriter::rewrite((x1 | y) | z);
+		assert(rq.size() == 4);
+		assert(term_as< NAryOperatorTerm >(rq, 3).op == NArySetOperation::UNION);
+		assert(term_as< NAryOperatorTerm >(rq, 3).arity == 3);
+	}
+
+	// Same-variable operands of a flattened intersection are grouped, even when not adjacent
+	{
+		const Query rq = QueryRewriter::rewrite((x1 & y) & (z & x2));
+		assert(rq.size() == 4);
+		assert(term_as< NAryOperatorTerm >(rq, 3).op == NArySetOperation::INTERSECTION);
+		assert(term_as< NAryOperatorTerm >(rq, 3).arity == 3);
+
+		int nexprs = 0;
+		for (size_t i = 0; i < 3; ++i) {
+			if (typeid(*rq[i]) == typeid(VariableExpressionTerm)) {
+				assert(term_as< VariableExpressionTerm >(rq, i).varname == "x");
+				++nexprs;
+			}
+		}
+		assert(nexprs == 1);
+	}
+
+	// Operators other than intersection/union are not restructured across variables
+	{
+		const Query rq = QueryRewriter::rewrite(make_difference_query(x1, y));
+		assert(rq.size() == 3);
+		assert(term_as< NAryOperatorTerm >(rq, 2).op == NArySetOperation::DIFFERENCE);
+	}
+}
+
+static void test_rewrite_results(IndexEncoding::Type enc_type, std::string indexfile, std::string datametafile) {
+	boost::shared_ptr< BitmapSetOperations > setops = boost::make_shared< BitmapSetOperations >(BitmapSetOperationsConfig());
+
+	boost::shared_ptr< InMemoryDataset<int> > dataset = boost::make_shared< InMemoryDataset<int> >(std::vector<int>(BIG_DOMAIN), Grid{BIG_DOMAIN.size()});
+	boost::shared_ptr< BinnedIndex > index = make_index< BitmapRegionEncoder, int >(BitmapRegionEncoderConfig(), dataset);
+	if (enc_type != IndexEncoding::Type::EQUALITY)
+		index = IndexEncoding::get_encoded_index(IndexEncoding::get_instance(enc_type), index, *setops);
+
+	write_dataset_metadata_file(*dataset, datametafile);
+	write_and_verify_index(index, indexfile);
+
+	boost::shared_ptr< Database > db = boost::make_shared< Database >();
+	db->add_variable(boost::make_shared< DataVariable >("var", datametafile, indexfile));
+	db->add_variable(boost::make_shared< DataVariable >("var2", datametafile, indexfile));
+
+	using CMode = QueryEngineOptions::ComplementMode;
+	BasicQueryEngine rewrite_qe(setops, QueryEngineOptions(CMode::AUTO, true));
+	BasicQueryEngine plain_qe(setops, QueryEngineOptions(CMode::AUTO, false));
+	rewrite_qe.open(db);
+	plain_qe.open(db);
+
+	const Query v13 = make_constraint_query("var", 1, 3), v27 = make_constraint_query("var", 2, 7), v89 = make_constraint_query("var", 8, 9);
+	const Query w05 = make_constraint_query("var2", 0, 5);
+
+	const std::vector< Query > queries = {
+		v13 & v27,
+		v13 | v89,
+		make_complement_query(v27),
+		make_complement_query(v13 | v89),
+		make_difference_query(v27, v13),
+		make_xor_query(v13, v27),
+		v13 & make_complement_query(v13),           // Empty
+		v13 | make_complement_query(v13),           // Full
+		(v13 | w05) | (v89 & w05),
+		(v27 & w05) & make_complement_query(v13),
+	};
+
+	for (size_t q = 0; q < queries.size(); ++q) {
+		QueryEngine::QueryStats rewrite_qstats, plain_qstats;
+		boost::shared_ptr< RegionEncoding > rewrite_result = rewrite_qe.evaluate(queries[q], 0, rewrite_qstats);
+		boost::shared_ptr< RegionEncoding > plain_result = plain_qe.evaluate(queries[q], 0, plain_qstats);
+		if (*rewrite_result != *plain_result) {
+			std::cerr << "Error: rewritten query " << q << " result differs from the unrewritten result (encoding " << (int)enc_type << ")" << std::endl;
+			abort();
+		}
+
+		assert(rewrite_qe.count(queries[q]) == plain_result->get_element_count());
+	}
+
+	rewrite_qe.close();
+	plain_qe.close();
+}
+
+int main(int argc, char **argv) {
+	using EncType = IndexEncoding::Type;
+
+	char *tempdir_cstr = std::getenv("testworkdir");
+	std::string tempdir = (tempdir_cstr ? tempdir_cstr : "test.work.dir");
+
+	std::string indexfile = tempdir + "/test-query-rewrite.index";
+	std::string datametafile = tempdir + "/test-query-rewrite.meta";
+
+	test_rewrite_structure();
+	for (EncType enc_type : { EncType::EQUALITY, EncType::RANGE, EncType::INTERVAL, EncType::BINARY_COMPONENT })
+		test_rewrite_results(enc_type, indexfile, datametafile);
+}
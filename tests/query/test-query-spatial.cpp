@@ -0,0 +1,306 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * test-query-spatial.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include "pique/data/grid.hpp"
+#include "pique/data/grid-subset.hpp"
+#include "pique/data/dataset.hpp"
+#include "pique/region/region-encoding.hpp"
+#include "pique/indexing/binning-spec.hpp"
+#include "pique/indexing/binned-index.hpp"
+#include "pique/indexing/index-builder.hpp"
+
+#include "pique/region/ii/ii.hpp"
+#include "pique/region/ii/ii-encode.hpp"
+#include "pique/region/cblq/cblq.hpp"
+#include "pique/region/cblq/cblq-encode.hpp"
+#include "pique/setops/ii/ii-setops.hpp"
+#include "pique/setops/cblq/cblq-setops.hpp"
+
+#include "pique/io/index-io.hpp"
+#include "pique/io/posix/posix-index-io.hpp"
+
+#include "pique/query/basic-query-engine.hpp"
+
+#include "write-dataset-metafile.hpp"
+
+using rid_ranges_t = std::vector< std::pair< uint64_t, uint64_t > >;
+
+// Linearizes coordinates in row-major order, or as a Z-order ID (last coordinate in the lowest bit) over a padded cube
+static uint64_t linearize(const Grid &grid, const std::vector< uint64_t > &coords, Grid::Linearization lin) {
+	const int ndim = grid.size();
+	uint64_t id = 0;
+	if (lin == Grid::Linearization::ROW_MAJOR_ORDER) {
+		for (int d = 0; d < ndim; ++d)
+			id = id * grid[d] + coords[d];
+	} else {
+		for (int bit = 0; bit < 32; ++bit)
+			for (int d = 0; d < ndim; ++d)
+				id |= ((coords[ndim - d - 1] >> bit) & 1ULL) << (bit * ndim + d);
+	}
+	return id;
+}
+
+// Iterates over all coordinates in the box [lb, lb + dims) in row-major order
+template<typename VisitFn>
+static void for_each_in_box(const std::vector< uint64_t > &lb, const std::vector< uint64_t > &dims, VisitFn visit) {
+	const int ndim = lb.size();
+	for (uint64_t dim : dims)
+		if (dim == 0)
+			return;
+
+	std::vector< uint64_t > coords(lb);
+	while (true) {
+		visit(coords);
+
+		int d = ndim - 1;
+		while (d >= 0 && ++coords[d] == lb[d] + dims[d]) {
+			coords[d] = lb[d];
+			--d;
+		}
+		if (d < 0)
+			break;
+	}
+}
+
+static std::vector< uint64_t > expand_ranges(const rid_ranges_t &ranges) {
+	std::vector< uint64_t > rids;
+	for (const rid_ranges_t::value_type &range : ranges)
+		for (uint64_t rid = range.first; rid < range.first + range.second; ++rid)
+			rids.push_back(rid);
+	return rids;
+}
+
+static void test_linearized_ranges(const Grid &grid, const std::vector< uint64_t > &offsets, const std::vector< uint64_t > &dims) {
+	for (Grid::Linearization lin : { Grid::Linearization::ROW_MAJOR_ORDER, Grid::Linearization::Z_ORDER }) {
+		std::vector< uint64_t > expected_rids;
+		for_each_in_box(offsets, dims, [&](const std::vector< uint64_t > &coords) { expected_rids.push_back(linearize(grid, coords, lin)); });
+		std::sort(expected_rids.begin(), expected_rids.end());
+
+		const rid_ranges_t ranges = GridSubset(grid, offsets, dims).compute_linearized_ranges(lin);
+		assert(expand_ranges(ranges) == expected_rids);
+
+		// Ranges must be maximal
+		for (size_t i = 1; i < ranges.size(); ++i)
+			assert(ranges[i - 1].first + ranges[i - 1].second < ranges[i].first);
+	}
+}
+
+static void test_region_from_rid_ranges(uint64_t nelem, const rid_ranges_t &ranges) {
+	const std::vector< uint64_t > expected_rids = expand_ranges(ranges);
+	for (RegionEncoding::Type type : { RegionEncoding::Type::II, RegionEncoding::Type::CII, RegionEncoding::Type::WAH,
+										RegionEncoding::Type::CBLQ_2D, RegionEncoding::Type::CBLQ_3D, RegionEncoding::Type::UNCOMPRESSED_BITMAP, RegionEncoding::Type::WAH64 })
+	{
+		boost::shared_ptr< RegionEncoding > region = RegionEncoding::make_region_from_rid_ranges(type, nelem, ranges);
+		assert(region->get_type() == type);
+		assert(region->get_domain_size() == nelem);
+		assert(region->get_element_count() == expected_rids.size());
+
+		std::vector< uint64_t > rids;
+		region->convert_to_rids(rids, 0, true, true);
+		assert(rids == expected_rids);
+	}
+}
+
+// A 2D variable partitioned into blocks of elements (the last partition being short), with values equal to the column index
+static constexpr uint64_t NROWS = 13, NCOLS = 10, ROWS_PER_PARTITION = 5;
+
+static int value_at(uint64_t row, uint64_t col) { return (int)col; }
+
+// Writes the variable's index in partitions of partition_size elements, in row-major order or (if zorder) in Z-order over each
+// partition's block of rows (partition_size must then be a multiple of NCOLS)
+template<typename RegionEncoderT>
+static void write_partitioned_index(std::string indexfile, typename RegionEncoderT::RegionEncoderConfig conf, uint64_t partition_size, bool zorder) {
+	std::vector< int > values;
+	for (uint64_t row = 0; row < NROWS; ++row)
+		for (uint64_t col = 0; col < NCOLS; ++col)
+			values.push_back(value_at(row, col));
+
+	using SigbitsBinningSpec = SigbitsBinningSpecification< int >;
+	const Grid grid{NROWS, NCOLS};
+	InMemoryDataset< int > dataset((std::vector< int >(values)), grid);
+	IndexBuilder< int, RegionEncoderT, SigbitsBinningSpec > builder(conf, boost::make_shared< SigbitsBinningSpec >(sizeof(int)*8));
+
+	POSIXIndexIO iio;
+	assert(iio.open(indexfile, IndexOpenMode::WRITE));
+
+	assert(!zorder || partition_size % NCOLS == 0);
+	for (uint64_t offset = 0; offset < NROWS * NCOLS; offset += partition_size) {
+		const uint64_t size = std::min(partition_size, NROWS * NCOLS - offset);
+		const GridSubset block(grid, offset, size);
+		boost::shared_ptr< BinnedIndex > index = zorder ? builder.build_index_zo(dataset, block) : builder.build_index(dataset, block);
+		if (zorder) {
+			assert(index->get_grid() && index->get_grid()->get_linearization() == Grid::Linearization::Z_ORDER);
+			assert(*index->get_grid() == std::vector< uint64_t >({size / NCOLS, NCOLS}));
+		} else {
+			assert(!index->get_grid());
+		}
+
+		boost::shared_ptr< IndexPartitionIO > partio = iio.append_partition();
+		partio->set_domain_global_offset(offset);
+		assert(partio->write_index(*index));
+		assert(partio->close());
+	}
+
+	assert(iio.close());
+}
+
+template<typename RegionEncoderT>
+static void write_zorder_index(std::string indexfile, typename RegionEncoderT::RegionEncoderConfig conf) {
+	std::vector< int > values;
+	for (uint64_t row = 0; row < NROWS; ++row)
+		for (uint64_t col = 0; col < NCOLS; ++col)
+			values.push_back(value_at(row, col));
+
+	using SigbitsBinningSpec = SigbitsBinningSpecification< int >;
+	InMemoryDataset< int > dataset((std::vector< int >(values)), Grid{NROWS, NCOLS});
+	IndexBuilder< int, RegionEncoderT, SigbitsBinningSpec > builder(conf, boost::make_shared< SigbitsBinningSpec >(sizeof(int)*8));
+	boost::shared_ptr< BinnedIndex > index = builder.build_index_zo(dataset);
+
+	POSIXIndexIO iio;
+	assert(iio.open(indexfile, IndexOpenMode::WRITE));
+	boost::shared_ptr< IndexPartitionIO > partio = iio.append_partition();
+	assert(partio->write_index(*index));
+	assert(partio->close());
+
+	// The index's grid is recorded in its partition metadata
+	assert(iio.close());
+	assert(iio.open(indexfile, IndexOpenMode::READ));
+	const boost::optional< Grid > part_grid = iio.get_partition(0)->get_partition_metadata().grid;
+	assert(part_grid && part_grid->get_linearization() == Grid::Linearization::Z_ORDER);
+	assert(*part_grid == std::vector< uint64_t >({NROWS, NCOLS}));
+	assert(iio.close());
+}
+
+// An element's RID, as (partition domain offset, RID within the partition), in an index with partitions of partition_size elements,
+// each linearized in the given order (over its block of rows, in Z-order)
+using element_id_t = std::pair< uint64_t, uint64_t >;
+static element_id_t get_element_id(const std::vector< uint64_t > &coords, uint64_t partition_size, Grid::Linearization lin) {
+	if (lin == Grid::Linearization::ROW_MAJOR_ORDER) {
+		const uint64_t rid = coords[0] * NCOLS + coords[1];
+		return std::make_pair(rid / partition_size * partition_size, rid % partition_size);
+	}
+
+	const uint64_t rows_per_partition = partition_size / NCOLS;
+	const uint64_t first_row = coords[0] / rows_per_partition * rows_per_partition;
+	const Grid part_grid{std::min(rows_per_partition, NROWS - first_row), NCOLS};
+	return std::make_pair(first_row * NCOLS, linearize(part_grid, {coords[0] - first_row, coords[1]}, lin));
+}
+
+// Checks the query (value in [lb, ub], inside the box) against a brute-force evaluation, both alone and in conjunction
+static void check_spatial_query(QueryEngine &qe, const std::vector< uint64_t > &offsets, const std::vector< uint64_t > &dims, int lb, int ub, uint64_t partition_size, Grid::Linearization lin) {
+	std::vector< element_id_t > expected_box_ids, expected_ids;
+	for_each_in_box(offsets, dims, [&](const std::vector< uint64_t > &coords) {
+		const element_id_t id = get_element_id(coords, partition_size, lin);
+		expected_box_ids.push_back(id);
+		if (value_at(coords[0], coords[1]) >= lb && value_at(coords[0], coords[1]) <= ub)
+			expected_ids.push_back(id);
+	});
+	std::sort(expected_box_ids.begin(), expected_box_ids.end());
+	std::sort(expected_ids.begin(), expected_ids.end());
+
+	Query box_query, value_query;
+	box_query.push_back(boost::make_shared< SpatialConstraintTerm >("var", offsets, dims));
+	value_query.push_back(boost::make_shared< ConstraintTerm >("var", UniversalValue(lb), UniversalValue(ub)));
+
+	for (const std::pair< Query, const std::vector< element_id_t > * > &test : { std::make_pair(box_query, &expected_box_ids), std::make_pair(value_query & box_query, &expected_ids) }) {
+		std::vector< element_id_t > ids;
+		std::vector< uint64_t > partition_rids;
+		boost::shared_ptr< QueryEngine::QueryCursor > cursor = qe.evaluate(test.first);
+		while (cursor->has_next()) {
+			QueryEngine::QueryPartitionResult result = cursor->next();
+			result.result->convert_to_rids(partition_rids, 0, true, true);
+			for (uint64_t rid : partition_rids)
+				ids.push_back(std::make_pair(result.partition_domain.first, rid));
+		}
+
+		std::sort(ids.begin(), ids.end());
+		assert(ids == *test.second);
+		assert(qe.count(test.first) == test.second->size());
+	}
+}
+
+template<typename SetOperationsT>
+static void do_query_test(std::string indexfile, std::string datametafile, typename SetOperationsT::SetOperationsConfig setops_conf, uint64_t partition_size, Grid::Linearization lin) {
+	boost::shared_ptr< Database > db = boost::make_shared< Database >();
+	db->add_variable(boost::make_shared< DataVariable >("var", datametafile, indexfile));
+
+	BasicQueryEngine qe(boost::make_shared< SetOperationsT >(setops_conf));
+	qe.open(db);
+
+	check_spatial_query(qe, {2, 3}, {4, 5}, 4, 6, partition_size, lin);    // Within one partition (row-major)
+	check_spatial_query(qe, {3, 0}, {8, NCOLS}, 0, 8, partition_size, lin); // Spanning partitions, full rows
+	check_spatial_query(qe, {0, 0}, {NROWS, NCOLS}, 2, 3, partition_size, lin);
+	check_spatial_query(qe, {12, 9}, {1, 1}, 9, 9, partition_size, lin);
+	check_spatial_query(qe, {5, 1}, {0, 4}, 0, 9, partition_size, lin);     // Empty box
+
+	qe.close();
+}
+
+int main(int argc, char **argv) {
+	char *tempdir_cstr = std::getenv("testworkdir");
+	std::string tempdir = (tempdir_cstr ? tempdir_cstr : "test.work.dir");
+
+	std::string indexfile = tempdir + "/test-query-spatial.index";
+	std::string datametafile = tempdir + "/test-query-spatial.meta";
+
+	test_linearized_ranges(Grid{16}, {3}, {9});
+	test_linearized_ranges(Grid{8, 8}, {0, 0}, {8, 8});
+	test_linearized_ranges(Grid{8, 8}, {2, 4}, {4, 4});
+	test_linearized_ranges(Grid{13, 10}, {3, 1}, {7, 9});
+	test_linearized_ranges(Grid{13, 10}, {3, 0}, {7, 10});
+	test_linearized_ranges(Grid{9, 3, 6}, {1, 1, 2}, {5, 2, 3});
+	test_linearized_ranges(Grid{9, 3, 6}, {4, 0, 0}, {2, 3, 6});
+	test_linearized_ranges(Grid{7, 12, 5}, {0, 5, 1}, {7, 0, 3});
+
+	test_region_from_rid_ranges(100, {});
+	test_region_from_rid_ranges(100, { {0, 100} });
+	test_region_from_rid_ranges(100, { {3, 4}, {10, 1}, {50, 30}, {99, 1} });
+	test_region_from_rid_ranges(64, GridSubset(Grid{8, 8}, {1, 2}, {5, 3}).compute_linearized_ranges(Grid::Linearization::Z_ORDER));
+
+	write_dataset_metadata_file(InMemoryDataset< int >(std::vector< int >(NROWS * NCOLS), Grid{NROWS, NCOLS}), datametafile);
+
+	write_partitioned_index< IIRegionEncoder >(indexfile, IIRegionEncoderConfig(), ROWS_PER_PARTITION * NCOLS, false);
+	do_query_test< IISetOperations >(indexfile, datametafile, IISetOperationsConfig(), ROWS_PER_PARTITION * NCOLS, Grid::Linearization::ROW_MAJOR_ORDER);
+
+	write_partitioned_index< CBLQRegionEncoder<2> >(indexfile, CBLQRegionEncoderConfig(false), ROWS_PER_PARTITION * NCOLS, false);
+	do_query_test< CBLQSetOperations<2> >(indexfile, datametafile, CBLQSetOperationsConfig(true), ROWS_PER_PARTITION * NCOLS, Grid::Linearization::ROW_MAJOR_ORDER);
+
+	// Row-major partitions that begin and end partway through rows
+	write_partitioned_index< IIRegionEncoder >(indexfile, IIRegionEncoderConfig(), 23, false);
+	do_query_test< IISetOperations >(indexfile, datametafile, IISetOperationsConfig(), 23, Grid::Linearization::ROW_MAJOR_ORDER);
+
+	// With a Z-order index, a box is a union of a few aligned quadtree blocks
+	write_zorder_index< CBLQRegionEncoder<2> >(indexfile, CBLQRegionEncoderConfig(false));
+	do_query_test< CBLQSetOperations<2> >(indexfile, datametafile, CBLQSetOperationsConfig(true), NROWS * NCOLS, Grid::Linearization::Z_ORDER);
+
+	// Each partition in Z-order over its own row block
+	write_partitioned_index< CBLQRegionEncoder<2> >(indexfile, CBLQRegionEncoderConfig(false), ROWS_PER_PARTITION * NCOLS, true);
+	do_query_test< CBLQSetOperations<2> >(indexfile, datametafile, CBLQSetOperationsConfig(true), ROWS_PER_PARTITION * NCOLS, Grid::Linearization::Z_ORDER);
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * test-query-zonemaps.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include "pique/data/grid.hpp"
+#include "pique/data/dataset.hpp"
+#include "pique/region/region-encoding.hpp"
+#include "pique/indexing/binning-spec.hpp"
+#include "pique/indexing/binned-index.hpp"
+#include "pique/indexing/index-builder.hpp"
+
+#include "pique/region/bitmap/bitmap.hpp"
+#include "pique/region/bitmap/bitmap-encode.hpp"
+#include "pique/setops/bitmap/bitmap-setops.hpp"
+
+#include "pique/io/index-io.hpp"
+#include "pique/io/posix/posix-index-io.hpp"
+
+#include "pique/query/basic-query-engine.hpp"
+
+#include "make-index.hpp"
+#include "write-dataset-metafile.hpp"
+
+// Each partition holds the values [10*p, 10*p + 3], so value ranges drift across partitions
+static constexpr int NUM_PARTITIONS = 3;
+static constexpr uint64_t PARTITION_SIZE = 16;
+
+static std::vector<int> make_partition_domain(int partition) {
+	std::vector<int> domain;
+	for (uint64_t i = 0; i < PARTITION_SIZE; ++i)
+		domain.push_back(partition * 10 + (int)(i % 4));
+	return domain;
+}
+
+template<typename MakeBinningSpecFn>
+static void write_partitioned_index(std::string indexfile, MakeBinningSpecFn make_binning_spec) {
+	POSIXIndexIO iio;
+	assert(iio.open(indexfile, IndexOpenMode::WRITE));
+
+	for (int p = 0; p < NUM_PARTITIONS; ++p) {
+		InMemoryDataset<int> dataset(make_partition_domain(p), Grid{PARTITION_SIZE});
+		auto binning_spec = make_binning_spec();
+		boost::shared_ptr< BinnedIndex > index =
+				make_index< BitmapRegionEncoder, typename decltype(binning_spec)::element_type, int >(BitmapRegionEncoderConfig(), binning_spec, dataset);
+
+		boost::shared_ptr< IndexPartitionIO > partio = iio.append_partition();
+		partio->set_domain_global_offset(p * PARTITION_SIZE);
+		assert(partio->write_index(*index));
+		assert(partio->close());
+	}
+
+	assert(iio.close());
+
+	// Check that every partition received a zone map
+	assert(iio.open(indexfile, IndexOpenMode::READ));
+	for (const IndexIO::GlobalPartitionMetadata &gpmeta : iio.get_all_partition_metadatas())
+		assert(gpmeta.zone_map && gpmeta.index_rep && *gpmeta.index_rep == RegionEncoding::Type::UNCOMPRESSED_BITMAP);
+	assert(iio.close());
+}
+
+enum struct Expected { NOT_PRUNED, PRUNED_EMPTY, PRUNED_FULL };
+
+static void check_query(BasicQueryEngine &qe, int lb, int ub, const std::vector< Expected > &expected) {
+	Query q;
+	q.push_back(boost::make_shared< ConstraintTerm >("var", UniversalValue(lb), UniversalValue(ub)));
+
+	for (int p = 0; p < NUM_PARTITIONS; ++p) {
+		QueryEngine::QueryStats qstats;
+		boost::shared_ptr< RegionEncoding > result = qe.evaluate(q, p, qstats);
+
+		assert(qstats.terminfos.size() == 1);
+		const QueryEngine::ConstraintTermEvalStats &cterm = dynamic_cast< const QueryEngine::ConstraintTermEvalStats & >(*qstats.terminfos[0]);
+
+		switch (expected[p]) {
+		case Expected::NOT_PRUNED:
+			assert(!cterm.zone_map_pruned);
+			break;
+		case Expected::PRUNED_EMPTY:
+			assert(cterm.zone_map_pruned);
+			assert(result->get_element_count() == 0);
+			break;
+		case Expected::PRUNED_FULL:
+			assert(cterm.zone_map_pruned);
+			assert(result->get_element_count() == PARTITION_SIZE);
+			break;
+		}
+	}
+}
+
+// An intersection with a constraint pruned to the empty region by the zone map must skip the other constraint entirely
+static void check_short_circuit(BasicQueryEngine &qe) {
+	Query q1, q2;
+	q1.push_back(boost::make_shared< ConstraintTerm >("var", UniversalValue(10), UniversalValue(13)));
+	q2.push_back(boost::make_shared< ConstraintTerm >("var2", UniversalValue(0), UniversalValue(3)));
+	const Query q = q1 & q2;
+
+	// In partition 0, neither constraint is pruned to the empty region (the first one still selects the last bin), so both are evaluated
+	QueryEngine::QueryStats qstats0;
+	qe.evaluate(q, 0, qstats0);
+	assert(qstats0.constraints_skipped == 0);
+
+	for (int p = 1; p < NUM_PARTITIONS; ++p) {
+		QueryEngine::QueryStats qstats;
+		boost::shared_ptr< RegionEncoding > result = qe.evaluate(q, p, qstats);
+
+		assert(result->get_element_count() == 0);
+		assert(qstats.constraints_skipped == 1);
+		assert(qstats.terminfos.size() == 1);
+	}
+}
+
+template<typename MakeBinningSpecFn>
+static void do_test(std::string indexfile, std::string datametafile, MakeBinningSpecFn make_binning_spec) {
+	using E = Expected;
+
+	write_partitioned_index(indexfile, make_binning_spec);
+
+	boost::shared_ptr< Database > db = boost::make_shared< Database >();
+	db->add_variable(boost::make_shared< DataVariable >("var", datametafile, indexfile));
+	db->add_variable(boost::make_shared< DataVariable >("var2", datametafile, indexfile));
+
+	BasicQueryEngine qe(boost::make_shared< BitmapSetOperations >(BitmapSetOperationsConfig()));
+	qe.open(db);
+
+	check_query(qe, 10, 13, { E::NOT_PRUNED, E::PRUNED_FULL, E::PRUNED_EMPTY });
+	check_query(qe, 5, 8, { E::NOT_PRUNED, E::PRUNED_EMPTY, E::PRUNED_EMPTY });
+	check_query(qe, 0, 30, { E::PRUNED_FULL, E::PRUNED_FULL, E::PRUNED_FULL });
+	check_short_circuit(qe);
+
+	Query q;
+	q.push_back(boost::make_shared< ConstraintTerm >("var", UniversalValue(0), UniversalValue(30)));
+	assert(qe.count(q) == NUM_PARTITIONS * PARTITION_SIZE);
+
+	qe.close();
+}
+
+int main(int argc, char **argv) {
+	char *tempdir_cstr = std::getenv("testworkdir");
+	std::string tempdir = (tempdir_cstr ? tempdir_cstr : "test.work.dir");
+
+	std::string indexfile = tempdir + "/test-query-zonemaps.index";
+	std::string datametafile = tempdir + "/test-query-zonemaps.meta";
+
+	std::vector<int> full_domain;
+	for (int p = 0; p < NUM_PARTITIONS; ++p) {
+		const std::vector<int> part_domain = make_partition_domain(p);
+		full_domain.insert(full_domain.end(), part_domain.begin(), part_domain.end());
+	}
+	write_dataset_metadata_file(InMemoryDataset<int>(std::vector<int>(full_domain), Grid{full_domain.size()}), datametafile);
+
+	do_test(indexfile, datametafile, []() {
+		return boost::make_shared< SigbitsBinningSpecification< int > >(sizeof(int) * 8);
+	});
+	do_test(indexfile, datametafile, []() {
+		std::vector<int> boundaries;
+		for (int b = 0; b < 25; b += 2)
+			boundaries.push_back(b);
+		return boost::make_shared< ExplicitBinsBinningSpecification< int > >(boundaries);
+	});
+}
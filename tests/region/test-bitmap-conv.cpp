@@ -36,8 +36,10 @@
 #include "pique/region/cblq/cblq.hpp"
 #include "pique/region/cblq/cblq-encode.hpp"
 #include "pique/region/bitmap/bitmap.hpp"
+#include "pique/region/ii/ii.hpp"
 
 #include "pique/convert/cblq/cblq-to-bitmap-convert.hpp"
+#include "pique/convert/cblq/to-cblq-convert.hpp"
 
 using boost::timer::cpu_timer;
 using boost::timer::cpu_times;
@@ -47,6 +49,7 @@ typedef boost::dynamic_bitset< BitmapRegionEncoding::block_t > Bitset;
 
 static Bitset make_large_bitmap(uint64_t nbits, uint64_t seed = boost::mt19937_64::default_seed);
 static Bitset make_large_sparse_bitmap(uint64_t nbits, int iters);
+static Bitset make_large_runs_bitmap(uint64_t nbits);
 
 std::string small_bitmap_str = "0001110100001111"; // written in big-endian: bits are 1111 0000 1011 1000 in little-endian
 const Bitset small_bitmap(small_bitmap_str);
@@ -54,6 +57,7 @@ const Bitset large_bitmap = make_large_bitmap(1ULL<<14);
 const Bitset uneven_bitmap = make_large_bitmap(27 + (1ULL<<14));
 const Bitset very_uneven_bitmap = make_large_bitmap(27 + (1ULL<<13));
 const Bitset large_sparse_bitmap = make_large_sparse_bitmap(27 + (1ULL<<13), 7); // 4 -> density ~= 2^-7
+const Bitset large_runs_bitmap = make_large_runs_bitmap(27 + (1ULL<<14));
 
 static Bitset make_large_bitmap(uint64_t nbits, uint64_t seed) {
 	boost::mt19937_64 rand; // default seed is fine
@@ -76,6 +80,18 @@ static Bitset make_large_sparse_bitmap(uint64_t nbits, int iters) {
 	return b;
 }
 
+// Random bits interspersed with long (unaligned) runs of 0s and 1s
+static Bitset make_large_runs_bitmap(uint64_t nbits) {
+	Bitset b = make_large_bitmap(nbits);
+	for (uint64_t i = 0; i < nbits / 4096; ++i) {
+		const uint64_t run_start = i * 4096 + 13;
+		const uint64_t run_len = std::min< uint64_t >(1000 + 300 * i, nbits - run_start);
+		for (uint64_t j = run_start; j < run_start + run_len; ++j)
+			b[j] = (i % 2 == 0);
+	}
+	return b;
+}
+
 template<typename RegionEncoderT>
 static boost::shared_ptr< typename RegionEncoderT::RegionEncodingOutT > make_region(typename RegionEncoderT::RegionEncoderConfig conf, const Bitset &bitmap) {
 	RegionEncoderT encoder(conf, bitmap.size());
@@ -89,10 +105,9 @@ static boost::shared_ptr< typename RegionEncoderT::RegionEncodingOutT > make_reg
 }
 
 template<typename RegionEncoderT, typename RegionConverterT>
-static void do_bitmap_test(const std::string testname, typename RegionEncoderT::RegionEncoderConfig conf, const Bitset &bitmap) {
+static void do_bitmap_test(const std::string testname, typename RegionEncoderT::RegionEncoderConfig conf, const Bitset &bitmap, const RegionConverterT &converter = RegionConverterT()) {
 	typedef typename RegionEncoderT::RegionEncodingOutT RegionEncodingT;
 
-	RegionConverterT converter;
 	boost::dynamic_bitset< BitmapRegionEncoding::block_t > actual_bitmap;
 
 	// Generate the input region (non-bitmap RE)
@@ -136,6 +151,65 @@ static void do_bitmap_test(const std::string testname, typename RegionEncoderT::
 #endif
 }
 
+template<int ndim>
+static void check_cblq_equal(const CBLQRegionEncoding<ndim> &actual, const CBLQRegionEncoding<ndim> &expected) {
+	if (actual == expected)
+		return;
+
+	// In-place set operations need not produce the encoder's exact layout, so fall back to comparing contents
+	std::vector< uint32_t > actual_rids, expected_rids;
+	const_cast< CBLQRegionEncoding<ndim> & >(actual).convert_to_rids(actual_rids, true);
+	const_cast< CBLQRegionEncoding<ndim> & >(expected).convert_to_rids(expected_rids, true);
+	assert(actual_rids == expected_rids);
+}
+
+template<int ndim, typename RegionConverterT>
+static void do_to_cblq_convert_test(const RegionConverterT &converter, boost::shared_ptr< const typename RegionConverterT::InRegionEncodingType > in, const CBLQRegionEncoding<ndim> &expected) {
+	// Convert to CBLQ; the result should be identical to directly encoding the CBLQ
+	boost::shared_ptr< CBLQRegionEncoding<ndim> > region = converter.convert(in);
+	assert(*region == expected);
+
+	// In-place union to an empty CBLQ
+	boost::shared_ptr< CBLQRegionEncoding<ndim> > ipunion_region = boost::make_shared< CBLQRegionEncoding<ndim> >(in->get_domain_size(), false);
+	converter.inplace_convert(in, ipunion_region, NArySetOperation::UNION);
+	check_cblq_equal(*ipunion_region, expected);
+}
+
+template<int ndim>
+static void do_to_cblq_test(const std::string testname, CBLQRegionEncoderConfig conf, const Bitset &bitmap) {
+	const boost::shared_ptr< CBLQRegionEncoding<ndim> > expected = make_region< CBLQRegionEncoder<ndim> >(conf, bitmap);
+
+	// Bitmap -> CBLQ (the bitset's blocks are laid out exactly as a bitmap RE's)
+	std::vector< BitmapRegionEncoding::block_t > blocks(bitmap.num_blocks());
+	boost::to_block_range(bitmap, blocks.begin());
+	boost::shared_ptr< const BitmapRegionEncoding > bitmap_region = boost::make_shared< BitmapRegionEncoding >(bitmap.size(), std::move(blocks));
+
+	cpu_timer bitmap_convert_timer;
+	do_to_cblq_convert_test< ndim >(BitmapToCBLQConverter<ndim>(conf), bitmap_region, *expected);
+	bitmap_convert_timer.stop();
+
+	// II -> CBLQ
+	std::vector< IIRegionEncoding::rid_t > rids;
+	for (size_t pos = bitmap.find_first(); pos != Bitset::npos; pos = bitmap.find_next(pos))
+		rids.push_back(pos);
+	boost::shared_ptr< const IIRegionEncoding > ii_region = boost::make_shared< IIRegionEncoding >(rids.begin(), rids.end(), bitmap.size());
+
+	cpu_timer ii_convert_timer;
+	do_to_cblq_convert_test< ndim >(IIToCBLQConverter<ndim>(conf), ii_region, *expected);
+	ii_convert_timer.stop();
+
+	// Both, via the converter preference list
+	PreferenceListRegionEncodingConverter preflist_converter;
+	preflist_converter.push_back(boost::make_shared< BitmapToCBLQConverter<ndim> >(conf));
+	preflist_converter.push_back(boost::make_shared< IIToCBLQConverter<ndim> >(conf));
+	assert(*boost::static_pointer_cast< CBLQRegionEncoding<ndim> >(preflist_converter.convert(bitmap_region, CBLQRegionEncoding<ndim>::TYPE)) == *expected);
+	assert(*boost::static_pointer_cast< CBLQRegionEncoding<ndim> >(preflist_converter.convert(ii_region, CBLQRegionEncoding<ndim>::TYPE)) == *expected);
+
+#ifdef VERBOSE_TESTS
+	printf("Test \"%s\" passed! Time bitmap/II convert: %lf/%lf\n", testname.c_str(), walltime(bitmap_convert_timer), walltime(ii_convert_timer));
+#endif
+}
+
 int main(int argc, char **argv) {
 	do_bitmap_test< CBLQRegionEncoder<2>, CBLQToBitmapConverter<2> >("small-cblq", CBLQRegionEncoderConfig(true), small_bitmap);
 	do_bitmap_test< CBLQRegionEncoder<2>, CBLQToBitmapConverter<2> >("large-cblq", CBLQRegionEncoderConfig(true), large_bitmap);
@@ -148,8 +222,41 @@ int main(int argc, char **argv) {
 	do_bitmap_test< CBLQRegionEncoder<2>, CBLQToBitmapDFConverter<2> >("uneven-cblq-df", CBLQRegionEncoderConfig(true), uneven_bitmap);
 	do_bitmap_test< CBLQRegionEncoder<2>, CBLQToBitmapDFConverter<2> >("very-uneven-cblq-df", CBLQRegionEncoderConfig(true), very_uneven_bitmap);
 	do_bitmap_test< CBLQRegionEncoder<2>, CBLQToBitmapDFConverter<2> >("large-sparse-cblq-df", CBLQRegionEncoderConfig(true), large_sparse_bitmap);
-}
-
-
-
 
+	do_bitmap_test< CBLQRegionEncoder<1>, CBLQToBitmapConverter<1> >("uneven-cblq1d", CBLQRegionEncoderConfig(true), uneven_bitmap);
+	do_bitmap_test< CBLQRegionEncoder<1>, CBLQToBitmapConverter<1> >("large-sparse-cblq1d", CBLQRegionEncoderConfig(true), large_sparse_bitmap);
+	do_bitmap_test< CBLQRegionEncoder<1>, CBLQToBitmapDFConverter<1> >("uneven-cblq1d-df", CBLQRegionEncoderConfig(true), uneven_bitmap);
+	do_bitmap_test< CBLQRegionEncoder<1>, CBLQToBitmapDFConverter<1> >("large-sparse-cblq1d-df", CBLQRegionEncoderConfig(true), large_sparse_bitmap);
+
+	// Parallel conversion, with spans as small as possible to force splitting
+	const CBLQToBitmapParallelConverter<1> par_converter1d(4, 1);
+	const CBLQToBitmapParallelConverter<2> par_converter2d(4, 1);
+	const CBLQToBitmapParallelConverter<3> par_converter3d(4, 1);
+	const CBLQToBitmapParallelConverter<4> par_converter4d(4, 1);
+	do_bitmap_test< CBLQRegionEncoder<2>, CBLQToBitmapParallelConverter<2> >("small-cblq-par", CBLQRegionEncoderConfig(true), small_bitmap, par_converter2d);
+	do_bitmap_test< CBLQRegionEncoder<2>, CBLQToBitmapParallelConverter<2> >("large-cblq-par", CBLQRegionEncoderConfig(true), large_bitmap, par_converter2d);
+	do_bitmap_test< CBLQRegionEncoder<2>, CBLQToBitmapParallelConverter<2> >("uneven-cblq-par", CBLQRegionEncoderConfig(false), uneven_bitmap, par_converter2d);
+	do_bitmap_test< CBLQRegionEncoder<2>, CBLQToBitmapParallelConverter<2> >("very-uneven-cblq-par", CBLQRegionEncoderConfig(true), very_uneven_bitmap, par_converter2d);
+	do_bitmap_test< CBLQRegionEncoder<2>, CBLQToBitmapParallelConverter<2> >("large-sparse-cblq-par", CBLQRegionEncoderConfig(true), large_sparse_bitmap, par_converter2d);
+	do_bitmap_test< CBLQRegionEncoder<2>, CBLQToBitmapParallelConverter<2> >("large-runs-cblq-par", CBLQRegionEncoderConfig(true), large_runs_bitmap, par_converter2d);
+	do_bitmap_test< CBLQRegionEncoder<2>, CBLQToBitmapParallelConverter<2> >("large-runs-cblq-par-serial", CBLQRegionEncoderConfig(true), large_runs_bitmap, CBLQToBitmapParallelConverter<2>(1));
+	do_bitmap_test< CBLQRegionEncoder<1>, CBLQToBitmapParallelConverter<1> >("uneven-cblq1d-par", CBLQRegionEncoderConfig(true), uneven_bitmap, par_converter1d);
+	do_bitmap_test< CBLQRegionEncoder<1>, CBLQToBitmapParallelConverter<1> >("large-runs-cblq1d-par", CBLQRegionEncoderConfig(false), large_runs_bitmap, par_converter1d);
+	do_bitmap_test< CBLQRegionEncoder<3>, CBLQToBitmapParallelConverter<3> >("uneven-cblq3d-par", CBLQRegionEncoderConfig(true), uneven_bitmap, par_converter3d);
+	do_bitmap_test< CBLQRegionEncoder<3>, CBLQToBitmapParallelConverter<3> >("large-runs-cblq3d-par", CBLQRegionEncoderConfig(false), large_runs_bitmap, par_converter3d);
+	do_bitmap_test< CBLQRegionEncoder<4>, CBLQToBitmapParallelConverter<4> >("uneven-cblq4d-par", CBLQRegionEncoderConfig(true), uneven_bitmap, par_converter4d);
+	do_bitmap_test< CBLQRegionEncoder<4>, CBLQToBitmapParallelConverter<4> >("large-runs-cblq4d-par", CBLQRegionEncoderConfig(false), large_runs_bitmap, par_converter4d);
+
+	do_to_cblq_test<2>("small-to-cblq", CBLQRegionEncoderConfig(true), small_bitmap);
+	do_to_cblq_test<2>("large-to-cblq", CBLQRegionEncoderConfig(true), large_bitmap);
+	do_to_cblq_test<2>("uneven-to-cblq", CBLQRegionEncoderConfig(true), uneven_bitmap);
+	do_to_cblq_test<2>("very-uneven-to-cblq", CBLQRegionEncoderConfig(false), very_uneven_bitmap);
+	do_to_cblq_test<2>("large-sparse-to-cblq", CBLQRegionEncoderConfig(true), large_sparse_bitmap);
+	do_to_cblq_test<2>("large-runs-to-cblq", CBLQRegionEncoderConfig(true), large_runs_bitmap);
+	do_to_cblq_test<2>("large-runs-to-cblq-nondense", CBLQRegionEncoderConfig(false), large_runs_bitmap);
+	do_to_cblq_test<1>("uneven-to-cblq1d", CBLQRegionEncoderConfig(true), uneven_bitmap);
+	do_to_cblq_test<1>("large-runs-to-cblq1d", CBLQRegionEncoderConfig(false), large_runs_bitmap);
+	do_to_cblq_test<3>("uneven-to-cblq3d", CBLQRegionEncoderConfig(true), uneven_bitmap);
+	do_to_cblq_test<3>("large-runs-to-cblq3d", CBLQRegionEncoderConfig(true), large_runs_bitmap);
+	do_to_cblq_test<3>("large-sparse-to-cblq3d", CBLQRegionEncoderConfig(false), large_sparse_bitmap);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * test-bp128.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+#include "pique/region/cii/bp128.hpp"
+
+typedef BP128Codec::rid_t rid_t;
+
+// Sorted RIDs starting at first, with gaps drawn from [1, max_gap]
+static std::vector< rid_t > make_rids(size_t count, rid_t first, uint64_t max_gap) {
+	std::vector< rid_t > rids;
+	uint64_t rid = first;
+	for (size_t i = 0; i < count && rid <= UINT32_MAX; i++) {
+		rids.push_back((rid_t)rid);
+		rid += 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_gap;
+	}
+	return rids;
+}
+
+static void do_test(const std::vector< rid_t > &rids) {
+	// Encode after some existing data, to check that blocks need no alignment
+	std::vector< char > encoded(3, 'x');
+	const size_t encoded_size = BP128Codec::encode_block(&rids.front(), rids.size(), encoded);
+	assert(encoded.size() == 3 + encoded_size);
+	assert(BP128Codec::get_block_size(&encoded[3]) == encoded_size);
+	assert(BP128Codec::get_block_count(&encoded[3]) == rids.size());
+	assert(BP128Codec::get_block_base(&encoded[3]) == rids.front());
+
+	std::vector< rid_t > decoded(BP128Codec::BLOCK_SIZE);
+	size_t decoded_count;
+	assert(BP128Codec::decode_block(&encoded[3], &decoded.front(), decoded_count) == encoded_size);
+	assert(decoded_count == rids.size());
+
+	decoded.resize(decoded_count);
+	assert(decoded == rids);
+}
+
+int main(int argc, char **argv) {
+	// Every bit width, in full and short blocks
+	for (int bits = 0; bits <= 32; bits++) {
+		const uint64_t max_gap = (bits == 0) ? 1 : (1ULL << bits) / 4 + 1;
+		for (size_t count : { (size_t)1, (size_t)5, (size_t)127, BP128Codec::BLOCK_SIZE })
+			do_test(make_rids(count, rand() % 1000, max_gap));
+	}
+
+	// Extremes of the RID space
+	do_test({ 0, UINT32_MAX });
+	do_test({ UINT32_MAX - 3, UINT32_MAX - 2, UINT32_MAX - 1, UINT32_MAX });
+	do_test(make_rids(BP128Codec::BLOCK_SIZE, UINT32_MAX - BP128Codec::BLOCK_SIZE + 1, 1));
+
+	// A dense block of consecutive RIDs packs to 3 bits (every difference four positions apart is 4)
+	std::vector< char > encoded;
+	assert(BP128Codec::encode_block(&make_rids(BP128Codec::BLOCK_SIZE, 100, 1).front(), BP128Codec::BLOCK_SIZE, encoded) == BP128Codec::HEADER_SIZE + 3 * 16);
+}
@@ -86,6 +86,19 @@ static inline void do_test(boost::shared_ptr< CIIRegionEncoding > cii, const boo
 	}
 	assert(rid_count == expected_rid_count);
 
+	// skip_to should land on the first RID at or after each (increasing) target
+	BaseProgressiveCIIDecoder sdecoder(*cii);
+	for (uint64_t target = 0; target < bitmap.size() + 10; target += 1 + rand() % 100) {
+		sdecoder.skip_to(target);
+
+		const size_t expected_rid = (target == 0) ? bitmap.find_first() : bitmap.find_next(target - 1);
+		if (expected_rid == boost::dynamic_bitset<>::npos) {
+			assert(!sdecoder.has_top());
+		} else {
+			assert(sdecoder.has_top() && sdecoder.top() == expected_rid);
+		}
+	}
+
 	boost::shared_ptr< CIISetOperations > setops = boost::make_shared< CIISetOperations >(CIISetOperationsConfig());
 	boost::shared_ptr< CIIRegionEncoding > inv_cii = setops->unary_set_op(cii, UnarySetOperation::COMPLEMENT);
 
@@ -112,15 +125,28 @@ static inline void do_test(boost::shared_ptr< CIIRegionEncoding > cii, const boo
 int main(int argc, char **argv) {
 	std::vector< std::reference_wrapper< boost::dynamic_bitset<> > > all_tests = { bitmap1, bitmap2, bitmap3, bigbitmap1, bigbitmap2, bigbitmap3 };
 
-	for (const boost::dynamic_bitset<> &bitmap : all_tests) {
-		boost::shared_ptr< CIIRegionEncoding > region = make_region< CIIRegionEncoder >(CIIRegionEncoderConfig(), bitmap);
-
-		// Test compressed
-		do_test(region, bitmap);
-
-		// Test uncompressed
-		region->decompress();
-		do_test(region, bitmap);
+#ifdef HAVE_RIDCOMPRESS
+	const std::vector< CIICompressionFormat > formats = { CIICompressionFormat::PFOR_DELTA, CIICompressionFormat::BP128 };
+#else
+	const std::vector< CIICompressionFormat > formats = { CIICompressionFormat::BP128 };
+#endif
+	for (CIICompressionFormat format : formats) {
+		for (const boost::dynamic_bitset<> &bitmap : all_tests) {
+			boost::shared_ptr< CIIRegionEncoding > region = make_region< CIIRegionEncoder >(CIIRegionEncoderConfig(format), bitmap);
+
+			// Test compressed
+			do_test(region, bitmap);
+			assert(region->get_element_count() == bitmap.count());
+
+			// Test uncompressed
+			region->decompress();
+			do_test(region, bitmap);
+
+			// Test recompressed
+			region->compress();
+			assert(*region == *make_region< CIIRegionEncoder >(CIIRegionEncoderConfig(format), bitmap));
+			do_test(region, bitmap);
+		}
 	}
 }
 
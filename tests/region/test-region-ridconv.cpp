@@ -38,6 +38,10 @@
 #include "pique/region/cblq/cblq-encode.hpp"
 #include "pique/region/wah/wah.hpp"
 #include "pique/region/wah/wah-encode.hpp"
+#include "pique/region/wah/wah64.hpp"
+#include "pique/region/wah/wah64-encode.hpp"
+#include "pique/region/bitmap/bitmap.hpp"
+#include "pique/region/bitmap/bitmap-encode.hpp"
 
 using boost::timer::cpu_timer;
 using boost::timer::cpu_times;
@@ -83,6 +87,22 @@ make_random_region(typename RegionEncoderT::RegionEncoderConfig conf, uint64_t r
    return builder.to_region_encoding();
 }
 
+static void test_rid_iterator(const RegionEncoding &region, const std::vector< uint32_t > &expected_rids, uint64_t offset, size_t batch_size) {
+	boost::shared_ptr< RIDBatchIterator > it = region.make_rid_iterator(offset);
+
+	std::vector<uint64_t> batch, rids;
+	while (it->next_batch(batch, batch_size)) {
+		assert(batch.size() <= batch_size);
+		rids.insert(rids.end(), batch.begin(), batch.end());
+	}
+	assert(batch.empty());
+	assert(!it->next_batch(batch, batch_size)); // Stays exhausted
+
+	assert(rids.size() == expected_rids.size());
+	for (size_t i = 0; i < rids.size(); ++i)
+		assert(rids[i] == expected_rids[i] + offset);
+}
+
 template<typename RegionEncodingT>
 static void test_ridconv(std::string testname, boost::shared_ptr< RegionEncodingT > region, std::vector< uint32_t > expected_rids) {
 
@@ -104,6 +124,11 @@ static void test_ridconv(std::string testname, boost::shared_ptr< RegionEncoding
 	sorted_timer.stop();
 	assert(rids == expected_rids);
 
+	for (size_t batch_size : { 1, 3, 64, 1 << 16 }) {
+		test_rid_iterator(*region, expected_rids, 0, batch_size);
+		test_rid_iterator(*region, expected_rids, 1ULL << 40, batch_size);
+	}
+
 	region->convert_to_rids(rids, true, false);
 	assert(rids == expected_rids);
 
@@ -136,11 +161,16 @@ static void test_ridconv(std::string testname, typename RegionEncoderT::RegionEn
 int main(int argc, char **argv) {
 	test_ridconv< IIRegionEncoder >("ii", IIRegionEncoderConfig());
 	test_ridconv< CIIRegionEncoder >("cii", CIIRegionEncoderConfig());
+	test_ridconv< CIIRegionEncoder >("cii-bp128", CIIRegionEncoderConfig(CIICompressionFormat::BP128));
+	test_ridconv< CBLQRegionEncoder<1> >("cblq1d", CBLQRegionEncoderConfig(false));
+	test_ridconv< CBLQRegionEncoder<1> >("cblq1d-dense", CBLQRegionEncoderConfig(true));
 	test_ridconv< CBLQRegionEncoder<2> >("cblq2d", CBLQRegionEncoderConfig(false));
 	test_ridconv< CBLQRegionEncoder<2> >("cblq2d-dense", CBLQRegionEncoderConfig(true));
 	test_ridconv< CBLQRegionEncoder<3> >("cblq3d", CBLQRegionEncoderConfig(false));
 	test_ridconv< CBLQRegionEncoder<3> >("cblq3d-dense", CBLQRegionEncoderConfig(true));
 	test_ridconv< WAHRegionEncoder >("wah", WAHRegionEncoderConfig());
+	test_ridconv< WAH64RegionEncoder >("wah64", WAH64RegionEncoderConfig());
+	test_ridconv< BitmapRegionEncoder >("bitmap", BitmapRegionEncoderConfig());
 }
 
 
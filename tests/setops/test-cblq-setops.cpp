@@ -78,10 +78,11 @@ struct TestCase {
 };
 
 template<typename RegionEncoderT, typename SetOperationsT>
-static boost::shared_ptr< RegionEncoding > do_test(const TestCase &test, std::string setopsimpl, typename RegionEncoderT::RegionEncoderConfig conf, typename SetOperationsT::SetOperationsConfig setops_conf) {
+static boost::shared_ptr< RegionEncoding > do_test(const TestCase &test, std::string setopsimpl, typename RegionEncoderT::RegionEncoderConfig conf, typename SetOperationsT::SetOperationsConfig setops_conf, boost::shared_ptr< SetOperationsT > setops = nullptr) {
 	typedef typename RegionEncoderT::RegionEncodingOutT RegionEncodingT;
 
-	boost::shared_ptr< SetOperationsT > setops = boost::make_shared< SetOperationsT >(setops_conf);
+	if (!setops)
+		setops = boost::make_shared< SetOperationsT >(setops_conf);
 
 	boost::shared_ptr< InMemoryDataset<int> > dataset = make_dataset(test.domain);
 	boost::shared_ptr< BinnedIndex > index = make_index< RegionEncoderT >(conf, dataset);
@@ -119,6 +120,12 @@ static boost::shared_ptr< RegionEncoding > do_test(const TestCase &test, std::st
 	return result;
 }
 
+// Split levels into spans as early as possible, so even the small test cases exercise the parallel path
+template<int ndim>
+static boost::shared_ptr< CBLQSetOperationsNAry3FastParallel<ndim> > make_parallel_setops() {
+	return boost::make_shared< CBLQSetOperationsNAry3FastParallel<ndim> >(CBLQSetOperationsConfig(true), 4, 1);
+}
+
 std::vector<int> && make_big_domain(uint64_t domain_size, int value_range, std::vector<int> &&domain_out) {
 	uint64_t i = 0;
 	for (; i < (uint64_t)value_range; i++)
@@ -139,6 +146,9 @@ const std::vector< TestCase > TEST_CASES = {
 	TestCase("med-inter", MEDIUM_DOMAIN, std::vector< std::pair<int, int> >{{0, 3}, {3, 5}}, NArySetOperation::INTERSECTION),
 	TestCase("big-inter", BIG_DOMAIN, std::vector< std::pair<int, int> >{{2, 6}, {5, 9}}, NArySetOperation::INTERSECTION),
 	TestCase("manybin-inter", MANYBINS_DOMAIN, std::vector< std::pair<int, int> >{{60, 120}, {80, 140}}, NArySetOperation::INTERSECTION),
+	TestCase("small-diff", SMALL_DOMAIN, std::vector< std::pair<int, int> >{{0, 1}, {1, 2}}, NArySetOperation::DIFFERENCE),
+	TestCase("med-diff", MEDIUM_DOMAIN, std::vector< std::pair<int, int> >{{0, 4}, {2, 3}, {4, 5}}, NArySetOperation::DIFFERENCE),
+	TestCase("big-diff", BIG_DOMAIN, std::vector< std::pair<int, int> >{{2, 6}, {5, 9}}, NArySetOperation::DIFFERENCE),
 };
 
 // test case small-union:
@@ -151,6 +161,33 @@ const std::vector< TestCase > TEST_CASES = {
 // [1, 2] = 2212 0001 1110 0010 (in big-endian)
 // final result = 2222 0000 1110 0001 0010 (big-endian, before compact)
 
+// Runs the test case on all CBLQ set operations implementations, checking them against the basic implementation,
+// and returns the (non-dense) result
+template<int ndim>
+static boost::shared_ptr< RegionEncoding > run_test_case(const TestCase &test) {
+	boost::shared_ptr< RegionEncoding > nondense_oracle = do_test< CBLQRegionEncoder<ndim>, CBLQSetOperations<ndim> >(test, "basic", CBLQRegionEncoderConfig(false), CBLQSetOperationsConfig(true));
+	boost::shared_ptr< RegionEncoding > nary3 = do_test< CBLQRegionEncoder<ndim>, CBLQSetOperationsNAry3Dense<ndim> >(test, "nary3", CBLQRegionEncoderConfig(false), CBLQSetOperationsConfig(true));
+	boost::shared_ptr< RegionEncoding > fast = do_test< CBLQRegionEncoder<ndim>, CBLQSetOperationsFast<ndim> >(test, "fast", CBLQRegionEncoderConfig(false), CBLQSetOperationsConfig(true));
+	boost::shared_ptr< RegionEncoding > naryfast = do_test< CBLQRegionEncoder<ndim>, CBLQSetOperationsNAry3Fast<ndim> >(test, "nary3fast", CBLQRegionEncoderConfig(false), CBLQSetOperationsConfig(true));
+	boost::shared_ptr< RegionEncoding > naryfastpar = do_test< CBLQRegionEncoder<ndim>, CBLQSetOperationsNAry3FastParallel<ndim> >(test, "nary3fastpar", CBLQRegionEncoderConfig(false), CBLQSetOperationsConfig(true), make_parallel_setops<ndim>());
+	assert(*nary3 == *nondense_oracle);
+	assert(*fast == *nondense_oracle);
+	assert(*naryfast == *nondense_oracle);
+	assert(*naryfastpar == *nondense_oracle);
+
+	boost::shared_ptr< RegionEncoding > dense_oracle = do_test< CBLQRegionEncoder<ndim>, CBLQSetOperations<ndim> >(test, "basic-dense", CBLQRegionEncoderConfig(true), CBLQSetOperationsConfig(true));
+	boost::shared_ptr< RegionEncoding > dense_nary3 = do_test< CBLQRegionEncoder<ndim>, CBLQSetOperationsNAry3Dense<ndim> >(test, "nary3-dense", CBLQRegionEncoderConfig(true), CBLQSetOperationsConfig(true));
+	boost::shared_ptr< RegionEncoding > dense_fast = do_test< CBLQRegionEncoder<ndim>, CBLQSetOperationsFast<ndim> >(test, "fast-dense", CBLQRegionEncoderConfig(true), CBLQSetOperationsConfig(true));
+	boost::shared_ptr< RegionEncoding > dense_naryfast = do_test< CBLQRegionEncoder<ndim>, CBLQSetOperationsNAry3Fast<ndim> >(test, "nary3fast-dense", CBLQRegionEncoderConfig(true), CBLQSetOperationsConfig(true));
+	boost::shared_ptr< RegionEncoding > dense_naryfastpar = do_test< CBLQRegionEncoder<ndim>, CBLQSetOperationsNAry3FastParallel<ndim> >(test, "nary3fastpar-dense", CBLQRegionEncoderConfig(true), CBLQSetOperationsConfig(true), make_parallel_setops<ndim>());
+	assert(*dense_nary3 == *dense_oracle);
+	assert(*dense_fast == *dense_oracle);
+	assert(*dense_naryfast == *dense_oracle);
+	assert(*dense_naryfastpar == *dense_oracle);
+
+	return nondense_oracle;
+}
+
 int main(int argc, char **argv) {
 	char *tempdir_cstr = std::getenv("testworkdir");
 	std::string tempdir = (tempdir_cstr ? tempdir_cstr : "test.work.dir");
@@ -160,21 +197,14 @@ int main(int argc, char **argv) {
 
 	for (auto test_it = TEST_CASES.cbegin(); test_it != TEST_CASES.cend(); test_it++) {
 		const TestCase &test = *test_it;
-		boost::shared_ptr< RegionEncoding > nondense_oracle = do_test< CBLQRegionEncoder<2>, CBLQSetOperations<2> >(test, "basic", CBLQRegionEncoderConfig(false), CBLQSetOperationsConfig(true));
-		boost::shared_ptr< RegionEncoding > nary3 = do_test< CBLQRegionEncoder<2>, CBLQSetOperationsNAry3Dense<2> >(test, "nary3", CBLQRegionEncoderConfig(false), CBLQSetOperationsConfig(true));
-		boost::shared_ptr< RegionEncoding > fast = do_test< CBLQRegionEncoder<2>, CBLQSetOperationsFast<2> >(test, "fast", CBLQRegionEncoderConfig(false), CBLQSetOperationsConfig(true));
-		boost::shared_ptr< RegionEncoding > naryfast = do_test< CBLQRegionEncoder<2>, CBLQSetOperationsNAry3Fast<2> >(test, "nary3fast", CBLQRegionEncoderConfig(false), CBLQSetOperationsConfig(true));
-		assert(*nary3 == *nondense_oracle);
-		assert(*fast == *nondense_oracle);
-		assert(*naryfast == *nondense_oracle);
-
-		boost::shared_ptr< RegionEncoding > dense_oracle = do_test< CBLQRegionEncoder<2>, CBLQSetOperations<2> >(test, "basic-dense", CBLQRegionEncoderConfig(true), CBLQSetOperationsConfig(true));
-		boost::shared_ptr< RegionEncoding > dense_nary3 = do_test< CBLQRegionEncoder<2>, CBLQSetOperationsNAry3Dense<2> >(test, "nary3-dense", CBLQRegionEncoderConfig(true), CBLQSetOperationsConfig(true));
-		boost::shared_ptr< RegionEncoding > dense_fast = do_test< CBLQRegionEncoder<2>, CBLQSetOperationsFast<2> >(test, "fast-dense", CBLQRegionEncoderConfig(true), CBLQSetOperationsConfig(true));
-		boost::shared_ptr< RegionEncoding > dense_naryfast = do_test< CBLQRegionEncoder<2>, CBLQSetOperationsNAry3Fast<2> >(test, "nary3fast-dense", CBLQRegionEncoderConfig(true), CBLQSetOperationsConfig(true));
-		assert(*dense_nary3 == *dense_oracle);
-		assert(*dense_fast == *dense_oracle);
-		assert(*dense_naryfast == *dense_oracle);
+		boost::shared_ptr< RegionEncoding > result_2d = run_test_case<2>(test);
+		boost::shared_ptr< RegionEncoding > result_1d = run_test_case<1>(test);
+
+		// The test domains are 1D, so the 1D and 2D CBLQs must select the same elements
+		std::vector< uint32_t > rids_2d, rids_1d;
+		result_2d->convert_to_rids(rids_2d, true);
+		result_1d->convert_to_rids(rids_1d, true);
+		assert(rids_1d == rids_2d);
 	}
 }
 
@@ -162,23 +162,86 @@ static inline void do_test_vary_setops(ciis_t all_regions, const bitmaps_t &all_
 	do_test_with_setops< CIISetOperationsNAry >(all_regions, all_bitmaps);
 }
 
-static inline void do_test(const bitmaps_t &all_bitmaps) {
+static inline void do_test(const bitmaps_t &all_bitmaps, CIIRegionEncoderConfig conf) {
 	std::vector< boost::shared_ptr< CIIRegionEncoding > > all_regions;
 	for (boost::dynamic_bitset<> &bitmap : all_bitmaps) {
-		all_regions.push_back(make_region< CIIRegionEncoder >(CIIRegionEncoderConfig(), bitmap));
+		all_regions.push_back(make_region< CIIRegionEncoder >(conf, bitmap));
 	}
 
 	for (int i = -1; i < (int)all_regions.size(); ++i) {
-		if (i >= 0)
+		if (i >= 0) {
 			all_regions[i]->decompress();
+			assert(all_regions[i]->get_size_in_bytes() > 1); // Uncompressed RIDs count toward the size, too
+		}
 		do_test_vary_setops(all_regions, all_bitmaps);
 	}
 }
 
+// Exposes the skip-table probing path, to check when it applies
+class SkippingCIISetOperations : public CIISetOperations {
+public:
+	SkippingCIISetOperations() : CIISetOperations(CIISetOperationsConfig(false)) {}
+	using CIISetOperations::binary_set_op_skipping;
+};
+
+// A sparse operand against a dense one, so intersections/differences probe the dense operand's skip table
+static void do_test_skewed(CIIRegionEncoderConfig conf) {
+	const uint64_t domain_size = 1ULL<<16;
+	boost::dynamic_bitset<> dense = make_big_bitmap(domain_size), sparse(domain_size, 0);
+	for (int i = 0; i < 40; i++)
+		sparse[rand() % domain_size] = true;
+	sparse[0] = sparse[domain_size - 1] = true;
+
+	SkippingCIISetOperations setops;
+	std::vector< uint32_t > rids, skipping_rids;
+
+	for (bool invert_dense : { false, true }) {
+		for (bool invert_sparse : { false, true }) {
+			boost::shared_ptr< CIIRegionEncoding > dense_region = make_region< CIIRegionEncoder >(conf, dense);
+			boost::shared_ptr< CIIRegionEncoding > sparse_region = make_region< CIIRegionEncoder >(conf, sparse);
+			if (invert_dense)	setops.inplace_unary_set_op(dense_region, UnarySetOperation::COMPLEMENT);
+			if (invert_sparse)	setops.inplace_unary_set_op(sparse_region, UnarySetOperation::COMPLEMENT);
+
+			const boost::dynamic_bitset<> dense_bits = invert_dense ? ~dense : dense;
+			const boost::dynamic_bitset<> sparse_bits = invert_sparse ? ~sparse : sparse;
+
+			for (NArySetOperation op : { NArySetOperation::INTERSECTION, NArySetOperation::DIFFERENCE }) {
+				for (bool sparse_first : { false, true }) {
+					const auto &left = sparse_first ? sparse_region : dense_region, &right = sparse_first ? dense_region : sparse_region;
+					const auto &left_bits = sparse_first ? sparse_bits : dense_bits, &right_bits = sparse_first ? dense_bits : sparse_bits;
+					const boost::dynamic_bitset<> expected = (op == NArySetOperation::INTERSECTION) ? (left_bits & right_bits) : (left_bits - right_bits);
+
+					setops.binary_set_op(left, right, op)->convert_to_rids(rids, true, true);
+					assert(rids.size() == expected.count());
+					for (uint32_t rid : rids)
+						assert(expected[rid]);
+
+					// Without inversion, the intersection (either way round) and the sparse operand minus the dense one
+					// must be computed by probing, rather than by merging all of the dense operand
+					if (!invert_dense && !invert_sparse && (op == NArySetOperation::INTERSECTION || sparse_first)) {
+						const boost::shared_ptr< CIIRegionEncoding > skipping_result = setops.binary_set_op_skipping(left, right, op);
+						assert(skipping_result);
+						skipping_result->convert_to_rids(skipping_rids, true, true);
+						assert(skipping_rids == rids);
+					}
+				}
+			}
+		}
+	}
+}
+
 int main(int argc, char **argv) {
-	do_test(bitmaps_t { bitmap1, bitmap2, bitmap3 });
-	do_test(bitmaps_t { bigbitmap1, bigbitmap2, bigbitmap3 });
-	do_test(bitmaps_t { rlybigbitmap1, rlybigbitmap2, rlybigbitmap3 });
+#ifdef HAVE_RIDCOMPRESS
+	const std::vector< CIIRegionEncoderConfig > confs = { CIIRegionEncoderConfig(CIICompressionFormat::PFOR_DELTA), CIIRegionEncoderConfig(CIICompressionFormat::BP128) };
+#else
+	const std::vector< CIIRegionEncoderConfig > confs = { CIIRegionEncoderConfig(CIICompressionFormat::BP128) };
+#endif
+	for (CIIRegionEncoderConfig conf : confs) {
+		do_test(bitmaps_t { bitmap1, bitmap2, bitmap3 }, conf);
+		do_test(bitmaps_t { bigbitmap1, bigbitmap2, bigbitmap3 }, conf);
+		do_test(bitmaps_t { rlybigbitmap1, rlybigbitmap2, rlybigbitmap3 }, conf);
+		do_test_skewed(conf);
+	}
 }
 
 
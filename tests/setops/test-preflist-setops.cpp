@@ -0,0 +1,170 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * test-preflist-setops.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/dynamic_bitset.hpp>
+
+#include "pique/region/region-encoding.hpp"
+#include "pique/setops/setops.hpp"
+#include "pique/indexing/representation-selector.hpp"
+
+#include "pique/region/ii/ii.hpp"
+#include "pique/region/ii/ii-encode.hpp"
+#include "pique/setops/ii/ii-setops.hpp"
+
+#include "pique/region/cblq/cblq.hpp"
+#include "pique/region/cblq/cblq-encode.hpp"
+#include "pique/setops/cblq/cblq-setops.hpp"
+
+#include "pique/region/bitmap/bitmap.hpp"
+#include "pique/region/bitmap/bitmap-encode.hpp"
+#include "pique/setops/bitmap/bitmap-setops.hpp"
+
+using bitmap_t = boost::dynamic_bitset<>;
+using RegionType = RegionEncoding::Type;
+
+// Each bit is set with probability 1/sparsity
+static bitmap_t make_random_bitmap(uint64_t domain_size, int sparsity) {
+	bitmap_t bitmap(domain_size, 0);
+	for (uint64_t i = 0; i < domain_size; i++)
+		bitmap[i] = (rand() % sparsity == 0);
+	return bitmap;
+}
+
+template<typename RegionEncoderT>
+static boost::shared_ptr< RegionEncoding > make_region(typename RegionEncoderT::RegionEncoderConfig conf, const bitmap_t &bitmap) {
+	RegionEncoderT encoder(conf, bitmap.size());
+	for (uint64_t i = 0; i < bitmap.size(); ++i)
+		encoder.push_bits(1, bitmap[i]);
+	encoder.finalize();
+	return encoder.to_region_encoding();
+}
+
+static boost::shared_ptr< RegionEncoding > make_region(RegionType type, const bitmap_t &bitmap) {
+	switch (type) {
+	case RegionType::II: return make_region< IIRegionEncoder >(IIRegionEncoderConfig(), bitmap);
+	case RegionType::CBLQ_2D: return make_region< CBLQRegionEncoder<2> >(CBLQRegionEncoderConfig(false), bitmap); // Match the suffix density of converted CBLQs
+	case RegionType::UNCOMPRESSED_BITMAP: return make_region< BitmapRegionEncoder >(BitmapRegionEncoderConfig(), bitmap);
+	default: abort(); return nullptr;
+	}
+}
+
+static bitmap_t apply_op(bitmap_t left, const bitmap_t &right, NArySetOperation op) {
+	switch (op) {
+	case NArySetOperation::UNION: return left |= right;
+	case NArySetOperation::INTERSECTION: return left &= right;
+	case NArySetOperation::DIFFERENCE: return left -= right;
+	case NArySetOperation::SYMMETRIC_DIFFERENCE: return left ^= right;
+	default: abort(); return left;
+	}
+}
+
+static void check_region(boost::shared_ptr< const RegionEncoding > region, const bitmap_t &expected) {
+	std::vector< uint32_t > rids, expected_rids;
+	for (uint32_t rid = 0; rid < expected.size(); ++rid)
+		if (expected[rid])
+			expected_rids.push_back(rid);
+
+	boost::const_pointer_cast< RegionEncoding >(region)->convert_to_rids(rids, true, true);
+	assert(rids == expected_rids);
+}
+
+static boost::shared_ptr< PreferenceListSetOperations > make_preflist_setops() {
+	boost::shared_ptr< PreferenceListSetOperations > setops = boost::make_shared< PreferenceListSetOperations >();
+	setops->push_back(boost::make_shared< IISetOperations >(IISetOperationsConfig()));
+	setops->push_back(boost::make_shared< CBLQSetOperationsFast<2> >(CBLQSetOperationsConfig(true)));
+	setops->push_back(boost::make_shared< BitmapSetOperations >(BitmapSetOperationsConfig()));
+	return setops;
+}
+
+static const std::vector< RegionType > TYPES = { RegionType::II, RegionType::CBLQ_2D, RegionType::UNCOMPRESSED_BITMAP };
+
+// Set operations over operands in every combination of representations
+static void do_mixed_setops_test(const std::vector< bitmap_t > &bitmaps) {
+	const boost::shared_ptr< PreferenceListSetOperations > setops = make_preflist_setops();
+
+	for (NArySetOperation op : { NArySetOperation::UNION, NArySetOperation::INTERSECTION, NArySetOperation::DIFFERENCE, NArySetOperation::SYMMETRIC_DIFFERENCE }) {
+		// Binary, out-of-place and in-place (which must keep the left operand's representation)
+		for (RegionType ltype : TYPES) {
+			for (RegionType rtype : TYPES) {
+				const bitmap_t expected = apply_op(bitmaps[0], bitmaps[1], op);
+				const boost::shared_ptr< const RegionEncoding > right = make_region(rtype, bitmaps[1]);
+
+				check_region(setops->dynamic_binary_set_op(make_region(ltype, bitmaps[0]), right, op), expected);
+
+				const boost::shared_ptr< RegionEncoding > left = make_region(ltype, bitmaps[0]);
+				setops->dynamic_inplace_binary_set_op(left, right, op);
+				assert(left->get_type() == ltype);
+				check_region(left, expected);
+			}
+		}
+
+		// N-ary, with each operand in a different representation
+		bitmap_t expected = bitmaps[0];
+		for (size_t i = 1; i < bitmaps.size(); ++i)
+			expected = apply_op(expected, bitmaps[i], op);
+
+		for (size_t first_type = 0; first_type < TYPES.size(); ++first_type) {
+			std::vector< boost::shared_ptr< const RegionEncoding > > operands;
+			for (size_t i = 0; i < bitmaps.size(); ++i)
+				operands.push_back(make_region(TYPES[(first_type + i) % TYPES.size()], bitmaps[i]));
+
+			check_region(setops->dynamic_nary_set_op(operands.cbegin(), operands.cend(), op), expected);
+
+			const boost::shared_ptr< RegionEncoding > first = make_region(TYPES[first_type], bitmaps[0]);
+			setops->dynamic_inplace_nary_set_op(first, operands.cbegin() + 1, operands.cend(), op);
+			assert(first->get_type() == TYPES[first_type]);
+			check_region(first, expected);
+		}
+	}
+}
+
+// Sparse regions should be stored inverted, and dense, unstructured ones as bitmaps, with contents preserved
+static void do_selection_test(uint64_t domain_size) {
+	const RegionRepresentationSelector selector(TYPES);
+
+	const bitmap_t sparse = make_random_bitmap(domain_size, 1000), dense = make_random_bitmap(domain_size, 2);
+	for (RegionType type : TYPES) {
+		const boost::shared_ptr< RegionEncoding > selected_sparse = selector.select_representation(make_region(type, sparse));
+		assert(selected_sparse->get_type() == RegionType::II);
+		check_region(selected_sparse, sparse);
+
+		const boost::shared_ptr< RegionEncoding > selected_dense = selector.select_representation(make_region(type, dense));
+		assert(selected_dense->get_type() == RegionType::UNCOMPRESSED_BITMAP);
+		check_region(selected_dense, dense);
+	}
+}
+
+int main(int argc, char **argv) {
+	for (uint64_t domain_size : { 1ULL<<6, 1ULL<<12, 1ULL<<16 }) {
+		do_mixed_setops_test({ make_random_bitmap(domain_size, 2), make_random_bitmap(domain_size, 50), make_random_bitmap(domain_size, 3) });
+		do_mixed_setops_test({ make_random_bitmap(domain_size, 500), make_random_bitmap(domain_size, 2), bitmap_t(domain_size, 0), ~bitmap_t(domain_size, 0) });
+	}
+
+	do_selection_test(1ULL<<16);
+}
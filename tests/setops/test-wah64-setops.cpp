@@ -0,0 +1,169 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * test-wah64-setops.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/dynamic_bitset.hpp>
+
+#include "pique/region/region-encoding.hpp"
+#include "pique/setops/setops.hpp"
+
+#include "pique/region/wah/wah64.hpp"
+#include "pique/region/wah/wah64-encode.hpp"
+#include "pique/setops/wah/wah64-setops.hpp"
+
+using bitmap_t = boost::dynamic_bitset<>;
+using regions_t = std::vector< boost::shared_ptr< const WAH64RegionEncoding > >;
+
+static bitmap_t make_random_bitmap(uint64_t domain_size) {
+	bitmap_t bitmap(domain_size, 0);
+	for (uint64_t i = 0; i < domain_size; i++)
+		bitmap[i] = (rand() & 1);
+	return bitmap;
+}
+
+// Long 0/1 runs (spanning many WAH groups) interspersed with short random stretches
+static bitmap_t make_runs_bitmap(uint64_t domain_size) {
+	bitmap_t bitmap(domain_size, 0);
+	uint64_t i = 0;
+	while (i < domain_size) {
+		const uint64_t len = std::min< uint64_t >(rand() % 600 + 1, domain_size - i);
+		const int kind = rand() % 3;
+		for (uint64_t j = i; j < i + len; ++j)
+			bitmap[j] = (kind == 2) ? (rand() & 1) : kind;
+		i += len;
+	}
+	return bitmap;
+}
+
+static boost::shared_ptr< WAH64RegionEncoding > make_region(const bitmap_t &bitmap) {
+	WAH64RegionEncoder encoder(WAH64RegionEncoderConfig(), bitmap.size());
+
+	// Push runs, rather than single bits, to exercise fill appends
+	uint64_t i = 0;
+	while (i < bitmap.size()) {
+		uint64_t j = i + 1;
+		while (j < bitmap.size() && bitmap[j] == bitmap[i])
+			++j;
+		encoder.push_bits(j - i, bitmap[i]);
+		i = j;
+	}
+
+	encoder.finalize();
+	return encoder.to_region_encoding();
+}
+
+static bitmap_t apply_op(bitmap_t left, const bitmap_t &right, NArySetOperation op) {
+	switch (op) {
+	case NArySetOperation::UNION: return left |= right;
+	case NArySetOperation::INTERSECTION: return left &= right;
+	case NArySetOperation::DIFFERENCE: return left -= right;
+	case NArySetOperation::SYMMETRIC_DIFFERENCE: return left ^= right;
+	default: abort(); return left;
+	}
+}
+
+// Since the encoding is canonical, a result must equal the direct encoding of the expected bitmap
+static void check_region(WAH64RegionEncoding region, const bitmap_t &expected) {
+	assert(region == *make_region(expected));
+	assert(region.get_domain_size() == expected.size());
+	assert(region.get_element_count() == expected.count());
+
+	std::vector< uint64_t > rids, batch, batched_rids;
+	region.convert_to_rids(rids, 0, true, true);
+	for (uint64_t rid : rids)
+		assert(expected[rid]);
+	assert(rids.size() == expected.count());
+
+	boost::shared_ptr< RIDBatchIterator > rid_it = region.make_rid_iterator();
+	while (rid_it->next_batch(batch, 100))
+		batched_rids.insert(batched_rids.end(), batch.begin(), batch.end());
+	assert(batched_rids == rids);
+}
+
+static void do_test(const std::vector< bitmap_t > &bitmaps) {
+	WAH64SetOperations setops((WAH64SetOperationsConfig()));
+
+	regions_t regions;
+	for (const bitmap_t &bitmap : bitmaps) {
+		regions.push_back(make_region(bitmap));
+		check_region(*regions.back(), bitmap);
+	}
+
+	// Complement, out-of-place and in-place
+	for (size_t i = 0; i < bitmaps.size(); ++i) {
+		check_region(*setops.unary_set_op(regions[i], UnarySetOperation::COMPLEMENT), ~bitmaps[i]);
+
+		boost::shared_ptr< WAH64RegionEncoding > region = make_region(bitmaps[i]);
+		setops.inplace_unary_set_op(region, UnarySetOperation::COMPLEMENT);
+		check_region(*region, ~bitmaps[i]);
+	}
+
+	for (NArySetOperation op : { NArySetOperation::UNION, NArySetOperation::INTERSECTION, NArySetOperation::DIFFERENCE, NArySetOperation::SYMMETRIC_DIFFERENCE }) {
+		// Binary, out-of-place and in-place, over all operand pairs (including self-pairs)
+		for (size_t i = 0; i < bitmaps.size(); ++i) {
+			for (size_t j = 0; j < bitmaps.size(); ++j) {
+				const bitmap_t expected = apply_op(bitmaps[i], bitmaps[j], op);
+				check_region(*setops.binary_set_op(regions[i], regions[j], op), expected);
+
+				boost::shared_ptr< WAH64RegionEncoding > left = make_region(bitmaps[i]);
+				setops.inplace_binary_set_op(left, regions[j], op);
+				check_region(*left, expected);
+			}
+		}
+
+		// N-ary, out-of-place and in-place
+		bitmap_t expected = bitmaps[0];
+		for (size_t i = 1; i < bitmaps.size(); ++i)
+			expected = apply_op(expected, bitmaps[i], op);
+
+		check_region(*setops.nary_set_op(regions.begin(), regions.end(), op), expected);
+
+		boost::shared_ptr< WAH64RegionEncoding > first = make_region(bitmaps[0]);
+		setops.inplace_nary_set_op(first, regions.begin() + 1, regions.end(), op);
+		check_region(*first, expected);
+	}
+}
+
+static void do_test_for_domain_size(uint64_t domain_size) {
+	do_test({ make_random_bitmap(domain_size), make_random_bitmap(domain_size), make_random_bitmap(domain_size) });
+	do_test({ make_runs_bitmap(domain_size), make_runs_bitmap(domain_size), make_runs_bitmap(domain_size), make_runs_bitmap(domain_size) });
+	do_test({ make_runs_bitmap(domain_size), bitmap_t(domain_size, 0), ~bitmap_t(domain_size, 0), make_random_bitmap(domain_size) });
+
+	// Many operands, as in a bin merge, to exercise the single-pass n-ary merge
+	std::vector< bitmap_t > many_bitmaps;
+	for (int i = 0; i < 12; ++i)
+		many_bitmaps.push_back(make_runs_bitmap(domain_size));
+	do_test(many_bitmaps);
+}
+
+int main(int argc, char **argv) {
+	do_test_for_domain_size(16);
+	do_test_for_domain_size(63);
+	do_test_for_domain_size(63 * 40);
+	do_test_for_domain_size(1ULL<<14);
+	do_test_for_domain_size((1ULL<<14) + 5);
+}
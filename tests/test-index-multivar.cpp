@@ -0,0 +1,177 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * test-index-multivar.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#ifdef HAVE_HDF5
+#include <hdf5.h>
+#endif
+
+#include "pique/data/grid.hpp"
+#include "pique/data/dataset.hpp"
+#include "pique/region/region-encoding.hpp"
+#include "pique/region/ii/ii.hpp"
+#include "pique/region/ii/ii-encode.hpp"
+#include "pique/region/cblq/cblq.hpp"
+#include "pique/region/cblq/cblq-encode.hpp"
+#include "pique/region/wah/wah64.hpp"
+#include "pique/region/wah/wah64-encode.hpp"
+#include "pique/indexing/binned-index.hpp"
+#include "pique/indexing/index-builder.hpp"
+#include "pique/indexing/multivar-index-builder.hpp"
+
+// Runs of random lengths, so that many runs cross block boundaries
+template<typename datatype_t>
+static std::vector< datatype_t > make_values(uint64_t nelem, int nvalues) {
+	std::vector< datatype_t > values;
+	while (values.size() < nelem) {
+		const uint64_t run_length = rand() % 50 + 1;
+		values.insert(values.end(), std::min< uint64_t >(run_length, nelem - values.size()), (datatype_t)(rand() % nvalues));
+	}
+	return values;
+}
+
+static void check_same_index(const BinnedIndex &index, const BinnedIndex &expected_index) {
+	assert(index.get_domain_size() == expected_index.get_domain_size());
+	assert(index.get_num_bins() == expected_index.get_num_bins());
+	for (BinnedIndexTypes::bin_id_t bin = 0; bin < expected_index.get_num_bins(); ++bin) {
+		assert(index.get_bin_key(bin) == expected_index.get_bin_key(bin));
+		assert(*index.get_region(bin) == *expected_index.get_region(bin));
+	}
+}
+
+// A variable to be indexed both alone and alongside the others
+struct TestVariable {
+	boost::shared_ptr< const Dataset > dataset;
+	boost::shared_ptr< BinnedIndex > expected_index;
+	boost::shared_ptr< AbstractIndexBuildSession > session;
+};
+
+template<typename datatype_t, typename RegionEncoderT>
+static TestVariable make_variable(typename RegionEncoderT::RegionEncoderConfig conf, boost::shared_ptr< const Dataset > dataset) {
+	using SigbitsBinningSpec = SigbitsBinningSpecification< datatype_t >;
+
+	TestVariable var;
+	var.dataset = dataset;
+
+	IndexBuilder< datatype_t, RegionEncoderT, SigbitsBinningSpec > builder(conf, boost::make_shared< SigbitsBinningSpec >(sizeof(datatype_t)*8));
+	var.expected_index = builder.build_index(*var.dataset);
+	var.session = builder.begin_build(dataset->get_element_count());
+	return var;
+}
+
+template<typename datatype_t, typename RegionEncoderT>
+static TestVariable make_variable(typename RegionEncoderT::RegionEncoderConfig conf, const Grid &grid) {
+	return make_variable< datatype_t, RegionEncoderT >(conf, boost::make_shared< InMemoryDataset< datatype_t > >(make_values< datatype_t >(grid.get_npoints(), 20), Grid(grid)));
+}
+
+static void test_multivar_build(const Grid &grid, uint64_t block_elements) {
+	std::vector< TestVariable > vars;
+	vars.push_back(make_variable< int, IIRegionEncoder >(IIRegionEncoderConfig(), grid));
+	vars.push_back(make_variable< float, WAH64RegionEncoder >(WAH64RegionEncoderConfig(), grid));
+	vars.push_back(make_variable< double, CBLQRegionEncoder<1> >(CBLQRegionEncoderConfig(false), grid));
+
+	MultiVariableIndexBuilder builder(block_elements);
+	for (const TestVariable &var : vars)
+		builder.add_variable(var.dataset, var.session);
+
+	std::vector< boost::shared_ptr< BinnedIndex > > indexes = builder.build_indexes();
+	assert(indexes.size() == vars.size());
+	for (size_t i = 0; i < vars.size(); ++i)
+		check_same_index(*indexes[i], *vars[i].expected_index);
+
+	for (const IndexBuilderStats &stats : builder.get_stats())
+		assert(stats.num_bins > 0);
+}
+
+#ifdef HAVE_HDF5
+// Writes the values to a chunked HDF5 dataset, which (when multidimensional) can be read in subvolumes but not in
+// linearized ranges
+static boost::shared_ptr< const Dataset > make_hdf5_dataset(const std::vector< int > &values, const Grid &grid, std::string filename, std::string varname) {
+	const std::vector< hsize_t > dims(grid.begin(), grid.end());
+	std::vector< hsize_t > chunk_dims(dims);
+	chunk_dims[0] = std::max< hsize_t >(1, dims[0] / 4);
+	varname = std::string("/") + varname;
+
+	const hid_t h5out = H5Fcreate(filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	const hid_t dspace = H5Screate_simple(dims.size(), &dims.front(), NULL);
+	const hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	const herr_t chunkerr = H5Pset_chunk(dcpl, chunk_dims.size(), &chunk_dims.front());
+	const hid_t dset = H5Dcreate2(h5out, varname.c_str(), H5T_NATIVE_INT32, dspace, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+	const herr_t writeerr = H5Dwrite(dset, H5T_NATIVE_INT32, H5S_ALL, H5S_ALL, H5P_DEFAULT, &values.front());
+	const herr_t dsetcloseerr = H5Dclose(dset);
+	const herr_t dcplcloseerr = H5Pclose(dcpl);
+	const herr_t dspacecloseerr = H5Sclose(dspace);
+	const herr_t h5closeerr = H5Fclose(h5out);
+
+	assert(chunkerr == 0 && writeerr == 0 && dsetcloseerr == 0 && dcplcloseerr == 0 && dspacecloseerr == 0 && h5closeerr == 0);
+
+	return boost::make_shared< DatasetHDF5 >(filename, varname);
+}
+
+// An HDF5 variable is read in subvolume blocks, alongside an in-memory variable read in linearized-range blocks
+static void test_multivar_build_hdf5(const Grid &grid, uint64_t block_elements, std::string filename) {
+	const std::vector< int > values = make_values< int >(grid.get_npoints(), 20);
+
+	std::vector< TestVariable > vars;
+	vars.push_back(make_variable< float, WAH64RegionEncoder >(WAH64RegionEncoderConfig(), grid));
+	vars.push_back(make_variable< int, IIRegionEncoder >(IIRegionEncoderConfig(), boost::make_shared< InMemoryDataset< int > >(values, Grid(grid))));
+	vars.back().dataset = make_hdf5_dataset(values, grid, filename, "var"); // Expect the index of the same values held in memory
+	assert(vars.back().dataset->get_grid() == grid);
+
+	MultiVariableIndexBuilder builder(block_elements);
+	for (const TestVariable &var : vars)
+		builder.add_variable(var.dataset, var.session);
+
+	std::vector< boost::shared_ptr< BinnedIndex > > indexes = builder.build_indexes();
+	assert(indexes.size() == vars.size());
+	for (size_t i = 0; i < vars.size(); ++i)
+		check_same_index(*indexes[i], *vars[i].expected_index);
+}
+#endif
+
+int main(int argc, char **argv) {
+	srand(12345);
+
+#ifdef HAVE_HDF5
+	char *tempdir_cstr = std::getenv("testworkdir");
+	std::string tempdir = (tempdir_cstr ? tempdir_cstr : "test.work.dir");
+	std::string h5file = tempdir + "/test-index-multivar.h5";
+#endif
+
+	test_multivar_build(Grid{10000}, 1000);
+	test_multivar_build(Grid{97, 13, 5}, 100);      // Several rows per block
+	test_multivar_build(Grid{97, 13, 5}, 10);       // Blocks smaller than a row are rounded up to one row
+	test_multivar_build(Grid{97, 13, 5}, 1ULL<<20); // A single block
+
+#ifdef HAVE_HDF5
+	test_multivar_build_hdf5(Grid{10000}, 1000, h5file);
+	test_multivar_build_hdf5(Grid{97, 13, 5}, 100, h5file); // Blocks cross chunk boundaries
+#endif
+}
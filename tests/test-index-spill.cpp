@@ -0,0 +1,200 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * test-index-spill.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include "pique/data/grid.hpp"
+#include "pique/data/dataset.hpp"
+#include "pique/region/region-encoding.hpp"
+#include "pique/region/ii/ii.hpp"
+#include "pique/region/ii/ii-encode.hpp"
+#include "pique/region/cii/cii.hpp"
+#include "pique/region/cii/cii-encode.hpp"
+#include "pique/region/cblq/cblq.hpp"
+#include "pique/region/cblq/cblq-encode.hpp"
+#include "pique/region/wah/wah64.hpp"
+#include "pique/region/wah/wah64-encode.hpp"
+#include "pique/indexing/binned-index.hpp"
+#include "pique/indexing/index-builder.hpp"
+#include "pique/io/index-io.hpp"
+#include "pique/io/posix/posix-index-io.hpp"
+
+static std::string scratch_filename;
+
+// Mostly short runs over many bins, with occasional long runs, so that there are many more runs than bins
+static std::vector< int > make_values(uint64_t nelem, int nbins) {
+	std::vector< int > values;
+	while (values.size() < nelem) {
+		const uint64_t run_length = (rand() % 64 == 0) ? rand() % 1000 + 1 : rand() % 4 + 1;
+		values.insert(values.end(), std::min< uint64_t >(run_length, nelem - values.size()), rand() % nbins);
+	}
+	return values;
+}
+
+static void assert_regions_equal(const RegionEncoding &region, const RegionEncoding &expected_region) {
+	std::vector< uint32_t > rids, expected_rids;
+	region.convert_to_rids(rids, true, true);
+	expected_region.convert_to_rids(expected_rids, true, true);
+	assert(rids == expected_rids);
+	assert(region == expected_region);
+}
+
+// Checks each streamed region against an index built in-core as it arrives, then drops it
+class CheckingRegionSink : public BinnedIndexRegionSink {
+public:
+	CheckingRegionSink(const BinnedIndex &expected_index) : expected_index(expected_index), next_region(0) {}
+
+	virtual bool begin_regions(const BinnedIndex &index_meta, BinnedIndexTypes::region_count_t nregions) {
+		assert(index_meta.get_num_regions() == 0);
+		assert(index_meta.get_domain_size() == expected_index.get_domain_size());
+		assert(index_meta.get_all_bin_keys() == expected_index.get_all_bin_keys());
+		assert(nregions == expected_index.get_num_regions());
+		return true;
+	}
+	virtual bool write_region(boost::shared_ptr< RegionEncoding > region) {
+		assert(next_region < expected_index.get_num_regions());
+		assert_regions_equal(*region, *expected_index.get_region(next_region++));
+		return true;
+	}
+
+	const BinnedIndex &expected_index;
+	BinnedIndexTypes::region_id_t next_region;
+};
+
+// Builds the same index in-core and under a small memory budget, which must agree exactly
+template<typename RegionEncoderT>
+static void test_spilled_index(typename RegionEncoderT::RegionEncoderConfig conf, const Grid &grid, bool zorder, uint64_t memory_budget_bytes) {
+	using SigbitsBinningSpec = SigbitsBinningSpecification< int >;
+	using IndexBuilderT = IndexBuilder< int, RegionEncoderT, SigbitsBinningSpec >;
+
+	InMemoryDataset< int > dataset(make_values(grid.get_npoints(), 200), Grid(grid));
+
+	IndexBuilderT incore_builder(conf, boost::make_shared< SigbitsBinningSpec >(sizeof(int)*8));
+	IndexBuilderT spilling_builder(conf, boost::make_shared< SigbitsBinningSpec >(sizeof(int)*8), IndexBuilderSpillConfig(memory_budget_bytes, scratch_filename));
+
+	boost::shared_ptr< BinnedIndex > incore_index = zorder ? incore_builder.build_index_zo(dataset) : incore_builder.build_index(dataset);
+	boost::shared_ptr< BinnedIndex > spilled_index = zorder ? spilling_builder.build_index_zo(dataset) : spilling_builder.build_index(dataset);
+
+	assert(incore_builder.get_stats().num_spilled_pieces == 0);
+	assert(spilling_builder.get_stats().num_spilled_pieces > 0);
+	assert(spilling_builder.get_stats().peak_rss_bytes > 0);
+	assert(!std::ifstream(scratch_filename)); // The scratch file is removed after the build
+
+	assert(spilled_index->get_domain_size() == incore_index->get_domain_size());
+	assert(spilled_index->get_num_bins() == incore_index->get_num_bins());
+	for (BinnedIndexTypes::bin_id_t bin = 0; bin < incore_index->get_num_bins(); ++bin) {
+		assert(spilled_index->get_bin_key(bin) == incore_index->get_bin_key(bin));
+		assert_regions_equal(*spilled_index->get_region(bin), *incore_index->get_region(bin));
+	}
+
+	if (zorder)
+		return;
+
+	// Streaming the finished regions out as well bounds all the state held by the builder to the memory budget
+	IndexBuilderT streaming_builder(conf, boost::make_shared< SigbitsBinningSpec >(sizeof(int)*8), IndexBuilderSpillConfig(memory_budget_bytes, scratch_filename));
+	CheckingRegionSink sink(*incore_index);
+	boost::shared_ptr< BinnedIndex > index_meta = streaming_builder.build_index(dataset, GridSubset(grid), sink);
+
+	assert(sink.next_region == incore_index->get_num_regions());
+	assert(index_meta->get_num_regions() == 0 && index_meta->get_num_bins() == incore_index->get_num_bins());
+	assert(streaming_builder.get_stats().num_spilled_pieces > 0);
+	assert(streaming_builder.get_stats().peak_state_bytes > 0);
+	assert(streaming_builder.get_stats().peak_state_bytes <= memory_budget_bytes);
+	assert(incore_builder.get_stats().peak_state_bytes == 0); // Not tracked when not spilling
+}
+
+// Streams a spilled build directly into an index file, which must read back the same as the in-core index
+static void test_streamed_index_file(const std::string &index_filename, uint64_t memory_budget_bytes) {
+	using SigbitsBinningSpec = SigbitsBinningSpecification< int >;
+	using IndexBuilderT = IndexBuilder< int, CIIRegionEncoder, SigbitsBinningSpec >;
+	const CIIRegionEncoderConfig conf(CIICompressionFormat::BP128);
+
+	InMemoryDataset< int > dataset(make_values(1ULL<<21, 200), Grid{1ULL<<21});
+
+	IndexBuilderT incore_builder(conf, boost::make_shared< SigbitsBinningSpec >(sizeof(int)*8));
+	boost::shared_ptr< BinnedIndex > incore_index = incore_builder.build_index(dataset);
+
+	POSIXIndexIO outio;
+	assert(outio.open(index_filename, IndexOpenMode::WRITE));
+	boost::shared_ptr< IndexPartitionIO > outpartio = outio.append_partition();
+	outpartio->set_domain_global_offset(0);
+
+	IndexBuilderT streaming_builder(conf, boost::make_shared< SigbitsBinningSpec >(sizeof(int)*8), IndexBuilderSpillConfig(memory_budget_bytes, scratch_filename));
+	IndexPartitionRegionSink sink(outpartio);
+	streaming_builder.build_index(dataset, GridSubset(dataset.get_grid()), sink);
+	assert(streaming_builder.get_stats().peak_state_bytes <= memory_budget_bytes);
+
+	outpartio->close();
+	outio.close();
+
+	POSIXIndexIO inio;
+	assert(inio.open(index_filename, IndexOpenMode::READ));
+	assert(inio.get_num_partitions() == 1);
+	boost::shared_ptr< IndexPartitionIO > inpartio = inio.get_partition(0);
+
+	assert(inpartio->get_partition_metadata().domain->second == incore_index->get_domain_size());
+	assert(inpartio->get_all_bin_keys() == incore_index->get_all_bin_keys());
+	assert(inpartio->get_num_regions() == incore_index->get_num_regions());
+
+	std::set< BinnedIndexTypes::region_id_t > region_ids;
+	for (BinnedIndexTypes::region_id_t region = 0; region < incore_index->get_num_regions(); ++region)
+		region_ids.insert(region);
+
+	std::map< BinnedIndexTypes::region_id_t, boost::shared_ptr< RegionEncoding > > regions;
+	assert(inpartio->read_regions(region_ids, regions));
+	for (BinnedIndexTypes::region_id_t region = 0; region < incore_index->get_num_regions(); ++region) {
+		assert(inpartio->compute_regions_element_count(region, region + 1) == incore_index->get_region(region)->get_element_count());
+		assert_regions_equal(*regions[region], *incore_index->get_region(region));
+	}
+
+	inpartio->close();
+	inio.close();
+}
+
+int main(int argc, char **argv) {
+	char *tempdir_cstr = std::getenv("testworkdir");
+	std::string tempdir = (tempdir_cstr ? tempdir_cstr : "test.work.dir");
+	scratch_filename = tempdir + "/test-index-spill.scratch";
+
+	srand(12345);
+
+	// The budgets are well over twice the largest bin's region, and well under the encoders' total state without spilling
+	test_spilled_index< IIRegionEncoder >(IIRegionEncoderConfig(), Grid{1ULL<<21}, false, 1ULL<<18);
+	test_spilled_index< CIIRegionEncoder >(CIIRegionEncoderConfig(CIICompressionFormat::BP128), Grid{1ULL<<21}, false, 1ULL<<18);
+	test_spilled_index< WAH64RegionEncoder >(WAH64RegionEncoderConfig(), Grid{1ULL<<21}, false, 1ULL<<18);
+	test_spilled_index< CBLQRegionEncoder<1> >(CBLQRegionEncoderConfig(false), Grid{1ULL<<21}, false, 1ULL<<18);
+
+	test_spilled_index< IIRegionEncoder >(IIRegionEncoderConfig(), Grid{1500, 1400}, true, 1ULL<<18);
+	test_spilled_index< CBLQRegionEncoder<2> >(CBLQRegionEncoderConfig(true), Grid{1500, 1400}, true, 1ULL<<18);
+
+	test_streamed_index_file(tempdir + "/test-index-spill.index", 1ULL<<18);
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2015 David A. Boyuka II
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * test-index-zorder.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <boost/smart_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include "pique/data/grid.hpp"
+#include "pique/data/grid-subset.hpp"
+#include "pique/data/dataset.hpp"
+#include "pique/region/region-encoding.hpp"
+#include "pique/region/ii/ii.hpp"
+#include "pique/region/ii/ii-encode.hpp"
+#include "pique/region/cblq/cblq.hpp"
+#include "pique/region/cblq/cblq-encode.hpp"
+#include "pique/indexing/binned-index.hpp"
+#include "pique/indexing/index-builder.hpp"
+#include "pique/util/universal-value.hpp"
+
+// Interleaves the bits of the given row-major (C order) coordinates into a Z-order ID, with the last
+// (fastest-varying) coordinate in the lowest bit, matching zo_loop_iterate
+static uint64_t compute_zid(const std::vector< uint64_t > &coords, int exp_level) {
+	const int ndim = coords.size();
+	uint64_t zid = 0;
+	for (int bit = 0; bit < exp_level; ++bit)
+		for (int d = 0; d < ndim; ++d)
+			zid |= ((coords[ndim - d - 1] >> bit) & 1ULL) << (bit * ndim + d);
+	return zid;
+}
+
+template<typename RegionEncoderT>
+static void test_zorder_index(typename RegionEncoderT::RegionEncoderConfig conf, const Grid &grid, int exp_level, bool smeared) {
+	using SigbitsBinningSpec = SigbitsBinningSpecification< int >;
+	using BinningKeyType = typename SigbitsBinningSpec::QKeyType;
+
+	const int ndim = grid.size();
+	const uint64_t zo_nelem = 1ULL << (exp_level * ndim);
+
+	// Values form a few coarse blocks with some noise, so there are both long and short runs
+	std::vector< int > values;
+	std::vector< uint64_t > zids;
+	for (uint64_t rmoid = 0; rmoid < grid.get_npoints(); ++rmoid) {
+		std::vector< uint64_t > coords(ndim);
+		uint64_t rem = rmoid;
+		for (int d = ndim - 1; d >= 0; --d) {
+			coords[d] = rem % grid[d];
+			rem /= grid[d];
+		}
+
+		values.push_back((coords[0] / 4) + (rand() % 8 == 0 ? 3 : 0));
+		zids.push_back(compute_zid(coords, exp_level));
+	}
+
+	InMemoryDataset< int > dataset((std::vector< int >(values)), Grid(grid));
+	IndexBuilder< int, RegionEncoderT, SigbitsBinningSpec > builder(conf, boost::make_shared< SigbitsBinningSpec >(sizeof(int)*8));
+	boost::shared_ptr< BinnedIndex > index = builder.build_index_zo(dataset);
+
+	assert(index->get_domain_size() == zo_nelem);
+
+	// Every in-bounds element must appear at its Z-order ID in exactly the bin of its value
+	std::vector< int > bin_of_zid(zo_nelem, -1);
+	for (BinnedIndexTypes::bin_id_t bin = 0; bin < index->get_num_bins(); ++bin) {
+		std::vector< uint32_t > rids;
+		index->get_region(bin)->convert_to_rids(rids, true, true);
+		for (uint32_t rid : rids) {
+			assert(rid < zo_nelem);
+			assert(bin_of_zid[rid] == -1);
+			bin_of_zid[rid] = bin;
+		}
+	}
+
+	uint64_t inbounds_count = 0;
+	for (uint64_t rmoid = 0; rmoid < values.size(); ++rmoid) {
+		const int bin = bin_of_zid[zids[rmoid]];
+		assert(bin != -1);
+		assert(boost::get< BinningKeyType >(index->get_bin_key(bin)) == (BinningKeyType)values[rmoid]);
+		++inbounds_count;
+	}
+
+	// Without smearing, out-of-bounds elements must be in no bin
+	if (!smeared) {
+		uint64_t total_count = 0;
+		for (int bin : bin_of_zid)
+			if (bin != -1)
+				++total_count;
+		assert(total_count == inbounds_count);
+	}
+}
+
+// An index over a block of whole rows must match one over a dataset of just those rows
+template<typename RegionEncoderT>
+static void test_zorder_row_block(typename RegionEncoderT::RegionEncoderConfig conf, const Grid &grid, uint64_t first_row, uint64_t nrows) {
+	using SigbitsBinningSpec = SigbitsBinningSpecification< int >;
+
+	const uint64_t row_size = grid.get_npoints() / grid[0];
+	std::vector< int > values;
+	for (uint64_t i = 0; i < grid.get_npoints(); ++i)
+		values.push_back(rand() % 5);
+
+	std::vector< uint64_t > block_dims(grid.begin(), grid.end());
+	block_dims[0] = nrows;
+	InMemoryDataset< int > dataset((std::vector< int >(values)), Grid(grid));
+	InMemoryDataset< int > block_dataset(std::vector< int >(values.begin() + first_row * row_size, values.begin() + (first_row + nrows) * row_size), Grid(std::vector< uint64_t >(block_dims)));
+
+	IndexBuilder< int, RegionEncoderT, SigbitsBinningSpec > builder(conf, boost::make_shared< SigbitsBinningSpec >(sizeof(int)*8));
+	boost::shared_ptr< BinnedIndex > index = builder.build_index_zo(dataset, GridSubset(grid, first_row * row_size, nrows * row_size));
+	boost::shared_ptr< BinnedIndex > block_index = builder.build_index_zo(block_dataset);
+
+	// The index records the block's grid, linearized in Z-order
+	assert(index->get_grid() && index->get_grid()->get_linearization() == Grid::Linearization::Z_ORDER);
+	assert(*index->get_grid() == block_dims);
+
+	assert(index->get_domain_size() == block_index->get_domain_size());
+	assert(index->get_num_bins() == block_index->get_num_bins());
+	for (BinnedIndexTypes::bin_id_t bin = 0; bin < index->get_num_bins(); ++bin) {
+		std::vector< uint32_t > rids, block_rids;
+		index->get_region(bin)->convert_to_rids(rids, true, true);
+		block_index->get_region(bin)->convert_to_rids(block_rids, true, true);
+		assert(rids == block_rids);
+	}
+}
+
+// On spatially clustered data, a multi-dimensional encoding of a Z-order index must be much smaller than that of a
+// row-major index, since each cluster becomes a few aligned blocks rather than one run per row
+template<int ndim>
+static void test_zorder_size_reduction(const Grid &grid, uint64_t cluster_side) {
+	using SigbitsBinningSpec = SigbitsBinningSpecification< int >;
+
+	std::vector< int > values;
+	for (uint64_t rmoid = 0; rmoid < grid.get_npoints(); ++rmoid) {
+		int cluster = 0;
+		uint64_t rem = rmoid;
+		for (int d = ndim - 1; d >= 0; --d) {
+			cluster = cluster * (grid[d] / cluster_side) + (rem % grid[d]) / cluster_side;
+			rem /= grid[d];
+		}
+		values.push_back(cluster);
+	}
+
+	InMemoryDataset< int > dataset((std::vector< int >(values)), Grid(grid));
+	IndexBuilder< int, CBLQRegionEncoder<ndim>, SigbitsBinningSpec > builder(CBLQRegionEncoderConfig(false), boost::make_shared< SigbitsBinningSpec >(sizeof(int)*8));
+	const size_t rowmajor_bytes = builder.build_index(dataset)->get_size_in_bytes();
+	const size_t zorder_bytes = builder.build_index_zo(dataset)->get_size_in_bytes();
+
+	assert(zorder_bytes * 4 <= rowmajor_bytes);
+}
+
+int main(int argc, char **argv) {
+	srand(12345);
+
+	test_zorder_index< IIRegionEncoder >(IIRegionEncoderConfig(), Grid{8, 8}, 3, false);
+	test_zorder_index< IIRegionEncoder >(IIRegionEncoderConfig(), Grid{5, 7}, 3, false);
+	test_zorder_index< IIRegionEncoder >(IIRegionEncoderConfig(), Grid{9, 3, 6}, 4, false);
+	test_zorder_index< CBLQRegionEncoder<2> >(CBLQRegionEncoderConfig(false), Grid{16, 16}, 4, true);
+	test_zorder_index< CBLQRegionEncoder<2> >(CBLQRegionEncoderConfig(true), Grid{13, 21}, 5, true);
+	test_zorder_index< CBLQRegionEncoder<3> >(CBLQRegionEncoderConfig(false), Grid{9, 3, 6}, 4, true);
+	test_zorder_index< CBLQRegionEncoder<3> >(CBLQRegionEncoderConfig(true), Grid{7, 12, 5}, 4, true);
+
+	test_zorder_row_block< IIRegionEncoder >(IIRegionEncoderConfig(), Grid{13, 21}, 4, 5);
+	test_zorder_row_block< CBLQRegionEncoder<2> >(CBLQRegionEncoderConfig(false), Grid{13, 21}, 10, 3);
+	test_zorder_row_block< CBLQRegionEncoder<3> >(CBLQRegionEncoderConfig(false), Grid{9, 3, 6}, 0, 9);
+
+	test_zorder_size_reduction<2>(Grid{64, 64}, 16);
+	test_zorder_size_reduction<3>(Grid{32, 32, 32}, 8);
+}
@@ -88,8 +88,10 @@ static void verify_index(boost::shared_ptr< BinnedIndex > index, std::string ind
 							boost::counting_iterator< region_id_t >(index->get_num_regions())),
 						regions);
 	assert(regions.size() == index->get_num_regions());
-	for (region_id_t i = 0; i < index->get_num_regions(); i++)
+	for (region_id_t i = 0; i < index->get_num_regions(); i++) {
 		assert(*regions[i] == *index->get_region(i));
+		assert(partio->compute_regions_element_count(i, i + 1) == index->get_region(i)->get_element_count());
+	}
 
 	assert(partio->close());
 	assert(inindexio.close());
@@ -37,7 +37,7 @@ static void write_dataset_metadata_file(const InMemoryDataset<int> &dataset, std
 	fout.open(metadata_file, std::ios::out | std::ios::trunc);
 	assert(fout.good());
 
-	fout << dataset_path << std::endl;
+	fout << "raw " << dataset_path << std::endl; // The format, then the dataset path (see DataVariable::cache_metadata())
 
 	std::string datatype_name = *Datatypes::get_name_by_datatypeid(dataset.get_datatype());
 
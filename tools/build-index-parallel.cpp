@@ -61,6 +61,9 @@ extern "C" {
 #include <pique/region/wah/wah.hpp>
 #include <pique/region/wah/wah-encode.hpp>
 #include <pique/setops/wah/wah-setops.hpp>
+#include <pique/region/wah/wah64.hpp>
+#include <pique/region/wah/wah64-encode.hpp>
+#include <pique/setops/wah/wah64-setops.hpp>
 
 #include <pique/io/index-io.hpp>
 #include <pique/parallel/util/gather-serializable.hpp>
@@ -78,14 +81,17 @@ struct cmd_args_t {
 	char *binning_type_str;
 	char *binning_param_str;
 	bool cblq_dense_suff;
+	bool cii_bp128 {false};
 
 	uint64_t partition_size;
 	bool dedicated_master;
+	bool dynamic_assignment {true};
 
 	bool verbose {false};
 	uint64_t offset {0};
 	uint64_t nelem {UINT64_MAX};
 	bool relativize_subdomain {true};
+	bool zorder {false};
 };
 
 struct cmd_config_t {
@@ -97,13 +103,17 @@ struct cmd_config_t {
 	AbstractBinningSpecification::BinningSpecificationType binning_type;
 	std::string binning_param;
 	bool cblq_dense_suff;
+	bool cii_bp128; // Compress CII regions with the built-in BP128 codec rather than PForDelta
 
 	uint64_t partition_size;
 	bool dedicated_master;
+	bool dynamic_assignment;
 
 	bool verbose;
 	uint64_t offset, nelem;
 	bool relativize_subdomain;
+	bool zorder; // Index each partition in Z-order over its slab of the grid (see IndexBuilder::build_index_zo)
+	bool prefetch_data; // Read each rank's next partition on a helper thread, which needs MPI_THREAD_FUNNELED support
 };
 
 // MPI rank and size stored globally
@@ -125,6 +135,11 @@ static void print_parallel_index_generator_stats(ParallelIndexingStats stats) {
 				 << stats.indexing_stats.iostats.read_seeks << "/"
 				 << stats.indexing_stats.num_read_buffer_blocks << "/"
 				 << stats.indexing_stats.iostats.read_time << std::endl;
+	print_rank() << "Prefetched dataset read bytes/seeks/time: "
+				 << stats.dataread_stats.read_bytes << "/"
+				 << stats.dataread_stats.read_seeks << "/"
+				 << stats.dataread_stats.read_time << std::endl;
+	print_rank() << "Prefetch wait time: " << stats.prefetch_wait_time.time << std::endl;
 	print_rank() << "Indexing time: " << stats.indexing_stats.indexingtime.time << std::endl;
 	print_rank() << "Indexing remainder time (total - datasetread - indexing): "
 			     << (stats.indexing_stats.totaltime - stats.indexing_stats.indexingtime - stats.indexing_stats.iostats.get_read_as_time_stats()).time << std::endl;
@@ -147,10 +162,12 @@ static boost::shared_ptr< AbstractSetOperations > build_index_encode_setops() {
 	boost::shared_ptr< PreferenceListSetOperations > setops = boost::make_shared< PreferenceListSetOperations >();
 	setops->push_back(boost::make_shared< IISetOperations >(IISetOperationsConfig()));
 	setops->push_back(boost::make_shared< CIISetOperations >(CIISetOperationsConfig(true)));
+	setops->push_back(boost::make_shared< CBLQSetOperations<1> >(CBLQSetOperationsConfig(true)));
 	setops->push_back(boost::make_shared< CBLQSetOperations<2> >(CBLQSetOperationsConfig(true)));
 	setops->push_back(boost::make_shared< CBLQSetOperations<3> >(CBLQSetOperationsConfig(true)));
 	setops->push_back(boost::make_shared< CBLQSetOperations<4> >(CBLQSetOperationsConfig(true)));
 	setops->push_back(boost::make_shared< WAHSetOperations >(WAHSetOperationsConfig(true)));
+	setops->push_back(boost::make_shared< WAH64SetOperations >(WAH64SetOperationsConfig()));
 	return setops;
 }
 
@@ -202,6 +219,10 @@ static std::ostream & operator<<(std::ostream &o, ParallelIndexingStats &stats)
 		begin_str_key << "parts-indexed"  << end_str_key << begin_value << stats.num_partitions_indexed << end_value <<
 		begin_str_key << "elems-indexed"  << end_str_key << begin_value << stats.num_elements_indexed   << end_value <<
 		begin_str_key << "total-time"     << end_str_key << begin_value << stats.total_time     << end_value <<
+		begin_str_key << "queue-time"     << end_str_key << begin_value << stats.work_queue_time << end_value <<
+		begin_str_key << "idle-time"      << end_str_key << begin_value << stats.idle_time      << end_value <<
+		begin_str_key << "prefetch-wait-time" << end_str_key << begin_value << stats.prefetch_wait_time << end_value <<
+		begin_str_key << "dataread-stats" << end_str_key << begin_value << stats.dataread_stats << end_value <<
 		begin_str_key << "indexing-stats" << end_str_key << begin_value << stats.indexing_stats << end_value <<
 		begin_str_key << "io-stats"       << end_str_key << begin_value << stats.indexio_stats  << end_value <<
 		begin_str_key << "mpi-stats"      << end_str_key << begin_value << stats.mpistats       << end_value <<
@@ -221,8 +242,8 @@ bool produce_index_file(const cmd_config_t &conf, typename RegionEncoderT::Regio
 	ParallelIndexGenerator< datatype_t, RegionEncoderT, BinningSpecificationT >
 		pll_indexer(MPI_COMM_WORLD, encoder_conf, binning_spec, conf.index_enc, build_index_encode_setops());
 
-	if (conf.verbose) std::cerr << "[" << rank << "/" << size << "] Beginning parallel indexing (dedicated master? " << (conf.dedicated_master ? "yes" : "no") << ")..." << std::endl;
-	pll_indexer.generate_index(conf.index_filename, *dataset, conf.partition_size, conf.dedicated_master, conf.offset, conf.nelem, conf.relativize_subdomain);
+	if (conf.verbose) std::cerr << "[" << rank << "/" << size << "] Beginning parallel indexing (dedicated master? " << (conf.dedicated_master ? "yes" : "no") << ", dynamic assignment? " << (conf.dynamic_assignment ? "yes" : "no") << ")..." << std::endl;
+	pll_indexer.generate_index(conf.index_filename, *dataset, conf.partition_size, conf.dedicated_master, conf.offset, conf.nelem, conf.relativize_subdomain, conf.dynamic_assignment, conf.prefetch_data, conf.zorder);
 	if (conf.verbose) std::cerr << "[" << rank << "/" << size << "] Done!" << std::endl;
 
 	boost::optional< std::vector< ParallelIndexingStats > > opt_allstats = gather_serializables(pll_indexer.get_stats()); // Collect each rank's stats to a master rank
@@ -297,6 +318,9 @@ struct DispatchBinningSpec {
 
 template<typename RegionEncoderConfigT> auto make_encoder_config(const cmd_config_t &conf) -> RegionEncoderConfigT { return RegionEncoderConfigT(); }
 template<> auto make_encoder_config< CBLQRegionEncoderConfig >(const cmd_config_t &conf) -> CBLQRegionEncoderConfig { return CBLQRegionEncoderConfig(conf.cblq_dense_suff); }
+template<> auto make_encoder_config< CIIRegionEncoderConfig >(const cmd_config_t &conf) -> CIIRegionEncoderConfig {
+	return CIIRegionEncoderConfig(conf.cii_bp128 ? CIICompressionFormat::BP128 : DEFAULT_CII_COMPRESSION_FORMAT);
+}
 
 template<typename datatype_t>
 struct DispatchRegionEncoder {
@@ -315,8 +339,8 @@ struct DispatchDatatype {
 	using RepType = RegionEncoding::Type;
 	typedef typename
 			MakeValueToTypeDispatch< RepType >::
-				WithValues< RepType::II, RepType::CII, RepType::WAH, RepType::CBLQ_2D, RepType::CBLQ_3D, RepType::CBLQ_4D >::
-				WithTypes< IIRegionEncoder, CIIRegionEncoder, WAHRegionEncoder, CBLQRegionEncoder<2>, CBLQRegionEncoder<3>, CBLQRegionEncoder<4> >::type
+				WithValues< RepType::II, RepType::CII, RepType::WAH, RepType::CBLQ_1D, RepType::CBLQ_2D, RepType::CBLQ_3D, RepType::CBLQ_4D, RepType::WAH64 >::
+				WithTypes< IIRegionEncoder, CIIRegionEncoder, WAHRegionEncoder, CBLQRegionEncoder<1>, CBLQRegionEncoder<2>, CBLQRegionEncoder<3>, CBLQRegionEncoder<4>, WAH64RegionEncoder >::type
 			RepTypeToEncoderDispatch;
 
 	template<typename datatype_t>
@@ -359,6 +383,8 @@ static void validate_and_fully_parse_args(cmd_config_t &conf, cmd_args_t &args)
 		conf.index_enc = IndexEncoding::get_instance(EncType::HIERARCHICAL);
 	else if (enctype == "binarycomp")
 		conf.index_enc = IndexEncoding::get_instance(EncType::BINARY_COMPONENT);
+	else if (enctype == "multires")
+		conf.index_enc = IndexEncoding::get_instance(EncType::MULTI_RESOLUTION);
 	else
 		abort();
 
@@ -375,12 +401,15 @@ static void validate_and_fully_parse_args(cmd_config_t &conf, cmd_args_t &args)
 	conf.binning_param = std::string(args.binning_param_str);
 
 	conf.cblq_dense_suff = args.cblq_dense_suff;
+	conf.cii_bp128 = args.cii_bp128;
 	conf.partition_size = args.partition_size;
 	conf.dedicated_master = args.dedicated_master;
+	conf.dynamic_assignment = args.dynamic_assignment;
 	conf.verbose = args.verbose;
 	conf.offset = args.offset;
 	conf.nelem = args.nelem;
 	conf.relativize_subdomain = args.relativize_subdomain;
+	conf.zorder = args.zorder;
 }
 
 static myoption addopt(const char *flagname, int hasarg, OPTION_VALUE_TYPE type, void *output, void *fixedval = NULL) {
@@ -394,7 +423,8 @@ static myoption addopt(const char *flagname, int hasarg, OPTION_VALUE_TYPE type,
 }
 
 int main(int argc, char **argv) {
-	MPI_Init(&argc, &argv);
+	int thread_support;
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support); // ParallelIndexGenerator may prefetch data on a helper thread (which makes no MPI calls)
 	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 	MPI_Comm_size(MPI_COMM_WORLD, &size);
 
@@ -411,17 +441,24 @@ int main(int argc, char **argv) {
 		addopt("binningtype", required_argument, OPTION_TYPE_STRING, &args.binning_type_str),
 		addopt("binningparam", required_argument, OPTION_TYPE_STRING, &args.binning_param_str),
 		addopt("cblq_dense_suff", optional_argument, OPTION_TYPE_BOOLEAN, &args.cblq_dense_suff, &TRUEVAL),
+		addopt("cii_bp128", optional_argument, OPTION_TYPE_BOOLEAN, &args.cii_bp128, &TRUEVAL),
 		addopt("partsize", required_argument, OPTION_TYPE_UINT64, &args.partition_size),
 		addopt("dedmaster", required_argument, OPTION_TYPE_BOOLEAN, &args.dedicated_master, &FALSEVAL),
+		addopt("staticassign", no_argument, OPTION_TYPE_BOOLEAN, &args.dynamic_assignment, &FALSEVAL),
 		addopt("verbose", no_argument, OPTION_TYPE_BOOLEAN, &args.verbose, &TRUEVAL),
 		addopt("offset", required_argument, OPTION_TYPE_UINT64, &args.offset),
 		addopt("nelem", required_argument, OPTION_TYPE_UINT64, &args.nelem),
 		addopt("absrids", no_argument, OPTION_TYPE_BOOLEAN, &args.relativize_subdomain, &FALSEVAL),
+		addopt("zorder", no_argument, OPTION_TYPE_BOOLEAN, &args.zorder, &TRUEVAL),
         addopt(NULL, required_argument, OPTION_TYPE_BOOLEAN, NULL),
     };
     parse_args(&argc, &argv, opts);
     validate_and_fully_parse_args(conf, args);
 
+    conf.prefetch_data = (thread_support >= MPI_THREAD_FUNNELED);
+    if (!conf.prefetch_data && rank == 0)
+        std::cerr << "Warning: the MPI library does not support MPI_THREAD_FUNNELED, so data prefetching is disabled" << std::endl;
+
     produce_index_file(conf);
 
     MPI_Finalize();
@@ -30,6 +30,7 @@ extern "C" {
 }
 
 #include <cstdint>
+#include <algorithm>
 #include <cstring>
 #include <cassert>
 #include <typeindex>
@@ -39,12 +40,15 @@ extern "C" {
 #include <boost/none.hpp>
 #include <boost/optional.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
 
 #include <pique/data/dataset.hpp>
 #include <pique/io/database.hpp>
 
 #include <pique/indexing/binned-index.hpp>
 #include <pique/indexing/index-builder.hpp>
+#include <pique/indexing/multivar-index-builder.hpp>
+#include <pique/indexing/representation-selector.hpp>
 #include <pique/region/region-encoding.hpp>
 
 #include <pique/region/ii/ii.hpp>
@@ -59,6 +63,9 @@ extern "C" {
 #include <pique/region/wah/wah.hpp>
 #include <pique/region/wah/wah-encode.hpp>
 #include <pique/setops/wah/wah-setops.hpp>
+#include <pique/region/wah/wah64.hpp>
+#include <pique/region/wah/wah64-encode.hpp>
+#include <pique/setops/wah/wah64-setops.hpp>
 
 #include <pique/io/index-io.hpp>
 #include <pique/io/posix/posix-index-io.hpp>
@@ -72,17 +79,30 @@ struct cmd_args_t {
 	char *binning_type_str{nullptr};
 	char *binning_param_str{nullptr};
 	bool cblq_dense_suff{false};
+	bool cii_bp128{false};
+	bool append{false};
+	bool zorder{false};
+	uint64_t encode_threads{1};
+	uint64_t memory_budget_mb{0};
+	char *scratch_filename_str{nullptr};
 };
 
 struct cmd_config_t {
-	std::string dataset_meta_filename;
-	std::string index_filename;
+	// One index file per dataset; all datasets must share a grid, and are indexed in a single pass
+	std::vector< std::string > dataset_meta_filenames;
+	std::vector< std::string > index_filenames;
 
 	RegionEncoding::Type index_rep;
 	boost::shared_ptr< IndexEncoding > index_enc;
 	AbstractBinningSpecification::BinningSpecificationType binning_type;
 	std::string binning_param;
 	bool cblq_dense_suff;
+	bool cii_bp128; // Compress CII regions with the built-in BP128 codec rather than PForDelta
+	bool append; // Append the index as a new partition of an existing index file
+	bool zorder; // Index the grid in Z-order rather than row-major order (see IndexBuilder::build_index_zo)
+	int encode_threads; // Threads used to build encoded (non-equality) indexes; 0 means one per hardware thread
+	uint64_t memory_budget_bytes; // Memory budget for each variable's index builder (0 means unlimited)
+	std::string scratch_filename; // Scratch file base name (empty means each index file name + ".scratch")
 };
 
 template< typename BinningSpecificationT >
@@ -134,27 +154,40 @@ struct BinningSpecBuilder< ExplicitBinsBinningSpecification< ValueTypeT > > {
 };
 
 template<typename datatype_t, typename BinningSpecificationT, typename boost::disable_if_c< BinningSpecificationT::is_valid_instantiation, int >::type ignore = 0 >
-static boost::shared_ptr< BinnedIndex > build_index(const cmd_config_t &conf, boost::shared_ptr< Dataset > dataset) {
+static boost::shared_ptr< AbstractIndexBuildSession > begin_build(const cmd_config_t &conf, const IndexBuilderSpillConfig &spill_conf, boost::shared_ptr< Dataset > dataset) {
 	abort();
 }
 
+template<typename IndexBuilderT>
+static boost::shared_ptr< AbstractIndexBuildSession > begin_session(const cmd_config_t &conf, const IndexBuilderT &builder, const Dataset &dataset) {
+	if (conf.zorder)
+		return builder.begin_build_zo(dataset.get_grid());
+	else
+		return builder.begin_build(dataset.get_element_count());
+}
+
 template<typename datatype_t, typename BinningSpecificationT, typename boost::enable_if_c< BinningSpecificationT::is_valid_instantiation, int >::type ignore = 0 >
-static boost::shared_ptr< BinnedIndex > build_index(const cmd_config_t &conf, boost::shared_ptr< Dataset > dataset) {
+static boost::shared_ptr< AbstractIndexBuildSession > begin_build(const cmd_config_t &conf, const IndexBuilderSpillConfig &spill_conf, boost::shared_ptr< Dataset > dataset) {
 	boost::shared_ptr< BinningSpecificationT > binning_spec = BinningSpecBuilder< BinningSpecificationT >::build(conf);
 
 	switch (conf.index_rep) {
 	case RegionEncoding::Type::II:
-		return IndexBuilder< datatype_t, IIRegionEncoder, BinningSpecificationT >(IIRegionEncoderConfig(), binning_spec).build_index(*dataset);
+	case RegionEncoding::Type::HETEROGENEOUS: // Regions are re-encoded individually after building (see write_index_file)
+		return begin_session(conf, IndexBuilder< datatype_t, IIRegionEncoder, BinningSpecificationT >(IIRegionEncoderConfig(), binning_spec, spill_conf), *dataset);
 	case RegionEncoding::Type::CII:
-		return IndexBuilder< datatype_t, CIIRegionEncoder, BinningSpecificationT >(CIIRegionEncoderConfig(), binning_spec).build_index(*dataset);
+		return begin_session(conf, IndexBuilder< datatype_t, CIIRegionEncoder, BinningSpecificationT >(CIIRegionEncoderConfig(conf.cii_bp128 ? CIICompressionFormat::BP128 : DEFAULT_CII_COMPRESSION_FORMAT), binning_spec, spill_conf), *dataset);
 	case RegionEncoding::Type::WAH:
-		return IndexBuilder< datatype_t, WAHRegionEncoder, BinningSpecificationT >(WAHRegionEncoderConfig(), binning_spec).build_index(*dataset);
+		return begin_session(conf, IndexBuilder< datatype_t, WAHRegionEncoder, BinningSpecificationT >(WAHRegionEncoderConfig(), binning_spec, spill_conf), *dataset);
+	case RegionEncoding::Type::WAH64:
+		return begin_session(conf, IndexBuilder< datatype_t, WAH64RegionEncoder, BinningSpecificationT >(WAH64RegionEncoderConfig(), binning_spec, spill_conf), *dataset);
+	case RegionEncoding::Type::CBLQ_1D:
+		return begin_session(conf, IndexBuilder< datatype_t, CBLQRegionEncoder<1>, BinningSpecificationT >(CBLQRegionEncoderConfig(conf.cblq_dense_suff), binning_spec, spill_conf), *dataset);
 	case RegionEncoding::Type::CBLQ_2D:
-		return IndexBuilder< datatype_t, CBLQRegionEncoder<2>, BinningSpecificationT >(CBLQRegionEncoderConfig(conf.cblq_dense_suff), binning_spec).build_index(*dataset);
+		return begin_session(conf, IndexBuilder< datatype_t, CBLQRegionEncoder<2>, BinningSpecificationT >(CBLQRegionEncoderConfig(conf.cblq_dense_suff), binning_spec, spill_conf), *dataset);
 	case RegionEncoding::Type::CBLQ_3D:
-		return IndexBuilder< datatype_t, CBLQRegionEncoder<3>, BinningSpecificationT >(CBLQRegionEncoderConfig(conf.cblq_dense_suff), binning_spec).build_index(*dataset);
+		return begin_session(conf, IndexBuilder< datatype_t, CBLQRegionEncoder<3>, BinningSpecificationT >(CBLQRegionEncoderConfig(conf.cblq_dense_suff), binning_spec, spill_conf), *dataset);
 	case RegionEncoding::Type::CBLQ_4D:
-		return IndexBuilder< datatype_t, CBLQRegionEncoder<4>, BinningSpecificationT >(CBLQRegionEncoderConfig(conf.cblq_dense_suff), binning_spec).build_index(*dataset);
+		return begin_session(conf, IndexBuilder< datatype_t, CBLQRegionEncoder<4>, BinningSpecificationT >(CBLQRegionEncoderConfig(conf.cblq_dense_suff), binning_spec, spill_conf), *dataset);
 	default:
 		std::cerr << "Unsupported index representation " << (int)conf.index_rep << std::endl;
 		abort();
@@ -163,16 +196,16 @@ static boost::shared_ptr< BinnedIndex > build_index(const cmd_config_t &conf, bo
 }
 
 template<typename datatype_t>
-boost::shared_ptr< BinnedIndex > build_index(const cmd_config_t &conf, boost::shared_ptr< Dataset > dataset) {
+boost::shared_ptr< AbstractIndexBuildSession > begin_build(const cmd_config_t &conf, const IndexBuilderSpillConfig &spill_conf, boost::shared_ptr< Dataset > dataset) {
 	using BinningSpecificationType = AbstractBinningSpecification::BinningSpecificationType;
 
 	switch (conf.binning_type) {
 	case BinningSpecificationType::SIGBITS:
-		return build_index<datatype_t, SigbitsBinningSpecification< datatype_t > >(conf, dataset);
+		return begin_build<datatype_t, SigbitsBinningSpecification< datatype_t > >(conf, spill_conf, dataset);
 	case BinningSpecificationType::EXPLICIT_BINS:
-		return build_index<datatype_t, ExplicitBinsBinningSpecification< datatype_t > >(conf, dataset);
+		return begin_build<datatype_t, ExplicitBinsBinningSpecification< datatype_t > >(conf, spill_conf, dataset);
 	case BinningSpecificationType::PRECISION:
-		return build_index<datatype_t, PrecisionBinningSpecification< datatype_t > >(conf, dataset);
+		return begin_build<datatype_t, PrecisionBinningSpecification< datatype_t > >(conf, spill_conf, dataset);
 	default:
 		std::cerr << "Unsupported binning method " << (int)conf.binning_type << std::endl;
 		abort();
@@ -180,55 +213,90 @@ boost::shared_ptr< BinnedIndex > build_index(const cmd_config_t &conf, boost::sh
 	return nullptr;
 }
 
-struct BuildIndexDatatypeHelper {
+struct BeginBuildDatatypeHelper {
 	template<typename datatype_t>
-	boost::shared_ptr< BinnedIndex > operator()(const cmd_config_t &conf, boost::shared_ptr< Dataset > dataset) {
-		return build_index<datatype_t>(conf, dataset);
+	boost::shared_ptr< AbstractIndexBuildSession > operator()(const cmd_config_t &conf, const IndexBuilderSpillConfig &spill_conf, boost::shared_ptr< Dataset > dataset) {
+		return begin_build<datatype_t>(conf, spill_conf, dataset);
 	}
 };
 
-static boost::shared_ptr< BinnedIndex > build_index(const cmd_config_t &conf, boost::shared_ptr< Dataset > dataset) {
-	boost::shared_ptr< BinnedIndex > index =
-			Datatypes::DatatypeIDToCTypeDispatch::template dispatchMatching< boost::shared_ptr< BinnedIndex > >(
+static boost::shared_ptr< AbstractIndexBuildSession > begin_build(const cmd_config_t &conf, const IndexBuilderSpillConfig &spill_conf, boost::shared_ptr< Dataset > dataset) {
+	boost::shared_ptr< AbstractIndexBuildSession > session =
+			Datatypes::DatatypeIDToCTypeDispatch::template dispatchMatching< boost::shared_ptr< AbstractIndexBuildSession > >(
 						dataset->get_datatype(),
-						BuildIndexDatatypeHelper(),
+						BeginBuildDatatypeHelper(),
 						nullptr,
-						conf, dataset
+						conf, spill_conf, dataset
 			);
 
-	if (!index) {
+	if (!session) {
 		std::cerr << "Unsupported dataset datatype " << (int)dataset->get_datatype() << std::endl;
 		abort();
 	}
-	return index;
+	return session;
+}
+
+// Each variable's builder spills to its own scratch file
+static IndexBuilderSpillConfig get_spill_conf(const cmd_config_t &conf, size_t var) {
+	std::string scratch_filename = conf.index_filenames[var] + ".scratch";
+	if (!conf.scratch_filename.empty())
+		scratch_filename = conf.scratch_filename + (conf.index_filenames.size() > 1 ? "." + std::to_string(var) : "");
+
+	return IndexBuilderSpillConfig(conf.memory_budget_bytes, scratch_filename);
 }
 
 static boost::shared_ptr< BinnedIndex > encode_index(const cmd_config_t &conf, boost::shared_ptr< BinnedIndex > flat_index) {
 	PreferenceListSetOperations setops;
 	setops.push_back(boost::make_shared< IISetOperations >(IISetOperationsConfig()));
 	setops.push_back(boost::make_shared< CIISetOperations >(CIISetOperationsConfig(true)));
+	setops.push_back(boost::make_shared< CBLQSetOperationsFast<1> >(CBLQSetOperationsConfig(true)));
 	setops.push_back(boost::make_shared< CBLQSetOperationsFast<2> >(CBLQSetOperationsConfig(true)));
 	setops.push_back(boost::make_shared< CBLQSetOperationsFast<3> >(CBLQSetOperationsConfig(true)));
 	setops.push_back(boost::make_shared< CBLQSetOperationsFast<4> >(CBLQSetOperationsConfig(true)));
 	setops.push_back(boost::make_shared< WAHSetOperations >(WAHSetOperationsConfig(true)));
+	setops.push_back(boost::make_shared< WAH64SetOperations >(WAH64SetOperationsConfig()));
 
-	return IndexEncoding::get_encoded_index(conf.index_enc, flat_index, setops);
+	return IndexEncoding::get_encoded_index(conf.index_enc, flat_index, setops, conf.encode_threads);
 }
 
 static boost::shared_ptr< IndexIO > open_index_io(const cmd_config_t &conf) {
 	return boost::make_shared< POSIXIndexIO >();
 }
 
-static void produce_index_file(const cmd_config_t &conf) {
-	using EncType = IndexEncoding::Type;
+// An index file opened for writing, with a new partition appended to it
+struct output_index_t {
+	boost::shared_ptr< IndexIO > indexio;
+	boost::shared_ptr< IndexPartitionIO > partio;
+};
 
-	std::cout << "[1] Loading dataset based on metafile \"" << conf.dataset_meta_filename << "\"" << std::endl;
-	DataVariable dv("thevar", conf.dataset_meta_filename, boost::none);
-	boost::shared_ptr< Dataset > dataset = dv.open_dataset();
-	assert(dataset /* Need successful dataset load */);
+static output_index_t open_output_index(const cmd_config_t &conf, const std::string &index_filename) {
+	std::cout << "[3] Opening index file \"" << index_filename << "\" for " << (conf.append ? "appending" : "writing") << "..." << std::endl;
+	output_index_t out;
+	out.indexio = open_index_io(conf);
+	if (!out.indexio->open(index_filename, conf.append ? IndexOpenMode::WRITE_APPEND : IndexOpenMode::WRITE)) {
+		std::cerr << "Error: could not open index file \"" << index_filename << "\"" << std::endl;
+		abort();
+	}
 
-	std::cout << "[2] Building index..." << std::endl;
-	boost::shared_ptr< BinnedIndex > flat_index = build_index(conf, dataset);
+	// When appending, place the new partition's domain after those of all existing partitions
+	IndexIOTypes::domain_offset_t domain_offset = 0;
+	for (const IndexIO::GlobalPartitionMetadata &gpmeta : out.indexio->get_all_partition_metadatas())
+		domain_offset = std::max(domain_offset, gpmeta.domain.first + gpmeta.domain.second);
+
+	std::cout << "[4] Writing index to disk (partition " << out.indexio->get_num_partitions() << ", domain offset " << domain_offset << ")..." << std::endl;
+	out.partio = out.indexio->append_partition();
+	out.partio->set_domain_global_offset(domain_offset);
+	return out;
+}
+
+static void close_output_index(output_index_t &out) {
+	std::cout << "[5] Finalizing index..." << std::endl;
+	out.partio->close();
+	out.indexio->close();
+}
+
+static void write_index_file(const cmd_config_t &conf, const std::string &index_filename, boost::shared_ptr< BinnedIndex > flat_index) {
+	using EncType = IndexEncoding::Type;
 
 	std::cout << "    Index statistics:" << std::endl;
 	flat_index->dump_summary();
@@ -244,17 +312,76 @@ static void produce_index_file(const cmd_config_t &conf) {
 		final_index->dump_summary();
 	}
 
-	std::cout << "[3] Opening index file \"" << conf.index_filename << "\" for writing..." << std::endl;
-	boost::shared_ptr< IndexIO > indexio = open_index_io(conf);
-	indexio->open(conf.index_filename, IndexOpenMode::WRITE);
+	if (conf.index_rep == RegionEncoding::Type::HETEROGENEOUS) {
+		std::cout << "[2.75] Selecting region representations..." << std::endl;
+		final_index = RegionRepresentationSelector().select_representations(final_index, conf.encode_threads);
+
+		std::cout << "    Final index statistics:" << std::endl;
+		final_index->dump_summary();
+	}
+
+	output_index_t out = open_output_index(conf, index_filename);
+	out.partio->write_index(*final_index);
+	close_output_index(out);
+}
 
-	std::cout << "[4] Writing index to disk..." << std::endl;
-	boost::shared_ptr< IndexPartitionIO > partio = indexio->append_partition();
-	partio->write_index(*final_index);
+// When building out-of-core, an index that needs no further processing once built (a flat index in the representation it
+// was built in) is written as it is finished, a region at a time, so that the finished index is never held in memory
+static bool stream_index_files(const cmd_config_t &conf) {
+	return conf.memory_budget_bytes > 0 &&
+		   conf.index_enc->get_type() == IndexEncoding::Type::EQUALITY &&
+		   conf.index_rep != RegionEncoding::Type::HETEROGENEOUS;
+}
 
-	std::cout << "[5] Finalizing index..." << std::endl;
-	partio->close();
-	indexio->close();
+static void produce_index_files(const cmd_config_t &conf) {
+	const size_t nvars = conf.dataset_meta_filenames.size();
+	const bool streaming = stream_index_files(conf);
+
+	// Build all variables' indexes in one pass over their (common) grid
+	MultiVariableIndexBuilder builder;
+	for (size_t var = 0; var < nvars; ++var) {
+		std::cout << "[1] Loading dataset based on metafile \"" << conf.dataset_meta_filenames[var] << "\"" << std::endl;
+		DataVariable dv("thevar", conf.dataset_meta_filenames[var], boost::none);
+		boost::shared_ptr< Dataset > dataset = dv.open_dataset();
+		assert(dataset /* Need successful dataset load */);
+
+		builder.add_variable(dataset, begin_build(conf, get_spill_conf(conf, var), dataset));
+	}
+
+	std::vector< output_index_t > outputs;
+	std::vector< boost::shared_ptr< BinnedIndexRegionSink > > sinks;
+	if (streaming) {
+		for (size_t var = 0; var < nvars; ++var) {
+			outputs.push_back(open_output_index(conf, conf.index_filenames[var]));
+			sinks.push_back(boost::make_shared< IndexPartitionRegionSink >(outputs.back().partio));
+		}
+	}
+
+	std::cout << "[2] Building index" << (nvars > 1 ? "es" : "") << (streaming ? " (writing each region as it is finished)" : "") << "..." << std::endl;
+	std::vector< boost::shared_ptr< BinnedIndex > > flat_indexes = streaming ? builder.build_indexes(sinks) : builder.build_indexes();
+
+	const std::vector< IndexBuilderStats > all_stats = builder.get_stats();
+	for (size_t var = 0; var < nvars; ++var) {
+		const IndexBuilderStats &stats = all_stats[var];
+		if (nvars > 1)
+			std::cout << "    Variable " << var << " (\"" << conf.dataset_meta_filenames[var] << "\"):" << std::endl;
+		std::cout << "    Peak RSS: " << stats.peak_rss_bytes << " bytes" << std::endl;
+		if (stats.num_spilled_pieces)
+			std::cout << "    Spilled " << stats.num_spilled_pieces << " pieces (" << stats.spilled_bytes << " bytes) in " << stats.spilltime.time << "s" << std::endl;
+		if (stats.peak_state_bytes)
+			std::cout << "    Peak encoder/region state: " << stats.peak_state_bytes << " bytes" << std::endl;
+	}
+
+	for (size_t var = 0; var < nvars; ++var) {
+		if (nvars > 1)
+			std::cout << "Variable " << var << " (\"" << conf.dataset_meta_filenames[var] << "\"):" << std::endl;
+		if (streaming) {
+			close_output_index(outputs[var]);
+		} else {
+			write_index_file(conf, conf.index_filenames[var], flat_indexes[var]);
+			flat_indexes[var] = nullptr; // Release each index once written
+		}
+	}
 	std::cout << "[6] Done!" << std::endl;
 }
 
@@ -262,9 +389,13 @@ static void validate_and_fully_parse_args(cmd_config_t &conf, cmd_args_t &args)
 	using EncType = IndexEncoding::Type;
 	using BinningType = AbstractBinningSpecification::BinningSpecificationType;
 
-	conf.dataset_meta_filename = args.dataset_meta_filename_str;
-
-	conf.index_filename = args.index_filename_str;
+	// Comma-separated lists, to index several variables at once
+	boost::algorithm::split(conf.dataset_meta_filenames, std::string(args.dataset_meta_filename_str), boost::algorithm::is_any_of(","));
+	boost::algorithm::split(conf.index_filenames, std::string(args.index_filename_str), boost::algorithm::is_any_of(","));
+	if (conf.dataset_meta_filenames.size() != conf.index_filenames.size()) {
+		std::cerr << "Need one index file per dataset metafile (got " << conf.dataset_meta_filenames.size() << " metafiles and " << conf.index_filenames.size() << " index files)" << std::endl;
+		abort();
+	}
 
 	const boost::optional< RegionEncoding::Type > reptype = RegionEncoding::get_region_representation_type_by_name(args.index_rep_str);
 	assert(reptype /* Need valid index representation type */);
@@ -281,6 +412,8 @@ static void validate_and_fully_parse_args(cmd_config_t &conf, cmd_args_t &args)
 		conf.index_enc = IndexEncoding::get_instance(EncType::HIERARCHICAL);
 	else if (enctype == "binarycomp")
 		conf.index_enc = IndexEncoding::get_instance(EncType::BINARY_COMPONENT);
+	else if (enctype == "multires")
+		conf.index_enc = IndexEncoding::get_instance(EncType::MULTI_RESOLUTION);
 	else
 		abort();
 
@@ -297,6 +430,12 @@ static void validate_and_fully_parse_args(cmd_config_t &conf, cmd_args_t &args)
 	conf.binning_param = std::string(args.binning_param_str);
 
 	conf.cblq_dense_suff = args.cblq_dense_suff;
+	conf.cii_bp128 = args.cii_bp128;
+	conf.append = args.append;
+	conf.zorder = args.zorder;
+	conf.encode_threads = (int)args.encode_threads;
+	conf.memory_budget_bytes = args.memory_budget_mb << 20;
+	conf.scratch_filename = args.scratch_filename_str ? std::string(args.scratch_filename_str) : std::string();
 }
 
 static myoption addopt(const char *flagname, int hasarg, OPTION_VALUE_TYPE type, void *output, void *fixedval = NULL) {
@@ -323,10 +462,16 @@ int main(int argc, char **argv) {
 		addopt("binningtype", required_argument, OPTION_TYPE_STRING, &args.binning_type_str),
 		addopt("binningparam", required_argument, OPTION_TYPE_STRING, &args.binning_param_str),
 		addopt("cblq_dense_suff", optional_argument, OPTION_TYPE_BOOLEAN, &args.cblq_dense_suff, &TRUEVAL),
+		addopt("cii_bp128", optional_argument, OPTION_TYPE_BOOLEAN, &args.cii_bp128, &TRUEVAL),
+		addopt("append", optional_argument, OPTION_TYPE_BOOLEAN, &args.append, &TRUEVAL),
+		addopt("zorder", optional_argument, OPTION_TYPE_BOOLEAN, &args.zorder, &TRUEVAL),
+		addopt("encode_threads", required_argument, OPTION_TYPE_UINT64, &args.encode_threads),
+		addopt("memory_budget_mb", required_argument, OPTION_TYPE_UINT64, &args.memory_budget_mb),
+		addopt("scratch_file", required_argument, OPTION_TYPE_STRING, &args.scratch_filename_str),
         addopt(NULL, required_argument, OPTION_TYPE_BOOLEAN, NULL),
     };
     parse_args(&argc, &argv, opts);
     validate_and_fully_parse_args(conf, args);
 
-    produce_index_file(conf);
+    produce_index_files(conf);
 }
@@ -76,6 +76,7 @@ static std::string get_index_encoding_name(IndexEncoding::Type type) {
 	case Type::INTERVAL:			return "interval";
 	case Type::BINARY_COMPONENT:	return "binarycomp";
 	case Type::HIERARCHICAL:		return "hierarchical";
+	case Type::MULTI_RESOLUTION:	return "multires";
 	default: return "unknown";
 	}
 }
@@ -28,10 +28,13 @@
 #include <pique/setops/cii/cii-setops.hpp>
 #include <pique/setops/cblq/cblq-setops.hpp>
 #include <pique/setops/wah/wah-setops.hpp>
+#include <pique/setops/wah/wah64-setops.hpp>
 #include <pique/setops/bitmap/bitmap-setops.hpp>
 
 #include <pique/convert/region-convert.hpp>
+#include <pique/convert/rid-stream-convert.hpp>
 #include <pique/convert/cblq/cblq-to-bitmap-convert.hpp>
+#include <pique/convert/cblq/to-cblq-convert.hpp>
 
 #include <pique/query/query-engine.hpp>
 #include <pique/query/basic-query-engine.hpp>
@@ -51,35 +54,72 @@ static boost::shared_ptr< AbstractSetOperations > make_arity_thresh(size_t thres
 	);
 }
 
-static boost::shared_ptr< BasicQueryEngine > configure_basic_query_engine(std::string setops_mode, QueryEngineOptions options, bool verbose) {
-	boost::shared_ptr< PreferenceListSetOperations > preflist_setops = boost::make_shared< PreferenceListSetOperations >();
+// Converts bitmap or II operands to CBLQ of any dimensionality directly, and anything else through a RID stream
+static boost::shared_ptr< PreferenceListRegionEncodingConverter > configure_cblq_converter(bool dense_suffix) {
+	boost::shared_ptr< PreferenceListRegionEncodingConverter > preflist_converter = boost::make_shared< PreferenceListRegionEncodingConverter >();
+	const CBLQRegionEncoderConfig conf(dense_suffix);
+
+	preflist_converter->push_back(boost::make_shared< BitmapToCBLQConverter<1> >(conf));
+	preflist_converter->push_back(boost::make_shared< BitmapToCBLQConverter<2> >(conf));
+	preflist_converter->push_back(boost::make_shared< BitmapToCBLQConverter<3> >(conf));
+	preflist_converter->push_back(boost::make_shared< BitmapToCBLQConverter<4> >(conf));
+	preflist_converter->push_back(boost::make_shared< IIToCBLQConverter<1> >(conf));
+	preflist_converter->push_back(boost::make_shared< IIToCBLQConverter<2> >(conf));
+	preflist_converter->push_back(boost::make_shared< IIToCBLQConverter<3> >(conf));
+	preflist_converter->push_back(boost::make_shared< IIToCBLQConverter<4> >(conf));
+	preflist_converter->push_back(boost::make_shared< RIDStreamRegionEncodingConverter >());
+	return preflist_converter;
+}
+
+static boost::shared_ptr< BasicQueryEngine > configure_basic_query_engine(std::string setops_mode, std::string convert_mode, QueryEngineOptions options, bool verbose) {
+	// Operands of differing representations (e.g., in heterogeneous indexes) are converted to a common one; by default
+	// through a RID stream, or in "cblq" mode, directly into CBLQ where possible (other modes apply to the bitmap engine)
+	boost::shared_ptr< PreferenceListSetOperations > preflist_setops;
+	if (convert_mode == "cblq") {
+		preflist_setops = boost::make_shared< PreferenceListSetOperations >(configure_cblq_converter(true));
+		if (verbose) std::cerr << "Using direct bitmap/II-to-CBLQ operand conversion" << std::endl;
+	} else {
+		preflist_setops = boost::make_shared< PreferenceListSetOperations >();
+	}
 
 	// Only one set operations code for II, CII (N-ary seems universally better, but is buggy) and WAH
 	preflist_setops->push_back(boost::make_shared< IISetOperations >(IISetOperationsConfig()));
 	preflist_setops->push_back(boost::make_shared< CIISetOperations >(CIISetOperationsConfig(false)));
 	preflist_setops->push_back(boost::make_shared< WAHSetOperations >(WAHSetOperationsConfig()));
+	preflist_setops->push_back(boost::make_shared< WAH64SetOperations >(WAH64SetOperationsConfig()));
 
 	if (setops_mode == "nary3") {
+		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry3Dense<1> >(NARY_ARITY_THRESH, CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry3Dense<2> >(NARY_ARITY_THRESH, CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry3Dense<3> >(NARY_ARITY_THRESH, CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry3Dense<4> >(NARY_ARITY_THRESH, CBLQSetOperationsConfig(true)));
 		if (verbose) std::cerr << "Using nary3 setops for binmerge" << std::endl;
 	} else if (setops_mode == "nary2") {
+		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry2Dense<1> >(NARY_ARITY_THRESH, CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry2Dense<2> >(NARY_ARITY_THRESH, CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry2Dense<3> >(NARY_ARITY_THRESH, CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry2Dense<4> >(NARY_ARITY_THRESH, CBLQSetOperationsConfig(true)));
 		if (verbose) std::cerr << "Using nary2 setops for binmerge" << std::endl;
 	} else if (setops_mode == "fastunion") {
+		preflist_setops->push_back(boost::make_shared< CBLQSetOperationsFast<1> >(CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(boost::make_shared< CBLQSetOperationsFast<2> >(CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(boost::make_shared< CBLQSetOperationsFast<3> >(CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(boost::make_shared< CBLQSetOperationsFast<4> >(CBLQSetOperationsConfig(true)));
 		if (verbose) std::cerr << "Using fastunion setops for binmerge" << std::endl;
 	} else if (setops_mode == "fastnary3") {
+		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry3Fast<1> >(NARYFAST_ARITY_THRESH, CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry3Fast<2> >(NARYFAST_ARITY_THRESH, CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry3Fast<3> >(NARYFAST_ARITY_THRESH, CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry3Fast<4> >(NARYFAST_ARITY_THRESH, CBLQSetOperationsConfig(true)));
 		if (verbose) std::cerr << "Using fastnary3 setops for binmerge" << std::endl;
+	} else if (setops_mode == "fastnary3par") {
+		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry3FastParallel<1> >(NARYFAST_ARITY_THRESH, CBLQSetOperationsConfig(true)));
+		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry3FastParallel<2> >(NARYFAST_ARITY_THRESH, CBLQSetOperationsConfig(true)));
+		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry3FastParallel<3> >(NARYFAST_ARITY_THRESH, CBLQSetOperationsConfig(true)));
+		preflist_setops->push_back(make_arity_thresh< CBLQSetOperationsNAry3FastParallel<4> >(NARYFAST_ARITY_THRESH, CBLQSetOperationsConfig(true)));
+		if (verbose) std::cerr << "Using fastnary3par (multithreaded fastnary3) setops for binmerge" << std::endl;
 	} else if (setops_mode == "" || setops_mode == "standard" || setops_mode == "basic") {
+		preflist_setops->push_back(boost::make_shared< CBLQSetOperations<1> >(CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(boost::make_shared< CBLQSetOperations<2> >(CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(boost::make_shared< CBLQSetOperations<3> >(CBLQSetOperationsConfig(true)));
 		preflist_setops->push_back(boost::make_shared< CBLQSetOperations<4> >(CBLQSetOperationsConfig(true)));
@@ -97,11 +137,19 @@ static boost::shared_ptr< BitmapQueryEngine > configure_bitmap_query_engine(std:
 	boost::shared_ptr< BitmapPrefListConv > preflist_converter = boost::make_shared< BitmapPrefListConv >();
 
 	if (convert_mode == "dfs" || convert_mode == "df") {
+		preflist_converter->push_back(boost::make_shared< CBLQToBitmapDFConverter<1> >());
 		preflist_converter->push_back(boost::make_shared< CBLQToBitmapDFConverter<2> >());
 		preflist_converter->push_back(boost::make_shared< CBLQToBitmapDFConverter<3> >());
 		preflist_converter->push_back(boost::make_shared< CBLQToBitmapDFConverter<4> >());
 		if (verbose) std::cerr << "Using depth-first CBLQ-to-bitmap conversion" << std::endl;
+	} else if (convert_mode == "par" || convert_mode == "parallel") {
+		preflist_converter->push_back(boost::make_shared< CBLQToBitmapParallelConverter<1> >());
+		preflist_converter->push_back(boost::make_shared< CBLQToBitmapParallelConverter<2> >());
+		preflist_converter->push_back(boost::make_shared< CBLQToBitmapParallelConverter<3> >());
+		preflist_converter->push_back(boost::make_shared< CBLQToBitmapParallelConverter<4> >());
+		if (verbose) std::cerr << "Using parallel (multithreaded) CBLQ-to-bitmap conversion" << std::endl;
 	} else if (convert_mode == "" || convert_mode == "standard" || convert_mode == "basic") {
+		preflist_converter->push_back(boost::make_shared< CBLQToBitmapConverter<1> >());
 		preflist_converter->push_back(boost::make_shared< CBLQToBitmapConverter<2> >());
 		preflist_converter->push_back(boost::make_shared< CBLQToBitmapConverter<3> >());
 		preflist_converter->push_back(boost::make_shared< CBLQToBitmapConverter<4> >());
@@ -122,7 +170,7 @@ boost::shared_ptr< QueryEngine > configure_query_engine(std::string qe_mode, std
 		return configure_bitmap_query_engine(convert_mode, options, verbose);
 	} else if (qe_mode == "" || qe_mode == "standard" || qe_mode == "basic" || qe_mode == "setops") {
 		if (verbose) std::cerr << "Using setops-based query engine" << std::endl;
-		return configure_basic_query_engine(setops_mode, options, verbose);
+		return configure_basic_query_engine(setops_mode, convert_mode, options, verbose);
 	} else {
 		std::cerr << "WARNING: Unrecognized QueryEngine mode: \"" << qe_mode << "\"" << std::endl;
 		return nullptr;
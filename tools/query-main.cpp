@@ -42,6 +42,9 @@ extern "C" {
 
 #include "query-helper.hpp"
 
+// Number of RIDs converted and written per batch when dumping results to a RID file
+static constexpr size_t RID_BATCH_SIZE = (1ULL << 20);
+
 struct cmd_args_t {
 	const char *dbfile {nullptr};
 	const char *ridfile {nullptr};
@@ -49,6 +52,7 @@ struct cmd_args_t {
 	const char *setopsmode {"fastnary3"};
 	const char *convmode {"df"};
 	const char *complmode {"auto"};
+	const char *rewrite {"on"};
 };
 
 struct cmd_config_t {
@@ -74,6 +78,11 @@ static void validate_and_fully_parse_args(cmd_config_t &conf, cmd_args_t &args)
 		(strcasecmp(args.complmode, "never") == 0) ? ComplMode::NEVER :
 		(strcasecmp(args.complmode, "always") == 0) ? ComplMode::ALWAYS :
 		(abort(), ComplMode::AUTO);
+
+	conf.qeoptions.rewrite_queries =
+		(strcasecmp(args.rewrite, "on") == 0) ? true :
+		(strcasecmp(args.rewrite, "off") == 0) ? false :
+		(abort(), true);
 }
 
 static myoption addopt(const char *flagname, int hasarg, OPTION_VALUE_TYPE type, void *output, void *fixedval = NULL) {
@@ -251,16 +260,23 @@ static int run_expr_query(const cmd_config_t &conf, int argc, char **argv) {
 		double rid_count_or_conv_time = 0;
 
 		if (conf.ridfile) {
-			// Convert the result to RIDs, storing in a vector for dumping to file
-			TIME_BLOCK_BEGIN(&rid_count_or_conv_time, nullptr)
-			part_result.result->convert_to_rids(rids, true, false);
-			TIME_BLOCK_END()
-
-			part_result_count = rids.size();
+			// Stream the result's (global) RIDs to file in binary form, a bounded batch at a time,
+			// rather than materializing the entire partition result as RIDs
+			part_result_count = 0;
+			boost::shared_ptr< RIDBatchIterator > rid_it = part_result.make_rid_iterator();
+			while (true) {
+				bool has_batch;
+				TIME_BLOCK_BEGIN(&rid_count_or_conv_time, nullptr)
+				has_batch = rid_it->next_batch(rids, RID_BATCH_SIZE);
+				TIME_BLOCK_END()
+
+				if (!has_batch)
+					break;
 
-			// Write the RIDs to file, in binary form
-			ridsout.write(reinterpret_cast<char*>(&rids.front()), rids.size() * sizeof(uint64_t));
-			assert(ridsout.good());
+				part_result_count += rids.size();
+				ridsout.write(reinterpret_cast<char*>(&rids.front()), rids.size() * sizeof(uint64_t));
+				assert(ridsout.good());
+			}
 		} else {
 			TIME_BLOCK_BEGIN(&rid_count_or_conv_time, nullptr)
 			part_result_count = part_result.result->get_element_count();
@@ -280,9 +296,11 @@ static int run_expr_query(const cmd_config_t &conf, int argc, char **argv) {
 		uint64_t total_bins_touched = 0;
 		size_t num_constraints = 0;
 		size_t num_complements_used = 0;
+		size_t num_zone_map_pruned = 0;
 		for (const auto &cterm : constraint_term_stats) {
 			++num_constraints;
 			num_complements_used += cterm.used_complement_binmerge ? 1 : 0;
+			num_zone_map_pruned += cterm.zone_map_pruned ? 1 : 0;
 			total_bins_touched += cterm.used_bincount;
 		}
 
@@ -300,7 +318,9 @@ static int run_expr_query(const cmd_config_t &conf, int argc, char **argv) {
 				  << "setops time = " << part_result.stats.setopstotal.time << ", "
 				  << "ridconv time = " << rid_count_or_conv_time << ", "
 				  << "bins touched = " << total_bins_touched << ", "
-				  << "bin complements used = " << num_complements_used
+				  << "bin complements used = " << num_complements_used << ", "
+				  << "constraints pruned by zone map = " << num_zone_map_pruned << ", "
+				  << "constraints skipped = " << part_result.stats.constraints_skipped
 				  << std::endl;
 		std::cerr << "> More stats: ";
 		for (const auto &cterm : constraint_term_stats) {
@@ -340,6 +360,7 @@ int main(int argc, char **argv) {
       	addopt("setopsmode", required_argument, OPTION_TYPE_STRING, &args.setopsmode),
       	addopt("convmode", required_argument, OPTION_TYPE_STRING, &args.convmode),
       	addopt("complmode", required_argument, OPTION_TYPE_STRING, &args.complmode),
+      	addopt("rewrite", required_argument, OPTION_TYPE_STRING, &args.rewrite),
         addopt(NULL, required_argument, OPTION_TYPE_BOOLEAN, NULL),
     };
     parse_args(&argc, &argv, opts);